@@ -23,6 +23,7 @@ struct MicrophoneReverbApp : public LabSoundExampleApp
             recorder = std::make_shared<RecorderNode>(context->sampleRate());
             // input->connect(ac, recorder.get(), 0, 0); Debugging -- this works
             context->addAutomaticPullNode(recorder);
+            recorder->mixToMono(true);
             recorder->startRecording();
             
             convolve = std::make_shared<ConvolverNode>(context->sampleRate());
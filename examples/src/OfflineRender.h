@@ -15,6 +15,7 @@ struct OfflineRenderApp : public LabSoundExampleApp
         auto recorder = std::make_shared<RecorderNode>(context->sampleRate());
         
         context->addAutomaticPullNode(recorder);
+        recorder->mixToMono(true);
         recorder->startRecording();
         {
             ContextGraphLock g(context, "OfflineRenderApp");
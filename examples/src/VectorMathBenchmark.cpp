@@ -0,0 +1,278 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+// Times each VectorMath kernel on a render quantum, as a plain scalar loop and through the baseline
+// build (SSE2 on x86) and each wider kernel table the running CPU supports. Pass a frame count to
+// time a different size. Built by linux/Makefile.am as VectorMathBenchmark.
+
+#include "internal/VectorMath.h"
+#include "internal/VectorMathKernels.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+using namespace WebCore;
+
+// Keeps GCC from vectorizing the scalar references, so that they measure what the kernels replace.
+#if defined(__GNUC__) && !defined(__clang__)
+#define SCALAR_LOOP __attribute__((optimize("no-tree-vectorize")))
+#else
+#define SCALAR_LOOP
+#endif
+
+namespace
+{
+    const size_t MixSources = VectorMath::MixGroupSize;
+
+    struct Buffers
+    {
+        std::vector<float> a, b, c, d, decibels, dest, dest2, interleaved;
+        std::vector<std::vector<float>> sources;
+        std::vector<const float*> sourcePointers;
+        std::vector<float> gains;
+    };
+
+    volatile float sink = 0; // results that are returned rather than written, so they aren't optimized away
+
+    SCALAR_LOOP void scalarVsma(const float* s, float k, float* d, size_t n) { for (size_t i = 0; i < n; ++i) d[i] += s[i] * k; }
+    SCALAR_LOOP void scalarVsmul(const float* s, float k, float* d, size_t n) { for (size_t i = 0; i < n; ++i) d[i] = s[i] * k; }
+    SCALAR_LOOP void scalarVadd(const float* s1, const float* s2, float* d, size_t n) { for (size_t i = 0; i < n; ++i) d[i] = s1[i] + s2[i]; }
+    SCALAR_LOOP void scalarVmul(const float* s1, const float* s2, float* d, size_t n) { for (size_t i = 0; i < n; ++i) d[i] = s1[i] * s2[i]; }
+    SCALAR_LOOP void scalarVmin(const float* s1, const float* s2, float* d, size_t n) { for (size_t i = 0; i < n; ++i) d[i] = std::min(s1[i], s2[i]); }
+    SCALAR_LOOP void scalarVmax(const float* s1, const float* s2, float* d, size_t n) { for (size_t i = 0; i < n; ++i) d[i] = std::max(s1[i], s2[i]); }
+    SCALAR_LOOP void scalarVabs(const float* s, float* d, size_t n) { for (size_t i = 0; i < n; ++i) d[i] = fabsf(s[i]); }
+
+    SCALAR_LOOP void scalarZvmul(const float* r1, const float* i1, const float* r2, const float* i2, float* rd, float* id, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i) {
+            float real = r1[i] * r2[i] - i1[i] * i2[i];
+            float imag = r1[i] * i2[i] + i1[i] * r2[i];
+            rd[i] = real;
+            id[i] = imag;
+        }
+    }
+
+    SCALAR_LOOP float scalarVsvesq(const float* s, size_t n)
+    {
+        float sum = 0;
+        for (size_t i = 0; i < n; ++i)
+            sum += s[i] * s[i];
+        return sum;
+    }
+
+    SCALAR_LOOP float scalarVmaxmgv(const float* s, size_t n)
+    {
+        float max = 0;
+        for (size_t i = 0; i < n; ++i)
+            max = std::max(max, fabsf(s[i]));
+        return max;
+    }
+
+    SCALAR_LOOP void scalarVclip(const float* s, float low, float high, float* d, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i)
+            d[i] = std::max(low, std::min(high, s[i]));
+    }
+
+    SCALAR_LOOP void scalarVintlve(const float* r, const float* im, float* d, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i) {
+            d[2 * i] = r[i];
+            d[2 * i + 1] = im[i];
+        }
+    }
+
+    SCALAR_LOOP void scalarVdeintlve(const float* s, float* r, float* im, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i) {
+            r[i] = s[2 * i];
+            im[i] = s[2 * i + 1];
+        }
+    }
+
+    SCALAR_LOOP void scalarVrampmul(const float* s, float gain, float step, float* d, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i) {
+            d[i] = s[i] * gain;
+            gain += step;
+        }
+    }
+
+    SCALAR_LOOP void scalarVrampmuladd(const float* s, float gain, float step, float* d, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i) {
+            d[i] += s[i] * gain;
+            gain += step;
+        }
+    }
+
+    SCALAR_LOOP void scalarVcrossfade(const float* from, const float* to, float mix, float step, float* d, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i) {
+            d[i] = from[i] + (to[i] - from[i]) * mix;
+            mix += step;
+        }
+    }
+
+    SCALAR_LOOP void scalarVlin2db(const float* s, float* d, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i)
+            d[i] = s[i] ? 20 * log10f(fabsf(s[i])) : VectorMath::SilentDecibels;
+    }
+
+    SCALAR_LOOP void scalarVdb2lin(const float* s, float* d, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i)
+            d[i] = powf(10, s[i] / 20);
+    }
+
+    SCALAR_LOOP void scalarZvmag(const float* r, const float* im, float scale, float* d, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i)
+            d[i] = scale * sqrtf(r[i] * r[i] + im[i] * im[i]);
+    }
+
+    SCALAR_LOOP void scalarVmix(const float* const* sources, const float* gains, size_t count, float* d, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i) {
+            float sum = 0;
+            for (size_t k = 0; k < count; ++k)
+                sum += sources[k][i] * gains[k];
+            d[i] = sum;
+        }
+    }
+
+    struct Kernel
+    {
+        const char* name;
+        std::function<void()> scalar;
+        std::function<void()> vector; // through the VectorMath entry point, so it runs whichever table is set
+    };
+
+    std::vector<Kernel> makeKernels(Buffers& b, size_t n)
+    {
+        float* A = b.a.data();
+        float* B = b.b.data();
+        float* C = b.c.data();
+        float* D = b.d.data();
+        float* dB = b.decibels.data();
+        float* dest = b.dest.data();
+        float* dest2 = b.dest2.data();
+        float* interleaved = b.interleaved.data();
+        const float* const* sources = b.sourcePointers.data();
+        const float* gains = b.gains.data();
+
+        static const float scale = 0.7f;
+        static const float low = -0.5f;
+        static const float high = 0.5f;
+        static const float step = 1.0f / 4096;
+
+        std::vector<Kernel> kernels;
+        kernels.push_back({ "vsma", [=] { scalarVsma(A, scale, dest, n); }, [=] { VectorMath::vsma(A, 1, &scale, dest, 1, n); } });
+        kernels.push_back({ "vsmul", [=] { scalarVsmul(A, scale, dest, n); }, [=] { VectorMath::vsmul(A, 1, &scale, dest, 1, n); } });
+        kernels.push_back({ "vadd", [=] { scalarVadd(A, B, dest, n); }, [=] { VectorMath::vadd(A, 1, B, 1, dest, 1, n); } });
+        kernels.push_back({ "vmul", [=] { scalarVmul(A, B, dest, n); }, [=] { VectorMath::vmul(A, 1, B, 1, dest, 1, n); } });
+        kernels.push_back({ "zvmul", [=] { scalarZvmul(A, B, C, D, dest, dest2, n); }, [=] { VectorMath::zvmul(A, B, C, D, dest, dest2, n); } });
+        kernels.push_back({ "vsvesq", [=] { sink = scalarVsvesq(A, n); }, [=] { float sum; VectorMath::vsvesq(A, 1, &sum, n); sink = sum; } });
+        kernels.push_back({ "vmaxmgv", [=] { sink = scalarVmaxmgv(A, n); }, [=] { float max; VectorMath::vmaxmgv(A, 1, &max, n); sink = max; } });
+        kernels.push_back({ "vclip", [=] { scalarVclip(A, low, high, dest, n); }, [=] { VectorMath::vclip(A, 1, &low, &high, dest, 1, n); } });
+        kernels.push_back({ "vintlve", [=] { scalarVintlve(A, B, interleaved, n); }, [=] { VectorMath::vintlve(A, B, interleaved, n); } });
+        kernels.push_back({ "vdeintlve", [=] { scalarVdeintlve(interleaved, dest, dest2, n); }, [=] { VectorMath::vdeintlve(interleaved, dest, dest2, n); } });
+        kernels.push_back({ "vrampmul", [=] { scalarVrampmul(A, 0.5f, step, dest, n); }, [=] { float gain = 0.5f; VectorMath::vrampmul(A, &gain, &step, dest, n); } });
+        kernels.push_back({ "vrampmuladd", [=] { scalarVrampmuladd(A, 0.5f, step, dest, n); }, [=] { float gain = 0.5f; VectorMath::vrampmuladd(A, &gain, &step, dest, n); } });
+        kernels.push_back({ "vcrossfade", [=] { scalarVcrossfade(A, B, 0.25f, step, dest, n); }, [=] { float mix = 0.25f; VectorMath::vcrossfade(A, B, &mix, &step, dest, n); } });
+        kernels.push_back({ "vmin", [=] { scalarVmin(A, B, dest, n); }, [=] { VectorMath::vmin(A, B, dest, n); } });
+        kernels.push_back({ "vmax", [=] { scalarVmax(A, B, dest, n); }, [=] { VectorMath::vmax(A, B, dest, n); } });
+        kernels.push_back({ "vabs", [=] { scalarVabs(A, dest, n); }, [=] { VectorMath::vabs(A, dest, n); } });
+        kernels.push_back({ "vlin2db", [=] { scalarVlin2db(A, dest, n); }, [=] { VectorMath::vlin2db(A, dest, n); } });
+        kernels.push_back({ "vdb2lin", [=] { scalarVdb2lin(dB, dest, n); }, [=] { VectorMath::vdb2lin(dB, dest, n); } });
+        kernels.push_back({ "zvmag", [=] { scalarZvmag(A, B, scale, dest, n); }, [=] { VectorMath::zvmag(A, B, &scale, dest, n); } });
+        kernels.push_back({ "vmix", [=] { scalarVmix(sources, gains, MixSources, dest, n); }, [=] { VectorMath::vmix(sources, gains, MixSources, dest, false, n); } });
+        return kernels;
+    }
+
+    // Nanoseconds per call, the best of several runs so that a stray interruption doesn't count.
+    double timeKernel(const std::function<void()>& kernel, size_t frames)
+    {
+        const size_t calls = std::max<size_t>(1000, (1 << 24) / std::max<size_t>(frames, 1));
+        const int runs = 5;
+
+        for (size_t i = 0; i < calls / 10; ++i)
+            kernel();
+
+        double best = 1e30;
+        for (int run = 0; run < runs; ++run) {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (size_t i = 0; i < calls; ++i)
+                kernel();
+            auto end = std::chrono::high_resolution_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count() / calls);
+        }
+        return best;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t frames = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : 128;
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> signal(-1, 1);
+    std::uniform_real_distribution<float> level(-60, 0);
+
+    Buffers b;
+    for (auto* v : { &b.a, &b.b, &b.c, &b.d }) {
+        v->resize(frames);
+        for (auto& x : *v)
+            x = signal(random);
+    }
+    b.decibels.resize(frames);
+    for (auto& x : b.decibels)
+        x = level(random);
+    b.dest.resize(frames);
+    b.dest2.resize(frames);
+    b.interleaved.resize(2 * frames);
+    b.sources.assign(MixSources, b.a);
+    for (auto& source : b.sources)
+        b.sourcePointers.push_back(source.data());
+    b.gains.assign(MixSources, 1.0f / MixSources);
+
+    // The columns: scalar loops, then the entry points with no table, then each table the CPU has.
+    std::vector<const VectorMath::VectorKernels*> tables;
+    tables.push_back(nullptr);
+    if (const VectorMath::VectorKernels* kernels = VectorMath::avx2Kernels())
+        tables.push_back(kernels);
+    if (const VectorMath::VectorKernels* kernels = VectorMath::avx512Kernels())
+        tables.push_back(kernels);
+
+    const VectorMath::VectorKernels* selected = VectorMath::selectX86Kernels();
+
+    VectorMath::setKernels(nullptr);
+    std::string baselineName = VectorMath::kernelName();
+
+    printf("VectorMath kernels, %d frames, ns per call\n\n", static_cast<int>(frames));
+    printf("%-12s %10s", "kernel", "scalar");
+    for (auto table : tables)
+        printf(" %10s", table ? table->name : baselineName.c_str());
+    printf("\n");
+
+    for (auto& kernel : makeKernels(b, frames)) {
+        printf("%-12s %10.1f", kernel.name, timeKernel(kernel.scalar, frames));
+        for (auto table : tables) {
+            VectorMath::setKernels(table);
+            printf(" %10.1f", timeKernel(kernel.vector, frames));
+        }
+        printf("\n");
+    }
+
+    VectorMath::setKernels(selected);
+    printf("\nThe library dispatches to %s on this CPU.\n", VectorMath::kernelName());
+    return 0;
+}
@@ -33,8 +33,37 @@
 #include <string.h>
 #include <stdint.h>
 
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
 namespace WebCore {
 
+    // Audio buffers are aligned to a cache line, which also satisfies the 16 and 32 byte
+    // requirements of SSE and AVX loads.
+    const size_t AudioArrayAlignment = 64;
+
+    inline void* alignedMalloc(size_t size, size_t alignment)
+    {
+#if defined(_MSC_VER)
+        return _aligned_malloc(size ? size : alignment, alignment);
+#else
+        void* allocation = 0;
+        if (posix_memalign(&allocation, alignment, size ? size : alignment))
+            return 0;
+        return allocation;
+#endif
+    }
+
+    inline void alignedFree(void* allocation)
+    {
+#if defined(_MSC_VER)
+        _aligned_free(allocation);
+#else
+        free(allocation);
+#endif
+    }
+
     template<typename T>
     class AudioArray {
     public:
@@ -46,44 +75,25 @@ namespace WebCore {
 
         ~AudioArray()
         {
-            free(m_allocation);
+            alignedFree(m_allocation);
         }
 
         // It's OK to call allocate() multiple times, but data will *not* be copied from an initial allocation
         // if re-allocated. Allocations are zero-initialized.
         void allocate(size_t n)
         {
-            size_t initialSize = sizeof(T) * n;
-            
-            const size_t alignment = 16;
-            
             if (m_allocation)
-                free(m_allocation);
-
-            bool isAllocationGood = false;
-
-            while (!isAllocationGood) {
-                // Initially we try to allocate the exact size, but if it's not aligned
-                // then we'll have to reallocate and from then on allocate extra.
-                static size_t extraAllocationBytes = 0;
-
-                T* allocation = static_cast<T*>(malloc(initialSize + extraAllocationBytes));
-                if (!allocation) {
-                    //CRASH();
-                }
-                T* alignedData = alignedAddress(allocation, alignment);
-
-                if (alignedData == allocation || extraAllocationBytes == alignment) {
-                    m_allocation = allocation;
-                    m_alignedData = alignedData;
-                    m_size = n;
-                    isAllocationGood = true;
-                    zero();
-                } else {
-                    extraAllocationBytes = alignment; // always allocate extra after the first alignment failure.
-                    free(allocation);
-                }
+                alignedFree(m_allocation);
+
+            m_allocation = static_cast<T*>(alignedMalloc(sizeof(T) * n, AudioArrayAlignment));
+            if (!m_allocation) {
+                //CRASH();
+                n = 0;
             }
+
+            m_alignedData = m_allocation;
+            m_size = n;
+            zero();
         }
 
         T* data() { return m_alignedData; }
@@ -128,12 +138,6 @@ namespace WebCore {
         }
         
     private:
-        static T* alignedAddress(T* address, intptr_t alignment)
-        {
-            intptr_t value = reinterpret_cast<intptr_t>(address);
-            return reinterpret_cast<T*>((value + alignment - 1) & ~(alignment - 1));
-        }
-        
         T* m_allocation;
         T* m_alignedData;
         size_t m_size;
@@ -29,6 +29,7 @@
 #include "LabSound/core/AudioParam.h"
 #include "LabSound/core/AudioScheduledSourceNode.h"
 #include "LabSound/core/PannerNode.h"
+#include "LabSound/core/Synthesis.h"
 
 #include <memory>
 
@@ -84,6 +85,10 @@ public:
     std::shared_ptr<AudioParam> gain() { return m_gain; }
     std::shared_ptr<AudioParam> playbackRate() { return m_playbackRate; }
 
+    // How the buffer is read when it doesn't play back at exactly its own rate. Defaults to linear.
+    InterpolationMode interpolationMode() const { return m_interpolationMode; }
+    void setInterpolationMode(InterpolationMode);
+
     // If a panner node is set, then we can incorporate doppler shift into the playback pitch rate.
     void setPannerNode(PannerNode*);
     virtual void clearPannerNode() override;
@@ -140,6 +145,8 @@ private:
     // m_lastGain provides continuity when we dynamically adjust the gain.
     float m_lastGain;
 
+    InterpolationMode m_interpolationMode;
+
     // We optionally keep track of a panner node which has a doppler shift that is incorporated into
     // the pitch rate. We manually manage ref-counting because we want to use RefTypeConnection.
     PannerNode* m_pannerNode;
@@ -31,6 +31,7 @@ namespace WebCore
 {
 
 class AudioBuffer;
+class AudioBufferPool;
 class AudioDestinationNode;
 class AudioListener;
 class AudioNode;
@@ -106,6 +107,9 @@ public:
 
 	AudioListener * listener();
 
+	// Arena for render quantum sized buses. Only to be used while holding the render lock.
+	std::shared_ptr<AudioBufferPool> bufferPool() { return m_bufferPool; }
+
 	unsigned long activeSourceCount() const;
 
 	void incrementActiveSourceCount();
@@ -183,6 +187,7 @@ private:
 	std::shared_ptr<AudioDestinationNode> m_destinationNode;
 	std::shared_ptr<AudioListener> m_listener;
 	std::shared_ptr<HRTFDatabaseLoader> m_hrtfDatabaseLoader;
+	std::shared_ptr<AudioBufferPool> m_bufferPool;
 	std::shared_ptr<AudioBuffer> m_renderTarget;
 
 	std::vector<std::shared_ptr<AudioNode>> m_referencedNodes;
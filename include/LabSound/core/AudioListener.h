@@ -31,6 +31,8 @@
 
 #include "LabSound/core/FloatPoint3D.h"
 
+#include <atomic>
+
 namespace WebCore 
 {
 
@@ -41,12 +43,12 @@ public:
 
     AudioListener()
 	{
-
+        updateBasis();
 	}
 
     // Position
     void setPosition(float x, float y, float z) { setPosition(FloatPoint3D(x, y, z)); }
-    void setPosition(const FloatPoint3D &position) { m_position = position; }
+    void setPosition(const FloatPoint3D &position) { m_position = position; changed(); }
     const FloatPoint3D & position() const { return m_position; }
 
     // Orientation
@@ -55,28 +57,51 @@ public:
         setOrientation(FloatPoint3D(x, y, z));
         setUpVector(FloatPoint3D(upX, upY, upZ));
     }
-    void setOrientation(const FloatPoint3D &orientation) { m_orientation = orientation; }
+    void setOrientation(const FloatPoint3D &orientation) { m_orientation = orientation; updateBasis(); changed(); }
     const FloatPoint3D& orientation() const { return m_orientation; }
 
     // Up-vector
-    void setUpVector(const FloatPoint3D &upVector) { m_upVector = upVector; }
+    void setUpVector(const FloatPoint3D &upVector) { m_upVector = upVector; updateBasis(); changed(); }
     const FloatPoint3D& upVector() const { return m_upVector; }
 
+    // The listener's orthonormal basis, derived from the orientation and up vector when they are set, so
+    // that panners don't each derive it again.
+    const FloatPoint3D& frontBasis() const { return m_frontBasis; }
+    const FloatPoint3D& rightBasis() const { return m_rightBasis; }
+    const FloatPoint3D& upBasis() const { return m_upBasis; }
+
     // Velocity
     void setVelocity(float x, float y, float z) { setVelocity(FloatPoint3D(x, y, z)); }
-    void setVelocity(const FloatPoint3D &velocity) { m_velocity = velocity; }
+    void setVelocity(const FloatPoint3D &velocity) { m_velocity = velocity; changed(); }
     const FloatPoint3D& velocity() const { return m_velocity; }
 
     // Doppler factor
-    void setDopplerFactor(double dopplerFactor) { m_dopplerFactor = dopplerFactor; }
+    void setDopplerFactor(double dopplerFactor) { m_dopplerFactor = dopplerFactor; changed(); }
     double dopplerFactor() const { return m_dopplerFactor; }
 
     // Speed of sound
-    void setSpeedOfSound(double speedOfSound) { m_speedOfSound = speedOfSound; }
+    void setSpeedOfSound(double speedOfSound) { m_speedOfSound = speedOfSound; changed(); }
     double speedOfSound() const { return m_speedOfSound; }
 
+    // Incremented by every setter. Panners compare it with the version their cached azimuth, elevation
+    // and gains were computed at, and only compute them again when the listener has changed.
+    unsigned version() const { return m_version; }
+
 private:
 
+    void changed() { ++m_version; }
+
+    void updateBasis()
+    {
+        m_rightBasis = m_orientation.cross(m_upVector);
+        m_rightBasis.normalize();
+
+        m_frontBasis = m_orientation;
+        m_frontBasis.normalize();
+
+        m_upBasis = m_rightBasis.cross(m_frontBasis);
+    }
+
     // Position / Orientation
 	FloatPoint3D m_position = {0, 0, 0};
 	FloatPoint3D m_orientation {0, 0, -1};
@@ -86,6 +111,12 @@ private:
 
     double m_dopplerFactor = 1.0;
     double m_speedOfSound = 343.3;
+
+    FloatPoint3D m_frontBasis;
+    FloatPoint3D m_rightBasis;
+    FloatPoint3D m_upBasis;
+
+    std::atomic<unsigned> m_version {0};
 };
 
 } // WebCore
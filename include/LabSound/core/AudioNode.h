@@ -83,6 +83,14 @@ namespace LabSound
         NodeTypeSpectralMonitor,
         NodeTypeSupersaw,
 		NodeTypeSTK, 
+        NodeTypeOscillatorBank,
+        NodeTypeSampledInstrument,
+        NodeTypeTap,
+        NodeTypeSTFT,
+        NodeTypeStreamingSource,
+        NodeTypeMultiTapDelay,
+        NodeTypeFDNReverb,
+        NodeTypeMultibandCompressor,
 
         // enumeration terminator
         NodeTypeEnd,
@@ -29,6 +29,7 @@
 #include "LabSound/core/AudioSummingJunction.h"
 
 #include <set>
+#include <vector>
 
 namespace WebCore {
 
@@ -67,6 +68,11 @@ public:
     // bus() contains the rendered audio after pull() has been called for each time quantum.
     AudioBus* bus(ContextRenderLock&);
     
+    // The summing bus only holds memory between pull() and the end of the owning node's processing, after which
+    // its blocks go back to the context's buffer pool for the next node to use. Reading bus() after the release
+    // yields silence. Called from context's audio thread.
+    void releaseSummingBus();
+
     // updateInternalBus() updates m_internalSummingBus appropriately for the number of channels.
     // This must be called when we own the context's graph lock in the audio thread at the very start or end of the render quantum.
     void updateInternalBus(ContextRenderLock&);
@@ -84,6 +90,10 @@ private:
     void sumAllConnections(ContextRenderLock&, AudioBus* summingBus, size_t framesToProcess);
 
     std::unique_ptr<AudioBus> m_internalSummingBus;
+
+    // Scratch space for sumAllConnections(), kept between render quanta so that summing doesn't allocate.
+    std::vector<AudioBus*> m_connectionBuses;
+    std::vector<const float*> m_channelSources;
 };
 
 } // namespace WebCore
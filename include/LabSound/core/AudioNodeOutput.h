@@ -104,8 +104,8 @@ private:
     unsigned paramFanOutCount();
 
     // updateInternalBus() updates m_internalBus appropriately for the number of channels.
-    // It is called in the constructor or in the audio thread with the context's graph lock.
-    void updateInternalBus();
+    // It is called in the audio thread with the context's render lock, and moves the bus into the context's buffer pool.
+    void updateInternalBus(ContextRenderLock&);
 
     // Announce to any nodes we're connected to that we changed our channel count for its input.
     void propagateChannelCount(ContextRenderLock&);
@@ -41,12 +41,25 @@ enum DelayValues
 	D_8T = 4
 };
 
+// How a delay that isn't a whole number of frames is read. LINEAR is the cheapest. ALLPASS has a flat
+// frequency response, so it doesn't dull the highs of a short fractional delay, but it is recursive and
+// smears quick changes of delay. CUBIC fits a Catmull-Rom spline through four frames.
+enum class DelayInterpolation
+{
+    LINEAR = 0,
+    ALLPASS = 1,
+    CUBIC = 2
+};
+
 class DelayNode : public AudioBasicProcessorNode {
 
 public:
     DelayNode(float sampleRate, double maxDelayTime);
     std::shared_ptr<AudioParam> delayTime();
 
+    void setInterpolation(DelayInterpolation);
+    DelayInterpolation interpolation();
+
 private:
     DelayProcessor * delayProcessor();
 };
@@ -37,7 +37,8 @@ class DynamicsCompressorNode : public AudioNode
     
 public:
     
-    DynamicsCompressorNode(float sampleRate);
+    // The lookahead of preDelay() can be set up to maxPreDelayTime seconds.
+    DynamicsCompressorNode(float sampleRate, float maxPreDelayTime = 0.1f);
     virtual ~DynamicsCompressorNode();
 
     // AudioNode
@@ -53,6 +54,9 @@ public:
     std::shared_ptr<AudioParam> attack() { return m_attack; }
     std::shared_ptr<AudioParam> release() { return m_release; }
 
+    // Lookahead in seconds. The signal is delayed by this much, so that the gain reduction can anticipate its peaks.
+    std::shared_ptr<AudioParam> preDelay() { return m_preDelay; }
+
     // Amount by which the compressor is currently compressing the signal in decibels.
     std::shared_ptr<AudioParam> reduction() { return m_reduction; }
 
@@ -67,6 +71,8 @@ private:
     std::shared_ptr<AudioParam> m_reduction;
     std::shared_ptr<AudioParam> m_attack;
     std::shared_ptr<AudioParam> m_release;
+    std::shared_ptr<AudioParam> m_preDelay;
+    float m_maxPreDelayTime;
 };
 
 } // namespace WebCore
@@ -52,13 +52,6 @@ public:
         y = y_;
     }
 
-    FloatPoint3D& operator-(const FloatPoint3D& rhs) {
-        x -= rhs.x;
-        y -= rhs.y;
-        z -= rhs.z;
-        return *this;
-    }
-
     float distanceTo(const FloatPoint3D& rhs) const
     {
         return (*this - rhs).length();
@@ -0,0 +1,108 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+
+namespace LabSound
+{
+
+// A bounded queue that never locks or allocates once constructed, so the audio thread can
+// pop from it while any number of other threads push. Each slot carries a sequence number
+// saying whether it is ready to be written or read; a push or pop claims a slot by advancing
+// the shared position with a compare and swap. The capacity is rounded up to a power of two.
+template<typename Data>
+class LockFreeQueue
+{
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        Data data;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask;
+    std::atomic<size_t> m_pushPosition;
+    std::atomic<size_t> m_popPosition;
+
+public:
+    explicit LockFreeQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+
+        m_cells.reset(new Cell[size]);
+        m_mask = size - 1;
+        for (size_t i = 0; i < size; ++i)
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+
+        m_pushPosition.store(0, std::memory_order_relaxed);
+        m_popPosition.store(0, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const { return m_mask + 1; }
+
+    // Returns false, dropping the data, if the queue is full.
+    bool tryPush(Data const& data)
+    {
+        size_t position = m_pushPosition.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell& cell = m_cells[position & m_mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            ptrdiff_t difference = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(position);
+
+            if (difference == 0)
+            {
+                if (m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    cell.data = data;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+                return false;
+            else
+                position = m_pushPosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    bool tryPop(Data& poppedValue)
+    {
+        size_t position = m_popPosition.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell& cell = m_cells[position & m_mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            ptrdiff_t difference = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(position + 1);
+
+            if (difference == 0)
+            {
+                if (m_popPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    poppedValue = cell.data;
+                    cell.sequence.store(position + m_mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+                return false;
+            else
+                position = m_popPosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    // A snapshot; other threads may have pushed or popped by the time it returns.
+    bool empty() const
+    {
+        return m_popPosition.load(std::memory_order_acquire) == m_pushPosition.load(std::memory_order_acquire);
+    }
+};
+
+}
@@ -85,12 +85,6 @@ private:
     AudioFloatArray m_detuneValues;
     
     std::shared_ptr<WaveTable> m_waveTable;
-
-    // Cache the wave tables for different waveform types, except CUSTOM.
-    static std::shared_ptr<WaveTable> s_waveTableSine;
-    static std::shared_ptr<WaveTable> s_waveTableSquare;
-    static std::shared_ptr<WaveTable> s_waveTableSawtooth;
-    static std::shared_ptr<WaveTable> s_waveTableTriangle;
 };
 
 } // namespace WebCore
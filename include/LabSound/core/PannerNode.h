@@ -30,6 +30,8 @@
 #include "LabSound/core/AudioParam.h"
 #include "LabSound/core/FloatPoint3D.h"
 
+#include <atomic>
+
 namespace WebCore {
 
 // PannerNode is an AudioNode with one input and one output.
@@ -75,15 +77,15 @@ public:
 
     // Position
     FloatPoint3D position() const { return m_position; }
-    void setPosition(float x, float y, float z) { m_position = FloatPoint3D(x, y, z); }
+    void setPosition(float x, float y, float z) { m_position = FloatPoint3D(x, y, z); ++m_version; }
 
     // Orientation
-    FloatPoint3D orientation() const { return m_position; }
-    void setOrientation(float x, float y, float z) { m_orientation = FloatPoint3D(x, y, z); }
+    FloatPoint3D orientation() const { return m_orientation; }
+    void setOrientation(float x, float y, float z) { m_orientation = FloatPoint3D(x, y, z); ++m_version; }
 
     // Velocity
     FloatPoint3D velocity() const { return m_velocity; }
-    void setVelocity(float x, float y, float z) { m_velocity = FloatPoint3D(x, y, z); }
+    void setVelocity(float x, float y, float z) { m_velocity = FloatPoint3D(x, y, z); ++m_version; }
 
     // Distance parameters
     unsigned short distanceModel();
@@ -111,6 +113,24 @@ public:
     void getAzimuthElevation(ContextRenderLock& r, double* outAzimuth, double* outElevation);
     float dopplerRate(ContextRenderLock& r);
 
+    // A virtualized panner fades out and, once silent, skips panning altogether until it is made real
+    // again, when it fades back in. It still pulls its input, so the sources feeding it keep their place.
+    void setVirtualized(bool virtualized) { m_virtualized = virtualized; }
+    bool isVirtualized() const { return m_virtualized; }
+
+    // The gain the panner applies for distance, cone and, for a SpatializationNode, occlusion. It estimates
+    // how audible the panner is, for ranking voices.
+    float attenuation(ContextRenderLock& r) { return distanceConeGain(r); }
+
+    // Incremented by every setter that changes the panner's geometry or its distance and cone parameters.
+    unsigned geometryVersion() const { return m_version; }
+
+    // Supplies the panner's azimuth, elevation, gains and doppler rate, computed elsewhere from its geometry
+    // at version and the listener's at listenerVersion, as a SpatialScene computes them for many panners at
+    // once. They stand in for the panner's own computation until either the panner or the listener changes.
+    void setComputedGeometry(unsigned version, unsigned listenerVersion, double azimuth, double elevation,
+                             float distanceGain, float coneGain, float dopplerRate);
+
     // Accessors for dynamically calculated gain values.
     std::shared_ptr<AudioParam> distanceGain() { return m_distanceGain; }
     std::shared_ptr<AudioParam> coneGain() { return m_coneGain; }
@@ -120,6 +140,9 @@ public:
 
 protected:
 
+    // The geometry behind getAzimuthElevation, which caches its result.
+    void computeAzimuthElevation(AudioListener*, double* outAzimuth, double* outElevation);
+
     // Returns the combined distance and cone gain attenuation.
     virtual float distanceConeGain(ContextRenderLock& r);   /// @LabSound virtual
 
@@ -144,6 +167,33 @@ protected:
 
     float m_lastGain = -1.0f;
     unsigned m_connectionCount = 0;
+
+    std::atomic<bool> m_virtualized {false};
+    bool m_isSilent = false;    // virtualized and faded out
+
+    // Incremented by every setter. The azimuth and elevation, the distance and cone gain and the doppler
+    // rate are cached along with this version and the listener's version they were computed at, and are
+    // only computed again once either has changed, so a panner that is standing still costs no geometry.
+    struct GeometryCache
+    {
+        unsigned version = ~0u;
+        unsigned listenerVersion = ~0u;
+
+        bool isCurrent(unsigned v, unsigned lv) const { return version == v && listenerVersion == lv; }
+        void update(unsigned v, unsigned lv) { version = v; listenerVersion = lv; }
+    };
+
+    std::atomic<unsigned> m_version {0};
+
+    GeometryCache m_azimuthElevationCache;
+    double m_cachedAzimuth = 0.0;
+    double m_cachedElevation = 0.0;
+
+    GeometryCache m_distanceConeGainCache;
+    float m_cachedDistanceConeGain = 1.0f;
+
+    GeometryCache m_dopplerRateCache;
+    float m_cachedDopplerRate = 1.0f;
 };
 
 } // namespace WebCore
@@ -16,6 +16,16 @@ namespace LabSound
         TRIANGLE = 3,
         CUSTOM = 4
     };
+
+    // How a sampled sound is read between its frames when it plays at another rate than it was recorded at.
+    // LINEAR is the cheapest. CUBIC fits a Catmull-Rom spline through four frames, and SINC applies a
+    // 16 tap windowed sinc, which is the most faithful and the most expensive.
+    enum class InterpolationMode
+    {
+        LINEAR = 0,
+        CUBIC = 1,
+        SINC = 2
+    };
 }
 
 #endif
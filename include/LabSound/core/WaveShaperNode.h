@@ -31,6 +31,17 @@ namespace WebCore
 {
    class WaveShaperProcessor;
 
+// How many times over the curve is applied at a higher sample rate. Shaping adds harmonics, and those above
+// the Nyquist frequency alias back down; oversampling moves the Nyquist frequency up for the curve alone,
+// and filters the harmonics away before returning to the context's rate. TWO_X delays the signal by 64
+// frames, FOUR_X by 72.
+enum class OverSampleType
+{
+    NONE = 0,
+    TWO_X = 1,
+    FOUR_X = 2
+};
+
 class WaveShaperNode : public AudioBasicProcessorNode
 {
    
@@ -43,6 +54,9 @@ public:
 
     void setCurve(ContextRenderLock&, std::shared_ptr<std::vector<float>>);
     std::shared_ptr<std::vector<float>> curve();
+
+    void setOversample(ContextRenderLock&, OverSampleType);
+    OverSampleType oversample();
 };
 
 } // namespace WebCore
@@ -44,10 +44,18 @@ class WaveTable
 public:
 
 	WaveTable(float sampleRate, OscillatorType basicWaveform);
-	WaveTable(float sampleRate, OscillatorType basicWaveform, std::vector<float> & real, std::vector<float> & imag);
+	WaveTable(float sampleRate, OscillatorType basicWaveform, const std::vector<float> & real, const std::vector<float> & imag);
 
 	~WaveTable();
 
+    // Wavetables never change once built, so oscillators playing the same waveform at the same sample rate
+    // can share one. These return the shared tables for a basic waveform or for a custom spectrum, building
+    // them on first use. Building takes an inverse FFT per pitch range and is done on the calling thread
+    // outside of the cache's lock, so call these from the main thread rather than while rendering.
+    // Basic waveforms are kept for the life of the process; custom spectra only while something holds them.
+    static std::shared_ptr<WaveTable> create(float sampleRate, OscillatorType basicWaveform);
+    static std::shared_ptr<WaveTable> create(float sampleRate, const std::vector<float> & real, const std::vector<float> & imag);
+
     // Returns pointers to the lower and higher wavetable data for the pitch range containing
     // the given fundamental frequency. These two tables are in adjacent "pitch" ranges
     // where the higher table will have the maximum number of partials which won't alias when played back
@@ -0,0 +1,84 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifndef LabSound_AudioTap_h
+#define LabSound_AudioTap_h
+
+#include "LabSound/core/AudioBasicInspectorNode.h"
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+
+namespace WebCore
+{
+    class AudioBus;
+    class AudioRingBuffer;
+}
+
+namespace LabSound
+{
+    // An AudioTap hands a copy of a signal from the render thread to one reader on another thread.
+    // The render thread's side is wait free: a render quantum is mixed to the tap's channel count if
+    // need be and copied into a ring buffer allocated by the constructor. If the reader has fallen so far
+    // behind that a quantum doesn't fit, the quantum is dropped and counted instead.
+    //
+    // All analysis of the signal happens on the reader's thread, so any number of taps cost the render
+    // thread no more than a copy each. A reader that stops reading for a while will next read frames up
+    // to the tap's capacity old, and fresh ones from then on.
+    class AudioTap
+    {
+        AudioTap(const AudioTap&); // noncopyable
+
+    public:
+
+        AudioTap(unsigned numberOfChannels, size_t capacityInFrames);
+        ~AudioTap();
+
+        unsigned numberOfChannels() const;
+        size_t capacity() const;
+
+        // Render thread only.
+        void write(const WebCore::AudioBus& bus, size_t framesToProcess);
+
+        // Reader thread only. Read up to framesToRead frames, one destination per channel or interleaved,
+        // and return the number of frames read.
+        size_t framesAvailable() const;
+        size_t read(float* const* destinations, size_t framesToRead);
+        size_t readInterleaved(float* destination, size_t framesToRead);
+
+        // Frames lost because the reader fell behind.
+        uint64_t droppedFrames() const { return m_droppedFrames; }
+
+    private:
+
+        std::unique_ptr<WebCore::AudioRingBuffer> m_ring;
+        std::unique_ptr<WebCore::AudioBus> m_mixBus;
+        std::atomic<uint64_t> m_droppedFrames;
+    };
+
+    // A pass through node that copies its input into an AudioTap, for meters, scopes and analyzers that
+    // run on another thread. Like the other inspector nodes it is pulled even if its output isn't connected.
+    class TapNode : public WebCore::AudioBasicInspectorNode
+    {
+
+    public:
+
+        TapNode(float sampleRate, unsigned numberOfChannels = 2, float capacitySeconds = 1.0f);
+        virtual ~TapNode();
+
+        virtual void process(ContextRenderLock&, size_t framesToProcess) override;
+        virtual void reset(ContextRenderLock&) override { }
+
+        std::shared_ptr<AudioTap> tap() const { return m_tap; }
+
+    private:
+
+        virtual double tailTime() const override { return 0; }
+        virtual double latencyTime() const override { return 0; }
+
+        std::shared_ptr<AudioTap> m_tap;
+    };
+}
+
+#endif
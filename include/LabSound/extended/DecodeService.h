@@ -0,0 +1,91 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifndef LabSound_DecodeService_h
+#define LabSound_DecodeService_h
+
+#include "LabSound/core/AudioBuffer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace LabSound
+{
+    struct DecodeProgress
+    {
+        size_t requested;   // loads requested since the service started
+        size_t completed;   // loads finished, including those that failed
+        size_t failed;
+    };
+
+    // Decodes audio files on a pool of worker threads, each with a decoder of its own, so loading a bank
+    // of sounds scales with the number of cores. Every load returns a future for the decoded buffer; if
+    // a file can't be decoded, the future's get() rethrows the decoder's std::runtime_error.
+    //
+    // Loads are started in the order they are requested. Destroying the service waits for the loads in
+    // progress and abandons the rest, whose futures then throw std::future_error (broken_promise).
+    class DecodeService
+    {
+        DecodeService(const DecodeService&); // noncopyable
+
+    public:
+
+        typedef std::shared_ptr<WebCore::AudioBuffer> Result;
+
+        // Zero threads means one per hardware thread.
+        explicit DecodeService(unsigned numberOfThreads = 0);
+        ~DecodeService();
+
+        unsigned numberOfThreads() const { return static_cast<unsigned>(m_workers.size()); }
+
+        std::future<Result> load(const std::string & path, bool mixToMono, float sampleRate);
+        std::future<Result> load(std::vector<uint8_t> buffer, const std::string & extension, bool mixToMono, float sampleRate);
+
+        // The futures are in the same order as the paths.
+        std::vector<std::future<Result>> loadMany(const std::vector<std::string> & paths, bool mixToMono, float sampleRate);
+
+        DecodeProgress progress() const;
+
+        // Called on a worker thread each time a load finishes, successfully or not. Keep it short; the
+        // worker doesn't start its next load until the callback returns.
+        void setProgressCallback(std::function<void(const DecodeProgress &)> callback);
+
+        // Blocks until every load requested so far has finished. The callbacks for the last of them may
+        // still be running when it returns.
+        void wait();
+
+    private:
+
+        struct Job;
+
+        void enqueue(std::unique_ptr<Job> job);
+        void workerThread();
+
+        std::vector<std::thread> m_workers;
+
+        std::mutex m_queueMutex;                    // held only to queue and dequeue, never while decoding
+        std::condition_variable m_queueCondition;
+        std::condition_variable m_idleCondition;
+        std::deque<std::unique_ptr<Job>> m_queue;
+        bool m_stopping;
+
+        std::atomic<size_t> m_requested;
+        std::atomic<size_t> m_completed;
+        std::atomic<size_t> m_failed;
+
+        std::mutex m_callbackMutex;
+        std::function<void(const DecodeProgress &)> m_progressCallback;
+    };
+
+} // end namespace LabSound
+
+#endif
@@ -0,0 +1,55 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifndef FDNReverbNode_h
+#define FDNReverbNode_h
+
+#include "LabSound/core/AudioBasicProcessorNode.h"
+#include "LabSound/core/AudioParam.h"
+
+namespace LabSound
+{
+    // How the delay lines' outputs are mixed before they are fed back. Both matrices are orthogonal, so
+    // the mixing neither adds nor loses energy. HADAMARD spreads every line into every other one with
+    // equal weight and diffuses fastest. HOUSEHOLDER mostly feeds each line back into itself, and is
+    // the cheaper of the two.
+    enum class FeedbackMatrix
+    {
+        HADAMARD = 0,
+        HOUSEHOLDER = 1
+    };
+
+    // An algorithmic reverb built from a feedback delay network: 4, 8 or 16 delay lines of mutually prime
+    // lengths, whose outputs are damped, mixed by an orthogonal matrix and fed back with the input. The
+    // lines share one buffer, and each is read and written a block at a time, so the network costs a
+    // handful of vector operations per line and block, a small fraction of what a ConvolverNode with a
+    // reverb impulse costs.
+    //
+    // The input channels are mixed together to feed the network. Each output channel takes a different
+    // combination of the lines, so the channels are decorrelated. The output is the reverberation only.
+    class FDNReverbNode : public WebCore::AudioBasicProcessorNode
+    {
+        class FDNReverbNodeInternal;
+        FDNReverbNodeInternal * internalNode;
+
+    public:
+
+        // numberOfLines is rounded to 4, 8 or 16. size scales the line lengths, from 0.25 to 4, so
+        // larger sizes sound like larger rooms.
+        FDNReverbNode(float sampleRate, unsigned numberOfLines = 8, float size = 1.0f);
+        virtual ~FDNReverbNode();
+
+        unsigned numberOfLines() const;
+
+        // The time in seconds for the reverberation to decay by 60dB.
+        std::shared_ptr<WebCore::AudioParam> decayTime();
+
+        // The frequency in Hz above which the reverberation decays faster. At the Nyquist frequency, the
+        // highest it goes, every frequency decays at the same rate.
+        std::shared_ptr<WebCore::AudioParam> damping();
+
+        void setMatrix(FeedbackMatrix);
+    };
+}
+
+#endif
@@ -36,18 +36,29 @@
 // LabSound Extended Public API
 #include "LabSound/extended/RealtimeAnalyser.h"
 #include "LabSound/extended/ADSRNode.h"
+#include "LabSound/extended/AudioTap.h"
 #include "LabSound/extended/ClipNode.h"
+#include "LabSound/extended/DecodeService.h"
 #include "LabSound/extended/DiodeNode.h"
+#include "LabSound/extended/FDNReverbNode.h"
 #include "LabSound/extended/FunctionNode.h"
+#include "LabSound/extended/MultibandCompressorNode.h"
+#include "LabSound/extended/MultiTapDelayNode.h"
 #include "LabSound/extended/NoiseNode.h"
+#include "LabSound/extended/OscillatorBankNode.h"
 #include "LabSound/extended/PdNode.h"
 #include "LabSound/extended/PeakCompNode.h"
 #include "LabSound/extended/PowerMonitorNode.h"
 #include "LabSound/extended/PWMNode.h"
 #include "LabSound/extended/SoundBuffer.h"
 #include "LabSound/extended/SupersawNode.h"
+#include "LabSound/extended/TapAnalyzers.h"
+#include "LabSound/extended/VoiceManager.h"
+#include "LabSound/extended/SpatialScene.h"
 #include "LabSound/extended/SpatializationNode.h"
 #include "LabSound/extended/SpectralMonitorNode.h"
+#include "LabSound/extended/STFTNode.h"
+#include "LabSound/extended/StreamingSourceNode.h"
 #include "LabSound/extended/SampledInstrumentNode.h"
 #include "LabSound/extended/RecorderNode.h"
 
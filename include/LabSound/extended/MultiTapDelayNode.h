@@ -0,0 +1,48 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifndef MultiTapDelayNode_h
+#define MultiTapDelayNode_h
+
+#include "LabSound/core/AudioBasicProcessorNode.h"
+#include "LabSound/core/AudioParam.h"
+#include "LabSound/core/DelayNode.h"
+
+#include <vector>
+
+namespace LabSound
+{
+    struct DelayTap
+    {
+        float delayTime;    // seconds
+        float gain;
+    };
+
+    // A delay with any number of taps, all reading the one history each channel keeps, so that a multi-tap
+    // echo is a single node rather than a DelayNode and a GainNode per tap. The output is the sum of the
+    // taps. The longest tap is fed back into the history scaled by feedback(), for echoes that repeat;
+    // the loop is closed inside the node, so unlike a loop through the graph it adds no extra latency.
+    class MultiTapDelayNode : public WebCore::AudioBasicProcessorNode
+    {
+        class MultiTapDelayNodeInternal;
+        MultiTapDelayNodeInternal * internalNode;
+
+    public:
+
+        MultiTapDelayNode(float sampleRate, double maxDelayTime);
+        virtual ~MultiTapDelayNode();
+
+        double maxDelayTime() const;
+
+        // Replaces the taps. Delay times are clamped to 0 to maxDelayTime.
+        void setTaps(ContextRenderLock&, const std::vector<DelayTap>& taps);
+        const std::vector<DelayTap>& taps() const;
+
+        // From -0.99 to 0.99.
+        std::shared_ptr<WebCore::AudioParam> feedback();
+
+        void setInterpolation(WebCore::DelayInterpolation);
+    };
+}
+
+#endif
@@ -0,0 +1,61 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifndef MultibandCompressorNode_h
+#define MultibandCompressorNode_h
+
+#include "LabSound/core/AudioBasicProcessorNode.h"
+#include "LabSound/core/AudioParam.h"
+
+namespace LabSound
+{
+    // A compressor that splits its input into 2 to 5 frequency bands and compresses each band on its own, so that
+    // a loud bass doesn't pull down the whole mix. The whole chain, from the crossovers through the detectors to
+    // summing the bands back together, runs within the node, rather than as a graph of filter, compressor and
+    // gain nodes that each pay for a pass over the block.
+    //
+    // The crossovers are 4th order Linkwitz-Riley filters, run four at a time in the lanes of a vector, and
+    // each lower band is passed through the allpass of every crossover above it. With the compression off, the
+    // bands sum back to a flat response. Each band's detector follows the loudest channel, so the stereo image
+    // holds still as the gain changes.
+    class MultibandCompressorNode : public WebCore::AudioBasicProcessorNode
+    {
+        class MultibandCompressorNodeInternal;
+        MultibandCompressorNodeInternal * internalNode;
+
+    public:
+
+        // numberOfBands is clamped to 2 to 5.
+        MultibandCompressorNode(float sampleRate, unsigned numberOfBands = 3);
+        virtual ~MultibandCompressorNode();
+
+        unsigned numberOfBands() const;
+
+        // The frequency in Hz dividing band i from band i + 1, for i from 0 to numberOfBands() - 2. Each
+        // crossover is kept above the one before it.
+        std::shared_ptr<WebCore::AudioParam> crossover(unsigned i);
+
+        // Each band's settings. The functions throw std::out_of_range for bands that don't exist.
+
+        // Threshold in dB, default -24
+        std::shared_ptr<WebCore::AudioParam> threshold(unsigned band);
+
+        // Ratio, default 4:1
+        std::shared_ptr<WebCore::AudioParam> ratio(unsigned band);
+
+        // The width in dB of the soft knee around the threshold, default 6
+        std::shared_ptr<WebCore::AudioParam> knee(unsigned band);
+
+        // Attack and release in seconds, defaults 0.005 and 0.1
+        std::shared_ptr<WebCore::AudioParam> attack(unsigned band);
+        std::shared_ptr<WebCore::AudioParam> release(unsigned band);
+
+        // Makeup gain in dB, default 0
+        std::shared_ptr<WebCore::AudioParam> makeup(unsigned band);
+
+        // The most gain reduction in dB the band applied over the last block.
+        std::shared_ptr<WebCore::AudioParam> reduction(unsigned band);
+    };
+}
+
+#endif
@@ -0,0 +1,80 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifndef LabSound_OscillatorBankNode_h
+#define LabSound_OscillatorBankNode_h
+
+#include "LabSound/core/AudioParam.h"
+#include "LabSound/core/AudioScheduledSourceNode.h"
+#include "LabSound/core/Synthesis.h"
+#include "LabSound/core/WaveTable.h"
+
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+namespace LabSound
+{
+    // An OscillatorBankNode plays any number of wavetable voices sharing one WaveTable, summed to a mono output.
+    // It is much cheaper than the same number of OscillatorNodes. There are no per voice nodes or connections
+    // in the graph, the band limited tables for each voice are chosen once per render quantum instead of once
+    // per sample, and the voices are kept in parallel arrays and rendered several frames at a time with SIMD.
+    //
+    // Each voice plays at the bank's frequency times its own ratio, detuned by the bank's detune plus its own,
+    // at its own gain. The bank's frequency and detune are applied once per render quantum.
+    class OscillatorBankNode : public WebCore::AudioScheduledSourceNode
+    {
+
+    public:
+
+        OscillatorBankNode(ContextRenderLock& r, float sampleRate);
+        virtual ~OscillatorBankNode();
+
+        virtual void process(ContextRenderLock&, size_t framesToProcess) override;
+        virtual void reset(ContextRenderLock&) override;
+
+        OscillatorType type() const { return m_type; }
+        void setType(ContextRenderLock& r, OscillatorType);
+
+        void setWaveTable(ContextRenderLock& r, std::shared_ptr<WebCore::WaveTable>);
+
+        std::shared_ptr<WebCore::AudioParam> frequency() { return m_frequency; }
+        std::shared_ptr<WebCore::AudioParam> detune() { return m_detune; }
+
+        unsigned numberOfVoices() const { return static_cast<unsigned>(m_phases.size()); }
+
+        // Voices added by growing the bank start with a ratio of one, no detune and unity gain.
+        void setNumberOfVoices(ContextRenderLock& r, unsigned numberOfVoices);
+
+        void setVoiceFrequencyRatio(ContextRenderLock& r, unsigned voice, float ratio);
+        void setVoiceDetune(ContextRenderLock& r, unsigned voice, float cents);
+        void setVoiceGain(ContextRenderLock& r, unsigned voice, float gain);
+
+    private:
+
+        virtual bool propagatesSilence(double now) const override;
+
+        OscillatorType m_type;
+
+        // Frequency value in Hertz.
+        std::shared_ptr<WebCore::AudioParam> m_frequency;
+
+        // Detune value (deviating from the frequency) in Cents.
+        std::shared_ptr<WebCore::AudioParam> m_detune;
+
+        bool m_firstRender;
+
+        std::shared_ptr<WebCore::WaveTable> m_waveTable;
+
+        // Per voice state. The phases are fixed point fractions of a cycle, so they wrap for free.
+        std::vector<uint32_t> m_phases;
+        std::vector<float> m_frequencyRatios;
+        std::vector<float> m_detuneScales;
+        std::vector<float> m_gains;
+
+        // The gain each voice ended the last quantum at. Gain changes ramp over a quantum to avoid clicks.
+        std::vector<float> m_currentGains;
+    };
+}
+
+#endif
@@ -3,47 +3,34 @@
 
 #pragma once
 
-#include "LabSound/core/AudioBasicInspectorNode.h"
-#include <vector>
-#include <mutex>
+#include "LabSound/extended/AudioTap.h"
+#include "LabSound/extended/TapAnalyzers.h"
 
 namespace LabSound {
     
-    class PowerMonitorNode : public WebCore::AudioBasicInspectorNode 
+    // The intent of the power monitor node is to provide levels that can be used for a VU meter
+    // or a ducking algorithm. The render thread only copies the signal into the node's tap; the
+    // level is measured on the thread that asks for it.
+    class PowerMonitorNode : public TapNode
 	{
     public:
 
         PowerMonitorNode(float sampleRate);
 
         virtual ~PowerMonitorNode();
-        
-        virtual void process(ContextRenderLock&, size_t framesToProcess) override;
-        virtual void reset(ContextRenderLock&) override;
-
-        // instantaneous estimation of power
-        float db() const { return _db; }
-
-        // Could be better. Power is computed on the most recent frame. If the framesize is greater
-        // than the windowSize, then power is returned for the windowed end-of-frame. If framesize
-        // is less than windowSize, power is computed only on framesize. This could be a problem
-        // if the framesize is very large compared to the sample rate, for example, a 4k framesize
-        // on a 44khz samplerate is going to give you usable power measurements 11 times a second.
-        // If better resolution is required, it's probably better to use a RecorderNode, and perform
-        // analysis on the full data stream pulled from it.
-        //
-        // The intent of the power monitor node is to provide levels that can be used for a VU meter
-        // or a ducking algorithm.
-        //
-        void windowSize(size_t ws) { _windowSize = ws; }
-        size_t windowSize() const { return _windowSize; }
+
+        // Power of the most recent windowSize frames across all channels, in decibels.
+        // Reads whatever the tap has gathered since the last call, so call it from one thread only.
+        float db() const;
+
+        // For finer grained or longer measurements, read the tap() with a LevelMeter
+        // or LoudnessMeter of your own.
+        void windowSize(size_t ws) { _meter.setWindowSize(ws); }
+        size_t windowSize() const { return _meter.windowSize(); }
         
     private:
 
-        virtual double tailTime() const override { return 0; }      // required for BasicInspector
-        virtual double latencyTime() const override { return 0; }   // required for BasicInspector
-
-        float _db;
-        size_t _windowSize;
+        mutable LevelMeter _meter;
 
     };
 
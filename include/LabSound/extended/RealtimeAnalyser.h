@@ -33,7 +33,7 @@ namespace WebCore
 {
 
 class AudioBus;
-class FFTFrame;
+class SpectralAnalysis;
 
 class RealtimeAnalyser
 {
@@ -82,13 +82,16 @@ private:
     unsigned m_writeIndex;
     
     uint32_t m_fftSize;
-    std::unique_ptr<FFTFrame> m_analysisFrame;
+    std::unique_ptr<SpectralAnalysis> m_analysis;
     void doFFTAnalysis();
     
     // doFFTAnalysis() stores the floating-point magnitude analysis data here.
     AudioFloatArray m_magnitudeBuffer;
     AudioFloatArray& magnitudeBuffer() { return m_magnitudeBuffer; }
 
+    // getByteFrequencyData() converts the magnitudes to decibels here before scaling them to bytes.
+    AudioFloatArray m_decibelBuffer;
+
     // A value between 0 and 1 which averages the previous version of m_magnitudeBuffer with the current analysis magnitude data.
     double m_smoothingTimeConstant;    
 
@@ -6,48 +6,98 @@
 
 #include "LabSound/core/AudioBasicInspectorNode.h"
 #include "LabSound/core/AudioContext.h"
-#include <vector>
+#include "LabSound/extended/AudioTap.h"
+
+#include <atomic>
+#include <memory>
 #include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace WebCore
+{
+    class WavFileWriter;
+}
 
 namespace LabSound
 {
-    
+    enum class RecorderFormat
+    {
+        FLOAT32 = 0,
+        PCM16 = 1
+    };
+
+    // The render thread copies what passes through the recorder into an AudioTap made when recording starts,
+    // and never locks, allocates or waits on anything. A writer thread drains the tap, either streaming it
+    // to a WAV file or collecting it in memory for getData. If the writer falls so far behind that the tap
+    // is full, whole render quanta are dropped and counted rather than blocking the render thread.
+    //
+    // Recordings are stereo, or mono with mixToMono(true); the input is up or down mixed with the speaker rules.
     class RecorderNode : public WebCore::AudioBasicInspectorNode
     {
-        
+
     public:
-        
+
         RecorderNode(float sampleRate);
         virtual ~RecorderNode();
-        
+
         // AudioNode
         virtual void process(ContextRenderLock&, size_t framesToProcess) override;
         virtual void reset(ContextRenderLock&) override;
-        
-        void startRecording() { m_recording = true; }
-        void stopRecording() { m_recording = false; }
-        
+
+        // Records into memory, to be fetched with getData or written with writeRecordingToWav.
+        void startRecording();
+
+        // Streams the recording to a WAV file, so memory use doesn't grow however long it runs.
+        // Returns false if the file can't be created. bufferSeconds is how far the writer may fall behind.
+        bool startRecording(const std::string & filenameWithWavExtension, RecorderFormat format = RecorderFormat::FLOAT32, float bufferSeconds = 2.0f);
+
+        // Waits for the writer to store everything recorded so far, and finishes the file if there is one.
+        void stopRecording();
+
+        bool isRecording() const { return m_recording; }
+
+        // Takes effect when recording next starts.
         void mixToMono(bool m) { m_mixToMono = m; }
 
+        // Frames recorded since recording started that were lost because the writer fell behind.
+        uint64_t droppedFrames() const { return m_tap ? m_tap->droppedFrames() : 0; }
+
         // replaces result with the currently recorded data.
         // saved data is cleared.
         void getData(std::vector<float>& result);
-        
+
+        // Writes the data recorded in memory, interleaved in the given number of channels.
         void writeRecordingToWav(int channels, const std::string & filenameWithWavExtension);
-        
+
     private:
-        
+
         virtual double tailTime() const override { return 0; }
         virtual double latencyTime() const override { return 0; }
 
+        bool beginRecording(std::unique_ptr<WebCore::WavFileWriter> file, float bufferSeconds);
+        void writerThread();
+        void drain();
+
         bool m_mixToMono;
-        bool m_recording;
+        unsigned m_recordingChannels;
+
+        std::atomic<bool> m_recording;
+        std::atomic<bool> m_processing;     // set by the render thread while it may be writing to the tap
+        std::atomic<bool> m_stopWriter;
+
+        std::unique_ptr<AudioTap> m_tap;
+        std::unique_ptr<WebCore::WavFileWriter> m_file;     // null when recording into memory
+        std::vector<float> m_drainBuffer;                    // interleaved, used by the writer thread
+        std::thread m_writer;
 
         std::vector<float> m_data;  // interleaved
         mutable std::recursive_mutex m_mutex;
 
     };
-    
+
 } // end namespace LabSound
 
 #endif
@@ -0,0 +1,81 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifndef STFTNode_h
+#define STFTNode_h
+
+#include "LabSound/core/AudioBasicInspectorNode.h"
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+namespace LabSound
+{
+    struct STFTResolution
+    {
+        uint32_t windowSize;    // rounded up to a power of two
+        uint32_t hopSize;       // frames between the starts of successive windows; windowSize / 4 overlaps them by 75%
+    };
+
+    struct STFTFrame
+    {
+        uint64_t sampleFrame;   // the context sample frame of the first sample in the window
+        unsigned resolution;
+
+        // windowSize / 2 bins from DC up, of the Blackman windowed, unnormalized transform.
+        std::vector<float> real;
+        std::vector<float> imag;
+        std::vector<float> magnitudes;
+    };
+
+    // A pass through node that computes a short time Fourier transform of its input, mixed to mono, at one
+    // or more resolutions. Each resolution transforms a window of the most recent windowSize frames every
+    // hopSize frames, on the render thread as the samples arrive, so a hop that falls in the middle of a
+    // render quantum is computed at that point rather than at the end of it. Finished frames are queued
+    // without locks for a reader on another thread, for onset detection, spectral flux and the like.
+    //
+    // All of the frame storage is allocated by the constructor. If the reader falls so far behind that a
+    // resolution's queue is full, new frames of that resolution are dropped and counted.
+    class STFTNode : public WebCore::AudioBasicInspectorNode
+    {
+
+    public:
+
+        STFTNode(float sampleRate, uint32_t windowSize = 1024, uint32_t hopSize = 256, size_t queuedFrames = 64);
+        STFTNode(float sampleRate, const std::vector<STFTResolution>& resolutions, size_t queuedFrames = 64);
+        virtual ~STFTNode();
+
+        // AudioNode
+        virtual void process(ContextRenderLock&, size_t framesToProcess) override;
+        virtual void reset(ContextRenderLock&) override;
+
+        unsigned numberOfResolutions() const { return static_cast<unsigned>(m_analyses.size()); }
+        STFTResolution resolution(unsigned index) const;
+
+        // Reader thread only. Replaces frame with the oldest queued frame of the given resolution and
+        // returns true, or returns false if there is none. frame's vectors are only allocated the first time.
+        bool popFrame(unsigned resolution, STFTFrame& frame);
+
+        // Frames of every resolution lost because the reader fell behind.
+        uint64_t droppedFrames() const { return m_droppedFrames; }
+
+    private:
+
+        struct Analysis;
+
+        virtual double tailTime() const override { return 0; }
+        virtual double latencyTime() const override { return 0; }
+
+        void initializeAnalyses(const std::vector<STFTResolution>& resolutions, size_t queuedFrames);
+        void emitFrame(Analysis& analysis, unsigned resolution, uint64_t sampleFrame);
+
+        std::vector<std::unique_ptr<Analysis>> m_analyses;
+        std::vector<float> m_mono;
+        std::atomic<uint64_t> m_droppedFrames;
+    };
+
+} // end namespace LabSound
+
+#endif
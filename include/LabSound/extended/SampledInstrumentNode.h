@@ -6,17 +6,23 @@
 
 #include "LabSound/core/AudioContext.h"
 #include "LabSound/core/AudioNode.h"
-#include "LabSound/core/AudioParam.h"
-#include "LabSound/core/AudioBufferSourceNode.h"
+#include "LabSound/core/AudioSourceNode.h"
+#include "LabSound/core/LockFreeQueue.h"
 
-#include "LabSound/extended/ADSRNode.h"
 #include "LabSound/extended/SoundBuffer.h"
 #include "LabSound/extended/AudioContextLock.h"
 
-#include <iostream> 
 #include <array>
+#include <atomic>
 #include <string>
 #include <algorithm>
+#include <stdint.h>
+#include <vector>
+
+namespace WebCore
+{
+	class AudioBus;
+}
 
 namespace LabSound 
 {
@@ -74,27 +80,82 @@ namespace LabSound
 		uint8_t max;
 	};
 
-	// This class is a little but subversive of the typical LabSound node pattern. 
-	// Instead of inheriting from a node and injecting samples into an audio buffer,
-	// it internally creates ad-hoc AudioBufferSourceNode(s) and keeps them around
-	// in the graph so long as our gain node has been connected. 
-	class SampledInstrumentNode 
+	// A polyphonic sampler. The notes are rendered by a fixed pool of voices inside this node, so playing a note
+	// never allocates, creates nodes or touches the graph, and the cost of a render quantum is bounded by the
+	// number of voices however quickly notes arrive. When every voice is busy a new note steals the quietest
+	// releasing voice, or failing that the oldest one, which fades out over the rest of the render quantum.
+	//
+	// Note events may be sent from any thread. They are passed to the audio thread through a lock free queue
+	// and take effect on the sample frame of the context time they are given. A note with no time, or a time
+	// that has passed, plays at the start of the next render quantum. Events beyond the queue's capacity are
+	// dropped, and NoteOn and NoteOff report that by returning false.
+	class SampledInstrumentNode : public WebCore::AudioSourceNode
 	{
-		std::vector<std::shared_ptr<SamplerSound>> samples;
-		std::shared_ptr<WebCore::GainNode> gainNode;
-		std::vector<std::shared_ptr<WebCore::AudioBufferSourceNode>> voices;
 	public:
-        SampledInstrumentNode(float sampleRate);
-        ~SampledInstrumentNode();
+		SampledInstrumentNode(float sampleRate, unsigned numberOfVoices = 32);
+		virtual ~SampledInstrumentNode();
+
+		virtual void process(ContextRenderLock&, size_t framesToProcess) override;
+		virtual void reset(ContextRenderLock&) override;
+
+		// Decodes the samples and replaces the current instrument, silencing any notes that are playing. The
+		// samples are decoded in parallel with no lock held, and the render lock is taken only to swap in the
+		// finished instrument, so call it without holding the render lock. Throws std::runtime_error, leaving
+		// the current instrument in place, if a sample can't be decoded.
+		void LoadInstrument(std::shared_ptr<WebCore::AudioContext> context, std::vector<SampledInstrumentDefinition> & sounds);
+
+		bool NoteOn(const int midiNoteNumber, const float amplitude, double when = 0);
+		bool NoteOff(const int midiNoteNumber, double when = 0);
+
+		void KillAllNotes();
+
+		// A note fades out over the release time after its NoteOff, and plays to the end of its sample otherwise.
+		// May be called from any thread; notes released after the change use the new time.
+		void SetReleaseTime(float seconds);
 
-		void LoadInstrument(std::vector<SampledInstrumentDefinition> & sounds);
+		unsigned NumberOfVoices() const { return static_cast<unsigned>(voices.size()); }
+
+	private:
+		struct NoteEvent
+		{
+			enum Type { On, Off, AllOff };
+
+			uint64_t frame;
+			Type type;
+			uint8_t note;
+			float amplitude;
+		};
+
+		struct Voice
+		{
+			int sample = -1;       // index of the SamplerSound playing, -1 if the voice is free
+			uint8_t note = 0;
+			uint64_t serial = 0;   // orders the voices by the time they started
+			double position = 0;   // read position, in frames of the sample
+			double rate = 1;       // frames of the sample per frame of output
+			float gain = 0;
+			float gainStep = 0;    // negative while the voice is releasing
+			bool releasing = false;
+		};
+
+		virtual bool propagatesSilence(double now) const override;
+
+		bool Post(const NoteEvent & event, double when);
+		void HandleEvent(WebCore::AudioBus * outputBus, const NoteEvent & event, size_t frame, size_t framesToProcess);
+		void RenderVoice(WebCore::AudioBus * outputBus, Voice & voice, size_t frame, size_t framesToRender, bool fadeOut = false);
+
+		std::vector<std::shared_ptr<SamplerSound>> samples;
+		std::vector<Voice> voices;
+		uint64_t nextSerial = 0;
+		unsigned activeVoices = 0;
+		std::atomic<float> releaseTime; // set from any thread, read by the audio thread
 
-		void NoteOn(ContextRenderLock & r, const int midiNoteNumber, const float amplitude);
-		void NoteOff(ContextRenderLock & r, const int midiNoteNumber, const float amplitude);
+		LockFreeQueue<NoteEvent> events;
 
-		void KillAllNotes(); 
+		// Events taken from the queue that are due in a later render quantum.
+		std::vector<NoteEvent> pendingEvents;
 
-		WebCore::GainNode * GetOutputNode() { return gainNode.get(); }
+		std::vector<std::vector<float>> scratch;
 	};
 
 } // LabSound
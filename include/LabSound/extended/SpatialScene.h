@@ -0,0 +1,72 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifndef LabSound_SpatialScene_h
+#define LabSound_SpatialScene_h
+
+#include "LabSound/core/PannerNode.h"
+
+#include <memory>
+#include <vector>
+
+namespace LabSound
+{
+    class ContextRenderLock;
+
+    // Computes the geometry of many panners together. Each PannerNode otherwise works out its azimuth, elevation,
+    // distance and cone gains and doppler rate on its own, a vector at a time. The scene keeps the positions,
+    // orientations, velocities and distance and cone parameters of all its panners in structure of arrays
+    // form, and runs the whole computation four panners at a time in the lanes of a vector.
+    //
+    // The panners are still positioned with their own setters; update() gathers the geometry of those that
+    // changed, computes every panner's results and hands them to the panners. A panner that changes after
+    // an update computes its own results until the next update, so the results are never stale.
+    class SpatialScene
+    {
+        SpatialScene(const SpatialScene&); // noncopyable
+
+    public:
+
+        SpatialScene();
+        ~SpatialScene();
+
+        // A panner is added once; adding it again does nothing.
+        void addPanner(std::shared_ptr<WebCore::PannerNode> panner);
+        void removePanner(std::shared_ptr<WebCore::PannerNode> panner);
+
+        size_t numberOfPanners() const { return m_panners.size(); }
+
+        // Computes the results for every panner against the context's listener. Call it once per render
+        // quantum, or whenever the panners or the listener have moved. It does nothing if none has.
+        void update(ContextRenderLock& r);
+
+    private:
+
+        void gather(size_t i);
+        void compute(const WebCore::AudioListener& listener, size_t count);
+
+        std::vector<std::shared_ptr<WebCore::PannerNode>> m_panners;
+        std::vector<unsigned> m_versions;           // the version of each panner's geometry in the arrays
+        unsigned m_listenerVersion;
+        bool m_changed;
+
+        // Gathered from the panners
+        std::vector<float> m_positionX, m_positionY, m_positionZ;
+        std::vector<float> m_orientationX, m_orientationY, m_orientationZ;  // normalized
+        std::vector<float> m_velocityX, m_velocityY, m_velocityZ;
+        std::vector<float> m_refDistance, m_maxDistance, m_rolloffFactor;
+        std::vector<unsigned short> m_distanceModel;
+        std::vector<float> m_coneInnerAngle, m_coneOuterAngle, m_coneOuterGain; // half angles in degrees
+        std::vector<float> m_hasCone;               // 1 where the panner has a cone and an orientation
+
+        // Computed
+        std::vector<float> m_azimuth, m_elevation;
+        std::vector<float> m_linearGain, m_inverseGain, m_exponentialGain;
+        std::vector<float> m_distanceRatio;         // distance over the reference distance, for the exponential model
+        std::vector<float> m_coneGain;
+        std::vector<float> m_dopplerRate;
+    };
+
+} // end namespace LabSound
+
+#endif
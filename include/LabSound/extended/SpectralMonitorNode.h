@@ -3,34 +3,31 @@
 
 #pragma once
 
-#include "LabSound/core/AudioBasicInspectorNode.h"
-#include "LabSound/core/AudioContext.h"
+#include "LabSound/extended/AudioTap.h"
+#include "LabSound/extended/TapAnalyzers.h"
 
 #include <vector>
-#include <mutex>
 
 namespace LabSound 
 {
-    class SpectralMonitorNode : public WebCore::AudioBasicInspectorNode 
+    // The render thread only copies the signal, mixed to mono, into the node's tap. The transform
+    // runs on the thread that asks for the spectrum, which must always be the same thread.
+    class SpectralMonitorNode : public TapNode 
 	{
-		class SpectralMonitorNodeInternal;
-        std::unique_ptr<SpectralMonitorNodeInternal> internalNode;
     public:
 
         SpectralMonitorNode(float sampleRate);
         virtual ~SpectralMonitorNode();
 
-        virtual void process(ContextRenderLock&, size_t framesToProcess) override;
-        virtual void reset(ContextRenderLock&) override;
-
+        // Replaces result with windowSize() / 2 magnitudes of the most recent windowSize() frames.
         void spectralMag(std::vector<float>& result);
+
+        // Rounded up to a power of two.
         void windowSize(size_t ws);
         size_t windowSize() const;
 
     private:
 
-        // required for BasicInspector
-        virtual double tailTime() const override { return 0; }
-        virtual double latencyTime() const override { return 0; }
+        SpectrumAnalyzer m_analyzer;
     };
 } 
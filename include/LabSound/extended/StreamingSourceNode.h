@@ -0,0 +1,105 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifndef StreamingSourceNode_h
+#define StreamingSourceNode_h
+
+#include "LabSound/core/AudioScheduledSourceNode.h"
+#include "LabSound/extended/AudioContextLock.h"
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace WebCore
+{
+    class AudioRingBuffer;
+}
+
+namespace LabSound
+{
+    // StreamingSourceNode plays a sound file of any length without holding it in memory. A reader thread
+    // decodes ahead of playback into a ring buffer a fraction of a second long, and the render thread
+    // only copies out of it, resampling to the context's rate if the file's differs. WAV files, including
+    // RF64, are streamed from disk; other formats are decoded in full when opened.
+    //
+    // While looping, the reader keeps the start of the loop decoded in memory, so the audio after the loop
+    // point is in the buffer as soon as it is needed rather than waiting on a seek. Loop changes are heard
+    // once the audio already buffered has played. After a seek, playback is silent until the reader has
+    // refilled the buffer from the new position.
+    class StreamingSourceNode : public WebCore::AudioScheduledSourceNode
+    {
+
+    public:
+
+        StreamingSourceNode(float sampleRate);
+        virtual ~StreamingSourceNode();
+
+        // The output gets as many channels as the file. Returns false if the file can't be opened or decoded.
+        bool open(ContextRenderLock&, const std::string& path, float bufferSeconds = 0.25f);
+
+        unsigned numberOfChannels() const { return m_numberOfChannels; }
+        double duration() const;
+
+        // Moves playback to the given time in the file.
+        void seek(double seconds);
+
+        // Loop points are in seconds; a loopEnd of zero means the end of the file.
+        void setLoop(bool loop) { m_loop = loop; }
+        bool loop() const { return m_loop; }
+        void setLoopPoints(double loopStart, double loopEnd);
+
+        // Render quanta that were partly silent because the reader fell behind.
+        uint64_t underruns() const { return m_underruns; }
+
+        // AudioNode
+        virtual void process(ContextRenderLock&, size_t framesToProcess) override;
+        virtual void reset(ContextRenderLock&) override;
+
+    private:
+
+        struct Decoder;
+
+        virtual bool propagatesSilence(double now) const override;
+
+        void stopReader();
+        void readerThread();
+        size_t renderFrames(float* const* destinations, size_t framesToProcess);
+
+        std::unique_ptr<Decoder> m_decoder;
+        std::unique_ptr<WebCore::AudioRingBuffer> m_ring;
+        unsigned m_numberOfChannels;
+        float m_fileSampleRate;
+
+        std::thread m_reader;
+        std::atomic<bool> m_stopReader;
+
+        // A seek bumps the requested generation. The reader stops writing, repositions and acknowledges it,
+        // then waits for the render thread to discard what was buffered before writing again.
+        std::atomic<uint64_t> m_seekFrame;
+        std::atomic<unsigned> m_requestedGeneration;
+        std::atomic<unsigned> m_readerGeneration;
+        std::atomic<unsigned> m_renderGeneration;
+        std::atomic<bool> m_endOfStream;    // everything up to the end of the file has been buffered
+
+        std::atomic<bool> m_loop;
+        std::atomic<uint64_t> m_loopStart;  // in frames of the file
+        std::atomic<uint64_t> m_loopEnd;
+
+        // The render thread's resampling state; m_position is a fractional frame within m_scratch.
+        double m_rate;
+        double m_position;
+        size_t m_scratchFrames;
+        bool m_priming;                     // waiting for the buffer to fill after opening or seeking
+        std::vector<std::vector<float>> m_scratch;
+        std::vector<float*> m_scratchChannels;
+
+        std::atomic<uint64_t> m_underruns;
+    };
+
+} // end namespace LabSound
+
+#endif
@@ -0,0 +1,129 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifndef LabSound_TapAnalyzers_h
+#define LabSound_TapAnalyzers_h
+
+#include "LabSound/extended/AudioTap.h"
+
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+namespace WebCore
+{
+    class SpectralAnalysis;
+}
+
+namespace LabSound
+{
+    // Analyzers run on the thread that reads an AudioTap, never on the render thread. update() drains
+    // everything the tap has gathered since the last call. Several analyzers can share one tap's signal
+    // if the reader reads it once and hands the frames to each analyzer's analyze().
+    class TapAnalyzer
+    {
+    public:
+        TapAnalyzer();
+        virtual ~TapAnalyzer();
+
+        void update(AudioTap& tap);
+
+        virtual void analyze(const float* const* channels, unsigned numberOfChannels, size_t framesToProcess) = 0;
+        virtual void reset() = 0;
+
+    private:
+        std::vector<std::vector<float>> m_readBuffers;
+    };
+
+    // RMS and peak levels over the most recent window of frames.
+    class LevelMeter : public TapAnalyzer
+    {
+    public:
+        explicit LevelMeter(size_t windowSize = 2048);
+
+        void setWindowSize(size_t windowSize);
+        size_t windowSize() const { return m_windowSize; }
+
+        virtual void analyze(const float* const* channels, unsigned numberOfChannels, size_t framesToProcess) override;
+        virtual void reset() override;
+
+        unsigned numberOfChannels() const { return static_cast<unsigned>(m_history.size()); }
+
+        // Linear levels of one channel, or of all of them together.
+        float rms(unsigned channel) const;
+        float peak(unsigned channel) const;
+        float rms() const;
+        float peak() const;
+
+        // The RMS of all channels in decibels, floored at -100 dB.
+        float rmsDecibels() const;
+
+    private:
+        size_t m_windowSize;
+        size_t m_framesSeen;
+        size_t m_writeIndex;
+        std::vector<std::vector<float>> m_history;
+    };
+
+    // Loudness in LUFS as specified by ITU-R BS.1770-4 and EBU R128: K weighted, with momentary (400ms) and
+    // short term (3s) windows, and integrated loudness gated at -70 LUFS and 10 LU below the ungated level.
+    // The integrated measure keeps a fixed size histogram of block loudness, so it runs for any length of
+    // time in constant memory. Six channels are taken to be 5.1, with the LFE left out and the surrounds
+    // weighted by +1.5 dB; otherwise every channel has unit weight.
+    class LoudnessMeter : public TapAnalyzer
+    {
+    public:
+        explicit LoudnessMeter(float sampleRate);
+        virtual ~LoudnessMeter();
+
+        virtual void analyze(const float* const* channels, unsigned numberOfChannels, size_t framesToProcess) override;
+        virtual void reset() override;
+
+        // Each returns -HUGE_VAL until there is something to measure.
+        float momentaryLoudness() const;
+        float shortTermLoudness() const;
+        float integratedLoudness() const;
+
+    private:
+        struct KWeighting;
+
+        float m_sampleRate;
+        std::vector<std::unique_ptr<KWeighting>> m_filters;
+
+        size_t m_subBlockFrames;       // 100ms
+        size_t m_subBlockPosition;
+        double m_subBlockEnergy;
+
+        std::vector<double> m_subBlocks; // the energies of the last 30 sub blocks, circular
+        size_t m_subBlockCount;
+
+        std::vector<uint64_t> m_histogramCounts;
+        std::vector<double> m_histogramEnergies;
+    };
+
+    // The magnitude spectrum of the most recent window of frames, mixed to mono.
+    class SpectrumAnalyzer : public TapAnalyzer
+    {
+    public:
+        explicit SpectrumAnalyzer(size_t windowSize = 512);
+        virtual ~SpectrumAnalyzer();
+
+        // A power of two.
+        void setWindowSize(size_t windowSize);
+        size_t windowSize() const { return m_windowSize; }
+
+        virtual void analyze(const float* const* channels, unsigned numberOfChannels, size_t framesToProcess) override;
+        virtual void reset() override;
+
+        // Replaces result with windowSize / 2 magnitudes of a Blackman windowed transform.
+        void magnitudes(std::vector<float>& result);
+
+    private:
+        size_t m_windowSize;
+        size_t m_writeIndex;
+        std::vector<float> m_history;
+        std::unique_ptr<WebCore::SpectralAnalysis> m_analysis;
+    };
+}
+
+#endif
@@ -0,0 +1,74 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifndef LabSound_VoiceManager_h
+#define LabSound_VoiceManager_h
+
+#include "LabSound/core/PannerNode.h"
+
+#include <memory>
+#include <vector>
+
+namespace LabSound
+{
+    class ContextRenderLock;
+
+    // Caps the number of spatial voices that are rendered, so that the cost of a scene is bounded by the budget
+    // rather than by how many sources are in it. Each update ranks the voices by how audible they are likely
+    // to be, the panner's distance, cone and occlusion gain times the gain of the source, and keeps the
+    // loudest within the budget real. The rest are virtualized: they fade out and skip panning, and fade back
+    // in when they re-enter the budget.
+    //
+    // A voice that is already real ranks as though it were a little louder than it is, so that voices of
+    // about the same loudness don't trade places on every update.
+    class VoiceManager
+    {
+        VoiceManager(const VoiceManager&); // noncopyable
+
+    public:
+
+        explicit VoiceManager(unsigned budget);
+        ~VoiceManager();
+
+        unsigned budget() const { return m_budget; }
+        void setBudget(unsigned budget) { m_budget = budget; }
+
+        // Voices quieter than this gain are virtualized even when there is room in the budget. The default is
+        // 0.001, or -60dB.
+        float threshold() const { return m_threshold; }
+        void setThreshold(float gain) { m_threshold = gain; }
+
+        // sourceGain is the loudness of what the voice plays, such as the gain of a GainNode feeding the panner.
+        // A voice is added once; adding it again sets its gain. A removed voice is made real again.
+        void addVoice(std::shared_ptr<WebCore::PannerNode> panner, float sourceGain = 1.0f);
+        void removeVoice(std::shared_ptr<WebCore::PannerNode> panner);
+        void setSourceGain(std::shared_ptr<WebCore::PannerNode> panner, float sourceGain);
+
+        size_t numberOfVoices() const { return m_voices.size(); }
+        size_t numberOfRealVoices() const { return m_realVoices; }
+
+        // Ranks the voices and virtualizes those outside the budget. Call it whenever sources have moved; after
+        // SpatialScene::update, if there is one, whose results it then reuses.
+        void update(ContextRenderLock& r);
+
+    private:
+
+        struct Voice
+        {
+            std::shared_ptr<WebCore::PannerNode> panner;
+            float sourceGain;
+            float priority;
+        };
+
+        std::vector<Voice>::iterator find(const std::shared_ptr<WebCore::PannerNode>& panner);
+
+        std::vector<Voice> m_voices;
+        std::vector<size_t> m_order;
+        unsigned m_budget;
+        float m_threshold;
+        size_t m_realVoices;
+    };
+
+} // end namespace LabSound
+
+#endif
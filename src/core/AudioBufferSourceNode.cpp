@@ -31,6 +31,7 @@
 #include "internal/AudioUtilities.h"
 #include "internal/FloatConversion.h"
 #include "internal/AudioBus.h"
+#include "internal/BufferResampler.h"
 
 #include <algorithm>
 #include <WTF/MathExtras.h>
@@ -58,6 +59,7 @@ AudioBufferSourceNode::AudioBufferSourceNode(float sampleRate)
     , m_grainOffset(0.0)
     , m_grainDuration(DefaultGrainDuration)
     , m_lastGain(1.0)
+    , m_interpolationMode(InterpolationMode::LINEAR)
     , m_pannerNode(0)
 {
     setNodeType(NodeTypeAudioBufferSource);
@@ -292,39 +294,26 @@ bool AudioBufferSourceNode::renderFromBuffer(ContextRenderLock& r, AudioBus* bus
         }
         virtualReadIndex = readIndex;
     } else {
-        while (framesToProcess--) {
-            unsigned readIndex = static_cast<unsigned>(virtualReadIndex);
-            double interpolationFactor = virtualReadIndex - readIndex;
-
-            // For linear interpolation we need the next sample-frame too.
-            unsigned readIndex2 = readIndex + 1;
-            if (readIndex2 >= bufferLength) {
-                if (loop()) {
-                    // Make sure to wrap around at the end of the buffer.
-                    readIndex2 = static_cast<unsigned>(virtualReadIndex + 1 - virtualDeltaFrames);
-                } else
-                    readIndex2 = readIndex;
-            }
-
-            // Final sanity check on buffer access.
-            // FIXME: as an optimization, try to get rid of this inner-loop check and put assertions and guards before the loop.
-            if (readIndex >= bufferLength || readIndex2 >= bufferLength)
-                break;
+        ResamplerSource source;
+        source.channels = sourceChannels;
+        source.numberOfChannels = numChannels;
+        source.length = bufferLength;
+        source.loop = loop();
+        source.loopDeltaFrames = virtualDeltaFrames;
 
-            // Linear interpolation.
-            for (unsigned i = 0; i < numChannels; ++i) {
-                float* destination = destinationChannels[i];
-                const float* source = sourceChannels[i];
+        while (framesToProcess > 0) {
+            // Render in one pass up to the next loop point or the end, whichever comes first.
+            double framesToEnd = ceil((virtualEndFrame - virtualReadIndex) / pitchRate);
+            int framesThisTime = static_cast<int>(std::min<double>(framesToProcess, std::max(1.0, framesToEnd)));
 
-                double sample1 = source[readIndex];
-                double sample2 = source[readIndex2];
-                double sample = (1.0 - interpolationFactor) * sample1 + interpolationFactor * sample2;
+            if (virtualReadIndex < 0 || virtualReadIndex >= bufferLength)
+                break;
 
-                destination[writeIndex] = narrowPrecisionToFloat(sample);
-            }
-            writeIndex++;
+            BufferResampler::render(m_interpolationMode, source, virtualReadIndex, pitchRate, destinationChannels, writeIndex, framesThisTime);
 
-            virtualReadIndex += pitchRate;
+            writeIndex += framesThisTime;
+            framesToProcess -= framesThisTime;
+            virtualReadIndex += framesThisTime * pitchRate;
 
             // Wrap-around, retaining sub-sample position since virtualReadIndex is floating-point.
             if (virtualReadIndex >= virtualEndFrame) {
@@ -428,6 +417,12 @@ double AudioBufferSourceNode::totalPitchRate(ContextRenderLock& r)
     return totalRate;
 }
 
+void AudioBufferSourceNode::setInterpolationMode(InterpolationMode mode)
+{
+    BufferResampler::prepare(mode);
+    m_interpolationMode = mode;
+}
+
 bool AudioBufferSourceNode::looping()
 {
     return m_isLooping;
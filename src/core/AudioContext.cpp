@@ -14,6 +14,7 @@
 #include "LabSound/extended/AudioContextLock.h"
 
 #include "internal/HRTFDatabaseLoader.h"
+#include "internal/AudioBufferPool.h"
 #include "internal/AudioDestination.h"
 
 #include <stdio.h>
@@ -45,6 +46,7 @@ AudioContext::AudioContext()
 {
 	m_isOfflineContext = false;
 	m_listener = std::make_shared<AudioListener>();
+	m_bufferPool = std::make_shared<AudioBufferPool>(AudioNode::ProcessingSizeInFrames);
 }
 
 // Constructor for offline (non-realtime) rendering.
@@ -52,6 +54,7 @@ AudioContext::AudioContext(unsigned numberOfChannels, size_t numberOfFrames, flo
 {
 	m_isOfflineContext = true;
 	m_listener = std::make_shared<AudioListener>();
+	m_bufferPool = std::make_shared<AudioBufferPool>(AudioNode::ProcessingSizeInFrames);
 
 	// Create a new destination for offline rendering.
 	m_renderTarget = std::make_shared<AudioBuffer>(numberOfChannels, numberOfFrames, sampleRate);
@@ -347,6 +350,9 @@ void AudioContext::update(ContextGraphLock& g)
         //printf("%d\n", (int) in->numberOfRenderingConnections());
 		//pendingNodeConnections.clear();
 	}
+
+	// Grow the buffer pool here, off the render thread, for the graph as it now stands.
+	m_bufferPool->replenish();
 }
 
 void AudioContext::markForDeletion(ContextRenderLock& r, AudioNode* node)
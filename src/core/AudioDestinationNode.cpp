@@ -136,6 +136,8 @@ void AudioDestinationNode::render(AudioBus* sourceBus, AudioBus* destinationBus,
         destinationBus->copyFrom(*renderedBus);
     }
 
+    input(0)->releaseSummingBus();
+
     // Process nodes which need a little extra help because they are not connected to anything, but still need to process.
     m_context->processAutomaticPullNodes(renderLock, numberOfFrames);
 
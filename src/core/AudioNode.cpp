@@ -234,6 +234,10 @@ void AudioNode::processIfNecessary(ContextRenderLock& r, size_t framesToProcess)
             process(r, framesToProcess);
             unsilenceOutputs(r);
         }
+
+        // The input summing buses are dead now that processing is done, so hand their memory to the next node.
+        for (auto & in : m_inputs)
+            in->releaseSummingBus();
     }
 }
 
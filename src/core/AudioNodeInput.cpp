@@ -30,7 +30,9 @@
 #include "LabSound/extended/AudioContextLock.h"
 
 #include "internal/AudioBus.h"
+#include "internal/AudioBufferPool.h"
 #include "internal/Assertions.h"
+#include "internal/VectorMath.h"
 
 #include <algorithm>
 #include <mutex>
@@ -92,7 +94,22 @@ void AudioNodeInput::updateInternalBus(ContextRenderLock& r)
     if (numberOfInputChannels == m_internalSummingBus->numberOfChannels())
         return;
 
-    m_internalSummingBus = std::unique_ptr<AudioBus>(new AudioBus(numberOfInputChannels, AudioNode::ProcessingSizeInFrames));
+    // Without the render lock there is no pool to draw from, so a heap bus stands in until the next render.
+    if (!r.context()) {
+        m_internalSummingBus = std::unique_ptr<AudioBus>(new AudioBus(numberOfInputChannels, AudioNode::ProcessingSizeInFrames));
+        return;
+    }
+
+    // This may happen mid-pull, while the summing bus holds pooled memory, so keep it in the same state.
+    bool wasAcquired = m_internalSummingBus->isPooled();
+    m_internalSummingBus = std::unique_ptr<AudioBus>(new AudioBus(numberOfInputChannels, r.context()->bufferPool()));
+    if (!wasAcquired)
+        m_internalSummingBus->releasePooledMemory();
+}
+
+void AudioNodeInput::releaseSummingBus()
+{
+    m_internalSummingBus->releasePooledMemory();
 }
 
 unsigned AudioNodeInput::numberOfChannels(ContextRenderLock& r) const
@@ -126,11 +143,18 @@ AudioBus* AudioNodeInput::bus(ContextRenderLock& r)
         return renderingOutput(r, 0)->bus(r);
 
     // Multiple connections case (or no connections).
-    return internalSummingBus(r);
+    return m_internalSummingBus.get();
 }
 
 AudioBus* AudioNodeInput::internalSummingBus(ContextRenderLock& r)
 {
+    // Borrow memory from the pool for the rest of this render quantum; see releaseSummingBus().
+    // Without the render lock, a bus that has given its blocks back gets memory of its own instead.
+    if (r.context())
+        m_internalSummingBus->acquirePooledMemory(r.context()->bufferPool());
+    else if (!m_internalSummingBus->isPooled() && !m_internalSummingBus->channel(0)->ownsStorage())
+        m_internalSummingBus = std::unique_ptr<AudioBus>(new AudioBus(m_internalSummingBus->numberOfChannels(), AudioNode::ProcessingSizeInFrames));
+
     return m_internalSummingBus.get();
 }
 
@@ -143,20 +167,50 @@ void AudioNodeInput::sumAllConnections(ContextRenderLock& r, AudioBus* summingBu
     ASSERT(summingBus);
     if (!summingBus)
         return;
-        
-    summingBus->zero();
 
+    // Render audio from every connection before summing any of it. The buses stay valid for the rest of the
+    // render quantum, and having them all at hand lets the sum be made in a few passes over the summing bus
+    // instead of one per connection. Silent connections contribute nothing and are dropped here.
+    m_connectionBuses.clear();
     for (int i = 0; i < c; ++i)
     {
         auto output = renderingOutput(r, i);
         if (output)
         {
-            // Render audio from this output.
             AudioBus* connectionBus = output->pull(r, 0, framesToProcess);
-            
-            // Sum, with unity-gain.
-            summingBus->sumFrom(*connectionBus);
+            if (!connectionBus->isSilent())
+                m_connectionBuses.push_back(connectionBus);
+        }
+    }
+
+    // Sum, with unity-gain, the connections whose layout matches ours. vmix() overwrites the summing bus with
+    // the first connection rather than zeroing it first, and accumulates the rest several connections at a time.
+    unsigned numberOfChannels = summingBus->numberOfChannels();
+    for (unsigned channelIndex = 0; channelIndex < numberOfChannels; ++channelIndex)
+    {
+        m_channelSources.clear();
+        for (AudioBus* connectionBus : m_connectionBuses)
+        {
+            if (connectionBus->numberOfChannels() != numberOfChannels)
+                continue;
+
+            const AudioChannel* source = connectionBus->channel(channelIndex);
+            if (!source->isSilent())
+                m_channelSources.push_back(source->data());
         }
+
+        AudioChannel* destination = summingBus->channel(channelIndex);
+        if (m_channelSources.empty())
+            destination->zero();
+        else
+            VectorMath::vmix(m_channelSources.data(), nullptr, m_channelSources.size(), destination->mutableData(), false, summingBus->length());
+    }
+
+    // Connections with a different layout are up or down mixed into the sum through a mixing matrix.
+    for (AudioBus* connectionBus : m_connectionBuses)
+    {
+        if (connectionBus->numberOfChannels() != numberOfChannels)
+            summingBus->sumFrom(*connectionBus);
     }
 }
 
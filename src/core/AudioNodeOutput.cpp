@@ -31,6 +31,7 @@
 
 #include "internal/Assertions.h"
 #include "internal/AudioBus.h"
+#include "internal/AudioBufferPool.h"
 
 #include <mutex>
 
@@ -55,6 +56,8 @@ AudioNodeOutput::AudioNodeOutput(AudioNode* node, unsigned numberOfChannels)
 {
     ASSERT(numberOfChannels <= AudioContext::maxNumberOfChannels);
     
+    // There is no context yet, so this bus is heap allocated. It is moved into the context's
+    // buffer pool the first time the output is rendered.
     m_internalBus.reset(new AudioBus(numberOfChannels, AudioNode::ProcessingSizeInFrames));
 }
 
@@ -72,15 +75,27 @@ void AudioNodeOutput::setNumberOfChannels(ContextRenderLock& r, unsigned numberO
         return;
     
     m_desiredNumberOfChannels = numberOfChannels;
-    m_internalBus.reset(new AudioBus(numberOfChannels, AudioNode::ProcessingSizeInFrames));
+
+    // Without the render lock there is no pool to draw from, so a heap bus stands in until the output is rendered.
+    if (r.context())
+        m_internalBus.reset(new AudioBus(numberOfChannels, r.context()->bufferPool()));
+    else
+        m_internalBus.reset(new AudioBus(numberOfChannels, AudioNode::ProcessingSizeInFrames));
 }
 
-void AudioNodeOutput::updateInternalBus()
+void AudioNodeOutput::updateInternalBus(ContextRenderLock& r)
 {
-    if (numberOfChannels() == m_internalBus->numberOfChannels())
+    if (numberOfChannels() == m_internalBus->numberOfChannels() && m_internalBus->isPooled())
         return;
 
-    m_internalBus.reset(new AudioBus(numberOfChannels(), AudioNode::ProcessingSizeInFrames));
+    // As in setNumberOfChannels(), a heap bus stands in without the render lock.
+    if (!r.context()) {
+        if (numberOfChannels() != m_internalBus->numberOfChannels())
+            m_internalBus.reset(new AudioBus(numberOfChannels(), AudioNode::ProcessingSizeInFrames));
+        return;
+    }
+
+    m_internalBus.reset(new AudioBus(numberOfChannels(), r.context()->bufferPool()));
 }
 
 void AudioNodeOutput::updateRenderingState(ContextRenderLock& r)
@@ -89,9 +104,13 @@ void AudioNodeOutput::updateRenderingState(ContextRenderLock& r)
     {
         ASSERT(r.context());
         m_numberOfChannels = m_desiredNumberOfChannels;
-        updateInternalBus();
+        updateInternalBus(r);
         propagateChannelCount(r);
     }
+    else if (!m_internalBus->isPooled())
+    {
+        updateInternalBus(r);
+    }
     m_renderingFanOutCount = fanOutCount();
     m_renderingParamFanOutCount = paramFanOutCount();
 }
@@ -49,6 +49,16 @@ std::shared_ptr<AudioParam> DelayNode::delayTime()
     return delayProcessor()->delayTime();
 }
 
+void DelayNode::setInterpolation(DelayInterpolation interpolation)
+{
+    delayProcessor()->setInterpolation(interpolation);
+}
+
+DelayInterpolation DelayNode::interpolation()
+{
+    return delayProcessor()->interpolation();
+}
+
 DelayProcessor * DelayNode::delayProcessor() 
 { 
 	return static_cast<DelayProcessor*>(processor()); 
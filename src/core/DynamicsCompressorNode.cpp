@@ -37,7 +37,7 @@ using namespace std;
 namespace WebCore
 {
 
-DynamicsCompressorNode::DynamicsCompressorNode(float sampleRate) : AudioNode(sampleRate)
+DynamicsCompressorNode::DynamicsCompressorNode(float sampleRate, float maxPreDelayTime) : AudioNode(sampleRate), m_maxPreDelayTime(maxPreDelayTime)
 {
     addInput(std::unique_ptr<AudioNodeInput>(new AudioNodeInput(this)));
     addOutput(std::unique_ptr<AudioNodeOutput>(new AudioNodeOutput(this, 2)));
@@ -50,6 +50,7 @@ DynamicsCompressorNode::DynamicsCompressorNode(float sampleRate) : AudioNode(sam
     m_reduction = make_shared<AudioParam>("reduction", 0, -20, 0);
     m_attack = make_shared<AudioParam>("attack", 0.003, 0, 1);
     m_release = make_shared<AudioParam>("release", 0.250, 0, 1);
+    m_preDelay = make_shared<AudioParam>("preDelay", 0.006, 0, maxPreDelayTime);
 
     initialize();
 }
@@ -69,12 +70,14 @@ void DynamicsCompressorNode::process(ContextRenderLock& r, size_t framesToProces
     float ratio = m_ratio->value(r);
     float attack = m_attack->value(r);
     float release = m_release->value(r);
+    float preDelay = m_preDelay->value(r);
 
     m_dynamicsCompressor->setParameterValue(DynamicsCompressor::ParamThreshold, threshold);
     m_dynamicsCompressor->setParameterValue(DynamicsCompressor::ParamKnee, knee);
     m_dynamicsCompressor->setParameterValue(DynamicsCompressor::ParamRatio, ratio);
     m_dynamicsCompressor->setParameterValue(DynamicsCompressor::ParamAttack, attack);
     m_dynamicsCompressor->setParameterValue(DynamicsCompressor::ParamRelease, release);
+    m_dynamicsCompressor->setParameterValue(DynamicsCompressor::ParamPreDelay, preDelay);
 
     m_dynamicsCompressor->process(r, input(0)->bus(r), outputBus, framesToProcess);
 
@@ -92,7 +95,7 @@ void DynamicsCompressorNode::initialize()
     if (isInitialized())
         return;
 
-    m_dynamicsCompressor.reset(new DynamicsCompressor(sampleRate(), 2));
+    m_dynamicsCompressor.reset(new DynamicsCompressor(sampleRate(), 2, m_maxPreDelayTime));
     
     AudioNode::initialize();
 }
@@ -43,11 +43,6 @@ namespace WebCore {
 
 using namespace VectorMath;
 
-std::shared_ptr<WaveTable> OscillatorNode::s_waveTableSine = 0;
-std::shared_ptr<WaveTable> OscillatorNode::s_waveTableSquare = 0;
-std::shared_ptr<WaveTable> OscillatorNode::s_waveTableSawtooth = 0;
-std::shared_ptr<WaveTable> OscillatorNode::s_waveTableTriangle = 0;
-
 OscillatorNode::OscillatorNode(ContextRenderLock& r, float sampleRate)
     : AudioScheduledSourceNode(sampleRate)
     , m_type(OscillatorType::SINE)
@@ -80,45 +75,11 @@ OscillatorNode::~OscillatorNode()
 
 void OscillatorNode::setType(bool isConstructor, OscillatorType type)
 {
-    std::shared_ptr<WaveTable> waveTable;
-    float sampleRate = this->sampleRate();
-
-    switch (type) 
-	{
-		case OscillatorType::SINE:
-			if (!s_waveTableSine)
-			{
-				s_waveTableSine = std::make_shared<WaveTable>(sampleRate, OscillatorType::SINE);
-			}
-			waveTable = s_waveTableSine;
-			break;
-		case OscillatorType::SQUARE:
-			if (!s_waveTableSquare)
-			{
-				s_waveTableSquare = std::make_shared<WaveTable>(sampleRate, OscillatorType::SQUARE);
-			}
-			waveTable = s_waveTableSquare;
-			break;
-		case OscillatorType::SAWTOOTH:
-			if (!s_waveTableSawtooth)
-			{
-				s_waveTableSawtooth = std::make_shared<WaveTable>(sampleRate, OscillatorType::SAWTOOTH);
-			}
-			waveTable = s_waveTableSawtooth;
-			break;
-		case OscillatorType::TRIANGLE:
-			if (!s_waveTableTriangle)
-			{           
-				s_waveTableTriangle = std::make_shared<WaveTable>(sampleRate, OscillatorType::TRIANGLE);
-			}
-			waveTable = s_waveTableTriangle;
-			break;
-		case OscillatorType::CUSTOM:
-		default:
-            throw std::invalid_argument("Cannot set wavtable for custom type");
-    }
+    if (type == OscillatorType::CUSTOM)
+        throw std::invalid_argument("Cannot set wavtable for custom type");
 
-    setWaveTable(true, waveTable);
+    // The basic waveforms are shared by every oscillator running at this sample rate.
+    setWaveTable(true, WaveTable::create(sampleRate(), type));
     m_type = type;
 }
 
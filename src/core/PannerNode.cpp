@@ -149,6 +149,21 @@ void PannerNode::process(ContextRenderLock& r, size_t framesToProcess)
 
 	//@tofix make sure hrtf database is loaded
 
+    // A virtualized panner that has faded out does no more work until it is made real again. Its panner's
+    // state is then out of date, so it starts afresh, and fades in from silence.
+    bool virtualized = m_virtualized;
+    if (m_isSilent)
+    {
+        if (virtualized)
+        {
+            destination->zero();
+            return;
+        }
+
+        m_panner->reset();
+        m_isSilent = false;
+    }
+
     // Apply the panning effect.
     double azimuth;
     double elevation;
@@ -156,8 +171,8 @@ void PannerNode::process(ContextRenderLock& r, size_t framesToProcess)
 
     m_panner->pan(r, azimuth, elevation, source, destination, framesToProcess);
 
-    // Get the distance and cone gain.
-    double totalGain = distanceConeGain(r);
+    // Get the distance and cone gain, or fade out if virtualized.
+    double totalGain = virtualized ? 0.0 : distanceConeGain(r);
 
     // Snap to desired gain at the beginning.
     if (m_lastGain == -1.0)
@@ -165,6 +180,14 @@ void PannerNode::process(ContextRenderLock& r, size_t framesToProcess)
         
     // Apply gain in-place with de-zippering.
     destination->copyWithGainFrom(*destination, &m_lastGain, totalGain);
+
+    // The de-zippering snaps to the target once it is close enough, so a fade out ends at exactly 0. A silent
+    // input leaves nothing to fade.
+    if (virtualized && (m_lastGain == 0 || source->isSilent()))
+    {
+        m_lastGain = 0;
+        m_isSilent = true;
+    }
 }
 
 void PannerNode::reset(ContextRenderLock&)
@@ -215,6 +238,7 @@ void PannerNode::setDistanceModel(unsigned short model)
 		case DistanceEffect::ModelInverse:
 		case DistanceEffect::ModelExponential:
 			m_distanceEffect->setModel(static_cast<DistanceEffect::ModelType>(model), true);
+			++m_version;
 			break;
 		default:
 			throw std::invalid_argument("invalid distance model");
@@ -224,12 +248,44 @@ void PannerNode::setDistanceModel(unsigned short model)
 
 void PannerNode::getAzimuthElevation(ContextRenderLock& r, double* outAzimuth, double* outElevation)
 {
-    // FIXME: we should cache azimuth and elevation (if possible), so we only re-calculate if a change has been made.
+    AudioListener* l = listener(r);
+    unsigned version = m_version;
+    unsigned listenerVersion = l->version();
 
+    if (!m_azimuthElevationCache.isCurrent(version, listenerVersion))
+    {
+        computeAzimuthElevation(l, &m_cachedAzimuth, &m_cachedElevation);
+        m_azimuthElevationCache.update(version, listenerVersion);
+    }
+
+    if (outAzimuth)
+        *outAzimuth = m_cachedAzimuth;
+    if (outElevation)
+        *outElevation = m_cachedElevation;
+}
+
+void PannerNode::setComputedGeometry(unsigned version, unsigned listenerVersion, double azimuth, double elevation,
+                                     float distanceGain, float coneGain, float dopplerRate)
+{
+    m_cachedAzimuth = azimuth;
+    m_cachedElevation = elevation;
+    m_azimuthElevationCache.update(version, listenerVersion);
+
+    m_distanceGain->setValue(distanceGain);
+    m_coneGain->setValue(coneGain);
+    m_cachedDistanceConeGain = distanceGain * coneGain;
+    m_distanceConeGainCache.update(version, listenerVersion);
+
+    m_cachedDopplerRate = dopplerRate;
+    m_dopplerRateCache.update(version, listenerVersion);
+}
+
+void PannerNode::computeAzimuthElevation(AudioListener* l, double* outAzimuth, double* outElevation)
+{
     double azimuth = 0.0;
 
     // Calculate the source-listener vector
-    FloatPoint3D listenerPosition = listener(r)->position();
+    FloatPoint3D listenerPosition = l->position();
     FloatPoint3D sourceListener = m_position - listenerPosition;
 
     if (sourceListener.isZero()) 
@@ -243,15 +299,9 @@ void PannerNode::getAzimuthElevation(ContextRenderLock& r, double* outAzimuth, d
     sourceListener.normalize();
 
     // Align axes
-    FloatPoint3D listenerFront = listener(r)->orientation();
-    FloatPoint3D listenerUp = listener(r)->upVector();
-    FloatPoint3D listenerRight = listenerFront.cross(listenerUp);
-    listenerRight.normalize();
-
-    FloatPoint3D listenerFrontNorm = listenerFront;
-    listenerFrontNorm.normalize();
-
-    FloatPoint3D up = listenerRight.cross(listenerFrontNorm);
+    const FloatPoint3D& listenerRight = l->rightBasis();
+    const FloatPoint3D& listenerFrontNorm = l->frontBasis();
+    const FloatPoint3D& up = l->upBasis();
 
     float upProjection = sourceListener.dot(up);
 
@@ -281,17 +331,20 @@ void PannerNode::getAzimuthElevation(ContextRenderLock& r, double* outAzimuth, d
     else if (elevation < -90.0)
         elevation = -180.0 - elevation;
 
-    if (outAzimuth)
-        *outAzimuth = azimuth;
-    if (outElevation)
-        *outElevation = elevation;
+    *outAzimuth = azimuth;
+    *outElevation = elevation;
 }
 
 float PannerNode::dopplerRate(ContextRenderLock& r)
 {
+    unsigned version = m_version;
+    unsigned listenerVersion = listener(r)->version();
+
+    if (m_dopplerRateCache.isCurrent(version, listenerVersion))
+        return m_cachedDopplerRate;
+
     double dopplerShift = 1.0;
 
-    // FIXME: optimize for case when neither source nor listener has changed...
     double dopplerFactor = listener(r)->dopplerFactor();
 
     if (dopplerFactor > 0.0) 
@@ -305,12 +358,13 @@ float PannerNode::dopplerRate(ContextRenderLock& r)
         bool sourceHasVelocity = !sourceVelocity.isZero();
         bool listenerHasVelocity = !listenerVelocity.isZero();
 
-        if (sourceHasVelocity || listenerHasVelocity) 
-		{
-            // Calculate the source to listener vector
-            FloatPoint3D listenerPosition = listener(r)->position();
-            FloatPoint3D sourceToListener = m_position - listenerPosition;
+        // Calculate the source to listener vector
+        FloatPoint3D listenerPosition = listener(r)->position();
+        FloatPoint3D sourceToListener = m_position - listenerPosition;
 
+        // There's no direction to project the velocities on when the source is at the listener
+        if ((sourceHasVelocity || listenerHasVelocity) && !sourceToListener.isZero()) 
+		{
             double sourceListenerMagnitude = sourceToListener.length();
 
             double listenerProjection = sourceToListener.dot(listenerVelocity) / sourceListenerMagnitude;
@@ -334,11 +388,19 @@ float PannerNode::dopplerRate(ContextRenderLock& r)
         }
     }
 
-    return static_cast<float>(dopplerShift);
+    m_cachedDopplerRate = static_cast<float>(dopplerShift);
+    m_dopplerRateCache.update(version, listenerVersion);
+    return m_cachedDopplerRate;
 }
 
 float PannerNode::distanceConeGain(ContextRenderLock& r)
 {
+    unsigned version = m_version;
+    unsigned listenerVersion = listener(r)->version();
+
+    if (m_distanceConeGainCache.isCurrent(version, listenerVersion))
+        return m_cachedDistanceConeGain;
+
     FloatPoint3D listenerPosition = listener(r)->position();
 
     double listenerDistance = m_position.distanceTo(listenerPosition);
@@ -347,12 +409,13 @@ float PannerNode::distanceConeGain(ContextRenderLock& r)
     
     m_distanceGain->setValue(static_cast<float>(distanceGain));
 
-    // FIXME: could optimize by caching coneGain
     double coneGain = m_coneEffect->gain(m_position, m_orientation, listenerPosition);
     
     m_coneGain->setValue(static_cast<float>(coneGain));
 
-    return float(distanceGain * coneGain);
+    m_cachedDistanceConeGain = float(distanceGain * coneGain);
+    m_distanceConeGainCache.update(version, listenerVersion);
+    return m_cachedDistanceConeGain;
 }
 
 void PannerNode::notifyAudioSourcesConnectedToNode(ContextRenderLock& r, AudioNode* node)
@@ -388,22 +451,22 @@ void PannerNode::notifyAudioSourcesConnectedToNode(ContextRenderLock& r, AudioNo
 unsigned short PannerNode::distanceModel() { return m_distanceEffect->model(); }
 float PannerNode::refDistance() { return static_cast<float>(m_distanceEffect->refDistance()); }
 
-void PannerNode::setRefDistance(float refDistance) { m_distanceEffect->setRefDistance(refDistance); }
+void PannerNode::setRefDistance(float refDistance) { m_distanceEffect->setRefDistance(refDistance); ++m_version; }
 
 float PannerNode::maxDistance() { return static_cast<float>(m_distanceEffect->maxDistance()); }
-void PannerNode::setMaxDistance(float maxDistance) { m_distanceEffect->setMaxDistance(maxDistance); }
+void PannerNode::setMaxDistance(float maxDistance) { m_distanceEffect->setMaxDistance(maxDistance); ++m_version; }
 
 float PannerNode::rolloffFactor() { return static_cast<float>(m_distanceEffect->rolloffFactor()); }
-void PannerNode::setRolloffFactor(float rolloffFactor) { m_distanceEffect->setRolloffFactor(rolloffFactor); }
+void PannerNode::setRolloffFactor(float rolloffFactor) { m_distanceEffect->setRolloffFactor(rolloffFactor); ++m_version; }
 
 float PannerNode::coneInnerAngle() const { return static_cast<float>(m_coneEffect->innerAngle()); }
-void PannerNode::setConeInnerAngle(float angle) { m_coneEffect->setInnerAngle(angle); }
+void PannerNode::setConeInnerAngle(float angle) { m_coneEffect->setInnerAngle(angle); ++m_version; }
 
 float PannerNode::coneOuterAngle() const { return static_cast<float>(m_coneEffect->outerAngle()); }
-void PannerNode::setConeOuterAngle(float angle) { m_coneEffect->setOuterAngle(angle); }
+void PannerNode::setConeOuterAngle(float angle) { m_coneEffect->setOuterAngle(angle); ++m_version; }
 
 float PannerNode::coneOuterGain() const { return static_cast<float>(m_coneEffect->outerGain()); }
-void PannerNode::setConeOuterGain(float angle) { m_coneEffect->setOuterGain(angle); }
+void PannerNode::setConeOuterGain(float angle) { m_coneEffect->setOuterGain(angle); ++m_version; }
 
 double PannerNode::tailTime() const { return m_panner ? m_panner->tailTime() : 0; }
 double PannerNode::latencyTime() const { return m_panner ? m_panner->latencyTime() : 0; }
@@ -26,15 +26,11 @@
 #include "LabSound/extended/AudioContextLock.h"
 
 #include "internal/AudioBus.h"
-#include "internal/AudioUtilities.h"
-#include "internal/FFTFrame.h"
+#include "internal/SpectralAnalysis.h"
 #include "internal/VectorMath.h"
 
-#include <WTF/MathExtras.h>
-
 #include <algorithm>
 #include <limits.h>
-#include <complex>
 
 using namespace std;
 
@@ -62,23 +58,6 @@ uint32_t RoundNextPow2(uint32_t v)
     return v;
 }
     
-void ApplyBlackmanWindow(float * p, uint32_t n)
-{
-    // Blackman window
-    double alpha = 0.16;
-    double a0 = 0.5 * (1 - alpha);
-    double a1 = 0.5;
-    double a2 = 0.5 * alpha;
-    
-    for (uint32_t i = 0; i < n; ++i) 
-	{
-        double x = static_cast<double>(i) / static_cast<double>(n);
-        double window = a0 - a1 * cos(2 * piDouble * x) + a2 * cos(4 * piDouble * x);
-        p[i] *= float(window);
-    }
-
-}
-
 RealtimeAnalyser::RealtimeAnalyser(uint32_t fftSize)
     : m_inputBuffer(InputBufferSize)
     , m_writeIndex(0)
@@ -89,10 +68,11 @@ RealtimeAnalyser::RealtimeAnalyser(uint32_t fftSize)
     uint32_t size = max(min(RoundNextPow2(fftSize), MaxFFTSize), MinFFTSize);
     m_fftSize = size;
     
-    m_analysisFrame = std::unique_ptr<FFTFrame>(new FFTFrame(size));
+    m_analysis = std::unique_ptr<SpectralAnalysis>(new SpectralAnalysis(size));
     
-    // m_magnitudeBuffer has size = fftSize / 2 because it contains floats reduced from complex values in m_analysisFrame.
+    // m_magnitudeBuffer has size = fftSize / 2 because it contains floats reduced from the complex spectrum.
     m_magnitudeBuffer.allocate(size / 2);
+    m_decibelBuffer.allocate(size / 2);
 }
 
 RealtimeAnalyser::~RealtimeAnalyser()
@@ -144,53 +124,11 @@ void RealtimeAnalyser::writeInput(ContextRenderLock &r, AudioBus* bus, size_t fr
 
 void RealtimeAnalyser::doFFTAnalysis()
 {    
-    // Unroll the input buffer into a temporary buffer, where we'll apply an analysis window followed by an FFT.
-    uint32_t fftSize = this->fftSize();
-    
-    AudioFloatArray temporaryBuffer(fftSize);
-    float* inputBuffer = m_inputBuffer.data();
-    float* tempP = temporaryBuffer.data();
-
-    // Take the previous fftSize values from the input buffer and copy into the temporary buffer.
-    unsigned writeIndex = m_writeIndex;
-    if (writeIndex < fftSize) 
-	{
-        memcpy(tempP, inputBuffer + writeIndex - fftSize + InputBufferSize, sizeof(*tempP) * (fftSize - writeIndex));
-        memcpy(tempP + fftSize - writeIndex, inputBuffer, sizeof(*tempP) * writeIndex);
-    }
-    else
-	{
-		memcpy(tempP, inputBuffer + writeIndex - fftSize, sizeof(*tempP) * fftSize);
-	}
-
-    // Window the input samples.
-    ApplyBlackmanWindow(tempP, fftSize);
-    
-    // Do the analysis.
-    m_analysisFrame->doFFT(tempP);
-
-    float* realP = m_analysisFrame->realData();
-    float* imagP = m_analysisFrame->imagData();
-
-    // Blow away the packed nyquist component.
-    imagP[0] = 0;
-    
     // Normalize so than an input sine wave at 0dBfs registers as 0dBfs (undo FFT scaling factor).
-    const double magnitudeScale = 1.0 / DefaultFFTSize;
+    const float magnitudeScale = 1.0f / DefaultFFTSize;
 
     // A value of 0 does no averaging with the previous result.  Larger values produce slower, but smoother changes.
-    double k = m_smoothingTimeConstant;
-    k = max(0.0, k);
-    k = min(1.0, k);    
-    
-    // Convert the analysis data from complex to magnitude and average with the previous result.
-    float* destination = magnitudeBuffer().data();
-    size_t n = magnitudeBuffer().size();
-    for (size_t i = 0; i < n; ++i) {
-        std::complex<double> c(realP[i], imagP[i]);
-        double scalarMagnitude = abs(c) * magnitudeScale;        
-        destination[i] = float(k * destination[i] + (1 - k) * scalarMagnitude);
-    }
+    m_analysis->analyze(m_inputBuffer.data(), InputBufferSize, m_writeIndex, magnitudeScale, static_cast<float>(m_smoothingTimeConstant), magnitudeBuffer().data());
 }
 
 void RealtimeAnalyser::getFloatFrequencyData(std::vector<float>& destinationArray)
@@ -201,17 +139,8 @@ void RealtimeAnalyser::getFloatFrequencyData(std::vector<float>& destinationArra
     doFFTAnalysis();
     
     // Convert from linear magnitude to floating-point decibels.
-    const double minDecibels = m_minDecibels;
-    size_t sourceLength = magnitudeBuffer().size();
-    size_t len = min(sourceLength, destinationArray.size());
-    if (len > 0) {
-        const float* source = magnitudeBuffer().data();
-        for (unsigned i = 0; i < len; ++i) {
-            float linearValue = source[i];
-            double dbMag = !linearValue ? minDecibels : AudioUtilities::linearToDecibels(linearValue);
-            destinationArray[i] = float(dbMag);
-        }
-    }
+    size_t len = min(magnitudeBuffer().size(), destinationArray.size());
+    SpectralAnalysis::magnitudesToDecibels(magnitudeBuffer().data(), destinationArray.data(), len, static_cast<float>(m_minDecibels));
 }
 
 void RealtimeAnalyser::getByteFrequencyData(std::vector<uint8_t>& destinationArray)
@@ -222,29 +151,10 @@ void RealtimeAnalyser::getByteFrequencyData(std::vector<uint8_t>& destinationArr
     doFFTAnalysis();
     
     // Convert from linear magnitude to unsigned-byte decibels.
-    size_t sourceLength = magnitudeBuffer().size();
-    size_t len = min(sourceLength, destinationArray.size());
-    if (len > 0) {
-        const double rangeScaleFactor = m_maxDecibels == m_minDecibels ? 1 : 1 / (m_maxDecibels - m_minDecibels);
-        const double minDecibels = m_minDecibels;
-
-        const float* source = magnitudeBuffer().data();
-        for (unsigned i = 0; i < len; ++i) {
-            float linearValue = source[i];
-            double dbMag = !linearValue ? minDecibels : AudioUtilities::linearToDecibels(linearValue);
-            
-            // The range m_minDecibels to m_maxDecibels will be scaled to byte values from 0 to UCHAR_MAX.
-            double scaledValue = UCHAR_MAX * (dbMag - minDecibels) * rangeScaleFactor;
-
-            // Clip to valid range.
-            if (scaledValue < 0)
-                scaledValue = 0;
-            if (scaledValue > UCHAR_MAX)
-                scaledValue = UCHAR_MAX;
-            
-            destinationArray[i] = static_cast<unsigned char>(scaledValue);
-        }
-    }
+    // The range m_minDecibels to m_maxDecibels will be scaled to byte values from 0 to UCHAR_MAX.
+    size_t len = min(magnitudeBuffer().size(), destinationArray.size());
+    SpectralAnalysis::magnitudesToDecibels(magnitudeBuffer().data(), m_decibelBuffer.data(), len, static_cast<float>(m_minDecibels));
+    SpectralAnalysis::decibelsToBytes(m_decibelBuffer.data(), destinationArray.data(), len, static_cast<float>(m_minDecibels), static_cast<float>(m_maxDecibels));
 }
 
 // LabSound begin
@@ -8,6 +8,7 @@
 #include "LabSound/extended/AudioContextLock.h"
 
 #include "internal/AudioBus.h"
+#include "internal/EqualPowerPanner.h"
 #include "internal/Panner.h"
 #include "internal/AudioUtilities.h"
 #include <WTF/MathExtras.h>
@@ -155,6 +156,28 @@ public:
             m_pan = targetPan;
         }
         
+        // The pan approaches the target by the smoothing constant of the way each frame, so where it is at the
+        // first and the last frame of the quantum has a closed form. Unless a stereo source's pan crosses the
+        // centre, where one side stops passing through and the other starts, the gains for those two frames
+        // are all the trigonometry the quantum needs; the gains ramp linearly between them.
+        double decay = std::pow(1 - m_smoothingConstant, static_cast<double>(framesToProcess));
+        double firstPan = m_pan + (targetPan - m_pan) * m_smoothingConstant;
+        double lastPan = targetPan + (m_pan - targetPan) * decay;
+        
+        if (numberOfInputChannels == 1 || (firstPan <= 0) == (lastPan <= 0))
+        {
+            double firstGainL, firstGainR, lastGainL, lastGainR;
+            gainsForPan(firstPan, numberOfInputChannels, firstGainL, firstGainR);
+            gainsForPan(lastPan, numberOfInputChannels, lastGainL, lastGainR);
+            
+            double frames = framesToProcess > 1 ? static_cast<double>(framesToProcess - 1) : 1.0;
+            EqualPowerPanner::applyGains(sourceL, sourceR, destinationL, destinationR, firstPan <= 0,
+                                         static_cast<float>(firstGainL), static_cast<float>((lastGainL - firstGainL) / frames),
+                                         static_cast<float>(firstGainR), static_cast<float>((lastGainR - firstGainR) / frames), framesToProcess);
+            m_pan = lastPan;
+            return;
+        }
+        
         double gainL, gainR, panRadian;
         const double smoothingConstant = m_smoothingConstant;
         int n = framesToProcess;
@@ -233,6 +256,19 @@ public:
 
 private:
     
+    // The equal-power gains for a pan position, as panWithSampleAccurateValues computes them.
+    static void gainsForPan(double pan, unsigned numberOfInputChannels, double& gainL, double& gainR)
+    {
+        double panRadian;
+        if (numberOfInputChannels == 1)
+            panRadian = (pan * 0.5 + 0.5) * piOverTwoDouble;
+        else
+            panRadian = (pan <= 0 ? pan + 1 : pan) * piOverTwoDouble;
+        
+        gainL = std::cos(panRadian);
+        gainR = std::sin(panRadian);
+    }
+    
     bool m_isFirstRender = true;
     double m_pan = 0.0;
     
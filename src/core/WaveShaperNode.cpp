@@ -45,6 +45,16 @@ std::shared_ptr<std::vector<float>> WaveShaperNode::curve()
     return waveShaperProcessor()->curve();
 }
 
+void WaveShaperNode::setOversample(ContextRenderLock& r, OverSampleType type)
+{
+    waveShaperProcessor()->setOversample(r, type);
+}
+
+OverSampleType WaveShaperNode::oversample()
+{
+    return waveShaperProcessor()->oversample();
+}
+
  WaveShaperProcessor * WaveShaperNode::waveShaperProcessor() 
  {
 	 return static_cast<WaveShaperProcessor *>(m_processor.get());
@@ -37,6 +37,11 @@
 #include <algorithm>
 #include <iostream>
 #include <exception>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <stdint.h>
+#include <unordered_map>
 
 const unsigned WaveTableSize = 4096; // This must be a power of two.
 const unsigned NumberOfRanges = 36; // There should be 3 * log2(WaveTableSize) 1/3 octave ranges.
@@ -60,7 +65,7 @@ WaveTable::WaveTable(float sampleRate, OscillatorType basicWaveform) :
 	generateBasicWaveform(basicWaveform);
 }
 
-WaveTable::WaveTable(float sampleRate, OscillatorType basicWaveform, std::vector<float> & real, std::vector<float> & imag)
+WaveTable::WaveTable(float sampleRate, OscillatorType basicWaveform, const std::vector<float> & real, const std::vector<float> & imag)
 	: m_sampleRate(sampleRate),
 	m_waveTableSize(WaveTableSize), 
 	m_numberOfRanges(NumberOfRanges), 
@@ -87,6 +92,139 @@ WaveTable::~WaveTable()
 
 }
 
+namespace
+{
+    struct CustomWaveTable
+    {
+        float sampleRate;
+        std::vector<float> real;
+        std::vector<float> imag;
+        std::weak_ptr<WaveTable> waveTable;
+    };
+
+    struct WaveTableCache
+    {
+        std::mutex lock;
+        std::map<std::pair<float, OscillatorType>, std::shared_ptr<WaveTable>> basic;
+        std::unordered_multimap<size_t, CustomWaveTable> custom;
+
+        // The custom tables are swept of entries nothing plays anymore whenever they grow to this size,
+        // which then doubles, so the sweeps cost a constant amount per insert.
+        size_t customSweepSize = 16;
+    };
+
+    WaveTableCache& waveTableCache()
+    {
+        static WaveTableCache cache;
+        return cache;
+    }
+
+    // FNV-1a over the sample rate and the spectrum.
+    size_t hashSpectrum(float sampleRate, const std::vector<float>& real, const std::vector<float>& imag)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        auto mix = [&hash](const void* data, size_t size)
+        {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            for (size_t i = 0; i < size; ++i)
+            {
+                hash ^= bytes[i];
+                hash *= 1099511628211ULL;
+            }
+        };
+
+        mix(&sampleRate, sizeof(sampleRate));
+        mix(real.data(), real.size() * sizeof(float));
+        mix(imag.data(), imag.size() * sizeof(float));
+        return static_cast<size_t>(hash);
+    }
+
+    std::shared_ptr<WaveTable> findCustom(WaveTableCache& cache, size_t hash, float sampleRate, const std::vector<float>& real, const std::vector<float>& imag)
+    {
+        auto range = cache.custom.equal_range(hash);
+        for (auto i = range.first; i != range.second; )
+        {
+            std::shared_ptr<WaveTable> waveTable = i->second.waveTable.lock();
+            if (!waveTable)
+            {
+                // Nothing plays this spectrum anymore.
+                i = cache.custom.erase(i);
+                continue;
+            }
+
+            if (i->second.sampleRate == sampleRate && i->second.real == real && i->second.imag == imag)
+                return waveTable;
+
+            ++i;
+        }
+        return nullptr;
+    }
+
+    void sweepCustom(WaveTableCache& cache)
+    {
+        for (auto i = cache.custom.begin(); i != cache.custom.end(); )
+        {
+            if (i->second.waveTable.expired())
+                i = cache.custom.erase(i);
+            else
+                ++i;
+        }
+        cache.customSweepSize = std::max<size_t>(16, cache.custom.size() * 2);
+    }
+}
+
+std::shared_ptr<WaveTable> WaveTable::create(float sampleRate, OscillatorType basicWaveform)
+{
+    if (basicWaveform == OscillatorType::CUSTOM)
+        throw std::invalid_argument("Custom wavetables must be created from a spectrum");
+
+    WaveTableCache& cache = waveTableCache();
+    auto key = std::make_pair(sampleRate, basicWaveform);
+
+    {
+        std::lock_guard<std::mutex> lock(cache.lock);
+        auto i = cache.basic.find(key);
+        if (i != cache.basic.end())
+            return i->second;
+    }
+
+    std::shared_ptr<WaveTable> waveTable = std::make_shared<WaveTable>(sampleRate, basicWaveform);
+
+    // If another thread built the same tables in the meantime, use the ones it published.
+    std::lock_guard<std::mutex> lock(cache.lock);
+    return cache.basic.insert(std::make_pair(key, waveTable)).first->second;
+}
+
+std::shared_ptr<WaveTable> WaveTable::create(float sampleRate, const std::vector<float> & real, const std::vector<float> & imag)
+{
+    WaveTableCache& cache = waveTableCache();
+    size_t hash = hashSpectrum(sampleRate, real, imag);
+
+    {
+        std::lock_guard<std::mutex> lock(cache.lock);
+        if (std::shared_ptr<WaveTable> waveTable = findCustom(cache, hash, sampleRate, real, imag))
+            return waveTable;
+    }
+
+    std::shared_ptr<WaveTable> waveTable = std::make_shared<WaveTable>(sampleRate, OscillatorType::CUSTOM, real, imag);
+
+    std::lock_guard<std::mutex> lock(cache.lock);
+    if (std::shared_ptr<WaveTable> published = findCustom(cache, hash, sampleRate, real, imag))
+        return published;
+
+    // Lookups only drop the dead entries that share their hash, so sweep the rest as the cache grows.
+    if (cache.custom.size() >= cache.customSweepSize)
+        sweepCustom(cache);
+
+    CustomWaveTable entry;
+    entry.sampleRate = sampleRate;
+    entry.real = real;
+    entry.imag = imag;
+    entry.waveTable = waveTable;
+    cache.custom.insert(std::make_pair(hash, entry));
+    return waveTable;
+}
+
 void WaveTable::waveDataForFundamentalFrequency(float fundamentalFrequency, float* &lowerWaveData, float* &higherWaveData, float& tableInterpolationFactor)
 {
     // Negative frequencies are allowed, in which case we alias to the positive frequency.
@@ -0,0 +1,118 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#include "LabSound/core/AudioNodeInput.h"
+#include "LabSound/core/AudioNodeOutput.h"
+
+#include "LabSound/extended/AudioTap.h"
+
+#include "internal/AudioBus.h"
+#include "internal/AudioRingBuffer.h"
+#include "internal/MixingMatrix.h"
+
+#include <algorithm>
+
+using namespace WebCore;
+
+namespace LabSound {
+
+AudioTap::AudioTap(unsigned numberOfChannels, size_t capacityInFrames)
+    : m_droppedFrames(0)
+{
+    numberOfChannels = std::min(std::max(numberOfChannels, 1u), MaxBusChannels);
+    capacityInFrames = std::max(capacityInFrames, static_cast<size_t>(2 * AudioNode::ProcessingSizeInFrames));
+
+    m_ring.reset(new AudioRingBuffer(numberOfChannels, capacityInFrames));
+    m_mixBus.reset(new AudioBus(numberOfChannels, AudioNode::ProcessingSizeInFrames));
+}
+
+AudioTap::~AudioTap()
+{
+}
+
+unsigned AudioTap::numberOfChannels() const
+{
+    return m_ring->numberOfChannels();
+}
+
+size_t AudioTap::capacity() const
+{
+    return m_ring->capacity();
+}
+
+void AudioTap::write(const AudioBus& bus, size_t framesToProcess)
+{
+    // Quanta are dropped whole, so what is read is never torn within a quantum.
+    if (m_ring->framesAvailableToWrite() < framesToProcess) {
+        m_droppedFrames += framesToProcess;
+        return;
+    }
+
+    const AudioBus* source = &bus;
+    if (bus.numberOfChannels() != m_mixBus->numberOfChannels() && framesToProcess <= m_mixBus->length()) {
+        m_mixBus->copyFrom(bus);
+        source = m_mixBus.get();
+    }
+
+    const float* channels[MaxBusChannels];
+    unsigned numberOfChannels = m_ring->numberOfChannels();
+    for (unsigned c = 0; c < numberOfChannels; ++c)
+        channels[c] = source->channel(std::min(c, source->numberOfChannels() - 1))->data();
+
+    m_ring->write(channels, framesToProcess);
+}
+
+size_t AudioTap::framesAvailable() const
+{
+    return m_ring->framesAvailableToRead();
+}
+
+size_t AudioTap::read(float* const* destinations, size_t framesToRead)
+{
+    return m_ring->read(destinations, framesToRead);
+}
+
+size_t AudioTap::readInterleaved(float* destination, size_t framesToRead)
+{
+    return m_ring->readInterleaved(destination, framesToRead);
+}
+
+TapNode::TapNode(float sampleRate, unsigned numberOfChannels, float capacitySeconds)
+    : AudioBasicInspectorNode(sampleRate, 2)
+    , m_tap(std::make_shared<AudioTap>(numberOfChannels, static_cast<size_t>(capacitySeconds * sampleRate)))
+{
+    setNodeType((AudioNode::NodeType) LabSound::NodeTypeTap);
+}
+
+TapNode::~TapNode()
+{
+    uninitialize();
+}
+
+void TapNode::process(ContextRenderLock& r, size_t framesToProcess)
+{
+    AudioBus* outputBus = output(0)->bus(r);
+
+    if (!isInitialized() || !input(0)->isConnected()) {
+        if (outputBus)
+            outputBus->zero();
+        return;
+    }
+
+    AudioBus* bus = input(0)->bus(r);
+    bool isBusGood = bus && bus->numberOfChannels() > 0 && bus->channel(0)->length() >= framesToProcess;
+    if (!isBusGood) {
+        outputBus->zero();
+        return;
+    }
+
+    m_tap->write(*bus, framesToProcess);
+
+    // For in-place processing, our override of pullInputs() will just pass the audio data
+    // through unchanged if the channel count matches from input to output
+    // (resulting in inputBus == outputBus). Otherwise, do an up-mix to stereo.
+    if (bus != outputBus)
+        outputBus->copyFrom(*bus);
+}
+
+} // namespace LabSound
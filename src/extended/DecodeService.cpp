@@ -0,0 +1,188 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#include "LabSound/extended/DecodeService.h"
+
+#include "internal/AudioBus.h"
+#include "internal/AudioFileReader.h"
+
+#include <algorithm>
+
+using namespace WebCore;
+
+namespace LabSound {
+
+struct DecodeService::Job
+{
+    std::string path;               // empty when decoding from memory
+    std::vector<uint8_t> buffer;
+    std::string extension;
+    bool mixToMono;
+    float sampleRate;
+    std::promise<Result> promise;
+};
+
+DecodeService::DecodeService(unsigned numberOfThreads)
+    : m_stopping(false)
+    , m_requested(0)
+    , m_completed(0)
+    , m_failed(0)
+{
+    if (!numberOfThreads)
+        numberOfThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (unsigned i = 0; i < numberOfThreads; ++i)
+        m_workers.emplace_back(&DecodeService::workerThread, this);
+}
+
+DecodeService::~DecodeService()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_stopping = true;
+        m_queue.clear();
+    }
+    m_queueCondition.notify_all();
+    m_idleCondition.notify_all();
+
+    for (auto & worker : m_workers)
+        worker.join();
+}
+
+std::future<DecodeService::Result> DecodeService::load(const std::string & path, bool mixToMono, float sampleRate)
+{
+    std::unique_ptr<Job> job(new Job());
+    job->path = path;
+    job->mixToMono = mixToMono;
+    job->sampleRate = sampleRate;
+
+    std::future<Result> result = job->promise.get_future();
+    enqueue(std::move(job));
+    return result;
+}
+
+std::future<DecodeService::Result> DecodeService::load(std::vector<uint8_t> buffer, const std::string & extension, bool mixToMono, float sampleRate)
+{
+    std::unique_ptr<Job> job(new Job());
+    job->buffer = std::move(buffer);
+    job->extension = extension;
+    job->mixToMono = mixToMono;
+    job->sampleRate = sampleRate;
+
+    std::future<Result> result = job->promise.get_future();
+    enqueue(std::move(job));
+    return result;
+}
+
+std::vector<std::future<DecodeService::Result>> DecodeService::loadMany(const std::vector<std::string> & paths, bool mixToMono, float sampleRate)
+{
+    std::vector<std::future<Result>> results;
+    results.reserve(paths.size());
+
+    // Queue the whole batch at once, so the workers start on it together.
+    std::vector<std::unique_ptr<Job>> jobs;
+    jobs.reserve(paths.size());
+    for (auto & path : paths)
+    {
+        std::unique_ptr<Job> job(new Job());
+        job->path = path;
+        job->mixToMono = mixToMono;
+        job->sampleRate = sampleRate;
+        results.push_back(job->promise.get_future());
+        jobs.push_back(std::move(job));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_requested += jobs.size();
+        for (auto & job : jobs)
+            m_queue.push_back(std::move(job));
+    }
+    m_queueCondition.notify_all();
+
+    return results;
+}
+
+void DecodeService::enqueue(std::unique_ptr<Job> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        ++m_requested;
+        m_queue.push_back(std::move(job));
+    }
+    m_queueCondition.notify_one();
+}
+
+DecodeProgress DecodeService::progress() const
+{
+    DecodeProgress p;
+    p.completed = m_completed;
+    p.failed = m_failed;
+    p.requested = m_requested;
+    return p;
+}
+
+void DecodeService::setProgressCallback(std::function<void(const DecodeProgress &)> callback)
+{
+    std::lock_guard<std::mutex> lock(m_callbackMutex);
+    m_progressCallback = callback;
+}
+
+void DecodeService::wait()
+{
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    m_idleCondition.wait(lock, [this]() { return m_stopping || m_completed == m_requested; });
+}
+
+void DecodeService::workerThread()
+{
+    // Each worker keeps its own decoder for its whole life, so decodes never wait on one another.
+    AudioFileReader reader;
+
+    for (;;)
+    {
+        std::unique_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_queueCondition.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+            if (m_stopping)
+                return;
+
+            job = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+
+        try
+        {
+            std::unique_ptr<AudioBus> bus = job->path.empty() ?
+                reader.loadMemory(job->buffer, job->extension, job->mixToMono, job->sampleRate) :
+                reader.loadFile(job->path.c_str(), job->mixToMono, job->sampleRate);
+
+            job->promise.set_value(std::make_shared<AudioBuffer>(bus.get()));
+        }
+        catch (...)
+        {
+            ++m_failed;
+            job->promise.set_exception(std::current_exception());
+        }
+        job.reset();
+
+        DecodeProgress p;
+        {
+            std::lock_guard<std::mutex> lock(m_queueMutex);
+            ++m_completed;
+            p = progress();
+        }
+        m_idleCondition.notify_all();
+
+        std::function<void(const DecodeProgress &)> callback;
+        {
+            std::lock_guard<std::mutex> lock(m_callbackMutex);
+            callback = m_progressCallback;
+        }
+        if (callback)
+            callback(p);
+    }
+}
+
+} // namespace LabSound
@@ -0,0 +1,358 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#include "LabSound/core/AudioContext.h"
+#include "LabSound/core/AudioNodeInput.h"
+#include "LabSound/core/AudioNodeOutput.h"
+#include "LabSound/core/AudioProcessor.h"
+
+#include "LabSound/extended/AudioContextLock.h"
+#include "LabSound/extended/FDNReverbNode.h"
+
+#include "internal/Assertions.h"
+#include "internal/AudioBus.h"
+#include "internal/VectorMath.h"
+
+#include <WTF/MathExtras.h>
+
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace WebCore;
+
+namespace LabSound
+{
+    using namespace VectorMath;
+
+    namespace
+    {
+        // The line lengths spread geometrically over this range, at a size of 1.
+        const double ShortestLineSeconds = 0.020;
+        const double LongestLineSeconds = 0.060;
+
+        bool isPrime(size_t n)
+        {
+            if (n < 2)
+                return false;
+            for (size_t d = 2; d * d <= n; ++d)
+                if (n % d == 0)
+                    return false;
+            return true;
+        }
+
+        // a, b = a + b, a - b
+        void butterfly(float* a, float* b, size_t framesToProcess)
+        {
+            size_t k = 0;
+
+#ifdef __SSE2__
+            for (; k + 4 <= framesToProcess; k += 4)
+            {
+                __m128 x = _mm_loadu_ps(a + k);
+                __m128 y = _mm_loadu_ps(b + k);
+                _mm_storeu_ps(a + k, _mm_add_ps(x, y));
+                _mm_storeu_ps(b + k, _mm_sub_ps(x, y));
+            }
+#endif
+
+            for (; k < framesToProcess; ++k)
+            {
+                float x = a[k];
+                float y = b[k];
+                a[k] = x + y;
+                b[k] = x - y;
+            }
+        }
+    }
+
+    ///////////////////////////////////////////
+    // Private FDNReverbNode Implementation //
+    ///////////////////////////////////////////
+
+    class FDNReverbNode::FDNReverbNodeInternal : public WebCore::AudioProcessor
+    {
+    public:
+
+        FDNReverbNodeInternal(float sampleRate, unsigned numberOfLines, float size)
+            : AudioProcessor(sampleRate, 1)
+            , matrix(FeedbackMatrix::HADAMARD)
+            , m_numberOfLines(numberOfLines <= 4 ? 4 : numberOfLines <= 8 ? 8 : 16)
+            , m_writeIndex(0)
+            , m_lastDecayTime(0)
+            , m_lastDamping(0)
+            , m_lastMatrix(FeedbackMatrix::HADAMARD)
+            , m_dampingCoefficient(0)
+            , m_tailTime(0)
+        {
+            decayTime = std::make_shared<AudioParam>("decayTime", 2.0, 0.1, 60.0);
+            damping = std::make_shared<AudioParam>("damping", 6000.0, 20.0, sampleRate * 0.5);
+
+            size = std::min(std::max(size, 0.25f), 4.0f);
+
+            // Distinct primes, so that no two lines share a period and the echoes never line up.
+            double ratio = LongestLineSeconds / ShortestLineSeconds;
+            size_t previous = 0;
+            for (unsigned j = 0; j < m_numberOfLines; ++j)
+            {
+                double seconds = size * ShortestLineSeconds * pow(ratio, double(j) / (m_numberOfLines - 1));
+                size_t frames = std::max(static_cast<size_t>(seconds * sampleRate), previous + 1);
+                while (!isPrime(frames))
+                    ++frames;
+                m_delayFrames.push_back(frames);
+                previous = frames;
+            }
+
+            // Blocks are read from the lines before they are written, so they can be no longer than the
+            // shortest line.
+            m_blockSize = std::min(static_cast<size_t>(AudioNode::ProcessingSizeInFrames), m_delayFrames.front());
+
+            size_t lineLength = 2;
+            while (lineLength < m_delayFrames.back() + AudioNode::ProcessingSizeInFrames)
+                lineLength <<= 1;
+            m_lineLength = lineLength;
+            m_mask = lineLength - 1;
+
+            m_lines.allocate(m_numberOfLines * m_lineLength);
+            m_outputs.allocate(m_numberOfLines * AudioNode::ProcessingSizeInFrames);
+            m_input.allocate(AudioNode::ProcessingSizeInFrames);
+            m_sum.allocate(AudioNode::ProcessingSizeInFrames);
+            m_gains.assign(m_numberOfLines, 0.0f);
+            m_lowpass.assign(m_numberOfLines, 0.0f);
+        }
+
+        virtual ~FDNReverbNodeInternal() { }
+
+        virtual void initialize() override { m_initialized = true; }
+        virtual void uninitialize() override { m_initialized = false; }
+
+        virtual void process(ContextRenderLock& r, const AudioBus* sourceBus, AudioBus* destinationBus, size_t framesToProcess) override
+        {
+            unsigned numChannels = std::min(destinationBus->numberOfChannels(), sourceBus->numberOfChannels());
+            if (!isInitialized() || !numChannels)
+            {
+                destinationBus->zero();
+                return;
+            }
+
+            ASSERT(framesToProcess <= m_input.size());
+            framesToProcess = std::min(framesToProcess, m_input.size());
+
+            updateGains(r);
+
+            FeedbackMatrix mode = matrix;
+            const unsigned lines = m_numberOfLines;
+            const size_t stride = AudioNode::ProcessingSizeInFrames;
+            float* y = m_outputs.data();
+            float* input = m_input.data();
+
+            const float* sources[AudioContext::maxNumberOfChannels];
+            float sourceGains[AudioContext::maxNumberOfChannels];
+            unsigned numSources = std::min(sourceBus->numberOfChannels(), AudioContext::maxNumberOfChannels);
+            for (unsigned c = 0; c < numSources; ++c)
+            {
+                sources[c] = sourceBus->channel(c)->data();
+                sourceGains[c] = 1.0f / numSources;
+            }
+
+            unsigned bits = lines == 4 ? 2 : lines == 8 ? 3 : 4;
+            const float outputScale = 1.0f / sqrtf(static_cast<float>(lines));
+
+            for (size_t offset = 0; offset < framesToProcess; offset += m_blockSize)
+            {
+                size_t n = std::min(m_blockSize, framesToProcess - offset);
+
+                // Mix the input down before anything is written, as the destination may be the source.
+                const float* blockSources[AudioContext::maxNumberOfChannels];
+                for (unsigned c = 0; c < numSources; ++c)
+                    blockSources[c] = sources[c] + offset;
+                vmix(blockSources, sourceGains, numSources, input, false, n);
+
+                // Read each line's output for the block.
+                for (unsigned j = 0; j < lines; ++j)
+                {
+                    const float* line = m_lines.data() + j * m_lineLength;
+                    size_t start = (m_writeIndex - m_delayFrames[j]) & m_mask;
+                    size_t head = std::min(n, m_lineLength - start);
+                    memcpy(y + j * stride, line + start, head * sizeof(float));
+                    memcpy(y + j * stride + head, line, (n - head) * sizeof(float));
+                }
+
+                // Each output channel sums the lines with its own pattern of signs.
+                for (unsigned c = 0; c < destinationBus->numberOfChannels(); ++c)
+                {
+                    float* destination = destinationBus->channel(c)->mutableData() + offset;
+                    for (unsigned j = 0; j < lines; ++j)
+                    {
+                        float gain = ((j >> (c % bits)) & 1) ? -outputScale : outputScale;
+                        if (j)
+                            vsma(y + j * stride, 1, &gain, destination, 1, n);
+                        else
+                            vsmul(y, 1, &gain, destination, 1, n);
+                    }
+                }
+
+                // Damp and attenuate each line for its length.
+                const float a = m_dampingCoefficient;
+                for (unsigned j = 0; j < lines; ++j)
+                {
+                    float* v = y + j * stride;
+                    float z = m_lowpass[j];
+                    float g = m_gains[j];
+                    for (size_t i = 0; i < n; ++i)
+                    {
+                        z += (1 - a) * (v[i] - z);
+                        v[i] = g * z;
+                    }
+                    m_lowpass[j] = z;
+                }
+
+                // Mix the lines.
+                if (mode == FeedbackMatrix::HADAMARD)
+                {
+                    // The butterflies scale by sqrt(lines) overall, which updateGains has allowed for.
+                    for (unsigned half = 1; half < lines; half <<= 1)
+                        for (unsigned j = 0; j < lines; j += half << 1)
+                            for (unsigned k = j; k < j + half; ++k)
+                                butterfly(y + k * stride, y + (k + half) * stride, n);
+                }
+                else
+                {
+                    // I - 2/N: each line less 2/N of the sum of all of them.
+                    float* sum = m_sum.data();
+                    const float* outputs[16];
+                    for (unsigned j = 0; j < lines; ++j)
+                        outputs[j] = y + j * stride;
+                    vmix(outputs, 0, lines, sum, false, n);
+
+                    const float scale = -2.0f / lines;
+                    for (unsigned j = 0; j < lines; ++j)
+                        vsma(sum, 1, &scale, y + j * stride, 1, n);
+                }
+
+                // Feed the input in and write the block to the lines.
+                for (unsigned j = 0; j < lines; ++j)
+                {
+                    float* v = y + j * stride;
+                    vadd(v, 1, input, 1, v, 1, n);
+
+                    float* line = m_lines.data() + j * m_lineLength;
+                    size_t head = std::min(n, m_lineLength - m_writeIndex);
+                    memcpy(line + m_writeIndex, v, head * sizeof(float));
+                    memcpy(line, v + head, (n - head) * sizeof(float));
+                }
+
+                m_writeIndex = (m_writeIndex + n) & m_mask;
+            }
+        }
+
+        virtual void reset() override
+        {
+            m_lines.zero();
+            std::fill(m_lowpass.begin(), m_lowpass.end(), 0.0f);
+        }
+
+        virtual double tailTime() const override { return m_tailTime; }
+        virtual double latencyTime() const override { return 0; }
+
+        unsigned numberOfLines() const { return m_numberOfLines; }
+
+        std::shared_ptr<AudioParam> decayTime;
+        std::shared_ptr<AudioParam> damping;
+        std::atomic<FeedbackMatrix> matrix;
+
+    private:
+
+        // Works out the gains when the decay time, damping or matrix change.
+        void updateGains(ContextRenderLock& r)
+        {
+            float decay = decayTime->value(r);
+            float cutoff = damping->value(r);
+            FeedbackMatrix mode = matrix;
+            if (decay == m_lastDecayTime && cutoff == m_lastDamping && mode == m_lastMatrix)
+                return;
+
+            m_lastDecayTime = decay;
+            m_lastDamping = cutoff;
+            m_lastMatrix = mode;
+
+            decay = std::max(decay, 0.01f);
+            // At the Nyquist frequency the damping is off altogether.
+            cutoff = std::max(cutoff, 20.0f);
+            m_dampingCoefficient = cutoff < 0.5f * sampleRate() ? expf(-2 * piFloat * cutoff / sampleRate()) : 0;
+
+            // A trip around a line of d frames must lose 60dB * d / (decay * sampleRate). The Hadamard
+            // butterflies gain sqrt(lines), so that is taken out here too.
+            float matrixScale = mode == FeedbackMatrix::HADAMARD ? 1.0f / sqrtf(static_cast<float>(m_numberOfLines)) : 1.0f;
+            for (unsigned j = 0; j < m_numberOfLines; ++j)
+                m_gains[j] = matrixScale * powf(10.0f, -3.0f * m_delayFrames[j] / (decay * sampleRate()));
+
+            m_tailTime = decay + double(m_delayFrames.back()) / sampleRate();
+        }
+
+        unsigned m_numberOfLines;
+        std::vector<size_t> m_delayFrames;
+        size_t m_blockSize;
+        size_t m_lineLength;
+        size_t m_mask;
+        size_t m_writeIndex;
+
+        AudioFloatArray m_lines;      // the lines one after another, all written at m_writeIndex
+        AudioFloatArray m_outputs;    // a block of each line's output
+        AudioFloatArray m_input;
+        AudioFloatArray m_sum;
+
+        std::vector<float> m_gains;
+        std::vector<float> m_lowpass;
+        float m_lastDecayTime;
+        float m_lastDamping;
+        FeedbackMatrix m_lastMatrix;
+        float m_dampingCoefficient;
+        double m_tailTime;
+    };
+
+    //////////////////////////
+    // Public FDNReverbNode //
+    //////////////////////////
+
+    FDNReverbNode::FDNReverbNode(float sampleRate, unsigned numberOfLines, float size) : WebCore::AudioBasicProcessorNode(sampleRate)
+    {
+        m_processor.reset(new FDNReverbNodeInternal(sampleRate, numberOfLines, size));
+
+        internalNode = static_cast<FDNReverbNodeInternal*>(m_processor.get());
+
+        setNodeType((AudioNode::NodeType) LabSound::NodeTypeFDNReverb);
+        initialize();
+    }
+
+    FDNReverbNode::~FDNReverbNode()
+    {
+        uninitialize();
+    }
+
+    unsigned FDNReverbNode::numberOfLines() const
+    {
+        return internalNode->numberOfLines();
+    }
+
+    std::shared_ptr<AudioParam> FDNReverbNode::decayTime()
+    {
+        return internalNode->decayTime;
+    }
+
+    std::shared_ptr<AudioParam> FDNReverbNode::damping()
+    {
+        return internalNode->damping;
+    }
+
+    void FDNReverbNode::setMatrix(FeedbackMatrix m)
+    {
+        internalNode->matrix = m;
+    }
+
+} // end namespace LabSound
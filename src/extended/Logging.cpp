@@ -0,0 +1,29 @@
+// Copyright (c) 2003-2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "LabSound/extended/Logging.h"
+
+// These live apart from LabSound.cpp, so that code which only logs or asserts, such as VectorMath, can be
+// linked without the context and the rest of the engine.
+
+void LabSoundLog(const char* file, int line, const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+
+	char tmp[256] = { 0 };
+	sprintf(tmp, "[%s @ %i]\n\t%s\n", file, line, fmt);
+	vprintf(tmp, args);
+
+	va_end(args);
+}
+
+void LabSoundAssertLog(const char* file, int line, const char * function, const char * assertion)
+{
+	if (assertion) printf("[%s @ %i] ASSERTION FAILED: %s\n", file, line, assertion);
+	else printf("[%s @ %i] SHOULD NEVER BE REACHED\n", file, line);
+}
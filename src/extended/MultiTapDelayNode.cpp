@@ -0,0 +1,249 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#include "LabSound/core/AudioNodeInput.h"
+#include "LabSound/core/AudioNodeOutput.h"
+#include "LabSound/core/AudioProcessor.h"
+
+#include "LabSound/extended/AudioContextLock.h"
+#include "LabSound/extended/MultiTapDelayNode.h"
+
+#include "internal/Assertions.h"
+#include "internal/AudioBus.h"
+#include "internal/DelayLine.h"
+#include "internal/VectorMath.h"
+
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+#include <memory>
+#include <stdexcept>
+#include <string.h>
+
+using namespace WebCore;
+
+namespace LabSound
+{
+    using namespace VectorMath;
+
+    ///////////////////////////////////////////////
+    // Private MultiTapDelayNode Implementation //
+    ///////////////////////////////////////////////
+
+    class MultiTapDelayNode::MultiTapDelayNodeInternal : public WebCore::AudioProcessor
+    {
+        struct Channel
+        {
+            DelayLine line;
+            std::vector<float> tapStates;   // allpass interpolator state for each tap
+            float feedbackState;
+        };
+
+    public:
+
+        MultiTapDelayNodeInternal(float sampleRate, double maxDelayTime)
+            : AudioProcessor(sampleRate, 1)
+            , maxDelayTime(maxDelayTime)
+            , interpolation(DelayInterpolation::LINEAR)
+            , m_longestTapFrames(0)
+            , m_tailTime(0)
+            , m_input(AudioNode::ProcessingSizeInFrames)
+            , m_feedback(AudioNode::ProcessingSizeInFrames)
+            , m_tap(AudioNode::ProcessingSizeInFrames)
+        {
+            feedback = std::make_shared<AudioParam>("feedback", 0.0, -0.99, 0.99);
+        }
+
+        virtual ~MultiTapDelayNodeInternal() { }
+
+        virtual void initialize() override
+        {
+            size_t maxDelayFrames = static_cast<size_t>(ceil(maxDelayTime * sampleRate()));
+
+            m_channels.clear();
+            for (unsigned i = 0; i < numberOfChannels(); ++i)
+            {
+                std::unique_ptr<Channel> channel(new Channel());
+                channel->line.allocate(maxDelayFrames, AudioNode::ProcessingSizeInFrames);
+                channel->tapStates.assign(taps.size(), 0.0f);
+                channel->feedbackState = 0;
+                m_channels.push_back(std::move(channel));
+            }
+
+            m_initialized = true;
+        }
+
+        virtual void uninitialize() override
+        {
+            m_channels.clear();
+            m_initialized = false;
+        }
+
+        // Called with the render lock held.
+        void setTaps(const std::vector<DelayTap>& newTaps)
+        {
+            taps = newTaps;
+
+            m_tapFrames.clear();
+            m_longestTapFrames = 0;
+            for (auto & tap : taps)
+            {
+                tap.delayTime = std::min(std::max(tap.delayTime, 0.0f), static_cast<float>(maxDelayTime));
+                m_tapFrames.push_back(tap.delayTime * sampleRate());
+                m_longestTapFrames = std::max(m_longestTapFrames, m_tapFrames.back());
+            }
+
+            for (auto & channel : m_channels)
+                channel->tapStates.assign(taps.size(), 0.0f);
+        }
+
+        virtual void process(ContextRenderLock& r, const AudioBus* sourceBus, AudioBus* destinationBus, size_t framesToProcess) override
+        {
+            unsigned numChannels = numberOfChannels();
+            if (!isInitialized() || m_channels.size() != numChannels || sourceBus->numberOfChannels() != numChannels)
+            {
+                destinationBus->zero();
+                return;
+            }
+
+            ASSERT(framesToProcess <= m_input.size());
+            framesToProcess = std::min(framesToProcess, m_input.size());
+
+            DelayInterpolation mode = interpolation;
+
+            // The feedback is read before the block it feeds is written, so the blocks can be no longer
+            // than the longest tap.
+            float gain = std::min(std::max(feedback->value(r), -0.99f), 0.99f);
+            if (m_longestTapFrames < 1)
+                gain = 0;
+
+            size_t blockSize = gain ? std::min(framesToProcess, static_cast<size_t>(m_longestTapFrames)) : framesToProcess;
+
+            // The feedback decays by 60dB after log(0.001) / log(|gain|) trips around the loop.
+            double longest = m_longestTapFrames / sampleRate();
+            m_tailTime = gain ? longest * (1 + log(0.001) / log(fabs(gain))) : longest;
+
+            for (unsigned c = 0; c < numChannels; ++c)
+            {
+                Channel & channel = *m_channels[c];
+                channel.line.setInterpolation(mode);
+
+                const float* source = sourceBus->channel(c)->data();
+                float* destination = destinationBus->channel(c)->mutableData();
+
+                for (size_t offset = 0; offset < framesToProcess; offset += blockSize)
+                {
+                    size_t n = std::min(blockSize, framesToProcess - offset);
+
+                    if (gain)
+                    {
+                        float* input = m_input.data();
+                        float* fed = m_feedback.data();
+                        channel.line.readAhead(fed, n, m_longestTapFrames, channel.feedbackState);
+                        memcpy(input, source + offset, n * sizeof(float));
+                        vsma(fed, 1, &gain, input, 1, n);
+                        channel.line.write(input, n);
+                    }
+                    else
+                        channel.line.write(source + offset, n);
+
+                    // The source has been consumed, so the destination may now be written even if it is
+                    // the same bus.
+                    float* out = destination + offset;
+                    if (taps.empty())
+                    {
+                        memset(out, 0, n * sizeof(float));
+                        continue;
+                    }
+
+                    float* tap = m_tap.data();
+                    for (size_t t = 0; t < taps.size(); ++t)
+                    {
+                        channel.line.read(t ? tap : out, n, m_tapFrames[t], channel.tapStates[t]);
+                        if (t)
+                            vsma(tap, 1, &taps[t].gain, out, 1, n);
+                        else
+                            vsmul(out, 1, &taps[t].gain, out, 1, n);
+                    }
+                }
+            }
+        }
+
+        virtual void reset() override
+        {
+            for (auto & channel : m_channels)
+            {
+                channel->line.reset();
+                channel->tapStates.assign(taps.size(), 0.0f);
+                channel->feedbackState = 0;
+            }
+        }
+
+        virtual double tailTime() const override { return m_tailTime; }
+        virtual double latencyTime() const override { return 0; }
+
+        double maxDelayTime;
+        std::vector<DelayTap> taps;
+        std::shared_ptr<AudioParam> feedback;
+        std::atomic<DelayInterpolation> interpolation;
+
+    private:
+
+        std::vector<std::unique_ptr<Channel>> m_channels;
+        std::vector<double> m_tapFrames;
+        double m_longestTapFrames;
+        double m_tailTime;
+
+        AudioFloatArray m_input;
+        AudioFloatArray m_feedback;
+        AudioFloatArray m_tap;
+    };
+
+    //////////////////////////////
+    // Public MultiTapDelayNode //
+    //////////////////////////////
+
+    MultiTapDelayNode::MultiTapDelayNode(float sampleRate, double maxDelayTime) : WebCore::AudioBasicProcessorNode(sampleRate)
+    {
+        if (maxDelayTime <= 0)
+            throw std::out_of_range("Delay time must be positive");
+
+        m_processor.reset(new MultiTapDelayNodeInternal(sampleRate, maxDelayTime));
+
+        internalNode = static_cast<MultiTapDelayNodeInternal*>(m_processor.get());
+
+        setNodeType((AudioNode::NodeType) LabSound::NodeTypeMultiTapDelay);
+        initialize();
+    }
+
+    MultiTapDelayNode::~MultiTapDelayNode()
+    {
+        uninitialize();
+    }
+
+    double MultiTapDelayNode::maxDelayTime() const
+    {
+        return internalNode->maxDelayTime;
+    }
+
+    void MultiTapDelayNode::setTaps(ContextRenderLock&, const std::vector<DelayTap>& taps)
+    {
+        internalNode->setTaps(taps);
+    }
+
+    const std::vector<DelayTap>& MultiTapDelayNode::taps() const
+    {
+        return internalNode->taps;
+    }
+
+    std::shared_ptr<AudioParam> MultiTapDelayNode::feedback()
+    {
+        return internalNode->feedback;
+    }
+
+    void MultiTapDelayNode::setInterpolation(DelayInterpolation interpolation)
+    {
+        internalNode->interpolation = interpolation;
+    }
+
+} // end namespace LabSound
@@ -0,0 +1,562 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#include "LabSound/core/AudioNodeInput.h"
+#include "LabSound/core/AudioNodeOutput.h"
+#include "LabSound/core/AudioProcessor.h"
+
+#include "LabSound/extended/AudioContextLock.h"
+#include "LabSound/extended/MultibandCompressorNode.h"
+
+#include "internal/Assertions.h"
+#include "internal/AudioBus.h"
+#include "internal/VectorMath.h"
+
+#include <WTF/MathExtras.h>
+
+#include <algorithm>
+#include <math.h>
+#include <memory>
+#include <stdexcept>
+#include <string.h>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace WebCore;
+
+namespace LabSound
+{
+    using namespace VectorMath;
+
+    namespace
+    {
+        const unsigned MinBands = 2;
+        const unsigned MaxBands = 5;
+        const size_t MaxFramesPerBlock = AudioNode::ProcessingSizeInFrames;
+
+        // The default crossovers for each number of bands.
+        const float DefaultCrossovers[MaxBands - 1][MaxBands - 1] =
+        {
+            { 1000 },
+            { 200, 2000 },
+            { 150, 800, 4000 },
+            { 100, 400, 1600, 6400 }
+        };
+
+        enum class FilterKind { LOWPASS, HIGHPASS, ALLPASS };
+
+        // Four biquads side by side in the lanes of a vector, each a cascade of one or two identical stages
+        // in transposed direct form II. Each lane has its own coefficients, input and output, so one pass
+        // runs the low and high halves of a crossover for two channels at once.
+        class BiquadLanes
+        {
+        public:
+
+            static const unsigned Lanes = 4;
+
+            BiquadLanes() : stages(1)
+            {
+                memset(m_b0, 0, sizeof(m_b0));
+                memset(m_b1, 0, sizeof(m_b1));
+                memset(m_b2, 0, sizeof(m_b2));
+                memset(m_a1, 0, sizeof(m_a1));
+                memset(m_a2, 0, sizeof(m_a2));
+                reset();
+            }
+
+            // A 2nd order Butterworth section at frequency, normalized to the Nyquist frequency, from the
+            // Audio EQ Cookbook. Two lowpass or highpass stages make a 4th order Linkwitz-Riley filter, and
+            // the two Linkwitz-Riley halves sum to the allpass of the same frequency.
+            void setLane(unsigned lane, FilterKind kind, double frequency)
+            {
+                double w0 = piDouble * frequency;
+                double alpha = sin(w0) / (2 * sqrt(0.5));
+                double cosw = cos(w0);
+                double a0 = 1 + alpha;
+
+                double b0, b1, b2;
+                switch (kind)
+                {
+                case FilterKind::LOWPASS: b0 = (1 - cosw) / 2; b1 = 1 - cosw; b2 = b0; break;
+                case FilterKind::HIGHPASS: b0 = (1 + cosw) / 2; b1 = -(1 + cosw); b2 = b0; break;
+                case FilterKind::ALLPASS:
+                default: b0 = 1 - alpha; b1 = -2 * cosw; b2 = 1 + alpha; break;
+                }
+
+                m_b0[lane] = static_cast<float>(b0 / a0);
+                m_b1[lane] = static_cast<float>(b1 / a0);
+                m_b2[lane] = static_cast<float>(b2 / a0);
+                m_a1[lane] = static_cast<float>(-2 * cosw / a0);
+                m_a2[lane] = static_cast<float>((1 - alpha) / a0);
+            }
+
+            // All four lanes are read for a frame before any is written, so a lane may write the buffer
+            // another lane reads.
+            void process(const float* const* input, float* const* output, size_t framesToProcess)
+            {
+#ifdef __SSE2__
+                const __m128 b0 = _mm_loadu_ps(m_b0);
+                const __m128 b1 = _mm_loadu_ps(m_b1);
+                const __m128 b2 = _mm_loadu_ps(m_b2);
+                const __m128 a1 = _mm_loadu_ps(m_a1);
+                const __m128 a2 = _mm_loadu_ps(m_a2);
+                __m128 z1[2] = { _mm_loadu_ps(m_z1[0]), _mm_loadu_ps(m_z1[1]) };
+                __m128 z2[2] = { _mm_loadu_ps(m_z2[0]), _mm_loadu_ps(m_z2[1]) };
+                float y[Lanes];
+
+                for (size_t i = 0; i < framesToProcess; ++i)
+                {
+                    __m128 x = _mm_setr_ps(input[0][i], input[1][i], input[2][i], input[3][i]);
+                    for (unsigned s = 0; s < stages; ++s)
+                    {
+                        __m128 out = _mm_add_ps(_mm_mul_ps(b0, x), z1[s]);
+                        z1[s] = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, out)), z2[s]);
+                        z2[s] = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, out));
+                        x = out;
+                    }
+                    _mm_storeu_ps(y, x);
+                    output[0][i] = y[0];
+                    output[1][i] = y[1];
+                    output[2][i] = y[2];
+                    output[3][i] = y[3];
+                }
+
+                for (unsigned s = 0; s < 2; ++s)
+                {
+                    _mm_storeu_ps(m_z1[s], z1[s]);
+                    _mm_storeu_ps(m_z2[s], z2[s]);
+                }
+#else
+                float x[Lanes];
+                for (size_t i = 0; i < framesToProcess; ++i)
+                {
+                    for (unsigned l = 0; l < Lanes; ++l)
+                        x[l] = input[l][i];
+                    for (unsigned l = 0; l < Lanes; ++l)
+                    {
+                        for (unsigned s = 0; s < stages; ++s)
+                        {
+                            float out = m_b0[l] * x[l] + m_z1[s][l];
+                            m_z1[s][l] = m_b1[l] * x[l] - m_a1[l] * out + m_z2[s][l];
+                            m_z2[s][l] = m_b2[l] * x[l] - m_a2[l] * out;
+                            x[l] = out;
+                        }
+                    }
+                    for (unsigned l = 0; l < Lanes; ++l)
+                        output[l][i] = x[l];
+                }
+#endif
+            }
+
+            void reset()
+            {
+                memset(m_z1, 0, sizeof(m_z1));
+                memset(m_z2, 0, sizeof(m_z2));
+            }
+
+            unsigned stages;
+
+        private:
+
+            float m_b0[Lanes], m_b1[Lanes], m_b2[Lanes], m_a1[Lanes], m_a2[Lanes];
+            float m_z1[2][Lanes], m_z2[2][Lanes];
+        };
+
+        // destination = sum of bands[b] * gains[b]
+        void sumBands(const float* const* bands, const float* const* gains, unsigned numberOfBands, float* destination, size_t framesToProcess)
+        {
+            size_t i = 0;
+
+#ifdef __SSE2__
+            for (; i + 4 <= framesToProcess; i += 4)
+            {
+                __m128 sum = _mm_mul_ps(_mm_loadu_ps(bands[0] + i), _mm_loadu_ps(gains[0] + i));
+                for (unsigned b = 1; b < numberOfBands; ++b)
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(bands[b] + i), _mm_loadu_ps(gains[b] + i)));
+                _mm_storeu_ps(destination + i, sum);
+            }
+#endif
+
+            for (; i < framesToProcess; ++i)
+            {
+                float sum = bands[0][i] * gains[0][i];
+                for (unsigned b = 1; b < numberOfBands; ++b)
+                    sum += bands[b][i] * gains[b][i];
+                destination[i] = sum;
+            }
+        }
+    }
+
+    /////////////////////////////////////////////////////
+    // Private MultibandCompressorNode Implementation //
+    /////////////////////////////////////////////////////
+
+    class MultibandCompressorNode::MultibandCompressorNodeInternal : public WebCore::AudioProcessor
+    {
+        struct Band
+        {
+            std::shared_ptr<AudioParam> threshold;
+            std::shared_ptr<AudioParam> ratio;
+            std::shared_ptr<AudioParam> knee;
+            std::shared_ptr<AudioParam> attack;
+            std::shared_ptr<AudioParam> release;
+            std::shared_ptr<AudioParam> makeup;
+            std::shared_ptr<AudioParam> reduction;
+
+            float gainDb;                           // the smoothed gain reduction
+            std::vector<AudioFloatArray> signal;    // one buffer per channel
+            AudioFloatArray gain;
+        };
+
+        // A pass of BiquadLanes, and where each lane reads and writes. A band of -1 is the node's input.
+        struct FilterGroup
+        {
+            BiquadLanes filters;
+            unsigned crossover;
+            FilterKind kind[BiquadLanes::Lanes];
+            int inputBand[BiquadLanes::Lanes];
+            int outputBand[BiquadLanes::Lanes];
+            unsigned channel[BiquadLanes::Lanes];
+            bool used[BiquadLanes::Lanes];
+        };
+
+        struct LaneTask
+        {
+            FilterKind kind;
+            int inputBand;
+            int outputBand;
+            unsigned channel;
+        };
+
+    public:
+
+        MultibandCompressorNodeInternal(float sampleRate, unsigned numberOfBands)
+            : AudioProcessor(sampleRate, 1)
+            , m_level(MaxFramesPerBlock)
+            , m_magnitude(MaxFramesPerBlock)
+            , m_zeros(MaxFramesPerBlock)
+            , m_discard(MaxFramesPerBlock)
+        {
+            numberOfBands = std::min(std::max(numberOfBands, MinBands), MaxBands);
+
+            for (unsigned i = 0; i + 1 < numberOfBands; ++i)
+            {
+                crossovers.push_back(std::make_shared<AudioParam>("crossover", DefaultCrossovers[numberOfBands - 2][i], 20, 20000));
+                m_lastCrossovers.push_back(-1);
+            }
+
+            for (unsigned i = 0; i < numberOfBands; ++i)
+            {
+                std::unique_ptr<Band> band(new Band());
+                band->threshold = std::make_shared<AudioParam>("threshold", -24, -100, 0);
+                band->ratio = std::make_shared<AudioParam>("ratio", 4, 1, 20);
+                band->knee = std::make_shared<AudioParam>("knee", 6, 0, 40);
+                band->attack = std::make_shared<AudioParam>("attack", 0.005, 0, 1);
+                band->release = std::make_shared<AudioParam>("release", 0.1, 0, 5);
+                band->makeup = std::make_shared<AudioParam>("makeup", 0, 0, 40);
+                band->reduction = std::make_shared<AudioParam>("reduction", 0, -100, 0);
+                band->gainDb = 0;
+                band->gain.allocate(MaxFramesPerBlock);
+                bands.push_back(std::move(band));
+            }
+        }
+
+        virtual ~MultibandCompressorNodeInternal() { }
+
+        virtual void initialize() override
+        {
+            unsigned numChannels = numberOfChannels();
+            unsigned numBands = static_cast<unsigned>(bands.size());
+
+            for (auto & band : bands)
+            {
+                band->signal.clear();
+                band->signal.resize(numChannels);
+                for (auto & signal : band->signal)
+                    signal.allocate(MaxFramesPerBlock);
+                band->gainDb = 0;
+            }
+
+            // Each crossover splits the band below it from everything above, which the next crossover splits
+            // in turn. The crossovers must run in order, but within one the channels' lowpass and highpass
+            // halves are independent, and fill the lanes.
+            m_groups.clear();
+            std::vector<LaneTask> tasks;
+            for (unsigned k = 0; k + 1 < numBands; ++k)
+            {
+                tasks.clear();
+                for (unsigned c = 0; c < numChannels; ++c)
+                {
+                    int input = k ? static_cast<int>(k) : -1;
+                    tasks.push_back({ FilterKind::LOWPASS, input, static_cast<int>(k), c });
+                    tasks.push_back({ FilterKind::HIGHPASS, input, static_cast<int>(k + 1), c });
+                }
+                addGroups(tasks, k, 2);
+            }
+
+            // Then every band below a crossover, other than the band split there, takes its allpass so that the
+            // bands line up in phase. The allpasses of one crossover are independent of each other.
+            for (unsigned j = 1; j + 1 < numBands; ++j)
+            {
+                tasks.clear();
+                for (unsigned k = 0; k < j; ++k)
+                    for (unsigned c = 0; c < numChannels; ++c)
+                        tasks.push_back({ FilterKind::ALLPASS, static_cast<int>(k), static_cast<int>(k), c });
+                addGroups(tasks, j, 1);
+            }
+
+            std::fill(m_lastCrossovers.begin(), m_lastCrossovers.end(), -1.0f);
+            m_initialized = true;
+        }
+
+        virtual void uninitialize() override
+        {
+            m_groups.clear();
+            for (auto & band : bands)
+                band->signal.clear();
+            m_initialized = false;
+        }
+
+        virtual void process(ContextRenderLock& r, const AudioBus* sourceBus, AudioBus* destinationBus, size_t framesToProcess) override
+        {
+            unsigned numChannels = numberOfChannels();
+            if (!isInitialized() || !numChannels || sourceBus->numberOfChannels() != numChannels || destinationBus->numberOfChannels() != numChannels)
+            {
+                destinationBus->zero();
+                return;
+            }
+
+            unsigned numBands = static_cast<unsigned>(bands.size());
+
+            updateCrossovers(r);
+
+            // The detectors' settings, as the gain computer and the one pole smoothing coefficients.
+            struct Settings { float threshold, slope, knee, attack, release, makeup; } settings[MaxBands];
+            for (unsigned b = 0; b < numBands; ++b)
+            {
+                Band & band = *bands[b];
+                Settings & s = settings[b];
+                s.threshold = band.threshold->value(r);
+                s.slope = 1 / std::max(1.0f, band.ratio->value(r)) - 1;
+                s.knee = std::max(0.0f, band.knee->value(r));
+                s.attack = expf(-1 / (std::max(0.0001f, band.attack->value(r)) * sampleRate()));
+                s.release = expf(-1 / (std::max(0.0001f, band.release->value(r)) * sampleRate()));
+                s.makeup = band.makeup->value(r);
+            }
+
+            float reduction[MaxBands];
+            std::fill(reduction, reduction + MaxBands, 0.0f);
+
+            for (size_t offset = 0; offset < framesToProcess; offset += MaxFramesPerBlock)
+            {
+                size_t n = std::min(MaxFramesPerBlock, framesToProcess - offset);
+
+                // Split the bands. The input is consumed here, so the destination may be the same bus.
+                for (auto & group : m_groups)
+                {
+                    const float* input[BiquadLanes::Lanes];
+                    float* output[BiquadLanes::Lanes];
+                    for (unsigned l = 0; l < BiquadLanes::Lanes; ++l)
+                    {
+                        if (!group->used[l])
+                        {
+                            input[l] = m_zeros.data();
+                            output[l] = m_discard.data();
+                            continue;
+                        }
+
+                        unsigned c = group->channel[l];
+                        input[l] = group->inputBand[l] < 0 ? sourceBus->channel(c)->data() + offset : bands[group->inputBand[l]]->signal[c].data();
+                        output[l] = bands[group->outputBand[l]]->signal[c].data();
+                    }
+                    group->filters.process(input, output, n);
+                }
+
+                // Each band's detector follows its loudest channel.
+                for (unsigned b = 0; b < numBands; ++b)
+                {
+                    Band & band = *bands[b];
+                    const Settings & s = settings[b];
+
+                    float* level = m_level.data();
+                    vabs(band.signal[0].data(), level, n);
+                    for (unsigned c = 1; c < numChannels; ++c)
+                    {
+                        vabs(band.signal[c].data(), m_magnitude.data(), n);
+                        vmax(level, m_magnitude.data(), level, n);
+                    }
+                    vlin2db(level, level, n);
+
+                    // The static curve, as the gain reduction in dB, with a quadratic through the knee.
+                    float halfKnee = 0.5f * s.knee;
+                    for (size_t i = 0; i < n; ++i)
+                    {
+                        float over = level[i] - s.threshold;
+                        float gain;
+                        if (over <= -halfKnee)
+                            gain = 0;
+                        else if (over < halfKnee)
+                            gain = s.slope * (over + halfKnee) * (over + halfKnee) / (2 * s.knee);
+                        else
+                            gain = s.slope * over;
+                        level[i] = gain;
+                    }
+
+                    // Smooth it, attacking as the reduction deepens and releasing as it eases.
+                    float* gain = band.gain.data();
+                    float gainDb = band.gainDb;
+                    for (size_t i = 0; i < n; ++i)
+                    {
+                        float coefficient = level[i] < gainDb ? s.attack : s.release;
+                        gainDb = level[i] + coefficient * (gainDb - level[i]);
+                        reduction[b] = std::min(reduction[b], gainDb);
+                        gain[i] = gainDb + s.makeup;
+                    }
+                    band.gainDb = gainDb;
+
+                    vdb2lin(gain, gain, n);
+                }
+
+                // Sum the bands back together, each with its gain, in one pass per channel.
+                const float* gains[MaxBands];
+                for (unsigned b = 0; b < numBands; ++b)
+                    gains[b] = bands[b]->gain.data();
+
+                for (unsigned c = 0; c < numChannels; ++c)
+                {
+                    const float* signals[MaxBands];
+                    for (unsigned b = 0; b < numBands; ++b)
+                        signals[b] = bands[b]->signal[c].data();
+                    sumBands(signals, gains, numBands, destinationBus->channel(c)->mutableData() + offset, n);
+                }
+            }
+
+            for (unsigned b = 0; b < numBands; ++b)
+                bands[b]->reduction->setValue(reduction[b]);
+        }
+
+        virtual void reset() override
+        {
+            for (auto & group : m_groups)
+                group->filters.reset();
+            for (auto & band : bands)
+                band->gainDb = 0;
+        }
+
+        virtual double tailTime() const override { return 0; }
+        virtual double latencyTime() const override { return 0; }
+
+        std::vector<std::shared_ptr<AudioParam>> crossovers;
+        std::vector<std::unique_ptr<Band>> bands;
+
+    private:
+
+        // Packs the tasks into the lanes of as few groups as they fill.
+        void addGroups(const std::vector<LaneTask>& tasks, unsigned crossover, unsigned stages)
+        {
+            for (size_t t = 0; t < tasks.size(); t += BiquadLanes::Lanes)
+            {
+                std::unique_ptr<FilterGroup> group(new FilterGroup());
+                group->filters.stages = stages;
+                group->crossover = crossover;
+                for (unsigned l = 0; l < BiquadLanes::Lanes; ++l)
+                {
+                    group->used[l] = t + l < tasks.size();
+                    const LaneTask & task = group->used[l] ? tasks[t + l] : tasks[t];
+                    group->kind[l] = task.kind;
+                    group->inputBand[l] = task.inputBand;
+                    group->outputBand[l] = task.outputBand;
+                    group->channel[l] = task.channel;
+                }
+                m_groups.push_back(std::move(group));
+            }
+        }
+
+        // Keeps each crossover above the one below it and below the Nyquist frequency, and redesigns the
+        // filters of those that moved.
+        void updateCrossovers(ContextRenderLock& r)
+        {
+            float nyquist = 0.5f * sampleRate();
+            float floor = 10;
+            bool changed = false;
+            for (size_t i = 0; i < crossovers.size(); ++i)
+            {
+                float frequency = std::min(std::max(crossovers[i]->value(r), floor), 0.45f * nyquist);
+                floor = frequency * 1.01f;
+                if (frequency != m_lastCrossovers[i])
+                {
+                    m_lastCrossovers[i] = frequency;
+                    changed = true;
+                }
+            }
+
+            if (!changed)
+                return;
+
+            for (auto & group : m_groups)
+                for (unsigned l = 0; l < BiquadLanes::Lanes; ++l)
+                    group->filters.setLane(l, group->kind[l], m_lastCrossovers[group->crossover] / nyquist);
+        }
+
+        std::vector<std::unique_ptr<FilterGroup>> m_groups;
+        std::vector<float> m_lastCrossovers;
+
+        AudioFloatArray m_level;
+        AudioFloatArray m_magnitude;
+        AudioFloatArray m_zeros;
+        AudioFloatArray m_discard;
+    };
+
+    ////////////////////////////////////
+    // Public MultibandCompressorNode //
+    ////////////////////////////////////
+
+    MultibandCompressorNode::MultibandCompressorNode(float sampleRate, unsigned numberOfBands) : WebCore::AudioBasicProcessorNode(sampleRate)
+    {
+        m_processor.reset(new MultibandCompressorNodeInternal(sampleRate, numberOfBands));
+
+        internalNode = static_cast<MultibandCompressorNodeInternal*>(m_processor.get());
+
+        setNodeType((AudioNode::NodeType) LabSound::NodeTypeMultibandCompressor);
+        initialize();
+    }
+
+    MultibandCompressorNode::~MultibandCompressorNode()
+    {
+        uninitialize();
+    }
+
+    unsigned MultibandCompressorNode::numberOfBands() const
+    {
+        return static_cast<unsigned>(internalNode->bands.size());
+    }
+
+    std::shared_ptr<AudioParam> MultibandCompressorNode::crossover(unsigned i)
+    {
+        if (i >= internalNode->crossovers.size())
+            throw std::out_of_range("Crossover index out of range");
+        return internalNode->crossovers[i];
+    }
+
+#define BAND_PARAM(name) \
+    std::shared_ptr<AudioParam> MultibandCompressorNode::name(unsigned band) \
+    { \
+        if (band >= internalNode->bands.size()) \
+            throw std::out_of_range("Band index out of range"); \
+        return internalNode->bands[band]->name; \
+    }
+
+    BAND_PARAM(threshold)
+    BAND_PARAM(ratio)
+    BAND_PARAM(knee)
+    BAND_PARAM(attack)
+    BAND_PARAM(release)
+    BAND_PARAM(makeup)
+    BAND_PARAM(reduction)
+
+#undef BAND_PARAM
+
+} // end namespace LabSound
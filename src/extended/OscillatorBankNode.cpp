@@ -0,0 +1,299 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#include "LabSound/core/AudioNodeOutput.h"
+#include "LabSound/extended/OscillatorBankNode.h"
+#include "LabSound/extended/AudioContextLock.h"
+
+#include "internal/AudioBus.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdexcept>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+using namespace WebCore;
+
+namespace LabSound {
+
+namespace {
+
+    // Phases are unsigned 32 bit fractions of a cycle. The top tableSizeBits are the index into the
+    // wavetable and the bits below them are the position between that sample and the next.
+    struct VoiceRender
+    {
+        const float* higherWaveData;
+        const float* lowerWaveData;
+        float tableInterpolationFactor;
+        unsigned tableSizeBits;
+        uint32_t phaseIncrement;
+        float gain;
+        float gainStep;
+    };
+
+    // Renders one voice, adding it into destP, and returns the phase it finishes at.
+    uint32_t renderVoice(const VoiceRender& voice, uint32_t phase, float* destP, size_t framesToProcess)
+    {
+        const unsigned indexShift = 32 - voice.tableSizeBits;
+        const uint32_t indexMask = (1u << voice.tableSizeBits) - 1;
+        const uint32_t fractionMask = (1u << indexShift) - 1;
+        const float fractionScale = 1.0f / (fractionMask + 1.0f);
+
+        // The two tables only need to be blended between when the frequency falls between two ranges.
+        const bool blendTables = voice.tableInterpolationFactor > 0 && voice.lowerWaveData != voice.higherWaveData;
+
+        const float* higherWaveData = voice.higherWaveData;
+        const float* lowerWaveData = voice.lowerWaveData;
+        const float tableInterpolationFactor = voice.tableInterpolationFactor;
+        const uint32_t phaseIncrement = voice.phaseIncrement;
+        float gain = voice.gain;
+        const float gainStep = voice.gainStep;
+
+        size_t i = 0;
+
+#ifdef __SSE2__
+        // Four frames at a time. The mantissa of the fraction is built straight from the phase bits
+        // below the index, which gives the same value the scalar loop computes.
+        __m128i phases = _mm_setr_epi32(phase, phase + phaseIncrement, phase + 2 * phaseIncrement, phase + 3 * phaseIncrement);
+        const __m128i phaseStep = _mm_set1_epi32(4 * phaseIncrement);
+        const __m128i indexShiftCount = _mm_cvtsi32_si128(indexShift);
+        const __m128i fractionShiftCount = _mm_cvtsi32_si128(voice.tableSizeBits);
+        const __m128i mask = _mm_set1_epi32(indexMask);
+        const __m128i one = _mm_set1_epi32(1);
+        const __m128i exponentOfOne = _mm_set1_epi32(0x3f800000);
+        const __m128 ones = _mm_set1_ps(1);
+        const __m128 blend = _mm_set1_ps(tableInterpolationFactor);
+        __m128 gains = _mm_setr_ps(gain, gain + gainStep, gain + 2 * gainStep, gain + 3 * gainStep);
+        const __m128 gainSteps = _mm_set1_ps(4 * gainStep);
+
+        for (; i + 4 <= framesToProcess; i += 4) {
+            __m128i index1 = _mm_srl_epi32(phases, indexShiftCount);
+            __m128i index2 = _mm_and_si128(_mm_add_epi32(index1, one), mask);
+            __m128i mantissa = _mm_srli_epi32(_mm_sll_epi32(phases, fractionShiftCount), 9);
+            __m128 fraction = _mm_sub_ps(_mm_castsi128_ps(_mm_or_si128(mantissa, exponentOfOne)), ones);
+
+            int32_t i1[4];
+            int32_t i2[4];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(i1), index1);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(i2), index2);
+
+            __m128 sample1 = _mm_setr_ps(higherWaveData[i1[0]], higherWaveData[i1[1]], higherWaveData[i1[2]], higherWaveData[i1[3]]);
+            __m128 sample2 = _mm_setr_ps(higherWaveData[i2[0]], higherWaveData[i2[1]], higherWaveData[i2[2]], higherWaveData[i2[3]]);
+            __m128 sample = _mm_add_ps(sample1, _mm_mul_ps(fraction, _mm_sub_ps(sample2, sample1)));
+
+            if (blendTables) {
+                sample1 = _mm_setr_ps(lowerWaveData[i1[0]], lowerWaveData[i1[1]], lowerWaveData[i1[2]], lowerWaveData[i1[3]]);
+                sample2 = _mm_setr_ps(lowerWaveData[i2[0]], lowerWaveData[i2[1]], lowerWaveData[i2[2]], lowerWaveData[i2[3]]);
+                __m128 sampleLower = _mm_add_ps(sample1, _mm_mul_ps(fraction, _mm_sub_ps(sample2, sample1)));
+                sample = _mm_add_ps(sample, _mm_mul_ps(blend, _mm_sub_ps(sampleLower, sample)));
+            }
+
+            __m128 dest = _mm_loadu_ps(destP + i);
+            _mm_storeu_ps(destP + i, _mm_add_ps(dest, _mm_mul_ps(gains, sample)));
+
+            phases = _mm_add_epi32(phases, phaseStep);
+            gains = _mm_add_ps(gains, gainSteps);
+        }
+
+        phase += static_cast<uint32_t>(i) * phaseIncrement;
+        gain += i * gainStep;
+#endif
+
+        for (; i < framesToProcess; ++i) {
+            uint32_t index1 = phase >> indexShift;
+            uint32_t index2 = (index1 + 1) & indexMask;
+            float fraction = (phase & fractionMask) * fractionScale;
+
+            float sample = higherWaveData[index1] + fraction * (higherWaveData[index2] - higherWaveData[index1]);
+            if (blendTables) {
+                float sampleLower = lowerWaveData[index1] + fraction * (lowerWaveData[index2] - lowerWaveData[index1]);
+                sample += tableInterpolationFactor * (sampleLower - sample);
+            }
+
+            destP[i] += gain * sample;
+
+            phase += phaseIncrement;
+            gain += gainStep;
+        }
+
+        return phase;
+    }
+
+    unsigned log2OfPowerOfTwo(unsigned n)
+    {
+        unsigned bits = 0;
+        while ((1u << bits) < n)
+            ++bits;
+        return bits;
+    }
+
+} // namespace
+
+OscillatorBankNode::OscillatorBankNode(ContextRenderLock& r, float sampleRate)
+    : AudioScheduledSourceNode(sampleRate)
+    , m_type(OscillatorType::SINE)
+    , m_firstRender(true)
+{
+    setNodeType((AudioNode::NodeType) LabSound::NodeTypeOscillatorBank);
+
+    m_frequency = std::make_shared<AudioParam>("frequency", 440, 0, 100000);
+    m_detune = std::make_shared<AudioParam>("detune", 0, -4800, 4800);
+
+    setType(r, m_type);
+
+    // The voices are summed, so the bank is always mono.
+    addOutput(std::unique_ptr<AudioNodeOutput>(new AudioNodeOutput(this, 1)));
+
+    initialize();
+}
+
+OscillatorBankNode::~OscillatorBankNode()
+{
+    uninitialize();
+}
+
+void OscillatorBankNode::setType(ContextRenderLock& r, OscillatorType type)
+{
+    if (type == OscillatorType::CUSTOM)
+        throw std::invalid_argument("Cannot set wavetable for custom type");
+
+    m_waveTable = WaveTable::create(sampleRate(), type);
+    m_type = type;
+}
+
+void OscillatorBankNode::setWaveTable(ContextRenderLock& r, std::shared_ptr<WaveTable> waveTable)
+{
+    m_waveTable = waveTable;
+    m_type = OscillatorType::CUSTOM;
+}
+
+void OscillatorBankNode::setNumberOfVoices(ContextRenderLock& r, unsigned numberOfVoices)
+{
+    m_phases.resize(numberOfVoices, 0);
+    m_frequencyRatios.resize(numberOfVoices, 1);
+    m_detuneScales.resize(numberOfVoices, 1);
+    m_gains.resize(numberOfVoices, 1);
+    m_currentGains.resize(numberOfVoices, 0);
+}
+
+void OscillatorBankNode::setVoiceFrequencyRatio(ContextRenderLock& r, unsigned voice, float ratio)
+{
+    if (voice >= numberOfVoices())
+        throw std::out_of_range("Voice index exceeds the number of voices");
+    m_frequencyRatios[voice] = ratio;
+}
+
+void OscillatorBankNode::setVoiceDetune(ContextRenderLock& r, unsigned voice, float cents)
+{
+    if (voice >= numberOfVoices())
+        throw std::out_of_range("Voice index exceeds the number of voices");
+    m_detuneScales[voice] = powf(2, cents / 1200);
+}
+
+void OscillatorBankNode::setVoiceGain(ContextRenderLock& r, unsigned voice, float gain)
+{
+    if (voice >= numberOfVoices())
+        throw std::out_of_range("Voice index exceeds the number of voices");
+    m_gains[voice] = gain;
+}
+
+void OscillatorBankNode::process(ContextRenderLock& r, size_t framesToProcess)
+{
+    AudioBus* outputBus = output(0)->bus(r);
+
+    if (!isInitialized() || !outputBus->numberOfChannels() || !m_waveTable.get()) {
+        outputBus->zero();
+        return;
+    }
+
+    size_t quantumFrameOffset;
+    size_t nonSilentFramesToProcess;
+
+    updateSchedulingInfo(r, framesToProcess, outputBus, quantumFrameOffset, nonSilentFramesToProcess);
+
+    if (!nonSilentFramesToProcess || m_phases.empty()) {
+        outputBus->zero();
+        return;
+    }
+
+    if (m_firstRender) {
+        m_firstRender = false;
+        m_frequency->resetSmoothedValue();
+        m_detune->resetSmoothedValue();
+    }
+
+    // The bank's tuning is applied once per quantum.
+    float frequency;
+    if (m_frequency->hasSampleAccurateValues())
+        frequency = m_frequency->finalValue(r);
+    else {
+        m_frequency->smooth(r);
+        frequency = m_frequency->smoothedValue();
+    }
+
+    float detune;
+    if (m_detune->hasSampleAccurateValues())
+        detune = m_detune->finalValue(r);
+    else {
+        m_detune->smooth(r);
+        detune = m_detune->smoothedValue();
+    }
+
+    double cyclesPerFrame = frequency * powf(2, detune / 1200) / sampleRate();
+
+    float* destP = outputBus->channel(0)->mutableData() + quantumFrameOffset;
+    memset(destP, 0, sizeof(float) * nonSilentFramesToProcess);
+
+    VoiceRender voice;
+    voice.tableSizeBits = log2OfPowerOfTwo(m_waveTable->waveTableSize());
+
+    float gainRampScale = 1 / static_cast<float>(nonSilentFramesToProcess);
+
+    for (size_t v = 0; v < m_phases.size(); ++v) {
+        double voiceCyclesPerFrame = cyclesPerFrame * m_frequencyRatios[v] * m_detuneScales[v];
+
+        // Negative frequencies play backwards, which is just a very large increment once wrapped.
+        double cycles = voiceCyclesPerFrame - floor(voiceCyclesPerFrame);
+        voice.phaseIncrement = static_cast<uint32_t>(static_cast<int64_t>(cycles * 4294967296.0));
+
+        float currentGain = m_currentGains[v];
+        float targetGain = m_gains[v];
+        m_currentGains[v] = targetGain;
+
+        if (!currentGain && !targetGain) {
+            m_phases[v] += static_cast<uint32_t>(nonSilentFramesToProcess) * voice.phaseIncrement;
+            continue;
+        }
+
+        // The table selection only depends on the frequency, which is constant over the quantum.
+        float* lowerWaveData = 0;
+        float* higherWaveData = 0;
+        m_waveTable->waveDataForFundamentalFrequency(static_cast<float>(voiceCyclesPerFrame * sampleRate()), lowerWaveData, higherWaveData, voice.tableInterpolationFactor);
+        voice.lowerWaveData = lowerWaveData;
+        voice.higherWaveData = higherWaveData;
+
+        voice.gain = currentGain;
+        voice.gainStep = (targetGain - currentGain) * gainRampScale;
+
+        m_phases[v] = renderVoice(voice, m_phases[v], destP, nonSilentFramesToProcess);
+    }
+
+    outputBus->clearSilentFlag();
+}
+
+void OscillatorBankNode::reset(ContextRenderLock&)
+{
+    std::fill(m_phases.begin(), m_phases.end(), 0);
+}
+
+bool OscillatorBankNode::propagatesSilence(double now) const
+{
+    return !isPlayingOrScheduled() || hasFinished() || !m_waveTable.get();
+}
+
+} // namespace LabSound
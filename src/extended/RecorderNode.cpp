@@ -6,33 +6,136 @@
 
 #include "LabSound/extended/RecorderNode.h"
 
+#include "internal/Assertions.h"
 #include "internal/AudioBus.h"
+#include "internal/WavFileWriter.h"
 
-#include "libnyquist/WavEncoder.h"
+#include <chrono>
 
-namespace LabSound 
+namespace LabSound
 {
-    
+
     using namespace WebCore;
-    
-    RecorderNode::RecorderNode(float sampleRate) : AudioBasicInspectorNode(sampleRate, 2), m_recording(false), m_mixToMono(false)
+
+    namespace
+    {
+        // How often the writer thread wakes to drain the ring, and the most it takes out at once.
+        const std::chrono::milliseconds WriterPeriod(10);
+        const size_t WriterBlockFrames = 4096;
+    }
+
+    RecorderNode::RecorderNode(float sampleRate) : AudioBasicInspectorNode(sampleRate, 2), m_mixToMono(false), m_recordingChannels(2)
     {
+        m_recording = false;
+        m_processing = false;
+        m_stopWriter = false;
+
         addInput(std::unique_ptr<AudioNodeInput>(new AudioNodeInput(this)));
         addOutput(std::unique_ptr<AudioNodeOutput>(new AudioNodeOutput(this, 2)));
-        
+
         setNodeType((AudioNode::NodeType) LabSound::NodeTypeRecorder);
-        
+
         initialize();
     }
-    
+
     RecorderNode::~RecorderNode()
     {
+        stopRecording();
         uninitialize();
     }
-    
+
+    void RecorderNode::startRecording()
+    {
+        beginRecording(nullptr, 2.0f);
+    }
+
+    bool RecorderNode::startRecording(const std::string & filenameWithWavExtension, RecorderFormat format, float bufferSeconds)
+    {
+        unsigned channels = m_mixToMono ? 1 : 2;
+
+        std::unique_ptr<WavFileWriter> file(new WavFileWriter());
+        if (!file->open(filenameWithWavExtension, channels, sampleRate(), format == RecorderFormat::PCM16 ? WavFileWriter::PCM16 : WavFileWriter::Float32))
+        {
+            LOG_ERROR("Can't create %s for recording", filenameWithWavExtension.c_str());
+            return false;
+        }
+
+        return beginRecording(std::move(file), bufferSeconds);
+    }
+
+    bool RecorderNode::beginRecording(std::unique_ptr<WavFileWriter> file, float bufferSeconds)
+    {
+        stopRecording();
+
+        // Everything the render thread touches is allocated here, before it can see that recording has started.
+        m_recordingChannels = m_mixToMono ? 1 : 2;
+        m_tap.reset(new AudioTap(m_recordingChannels, static_cast<size_t>(bufferSeconds * sampleRate())));
+        m_drainBuffer.resize(WriterBlockFrames * m_recordingChannels);
+        m_file = std::move(file);
+
+        m_stopWriter = false;
+        m_writer = std::thread(&RecorderNode::writerThread, this);
+
+        m_recording = true;
+        return true;
+    }
+
+    void RecorderNode::stopRecording()
+    {
+        if (!m_writer.joinable())
+            return;
+
+        m_recording = false;
+
+        // A render quantum that saw the recording running may still be writing to the ring.
+        while (m_processing)
+            std::this_thread::yield();
+
+        m_stopWriter = true;
+        m_writer.join();
+
+        if (m_file)
+        {
+            m_file->close();
+            m_file.reset();
+        }
+    }
+
+    void RecorderNode::writerThread()
+    {
+        for (;;)
+        {
+            bool stopping = m_stopWriter;
+            drain();
+            if (stopping)
+                break;
+            std::this_thread::sleep_for(WriterPeriod);
+        }
+    }
+
+    void RecorderNode::drain()
+    {
+        while (size_t frames = m_tap->readInterleaved(m_drainBuffer.data(), WriterBlockFrames))
+        {
+            const float* samples = m_drainBuffer.data();
+            size_t count = frames * m_recordingChannels;
+
+            if (m_file)
+            {
+                if (!m_file->write(samples, frames))
+                    LOG_ERROR("Recording could not be written to disk");
+            }
+            else
+            {
+                std::lock_guard<std::recursive_mutex> lock(m_mutex);
+                m_data.insert(m_data.end(), samples, samples + count);
+            }
+        }
+    }
+
     void RecorderNode::getData(std::vector<float>& result)
     {
-        // swap is quick enough that process should not be adversely affected
+        // swap is quick enough that the writer should not be adversely affected
         result.clear();
         std::lock_guard<std::recursive_mutex> lock(m_mutex);
         result.swap(m_data);
@@ -41,7 +144,7 @@ namespace LabSound
     void RecorderNode::process(ContextRenderLock& r, size_t framesToProcess)
     {
         AudioBus* outputBus = output(0)->bus(r);
-        
+
         if (!isInitialized() || !input(0)->isConnected())
         {
             if (outputBus)
@@ -49,72 +152,21 @@ namespace LabSound
             return;
         }
 
-        // =====> should this follow the WebAudio pattern have a writer object to call here?
         AudioBus* bus = input(0)->bus(r);
-        
+
         bool isBusGood = bus && (bus->numberOfChannels() > 0) && (bus->channel(0)->length() >= framesToProcess);
-        
+
         if (!isBusGood)
         {
             outputBus->zero();
             return;
         }
-        
-        if (m_recording)
-        {
-            std::vector<const float*> channels;
-            unsigned numberOfChannels = bus->numberOfChannels();
-            
-            for (unsigned int i = 0; i < numberOfChannels; ++i)
-            {
-                channels.push_back(bus->channel(i)->data());
-            }
 
-            // mix down the output, or interleave the output
-            // use the tightest loop possible since this is part of the processing step
-            std::lock_guard<std::recursive_mutex> lock(m_mutex);
-            
-            m_data.reserve(framesToProcess * (m_mixToMono ? 1 : 2));
-            
-            if (m_mixToMono)
-            {
-                if (numberOfChannels == 1)
-                {
-                    for (size_t i = 0; i < framesToProcess; ++i)
-                    {
-                        m_data.push_back(channels[0][i]);
-                    }
-                }
-                
-                else
-                {
-                    for (size_t i = 0; i < framesToProcess; ++i)
-                    {
-                        float val = 0;
-                        for (unsigned int c = 0; c < numberOfChannels; ++ c)
-                        {
-                            val += channels[c][i];
-                        }
-                        val *= 1.0f / float(numberOfChannels);
-                        m_data.push_back(val);
-                    }
-                }
-
-            }
-            else
-            {
-                for (size_t i = 0; i < framesToProcess; ++i)
-                {
-                    for (unsigned int c = 0; c < numberOfChannels; ++ c)
-                    {
-                        m_data.push_back(channels[c][i]);
-                    }
-                }
-            }
+        m_processing = true;
+        if (m_recording)
+            m_tap->write(*bus, framesToProcess);
+        m_processing = false;
 
-        }
-        // <====== to here
-        
         // For in-place processing, our override of pullInputs() will just pass the audio data
         // through unchanged if the channel count matches from input to output
         // (resulting in inputBus == outputBus). Otherwise, do an up-mix to stereo.
@@ -123,34 +175,26 @@ namespace LabSound
            outputBus->copyFrom(*bus);
         }
     }
-    
+
     void RecorderNode::writeRecordingToWav(int channels, const std::string & filenameWithWavExtension)
     {
-        // Represents structure of underlying data
-        std::unique_ptr<nqr::AudioData> fileData(new nqr::AudioData());
-        
+        std::vector<float> data;
+        getData(data);
+
+        if (channels < 1)
+            return;
+
+        WavFileWriter file;
+        if (!file.open(filenameWithWavExtension, channels, sampleRate(), WavFileWriter::Float32))
         {
-            std::lock_guard<std::recursive_mutex> lock(m_mutex);
-            fileData->samples.swap(m_data);
+            LOG_ERROR("Can't create %s for recording", filenameWithWavExtension.c_str());
+            return;
         }
-        
-        fileData->channelCount = channels;
-        fileData->sourceFormat = nqr::PCM_FLT;
-        fileData->sampleRate = 44100; // @tofix hardcoded sample rate
-        // fileData->... other file data not needed
-        
-        // Represents target encoding (wav only)
-        // Libnyquist bug with things other than PCM_FLT?
-        nqr::EncoderParams params = {2, nqr::PCM_FLT, nqr::DITHER_NONE};
-        
-        nqr::WavEncoder encoder;
-        
-        int encoderStatus = encoder.WriteFile(params, fileData.get(), filenameWithWavExtension);
-        
-        LOG("[WavEncoder - Debug Status: %i]", encoderStatus);
-        
+
+        file.write(data.data(), data.size() / channels);
+        file.close();
     }
-    
+
     void RecorderNode::reset(ContextRenderLock& r)
     {
         std::vector<float> clear;
@@ -158,8 +202,8 @@ namespace LabSound
             std::lock_guard<std::recursive_mutex> lock(m_mutex);
             m_data.swap(clear);
         }
-        
+
         // release the data in clear's destructor after the mutex has been released
     }
-                                           
+
 } // end namespace LabSound
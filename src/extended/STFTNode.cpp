@@ -0,0 +1,242 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#include "LabSound/core/AudioContext.h"
+#include "LabSound/core/AudioNodeInput.h"
+#include "LabSound/core/AudioNodeOutput.h"
+#include "LabSound/core/LockFreeQueue.h"
+
+#include "LabSound/extended/AudioContextLock.h"
+#include "LabSound/extended/STFTNode.h"
+
+#include "internal/Assertions.h"
+#include "internal/AudioBus.h"
+#include "internal/MixingMatrix.h"
+#include "internal/SpectralAnalysis.h"
+#include "internal/VectorMath.h"
+
+#include <algorithm>
+#include <string.h>
+
+using namespace WebCore;
+
+namespace LabSound {
+
+namespace {
+
+    // A finished frame. Slots circulate between a resolution's free and ready queues, so the render
+    // thread never allocates one.
+    struct Slot
+    {
+        uint64_t sampleFrame;
+        std::vector<float> real;
+        std::vector<float> imag;
+        std::vector<float> magnitudes;
+    };
+
+} // anonymous namespace
+
+struct STFTNode::Analysis
+{
+    Analysis(STFTResolution settings, size_t queuedFrames)
+        : settings(settings)
+        , engine(settings.windowSize)
+        , history(settings.windowSize)
+        , writeIndex(0)
+        , framesUntilFrame(settings.windowSize)
+        , slots(queuedFrames)
+        , freeSlots(queuedFrames)
+        , readySlots(queuedFrames)
+    {
+        size_t bins = settings.windowSize / 2;
+        for (Slot& slot : slots) {
+            slot.sampleFrame = 0;
+            slot.real.resize(bins);
+            slot.imag.resize(bins);
+            slot.magnitudes.resize(bins);
+            freeSlots.tryPush(&slot);
+        }
+    }
+
+    STFTResolution settings;
+    SpectralAnalysis engine;
+
+    std::vector<float> history;     // the most recent windowSize frames, circular
+    size_t writeIndex;
+    size_t framesUntilFrame;        // the first frame waits for a full window, the rest for a hop
+
+    std::vector<Slot> slots;
+    LockFreeQueue<Slot*> freeSlots;
+    LockFreeQueue<Slot*> readySlots;
+};
+
+STFTNode::STFTNode(float sampleRate, uint32_t windowSize, uint32_t hopSize, size_t queuedFrames)
+    : AudioBasicInspectorNode(sampleRate, 2)
+    , m_droppedFrames(0)
+{
+    STFTResolution resolution = { windowSize, hopSize };
+    initializeAnalyses(std::vector<STFTResolution>(1, resolution), queuedFrames);
+}
+
+STFTNode::STFTNode(float sampleRate, const std::vector<STFTResolution>& resolutions, size_t queuedFrames)
+    : AudioBasicInspectorNode(sampleRate, 2)
+    , m_droppedFrames(0)
+{
+    initializeAnalyses(resolutions, queuedFrames);
+}
+
+STFTNode::~STFTNode()
+{
+    uninitialize();
+}
+
+void STFTNode::initializeAnalyses(const std::vector<STFTResolution>& resolutions, size_t queuedFrames)
+{
+    setNodeType((AudioNode::NodeType) LabSound::NodeTypeSTFT);
+
+    queuedFrames = std::max(queuedFrames, static_cast<size_t>(1));
+
+    for (STFTResolution settings : resolutions) {
+        uint32_t size = 32;
+        while (size < settings.windowSize)
+            size <<= 1;
+        settings.windowSize = size;
+        settings.hopSize = std::max(settings.hopSize, 1u);
+
+        m_analyses.emplace_back(new Analysis(settings, queuedFrames));
+    }
+
+    m_mono.resize(AudioNode::ProcessingSizeInFrames);
+}
+
+STFTResolution STFTNode::resolution(unsigned index) const
+{
+    ASSERT(index < m_analyses.size());
+    return m_analyses[index]->settings;
+}
+
+void STFTNode::process(ContextRenderLock& r, size_t framesToProcess)
+{
+    AudioBus* outputBus = output(0)->bus(r);
+
+    if (!isInitialized() || !input(0)->isConnected()) {
+        if (outputBus)
+            outputBus->zero();
+        return;
+    }
+
+    AudioBus* bus = input(0)->bus(r);
+    bool isBusGood = bus && bus->numberOfChannels() > 0 && bus->channel(0)->length() >= framesToProcess && r.context();
+    if (!isBusGood) {
+        outputBus->zero();
+        return;
+    }
+
+    if (m_mono.size() < framesToProcess)
+        m_mono.resize(framesToProcess);
+
+    // Mix the input to mono, as the analyser does.
+    const float* sources[MaxBusChannels];
+    float gains[MaxBusChannels];
+    unsigned numberOfChannels = bus->numberOfChannels();
+    for (unsigned c = 0; c < numberOfChannels; ++c) {
+        sources[c] = bus->channel(c)->data();
+        gains[c] = 1.0f / numberOfChannels;
+    }
+    VectorMath::vmix(sources, gains, numberOfChannels, m_mono.data(), false, framesToProcess);
+
+    const uint64_t quantumStartFrame = r.context()->currentSampleFrame();
+
+    for (unsigned index = 0; index < m_analyses.size(); ++index) {
+        Analysis& analysis = *m_analyses[index];
+        const size_t windowSize = analysis.settings.windowSize;
+
+        // Feed the history up to each point where a frame is due, and transform it there.
+        size_t i = 0;
+        while (i < framesToProcess) {
+            size_t count = std::min(framesToProcess - i, analysis.framesUntilFrame);
+
+            // When the hop is longer than the window, only the last window of frames can reach a frame.
+            size_t skipped = count > windowSize ? count - windowSize : 0;
+            size_t kept = count - skipped;
+            size_t writeIndex = (analysis.writeIndex + skipped) & (windowSize - 1);
+
+            size_t firstPart = std::min(kept, windowSize - writeIndex);
+            memcpy(analysis.history.data() + writeIndex, m_mono.data() + i + skipped, sizeof(float) * firstPart);
+            memcpy(analysis.history.data(), m_mono.data() + i + skipped + firstPart, sizeof(float) * (kept - firstPart));
+            analysis.writeIndex = (writeIndex + kept) & (windowSize - 1);
+
+            i += count;
+            analysis.framesUntilFrame -= count;
+
+            if (!analysis.framesUntilFrame) {
+                emitFrame(analysis, index, quantumStartFrame + i - windowSize);
+                analysis.framesUntilFrame = analysis.settings.hopSize;
+            }
+        }
+    }
+
+    // For in-place processing, our override of pullInputs() will just pass the audio data
+    // through unchanged if the channel count matches from input to output
+    // (resulting in inputBus == outputBus). Otherwise, do an up-mix to stereo.
+    if (bus != outputBus)
+        outputBus->copyFrom(*bus);
+}
+
+void STFTNode::emitFrame(Analysis& analysis, unsigned resolution, uint64_t sampleFrame)
+{
+    Slot* slot;
+    if (!analysis.freeSlots.tryPop(slot)) {
+        ++m_droppedFrames;
+        return;
+    }
+
+    SpectralAnalysis& engine = analysis.engine;
+    engine.transform(analysis.history.data(), analysis.history.size(), analysis.writeIndex);
+
+    size_t bins = engine.frequencyBinCount();
+    const float scale = 1;
+    memcpy(slot->real.data(), engine.realData(), sizeof(float) * bins);
+    memcpy(slot->imag.data(), engine.imagData(), sizeof(float) * bins);
+    VectorMath::zvmag(slot->real.data(), slot->imag.data(), &scale, slot->magnitudes.data(), bins);
+    slot->sampleFrame = sampleFrame;
+
+    analysis.readySlots.tryPush(slot);
+}
+
+void STFTNode::reset(ContextRenderLock&)
+{
+    for (auto& analysis : m_analyses) {
+        std::fill(analysis->history.begin(), analysis->history.end(), 0.0f);
+        analysis->writeIndex = 0;
+        analysis->framesUntilFrame = analysis->settings.windowSize;
+
+        // Frames computed before the reset are stale.
+        Slot* slot;
+        while (analysis->readySlots.tryPop(slot))
+            analysis->freeSlots.tryPush(slot);
+    }
+}
+
+bool STFTNode::popFrame(unsigned resolution, STFTFrame& frame)
+{
+    if (resolution >= m_analyses.size())
+        return false;
+
+    Analysis& analysis = *m_analyses[resolution];
+
+    Slot* slot;
+    if (!analysis.readySlots.tryPop(slot))
+        return false;
+
+    frame.sampleFrame = slot->sampleFrame;
+    frame.resolution = resolution;
+    frame.real.assign(slot->real.begin(), slot->real.end());
+    frame.imag.assign(slot->imag.begin(), slot->imag.end());
+    frame.magnitudes.assign(slot->magnitudes.begin(), slot->magnitudes.end());
+
+    analysis.freeSlots.tryPush(slot);
+    return true;
+}
+
+} // namespace LabSound
@@ -1,140 +1,349 @@
 // Copyright (c) 2014 Dimitri Diakopolous, All rights reserved.
 // License is MIT: http://opensource.org/licenses/MIT
 
+#include "LabSound/core/AudioNodeOutput.h"
 #include "LabSound/extended/SampledInstrumentNode.h"
+#include "LabSound/extended/DecodeService.h"
 
-#include "internal/ConfigMacros.h"
+#include "internal/AudioBus.h"
+#include "internal/AudioUtilities.h"
+#include "internal/BufferResampler.h"
+#include "internal/VectorMath.h"
 
+#include <future>
+#include <math.h>
 #include <string>
-#include <fstream>
-#include <streambuf>
-#include <stdlib.h>
+#include <thread>
 
-namespace LabSound 
+namespace LabSound
 {
 
 	using namespace WebCore;
 
-	struct SamplerSound 
+	struct SamplerSound
 	{
-
-		SamplerSound(std::shared_ptr<GainNode> d, SampledInstrumentDefinition & def) : destinationNode(d)
+		SamplerSound(const SampledInstrumentDefinition & def, std::shared_ptr<AudioBuffer> decoded) : audioBuffer(decoded)
 		{
-			audioBuffer = new SoundBuffer(def.audio, def.extension, d->sampleRate());
-			this->baseMidiNote = def.root;
-			this->midiNoteLow = def.min;
-			this->midiNoteHigh = def.max;
+			baseMidiNote = def.root;
+			midiNoteLow = def.min;
+			midiNoteHigh = def.max;
+
+			if (AudioBuffer * buffer = audioBuffer.get())
+			{
+				for (unsigned i = 0; i < buffer->numberOfChannels(); ++i)
+					channels.push_back(buffer->getChannelData(i)->data());
+				length = buffer->length();
+				bufferSampleRate = buffer->sampleRate();
+			}
 		}
 
-		bool AppliesToNote(uint8_t note) 
+		bool AppliesToNote(uint8_t note) const
 		{
-			// Debugging: 
-			//std::cout << "Note: " << int(note) << std::endl;
-			//std::cout << "Base: " << int(baseMidiNote) << std::endl;
-			//std::cout << "Low: " << int(midiNoteLow) << std::endl;
-			//std::cout << "High: " << int(midiNoteHigh) << std::endl;
-			//std::cout << std::endl << std::endl;
-			if (baseMidiNote == note || (note >= midiNoteLow && note <= midiNoteHigh)) 
-				return true; 
-			else 
-				return false; 
+			return baseMidiNote == note || (note >= midiNoteLow && note <= midiNoteHigh);
 		}
 
-		std::shared_ptr<AudioBufferSourceNode> Start(ContextRenderLock & r, int midiNoteNumber, float amplitude = 1.0) 
-		{
-            if (!r.context()) throw std::runtime_error("cannot get context");
-            
-			double pitchRatio = pow(2.0, (midiNoteNumber - baseMidiNote) / 12.0);
+		bool IsValid() const { return !channels.empty() && length; }
+
+		std::shared_ptr<AudioBuffer> audioBuffer;
+
+		// Taken once at load so the audio thread reads the decoded data directly.
+		std::vector<const float *> channels;
+		size_t length = 0;
+		float bufferSampleRate = 0;
+
+		uint8_t baseMidiNote;
+		uint8_t midiNoteLow;
+		uint8_t midiNoteHigh;
+	};
+
+	SampledInstrumentNode::SampledInstrumentNode(float sampleRate, unsigned numberOfVoices)
+		: AudioSourceNode(sampleRate)
+		, voices(std::max(numberOfVoices, 1u))
+		, releaseTime(0.05f)
+		, events(256)
+		, scratch(2, std::vector<float>(AudioNode::ProcessingSizeInFrames))
+	{
+		setNodeType((AudioNode::NodeType) LabSound::NodeTypeSampledInstrument);
 
-			std::shared_ptr<AudioBufferSourceNode> theSample(audioBuffer->create(r, r.context()->sampleRate()));
+		pendingEvents.reserve(events.capacity());
 
-			theSample->playbackRate()->setValue(pitchRatio); 
-			theSample->gain()->setValue(amplitude); 
+		addOutput(std::unique_ptr<AudioNodeOutput>(new AudioNodeOutput(this, 2)));
 
-			// Connect the source node to the parsed audio data for playback
-			theSample->setBuffer(r, audioBuffer->audioBuffer);
+		initialize();
+	}
 
-			theSample->connect(r.context(), destinationNode.get(), 0, 0);
-			theSample->start(0.0);
+	SampledInstrumentNode::~SampledInstrumentNode()
+	{
+		uninitialize();
+	}
 
-			return theSample;
+	void SampledInstrumentNode::LoadInstrument(std::shared_ptr<AudioContext> context, std::vector<SampledInstrumentDefinition> & sounds)
+	{
+		std::vector<std::shared_ptr<SamplerSound>> loaded;
+		if (!sounds.empty())
+		{
+			unsigned numberOfThreads = static_cast<unsigned>(std::min<size_t>(sounds.size(), std::max(std::thread::hardware_concurrency(), 1u)));
+			DecodeService decoder(numberOfThreads);
+
+			std::vector<std::future<DecodeService::Result>> decoded;
+			decoded.reserve(sounds.size());
+			for (auto & samp : sounds)
+				decoded.push_back(decoder.load(samp.audio, samp.extension, true, sampleRate()));
+
+			for (size_t i = 0; i < sounds.size(); ++i)
+			{
+				auto sound = std::make_shared<SamplerSound>(sounds[i], decoded[i].get());
+				if (sound->IsValid())
+					loaded.push_back(sound);
+			}
 		}
 
-		void Stop(ContextRenderLock & r, int midiNoteNumber, float amplitude = 0.0)
+		// The render lock is try-locked, so wait for a gap between render quanta. The voices refer to the samples
+		// by index, so they can't outlive the instrument they were playing.
+		for (;;)
 		{
-			//@tofix -- disconnect? 
+			ContextRenderLock r(context, "SampledInstrumentNode::LoadInstrument");
+			if (r.context() || !context)
+			{
+				reset(r);
+				samples.swap(loaded);
+				break;
+			}
+			std::this_thread::yield();
 		}
 
-        std::shared_ptr<GainNode> destinationNode;
+		// The previous instrument is freed here, after the lock is released.
+	}
 
-		SoundBuffer * audioBuffer;
+	bool SampledInstrumentNode::Post(const NoteEvent & event, double when)
+	{
+		NoteEvent timed = event;
+		timed.frame = when > 0 ? AudioUtilities::timeToSampleFrame(when, sampleRate()) : 0;
+		return events.tryPush(timed);
+	}
 
-		uint8_t baseMidiNote;
-		uint8_t midiNoteLow;
-		uint8_t midiNoteHigh; 
-	};
+	bool SampledInstrumentNode::NoteOn(const int midiNoteNumber, const float amplitude, double when)
+	{
+		if (midiNoteNumber < 0 || midiNoteNumber > 127)
+			return false;
 
-    SampledInstrumentNode::SampledInstrumentNode(float sampleRate) 
-	{ 
-        gainNode = std::make_shared<GainNode>(sampleRate);
-		gainNode->gain()->setValue(1.0);
+		NoteEvent event = { 0, NoteEvent::On, static_cast<uint8_t>(midiNoteNumber), amplitude };
+		return Post(event, when);
 	}
 
-	SampledInstrumentNode::~SampledInstrumentNode()
+	bool SampledInstrumentNode::NoteOff(const int midiNoteNumber, double when)
 	{
+		if (midiNoteNumber < 0 || midiNoteNumber > 127)
+			return false;
 
+		NoteEvent event = { 0, NoteEvent::Off, static_cast<uint8_t>(midiNoteNumber), 0 };
+		return Post(event, when);
 	}
 
-	//@tofix: add adsr
-	void SampledInstrumentNode::NoteOn(ContextRenderLock & r, const int midiNoteNumber, const float amplitude)
-    {
-        if (!r.context()) return;
-
-		std::cout << "Size: " << voices.size() << std::endl;
-
-		for (const auto & sample : samples)
-        {
-			// Find note in sample map
-			if (sample->AppliesToNote(midiNoteNumber))
-            {
-				for (auto & v : voices)
-				{	
-					if (v->hasFinished())
-					{
-						v = sample->Start(r, midiNoteNumber, amplitude); // this voice is free -> destruct
-						return;
-					}
-				}
+	void SampledInstrumentNode::KillAllNotes()
+	{
+		NoteEvent event = { 0, NoteEvent::AllOff, 0, 0 };
+		Post(event, 0);
+	}
 
-				// create new voice
-				voices.push_back(sample->Start(r, midiNoteNumber, amplitude));
-				return; 
+	void SampledInstrumentNode::SetReleaseTime(float seconds)
+	{
+		releaseTime.store(std::max(seconds, 0.0f), std::memory_order_relaxed);
+	}
+
+	void SampledInstrumentNode::process(ContextRenderLock & r, size_t framesToProcess)
+	{
+		AudioBus * outputBus = output(0)->bus(r);
+		outputBus->zero();
+
+		if (!isInitialized() || !outputBus->numberOfChannels() || !r.context())
+			return;
+
+		// Move the new events into the pending list, which is kept in time order. The list never grows
+		// beyond the queue's capacity; anything more waits in the queue for a later render quantum.
+		NoteEvent event;
+		while (pendingEvents.size() < pendingEvents.capacity() && events.tryPop(event))
+		{
+			auto position = std::upper_bound(pendingEvents.begin(), pendingEvents.end(), event,
+				[](const NoteEvent & a, const NoteEvent & b) { return a.frame < b.frame; });
+			pendingEvents.insert(position, event);
+		}
+
+		const uint64_t quantumStartFrame = r.context()->currentSampleFrame();
+		const uint64_t quantumEndFrame = quantumStartFrame + framesToProcess;
+
+		// Render the voices up to each event due in this quantum, then apply it.
+		size_t frame = 0;
+		size_t handled = 0;
+		for (;;)
+		{
+			bool due = handled < pendingEvents.size() && pendingEvents[handled].frame < quantumEndFrame;
+			size_t next = framesToProcess;
+			if (due)
+				next = pendingEvents[handled].frame > quantumStartFrame ? static_cast<size_t>(pendingEvents[handled].frame - quantumStartFrame) : 0;
 
+			if (next > frame && activeVoices)
+			{
+				for (auto & voice : voices)
+				{
+					if (voice.sample >= 0)
+						RenderVoice(outputBus, voice, frame, next - frame);
+				}
 			}
+			frame = std::max(frame, next);
+
+			if (!due)
+				break;
+
+			HandleEvent(outputBus, pendingEvents[handled], frame, framesToProcess);
+			++handled;
 		}
+
+		pendingEvents.erase(pendingEvents.begin(), pendingEvents.begin() + handled);
+
+		outputBus->clearSilentFlag();
 	}
 
-	void SampledInstrumentNode::NoteOff(ContextRenderLock & r, const int midiNoteNumber, const float amplitude)
+	void SampledInstrumentNode::HandleEvent(AudioBus * outputBus, const NoteEvent & event, size_t frame, size_t framesToProcess)
 	{
-		if (!r.context()) return;
-		 
-		// This logic is wrong. Find in voices... 
-		for (const auto & sample : samples)
-        {
-			if (sample->AppliesToNote(midiNoteNumber))
-            {
-				sample->Stop(r, midiNoteNumber, amplitude);
+		switch (event.type)
+		{
+		case NoteEvent::On:
+		{
+			int sample = -1;
+			for (size_t i = 0; i < samples.size(); ++i)
+			{
+				if (samples[i]->AppliesToNote(event.note))
+				{
+					sample = static_cast<int>(i);
+					break;
+				}
+			}
+			if (sample < 0)
+				return;
+
+			// Take a free voice, or steal the quietest releasing voice, or the oldest.
+			Voice * chosen = nullptr;
+			for (auto & voice : voices)
+			{
+				if (voice.sample < 0)
+				{
+					chosen = &voice;
+					break;
+				}
+				if (!chosen
+					|| (voice.releasing && (!chosen->releasing || voice.gain < chosen->gain))
+					|| (!voice.releasing && !chosen->releasing && voice.serial < chosen->serial))
+					chosen = &voice;
 			}
+
+			if (chosen->sample >= 0)
+			{
+				// The stolen note fades out over the rest of this quantum rather than cutting off with a click.
+				RenderVoice(outputBus, *chosen, frame, framesToProcess - frame, true);
+			}
+
+			const SamplerSound & sound = *samples[sample];
+
+			chosen->sample = sample;
+			chosen->note = event.note;
+			chosen->serial = nextSerial++;
+			chosen->position = 0;
+			chosen->rate = pow(2.0, (event.note - sound.baseMidiNote) / 12.0) * sound.bufferSampleRate / sampleRate();
+			chosen->gain = event.amplitude;
+			chosen->gainStep = 0;
+			chosen->releasing = false;
+			++activeVoices;
+			break;
+		}
+
+		case NoteEvent::Off:
+		{
+			float releaseFrames = std::max(releaseTime.load(std::memory_order_relaxed) * sampleRate(), 1.0f);
+			for (auto & voice : voices)
+			{
+				if (voice.sample >= 0 && voice.note == event.note && !voice.releasing)
+				{
+					voice.releasing = true;
+					voice.gainStep = -voice.gain / releaseFrames;
+				}
+			}
+			break;
+		}
+
+		case NoteEvent::AllOff:
+			for (auto & voice : voices)
+			{
+				if (voice.sample >= 0)
+					RenderVoice(outputBus, voice, frame, framesToProcess - frame, true);
+			}
+			break;
 		}
 	}
-	
-	void SampledInstrumentNode::LoadInstrument(std::vector<SampledInstrumentDefinition> & sounds) 
+
+	void SampledInstrumentNode::RenderVoice(AudioBus * outputBus, Voice & voice, size_t frame, size_t framesToRender, bool fadeOut)
 	{
-		for (auto & samp : sounds) 
+		const SamplerSound & sound = *samples[voice.sample];
+
+		if (fadeOut)
+		{
+			voice.releasing = true;
+			voice.gainStep = framesToRender ? -voice.gain / framesToRender : 0;
+		}
+
+		// Stop at the end of the sample, or when a release reaches silence.
+		double framesLeft = (sound.length - voice.position) / voice.rate;
+		size_t framesToPlay = framesLeft > 0 ? static_cast<size_t>(std::min(ceil(framesLeft), static_cast<double>(framesToRender))) : 0;
+		if (voice.releasing)
 		{
-            samples.push_back(std::make_shared<SamplerSound>(gainNode, samp));
+			double framesToSilence = voice.gainStep < 0 ? ceil(voice.gain / -voice.gainStep) : 0;
+			framesToPlay = std::min(framesToPlay, static_cast<size_t>(std::max(framesToSilence, 0.0)));
 		}
 
+		if (framesToPlay)
+		{
+			ResamplerSource source;
+			source.channels = sound.channels.data();
+			source.numberOfChannels = std::min(static_cast<unsigned>(sound.channels.size()), static_cast<unsigned>(scratch.size()));
+			source.length = sound.length;
+			source.loop = false;
+			source.loopDeltaFrames = 0;
+
+			float * destinations[2] = { scratch[0].data(), scratch[1].data() };
+			BufferResampler::render(InterpolationMode::LINEAR, source, voice.position, voice.rate, destinations, 0, framesToPlay);
+
+			float gain = voice.gain;
+			for (unsigned c = 0; c < outputBus->numberOfChannels(); ++c)
+			{
+				// Mono samples play in every channel.
+				gain = voice.gain;
+				const float * sourceP = scratch[std::min(c, source.numberOfChannels - 1)].data();
+				VectorMath::vrampmuladd(sourceP, &gain, &voice.gainStep, outputBus->channel(c)->mutableData() + frame, framesToPlay);
+			}
+
+			voice.gain = gain;
+			voice.position += framesToPlay * voice.rate;
+		}
+
+		if (framesToPlay < framesToRender || fadeOut || (voice.releasing && voice.gain <= 0))
+		{
+			voice.sample = -1;
+			voice.releasing = false;
+			--activeVoices;
+		}
+	}
+
+	void SampledInstrumentNode::reset(ContextRenderLock &)
+	{
+		for (auto & voice : voices)
+			voice = Voice();
+		activeVoices = 0;
+		pendingEvents.clear();
+	}
+
+	bool SampledInstrumentNode::propagatesSilence(double now) const
+	{
+		return !activeVoices && pendingEvents.empty() && events.empty();
 	}
 
 }
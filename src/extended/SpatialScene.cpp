@@ -0,0 +1,389 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#include "LabSound/core/AudioContext.h"
+#include "LabSound/core/AudioListener.h"
+#include "LabSound/core/FloatPoint3D.h"
+
+#include "LabSound/extended/AudioContextLock.h"
+#include "LabSound/extended/SpatialScene.h"
+
+#include "internal/VectorMath.h"
+
+#include <WTF/MathExtras.h>
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace WebCore;
+
+namespace LabSound
+{
+    namespace
+    {
+        const float MinDopplerRate = 0.125f;   // 3 octaves down
+        const float MaxDopplerRate = 16.0f;    // 4 octaves up
+
+        template<typename T>
+        void removeAt(std::vector<T>& v, size_t i)
+        {
+            v[i] = v.back();
+            v.pop_back();
+        }
+
+        inline float acosDegrees(float x)
+        {
+            return static_cast<float>(180.0 * acos(std::min(1.0f, std::max(-1.0f, x))) / piDouble);
+        }
+
+#ifdef __SSE2__
+        inline __m128 select(__m128 mask, __m128 a, __m128 b)
+        {
+            return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+        }
+
+        inline __m128 dot(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz)
+        {
+            return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+        }
+
+        // As FloatPoint3D::isZero
+        inline __m128 isZero(__m128 x, __m128 y, __m128 z)
+        {
+            const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+            const __m128 epsilon = _mm_set1_ps(FLT_EPSILON);
+            return _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(_mm_and_ps(x, absMask), epsilon),
+                                         _mm_cmplt_ps(_mm_and_ps(y, absMask), epsilon)),
+                              _mm_cmplt_ps(_mm_and_ps(z, absMask), epsilon));
+        }
+
+        // acos in degrees, of x clamped to [-1, 1]. The polynomial, from Abramowitz and Stegun 4.4.46, is
+        // good to 2e-8 radians, well below float precision.
+        inline __m128 acosDegrees(__m128 x)
+        {
+            const __m128 one = _mm_set1_ps(1);
+            x = _mm_min_ps(one, _mm_max_ps(_mm_set1_ps(-1), x));
+
+            __m128 negative = _mm_cmplt_ps(x, _mm_setzero_ps());
+            __m128 a = _mm_andnot_ps(_mm_set1_ps(-0.0f), x);
+
+            __m128 p = _mm_set1_ps(-0.0012624911f);
+            p = _mm_add_ps(_mm_mul_ps(p, a), _mm_set1_ps(0.0066700901f));
+            p = _mm_add_ps(_mm_mul_ps(p, a), _mm_set1_ps(-0.0170881256f));
+            p = _mm_add_ps(_mm_mul_ps(p, a), _mm_set1_ps(0.0308918810f));
+            p = _mm_add_ps(_mm_mul_ps(p, a), _mm_set1_ps(-0.0501743046f));
+            p = _mm_add_ps(_mm_mul_ps(p, a), _mm_set1_ps(0.0889789874f));
+            p = _mm_add_ps(_mm_mul_ps(p, a), _mm_set1_ps(-0.2145988016f));
+            p = _mm_add_ps(_mm_mul_ps(p, a), _mm_set1_ps(1.5707963050f));
+
+            __m128 r = _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(one, a)), p);
+            r = select(negative, _mm_sub_ps(_mm_set1_ps(piFloat), r), r);
+            return _mm_mul_ps(r, _mm_set1_ps(180.0f / piFloat));
+        }
+#endif
+    }
+
+    SpatialScene::SpatialScene() : m_listenerVersion(~0u), m_changed(false)
+    {
+    }
+
+    SpatialScene::~SpatialScene()
+    {
+    }
+
+    void SpatialScene::addPanner(std::shared_ptr<PannerNode> panner)
+    {
+        if (!panner || std::find(m_panners.begin(), m_panners.end(), panner) != m_panners.end())
+            return;
+
+        m_panners.push_back(panner);
+        m_versions.push_back(~0u);
+
+        size_t n = m_panners.size();
+        for (auto v : { &m_positionX, &m_positionY, &m_positionZ, &m_orientationX, &m_orientationY, &m_orientationZ,
+                        &m_velocityX, &m_velocityY, &m_velocityZ, &m_refDistance, &m_maxDistance, &m_rolloffFactor,
+                        &m_coneInnerAngle, &m_coneOuterAngle, &m_coneOuterGain, &m_hasCone,
+                        &m_azimuth, &m_elevation, &m_linearGain, &m_inverseGain, &m_exponentialGain,
+                        &m_distanceRatio, &m_coneGain, &m_dopplerRate })
+            v->resize(n);
+        m_distanceModel.resize(n);
+    }
+
+    void SpatialScene::removePanner(std::shared_ptr<PannerNode> panner)
+    {
+        auto it = std::find(m_panners.begin(), m_panners.end(), panner);
+        if (it == m_panners.end())
+            return;
+
+        // The last panner takes the place of the removed one.
+        size_t i = it - m_panners.begin();
+        removeAt(m_panners, i);
+        removeAt(m_versions, i);
+        for (auto v : { &m_positionX, &m_positionY, &m_positionZ, &m_orientationX, &m_orientationY, &m_orientationZ,
+                        &m_velocityX, &m_velocityY, &m_velocityZ, &m_refDistance, &m_maxDistance, &m_rolloffFactor,
+                        &m_coneInnerAngle, &m_coneOuterAngle, &m_coneOuterGain, &m_hasCone,
+                        &m_azimuth, &m_elevation, &m_linearGain, &m_inverseGain, &m_exponentialGain,
+                        &m_distanceRatio, &m_coneGain, &m_dopplerRate })
+            removeAt(*v, i);
+        removeAt(m_distanceModel, i);
+    }
+
+    void SpatialScene::gather(size_t i)
+    {
+        PannerNode& panner = *m_panners[i];
+
+        FloatPoint3D position = panner.position();
+        m_positionX[i] = position.x;
+        m_positionY[i] = position.y;
+        m_positionZ[i] = position.z;
+
+        FloatPoint3D velocity = panner.velocity();
+        m_velocityX[i] = velocity.x;
+        m_velocityY[i] = velocity.y;
+        m_velocityZ[i] = velocity.z;
+
+        m_distanceModel[i] = panner.distanceModel();
+        m_refDistance[i] = panner.refDistance();
+        m_maxDistance[i] = panner.maxDistance();
+        m_rolloffFactor[i] = panner.rolloffFactor();
+
+        // As ConeEffect, which takes the angles as whole angles and has no cone at all while both are 360.
+        FloatPoint3D orientation = panner.orientation();
+        float innerAngle = panner.coneInnerAngle();
+        float outerAngle = panner.coneOuterAngle();
+        m_hasCone[i] = !orientation.isZero() && !(innerAngle == 360 && outerAngle == 360) ? 1.0f : 0.0f;
+        m_coneInnerAngle[i] = fabsf(innerAngle) / 2;
+        m_coneOuterAngle[i] = fabsf(outerAngle) / 2;
+        m_coneOuterGain[i] = panner.coneOuterGain();
+
+        orientation.normalize();
+        m_orientationX[i] = orientation.x;
+        m_orientationY[i] = orientation.y;
+        m_orientationZ[i] = orientation.z;
+    }
+
+    void SpatialScene::update(ContextRenderLock& r)
+    {
+        if (!r.context())
+            return;
+
+        const AudioListener& listener = *r.context()->listener();
+        unsigned listenerVersion = listener.version();
+
+        // The version is read before the geometry, so a panner that changes while it is gathered is gathered
+        // again next time, and meanwhile doesn't take results that are older than it is.
+        for (size_t i = 0; i < m_panners.size(); ++i)
+        {
+            unsigned version = m_panners[i]->geometryVersion();
+            if (version != m_versions[i])
+            {
+                m_versions[i] = version;
+                gather(i);
+                m_changed = true;
+            }
+        }
+
+        if (!m_changed && listenerVersion == m_listenerVersion)
+            return;
+
+        size_t count = m_panners.size();
+        compute(listener, count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            float distanceGain;
+            switch (m_distanceModel[i])
+            {
+            case PannerNode::LINEAR_DISTANCE: distanceGain = m_linearGain[i]; break;
+            case PannerNode::EXPONENTIAL_DISTANCE: distanceGain = m_exponentialGain[i]; break;
+            case PannerNode::INVERSE_DISTANCE:
+            default: distanceGain = m_inverseGain[i]; break;
+            }
+
+            m_panners[i]->setComputedGeometry(m_versions[i], listenerVersion, m_azimuth[i], m_elevation[i], distanceGain, m_coneGain[i], m_dopplerRate[i]);
+        }
+
+        m_changed = false;
+        m_listenerVersion = listenerVersion;
+    }
+
+    // The same computations as PannerNode's getAzimuthElevation, distanceConeGain and dopplerRate, and as
+    // DistanceEffect and ConeEffect, but for all the panners at once.
+    void SpatialScene::compute(const AudioListener& listener, size_t count)
+    {
+        if (!count)
+            return;
+
+        const FloatPoint3D& L = listener.position();
+        const FloatPoint3D& R = listener.rightBasis();
+        const FloatPoint3D& F = listener.frontBasis();
+        const FloatPoint3D& U = listener.upBasis();
+        const FloatPoint3D& V = listener.velocity();
+
+        float dopplerFactor = static_cast<float>(listener.dopplerFactor());
+        float speedOfSound = static_cast<float>(listener.speedOfSound());
+        bool hasDoppler = dopplerFactor > 0;
+        bool listenerHasVelocity = !V.isZero();
+        float scaledSpeedOfSound = hasDoppler ? speedOfSound / dopplerFactor : 0;
+
+        size_t i = 0;
+
+#ifdef __SSE2__
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1);
+        const __m128 Lx = _mm_set1_ps(L.x), Ly = _mm_set1_ps(L.y), Lz = _mm_set1_ps(L.z);
+        const __m128 Rx = _mm_set1_ps(R.x), Ry = _mm_set1_ps(R.y), Rz = _mm_set1_ps(R.z);
+        const __m128 Fx = _mm_set1_ps(F.x), Fy = _mm_set1_ps(F.y), Fz = _mm_set1_ps(F.z);
+        const __m128 Ux = _mm_set1_ps(U.x), Uy = _mm_set1_ps(U.y), Uz = _mm_set1_ps(U.z);
+        const __m128 Vx = _mm_set1_ps(V.x), Vy = _mm_set1_ps(V.y), Vz = _mm_set1_ps(V.z);
+        const __m128 listenerMoves = listenerHasVelocity ? _mm_castsi128_ps(_mm_set1_epi32(-1)) : zero;
+        const __m128 c = _mm_set1_ps(speedOfSound);
+        const __m128 f = _mm_set1_ps(dopplerFactor);
+        const __m128 scaledC = _mm_set1_ps(scaledSpeedOfSound);
+        const __m128 infinity = _mm_set1_ps(INFINITY);
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+        for (; i + 4 <= count; i += 4)
+        {
+            // The listener to source vector, and its direction
+            __m128 dx = _mm_sub_ps(_mm_loadu_ps(&m_positionX[i]), Lx);
+            __m128 dy = _mm_sub_ps(_mm_loadu_ps(&m_positionY[i]), Ly);
+            __m128 dz = _mm_sub_ps(_mm_loadu_ps(&m_positionZ[i]), Lz);
+            __m128 coincident = isZero(dx, dy, dz);
+            __m128 distance = _mm_sqrt_ps(dot(dx, dy, dz, dx, dy, dz));
+            __m128 scale = _mm_andnot_ps(coincident, _mm_div_ps(one, distance));
+            __m128 nx = _mm_mul_ps(dx, scale), ny = _mm_mul_ps(dy, scale), nz = _mm_mul_ps(dz, scale);
+
+            // Azimuth, from the direction projected on the listener's horizontal plane
+            __m128 upProjection = dot(nx, ny, nz, Ux, Uy, Uz);
+            __m128 qx = _mm_sub_ps(nx, _mm_mul_ps(upProjection, Ux));
+            __m128 qy = _mm_sub_ps(ny, _mm_mul_ps(upProjection, Uy));
+            __m128 qz = _mm_sub_ps(nz, _mm_mul_ps(upProjection, Uz));
+            __m128 qScale = select(isZero(qx, qy, qz), one, _mm_div_ps(one, _mm_sqrt_ps(dot(qx, qy, qz, qx, qy, qz))));
+            qx = _mm_mul_ps(qx, qScale);
+            qy = _mm_mul_ps(qy, qScale);
+            qz = _mm_mul_ps(qz, qScale);
+
+            __m128 azimuth = acosDegrees(dot(qx, qy, qz, Rx, Ry, Rz));
+            __m128 behind = _mm_cmplt_ps(dot(qx, qy, qz, Fx, Fy, Fz), zero);
+            azimuth = select(behind, _mm_sub_ps(_mm_set1_ps(360), azimuth), azimuth);
+            azimuth = select(_mm_cmple_ps(azimuth, _mm_set1_ps(270)), _mm_sub_ps(_mm_set1_ps(90), azimuth), _mm_sub_ps(_mm_set1_ps(450), azimuth));
+            _mm_storeu_ps(&m_azimuth[i], _mm_andnot_ps(coincident, azimuth));
+
+            __m128 elevation = _mm_sub_ps(_mm_set1_ps(90), acosDegrees(upProjection));
+            _mm_storeu_ps(&m_elevation[i], _mm_andnot_ps(coincident, elevation));
+
+            // Distance gains, for a distance clamped to between the reference and maximum distances
+            __m128 refDistance = _mm_loadu_ps(&m_refDistance[i]);
+            __m128 maxDistance = _mm_loadu_ps(&m_maxDistance[i]);
+            __m128 rolloff = _mm_loadu_ps(&m_rolloffFactor[i]);
+            __m128 clamped = _mm_max_ps(_mm_min_ps(distance, maxDistance), refDistance);
+            __m128 beyond = _mm_mul_ps(rolloff, _mm_sub_ps(clamped, refDistance));
+            _mm_storeu_ps(&m_linearGain[i], _mm_sub_ps(one, _mm_div_ps(beyond, _mm_sub_ps(maxDistance, refDistance))));
+            _mm_storeu_ps(&m_inverseGain[i], _mm_div_ps(refDistance, _mm_add_ps(refDistance, beyond)));
+            _mm_storeu_ps(&m_distanceRatio[i], _mm_div_ps(clamped, refDistance));
+
+            // Cone gain, from the angle between the source's orientation and the direction to the listener
+            __m128 angle = acosDegrees(_mm_sub_ps(zero, dot(nx, ny, nz, _mm_loadu_ps(&m_orientationX[i]), _mm_loadu_ps(&m_orientationY[i]), _mm_loadu_ps(&m_orientationZ[i]))));
+            __m128 innerAngle = _mm_loadu_ps(&m_coneInnerAngle[i]);
+            __m128 outerAngle = _mm_loadu_ps(&m_coneOuterAngle[i]);
+            __m128 outerGain = _mm_loadu_ps(&m_coneOuterGain[i]);
+            __m128 x = _mm_div_ps(_mm_sub_ps(angle, innerAngle), _mm_sub_ps(outerAngle, innerAngle));
+            __m128 coneGain = _mm_add_ps(_mm_sub_ps(one, x), _mm_mul_ps(outerGain, x));
+            coneGain = select(_mm_cmpge_ps(angle, outerAngle), outerGain, coneGain);
+            coneGain = select(_mm_cmple_ps(angle, innerAngle), one, coneGain);
+            coneGain = select(_mm_cmpgt_ps(_mm_loadu_ps(&m_hasCone[i]), zero), coneGain, one);
+            _mm_storeu_ps(&m_coneGain[i], coneGain);
+
+            // Doppler rate, from the velocities projected on the direction from the listener to the source
+            __m128 rate = one;
+            if (hasDoppler)
+            {
+                __m128 sx = _mm_loadu_ps(&m_velocityX[i]), sy = _mm_loadu_ps(&m_velocityY[i]), sz = _mm_loadu_ps(&m_velocityZ[i]);
+                __m128 moving = _mm_andnot_ps(coincident, _mm_or_ps(listenerMoves, _mm_andnot_ps(isZero(sx, sy, sz), _mm_castsi128_ps(_mm_set1_epi32(-1)))));
+                __m128 listenerProjection = _mm_min_ps(_mm_sub_ps(zero, dot(nx, ny, nz, Vx, Vy, Vz)), scaledC);
+                __m128 sourceProjection = _mm_min_ps(_mm_sub_ps(zero, dot(nx, ny, nz, sx, sy, sz)), scaledC);
+                __m128 shift = _mm_div_ps(_mm_sub_ps(c, _mm_mul_ps(f, listenerProjection)), _mm_sub_ps(c, _mm_mul_ps(f, sourceProjection)));
+                shift = _mm_and_ps(shift, _mm_cmplt_ps(_mm_and_ps(shift, absMask), infinity)); // NaN and infinity become 0, as fixNANs
+                shift = _mm_min_ps(_mm_max_ps(shift, _mm_set1_ps(MinDopplerRate)), _mm_set1_ps(MaxDopplerRate));
+                rate = select(moving, shift, one);
+            }
+            _mm_storeu_ps(&m_dopplerRate[i], rate);
+        }
+#endif
+
+        for (; i < count; ++i)
+        {
+            FloatPoint3D d(m_positionX[i] - L.x, m_positionY[i] - L.y, m_positionZ[i] - L.z);
+            bool coincident = d.isZero();
+            float distance = d.length();
+            FloatPoint3D n = d;
+            n.normalize();
+
+            float upProjection = n.dot(U);
+            FloatPoint3D q = n - upProjection * U;
+            q.normalize();
+
+            float azimuth = acosDegrees(q.dot(R));
+            if (q.dot(F) < 0)
+                azimuth = 360 - azimuth;
+            azimuth = azimuth <= 270 ? 90 - azimuth : 450 - azimuth;
+            m_azimuth[i] = coincident ? 0 : azimuth;
+            m_elevation[i] = coincident ? 0 : 90 - acosDegrees(upProjection);
+
+            float refDistance = m_refDistance[i];
+            float maxDistance = m_maxDistance[i];
+            float clamped = std::max(std::min(distance, maxDistance), refDistance);
+            float beyond = m_rolloffFactor[i] * (clamped - refDistance);
+            m_linearGain[i] = 1 - beyond / (maxDistance - refDistance);
+            m_inverseGain[i] = refDistance / (refDistance + beyond);
+            m_distanceRatio[i] = clamped / refDistance;
+
+            float coneGain = 1;
+            if (m_hasCone[i] > 0)
+            {
+                float angle = acosDegrees(-n.dot(FloatPoint3D(m_orientationX[i], m_orientationY[i], m_orientationZ[i])));
+                if (angle <= m_coneInnerAngle[i])
+                    coneGain = 1;
+                else if (angle >= m_coneOuterAngle[i])
+                    coneGain = m_coneOuterGain[i];
+                else
+                {
+                    float x = (angle - m_coneInnerAngle[i]) / (m_coneOuterAngle[i] - m_coneInnerAngle[i]);
+                    coneGain = (1 - x) + m_coneOuterGain[i] * x;
+                }
+            }
+            m_coneGain[i] = coneGain;
+
+            float rate = 1;
+            FloatPoint3D sourceVelocity(m_velocityX[i], m_velocityY[i], m_velocityZ[i]);
+            if (hasDoppler && !coincident && (listenerHasVelocity || !sourceVelocity.isZero()))
+            {
+                float listenerProjection = std::min(-n.dot(V), scaledSpeedOfSound);
+                float sourceProjection = std::min(-n.dot(sourceVelocity), scaledSpeedOfSound);
+                rate = (speedOfSound - dopplerFactor * listenerProjection) / (speedOfSound - dopplerFactor * sourceProjection);
+                if (std::isnan(rate) || std::isinf(rate))
+                    rate = 0;
+                rate = std::min(std::max(rate, MinDopplerRate), MaxDopplerRate);
+            }
+            m_dopplerRate[i] = rate;
+        }
+
+        // pow(distance / refDistance, -rolloffFactor), as a gain in dB scaled by the rolloff factor
+        if (std::find(m_distanceModel.begin(), m_distanceModel.end(), static_cast<unsigned short>(PannerNode::EXPONENTIAL_DISTANCE)) != m_distanceModel.end())
+        {
+            const float minusOne = -1;
+            float* gain = m_exponentialGain.data();
+            VectorMath::vlin2db(m_distanceRatio.data(), gain, count);
+            VectorMath::vmul(gain, 1, m_rolloffFactor.data(), 1, gain, 1, count);
+            VectorMath::vsmul(gain, 1, &minusOne, gain, 1, count);
+            VectorMath::vdb2lin(gain, gain, count);
+        }
+    }
+
+} // end namespace LabSound
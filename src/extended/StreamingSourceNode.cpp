@@ -0,0 +1,422 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#include "LabSound/core/AudioContext.h"
+#include "LabSound/core/AudioNodeOutput.h"
+
+#include "LabSound/extended/StreamingSourceNode.h"
+
+#include "internal/Assertions.h"
+#include "internal/AudioBus.h"
+#include "internal/AudioFileReader.h"
+#include "internal/AudioRingBuffer.h"
+#include "internal/BufferResampler.h"
+#include "internal/WavFileReader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <string.h>
+
+using namespace WebCore;
+
+namespace LabSound {
+
+namespace {
+
+    // The most frames decoded at once by the reader.
+    const size_t ReadBlockFrames = 4096;
+
+    // How long the reader sleeps when the buffer is full.
+    const std::chrono::milliseconds ReaderPollInterval(5);
+
+} // anonymous namespace
+
+// Reads a WAV file from disk, or a file of another format that was decoded in full when opened.
+struct StreamingSourceNode::Decoder
+{
+    Decoder() : busPosition(0) { }
+
+    unsigned numberOfChannels() const { return bus ? bus->numberOfChannels() : file.numberOfChannels(); }
+    float sampleRate() const { return bus ? bus->sampleRate() : file.sampleRate(); }
+    uint64_t length() const { return bus ? bus->length() : file.length(); }
+    uint64_t position() const { return bus ? busPosition : file.position(); }
+
+    bool seek(uint64_t frame)
+    {
+        if (!bus)
+            return file.seek(frame);
+
+        busPosition = std::min(frame, length());
+        return true;
+    }
+
+    // Reads up to framesToRead frames, one destination per channel, and returns the number read.
+    size_t read(float* const* destinations, size_t framesToRead)
+    {
+        unsigned channels = numberOfChannels();
+
+        if (bus) {
+            size_t frames = static_cast<size_t>(std::min(static_cast<uint64_t>(framesToRead), length() - busPosition));
+            for (unsigned c = 0; c < channels; ++c)
+                memcpy(destinations[c], bus->channel(c)->data() + busPosition, sizeof(float) * frames);
+            busPosition += frames;
+            return frames;
+        }
+
+        if (interleaved.size() < framesToRead * channels)
+            interleaved.resize(framesToRead * channels);
+
+        size_t frames = file.read(interleaved.data(), framesToRead);
+        for (unsigned c = 0; c < channels; ++c) {
+            const float* source = interleaved.data() + c;
+            float* destination = destinations[c];
+            for (size_t i = 0; i < frames; ++i, source += channels)
+                destination[i] = *source;
+        }
+        return frames;
+    }
+
+    WavFileReader file;
+    std::unique_ptr<AudioBus> bus;
+    uint64_t busPosition;
+    std::vector<float> interleaved;
+};
+
+StreamingSourceNode::StreamingSourceNode(float sampleRate)
+    : AudioScheduledSourceNode(sampleRate)
+    , m_numberOfChannels(0)
+    , m_fileSampleRate(0)
+    , m_stopReader(false)
+    , m_seekFrame(0)
+    , m_requestedGeneration(0)
+    , m_readerGeneration(0)
+    , m_renderGeneration(0)
+    , m_endOfStream(false)
+    , m_loop(false)
+    , m_loopStart(0)
+    , m_loopEnd(0)
+    , m_rate(1)
+    , m_position(0)
+    , m_scratchFrames(0)
+    , m_priming(true)
+    , m_underruns(0)
+{
+    setNodeType((AudioNode::NodeType) NodeTypeStreamingSource);
+
+    // A call to open() sets the number of output channels to that of the file.
+    addOutput(std::unique_ptr<AudioNodeOutput>(new AudioNodeOutput(this, 1)));
+
+    initialize();
+}
+
+StreamingSourceNode::~StreamingSourceNode()
+{
+    stopReader();
+    uninitialize();
+}
+
+void StreamingSourceNode::stopReader()
+{
+    if (m_reader.joinable()) {
+        m_stopReader = true;
+        m_reader.join();
+    }
+    m_stopReader = false;
+}
+
+bool StreamingSourceNode::open(ContextRenderLock& r, const std::string& path, float bufferSeconds)
+{
+    stopReader();
+    m_decoder.reset();
+    m_ring.reset();
+    m_numberOfChannels = 0;
+
+    std::unique_ptr<Decoder> decoder(new Decoder());
+    if (!decoder->file.open(path)) {
+        try {
+            decoder->bus = MakeBusFromFile(path.c_str(), false, sampleRate());
+        }
+        catch (const std::exception&) {
+        }
+    }
+
+    unsigned numberOfChannels = decoder->numberOfChannels();
+    if (!numberOfChannels || numberOfChannels > AudioContext::maxNumberOfChannels || decoder->sampleRate() <= 0) {
+        LOG_ERROR("Can't open %s for streaming", path.c_str());
+        return false;
+    }
+
+    m_decoder = std::move(decoder);
+    m_numberOfChannels = numberOfChannels;
+    m_fileSampleRate = m_decoder->sampleRate();
+    m_rate = m_fileSampleRate / sampleRate();
+
+    // The buffer must hold at least a few render quanta's worth of the file.
+    size_t quantumFrames = static_cast<size_t>(ceil(AudioNode::ProcessingSizeInFrames * m_rate));
+    size_t capacity = std::max(static_cast<size_t>(bufferSeconds * m_fileSampleRate), 4 * quantumFrames);
+    m_ring.reset(new AudioRingBuffer(numberOfChannels, capacity));
+
+    // Interpolating a quantum needs the frames it spans plus one on either side.
+    m_scratch.assign(numberOfChannels, std::vector<float>(quantumFrames + 4));
+    m_scratchChannels.resize(numberOfChannels);
+    m_scratchFrames = 0;
+    m_position = 0;
+    m_priming = true;
+
+    m_seekFrame = 0;
+    m_requestedGeneration = 0;
+    m_readerGeneration = 0;
+    m_renderGeneration = 0;
+    m_endOfStream = false;
+
+    output(0)->setNumberOfChannels(r, numberOfChannels);
+
+    m_reader = std::thread(&StreamingSourceNode::readerThread, this);
+    return true;
+}
+
+double StreamingSourceNode::duration() const
+{
+    return m_decoder ? m_decoder->length() / static_cast<double>(m_fileSampleRate) : 0;
+}
+
+void StreamingSourceNode::seek(double seconds)
+{
+    m_seekFrame = static_cast<uint64_t>(std::max(seconds, 0.0) * m_fileSampleRate);
+    ++m_requestedGeneration;
+}
+
+void StreamingSourceNode::setLoopPoints(double loopStart, double loopEnd)
+{
+    m_loopStart = static_cast<uint64_t>(std::max(loopStart, 0.0) * m_fileSampleRate);
+    m_loopEnd = static_cast<uint64_t>(std::max(loopEnd, 0.0) * m_fileSampleRate);
+}
+
+void StreamingSourceNode::readerThread()
+{
+    const unsigned channels = m_numberOfChannels;
+    const uint64_t length = m_decoder->length();
+    const size_t headCapacity = m_ring->capacity();
+
+    // Refilling in small pieces would cost more in calls than it saves in latency.
+    const size_t minimumWrite = std::min(ReadBlockFrames, headCapacity / 4);
+
+    std::vector<std::vector<float>> block(channels, std::vector<float>(ReadBlockFrames));
+    std::vector<std::vector<float>> head(channels, std::vector<float>(headCapacity));
+    std::vector<float*> destinations(channels);
+    std::vector<const float*> sources(channels);
+
+    // The start of the loop, decoded ahead of time, and how much of it has been written since the last wrap.
+    bool headValid = false;
+    uint64_t headStart = 0;
+    size_t headLength = 0;
+    size_t headOffset = 0;
+    bool playingHead = false;
+
+    unsigned generation = m_readerGeneration;
+
+    while (!m_stopReader) {
+        unsigned requested = m_requestedGeneration.load(std::memory_order_acquire);
+        if (requested != generation) {
+            generation = requested;
+            playingHead = false;
+            m_endOfStream = false;
+            m_decoder->seek(m_seekFrame);
+            m_readerGeneration.store(generation, std::memory_order_release);
+        }
+
+        // Wait for the render thread to throw away what was buffered before a seek.
+        if (m_renderGeneration.load(std::memory_order_acquire) != generation) {
+            std::this_thread::sleep_for(ReaderPollInterval);
+            continue;
+        }
+
+        bool looping = m_loop;
+        uint64_t loopStart = std::min(m_loopStart.load(), length);
+        uint64_t loopEnd = m_loopEnd.load();
+        if (!loopEnd || loopEnd > length)
+            loopEnd = length;
+        if (loopEnd <= loopStart)
+            looping = false;
+
+        if (looping) {
+            size_t wanted = static_cast<size_t>(std::min(static_cast<uint64_t>(headCapacity), loopEnd - loopStart));
+            if (!headValid || headStart != loopStart || headLength != wanted) {
+                uint64_t resume = m_decoder->position();
+                m_decoder->seek(loopStart);
+
+                headLength = 0;
+                while (headLength < wanted) {
+                    for (unsigned c = 0; c < channels; ++c)
+                        destinations[c] = head[c].data() + headLength;
+                    size_t frames = m_decoder->read(destinations.data(), wanted - headLength);
+                    if (!frames)
+                        break;
+                    headLength += frames;
+                }
+
+                headValid = headLength == wanted;
+                headStart = loopStart;
+                playingHead = false;
+                m_decoder->seek(resume);
+            }
+        }
+
+        size_t space = m_ring->framesAvailableToWrite();
+        if (m_endOfStream || space < minimumWrite) {
+            std::this_thread::sleep_for(ReaderPollInterval);
+            continue;
+        }
+
+        if (playingHead) {
+            size_t frames = std::min(space, headLength - headOffset);
+            for (unsigned c = 0; c < channels; ++c)
+                sources[c] = head[c].data() + headOffset;
+            m_ring->write(sources.data(), frames);
+
+            headOffset += frames;
+            playingHead = headOffset < headLength;
+            continue;
+        }
+
+        uint64_t position = m_decoder->position();
+        uint64_t end = looping ? loopEnd : length;
+
+        size_t frames = 0;
+        if (position < end) {
+            for (unsigned c = 0; c < channels; ++c)
+                destinations[c] = block[c].data();
+            frames = m_decoder->read(destinations.data(), static_cast<size_t>(std::min(static_cast<uint64_t>(std::min(space, ReadBlockFrames)), end - position)));
+        }
+
+        if (!frames) {
+            // At the loop end, continue from the decoded head and have the disk pick up after it.
+            if (looping && headValid) {
+                playingHead = true;
+                headOffset = 0;
+                m_decoder->seek(loopStart + headLength);
+            }
+            else
+                m_endOfStream.store(true, std::memory_order_release);
+            continue;
+        }
+
+        for (unsigned c = 0; c < channels; ++c)
+            sources[c] = block[c].data();
+        m_ring->write(sources.data(), frames);
+    }
+}
+
+size_t StreamingSourceNode::renderFrames(float* const* destinations, size_t framesToProcess)
+{
+    if (m_rate == 1)
+        return m_ring->read(destinations, framesToProcess);
+
+    const size_t scratchCapacity = m_scratch[0].size();
+
+    // Top up the scratch with the frames this block spans; each output frame interpolates towards the frame after its position.
+    size_t needed = std::min(static_cast<size_t>(m_position + (framesToProcess - 1) * m_rate) + 2, scratchCapacity);
+    if (needed > m_scratchFrames) {
+        for (unsigned c = 0; c < m_numberOfChannels; ++c)
+            m_scratchChannels[c] = m_scratch[c].data() + m_scratchFrames;
+        m_scratchFrames += m_ring->read(m_scratchChannels.data(), needed - m_scratchFrames);
+    }
+
+    // If the reader fell behind, render only the frames whose positions fall before the last frame that arrived.
+    size_t frames = 0;
+    if (m_position + 1 < m_scratchFrames)
+        frames = std::min(framesToProcess, static_cast<size_t>(ceil((m_scratchFrames - 1 - m_position) / m_rate)));
+
+    if (frames) {
+        for (unsigned c = 0; c < m_numberOfChannels; ++c)
+            m_scratchChannels[c] = m_scratch[c].data();
+
+        ResamplerSource source = { m_scratchChannels.data(), m_numberOfChannels, m_scratchFrames, false, 0 };
+        BufferResampler::render(InterpolationMode::LINEAR, source, m_position, m_rate, destinations, 0, frames);
+        m_position += frames * m_rate;
+    }
+
+    // Keep the frames from the current position on for the next block. A position beyond them skips frames yet to be read.
+    size_t consumed = std::min(static_cast<size_t>(m_position), m_scratchFrames);
+    if (consumed) {
+        for (unsigned c = 0; c < m_numberOfChannels; ++c)
+            memmove(m_scratch[c].data(), m_scratch[c].data() + consumed, sizeof(float) * (m_scratchFrames - consumed));
+        m_scratchFrames -= consumed;
+        m_position -= consumed;
+    }
+
+    return frames;
+}
+
+void StreamingSourceNode::process(ContextRenderLock& r, size_t framesToProcess)
+{
+    AudioBus* outputBus = output(0)->bus(r);
+    if (!m_ring || !isInitialized() || !r.context() || outputBus->numberOfChannels() != m_numberOfChannels) {
+        outputBus->zero();
+        return;
+    }
+
+    size_t quantumFrameOffset;
+    size_t nonSilentFramesToProcess;
+    updateSchedulingInfo(r, framesToProcess, outputBus, quantumFrameOffset, nonSilentFramesToProcess);
+
+    // After a seek, discard what was buffered from the old position once the reader has stopped adding to it.
+    unsigned requested = m_requestedGeneration.load(std::memory_order_acquire);
+    if (m_renderGeneration.load(std::memory_order_relaxed) != requested) {
+        if (m_readerGeneration.load(std::memory_order_acquire) == requested) {
+            m_ring->discard(m_ring->capacity());
+            m_scratchFrames = 0;
+            m_position = 0;
+            m_priming = true;
+            m_renderGeneration.store(requested, std::memory_order_release);
+        }
+        outputBus->zero();
+        return;
+    }
+
+    // Stay silent until the reader has half filled the buffer, rather than stuttering while it catches up.
+    if (m_priming) {
+        m_priming = m_ring->framesAvailableToRead() < m_ring->capacity() / 2 && !m_endOfStream.load(std::memory_order_acquire);
+        if (m_priming) {
+            outputBus->zero();
+            return;
+        }
+    }
+
+    if (!nonSilentFramesToProcess) {
+        outputBus->zero();
+        return;
+    }
+
+    float* destinations[AudioContext::maxNumberOfChannels];
+    for (unsigned c = 0; c < m_numberOfChannels; ++c)
+        destinations[c] = outputBus->channel(c)->mutableData() + quantumFrameOffset;
+
+    size_t rendered = renderFrames(destinations, nonSilentFramesToProcess);
+
+    if (rendered < nonSilentFramesToProcess) {
+        for (unsigned c = 0; c < m_numberOfChannels; ++c)
+            memset(destinations[c] + rendered, 0, sizeof(float) * (nonSilentFramesToProcess - rendered));
+
+        // The reader sets the flag only after writing the last frame, so an empty buffer then means the end.
+        if (m_endOfStream.load(std::memory_order_acquire) && !m_ring->framesAvailableToRead())
+            finish(r);
+        else
+            ++m_underruns;
+    }
+
+    outputBus->clearSilentFlag();
+}
+
+void StreamingSourceNode::reset(ContextRenderLock&)
+{
+    // The stream keeps its place; seek() moves it.
+}
+
+bool StreamingSourceNode::propagatesSilence(double now) const
+{
+    return !isPlayingOrScheduled() || hasFinished() || !m_ring;
+}
+
+} // namespace LabSound
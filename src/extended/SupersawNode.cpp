@@ -1,12 +1,12 @@
 //  Created by Nick Porcino on 2013 11/17.
 //  reference http://noisehack.com/how-to-build-supersaw-synth-web-audio-api/
 
-#include "LabSound/core/OscillatorNode.h"
 #include "LabSound/core/AudioNodeInput.h"
 #include "LabSound/core/AudioNodeOutput.h"
 #include "LabSound/core/Synthesis.h"
 
 #include "LabSound/extended/SupersawNode.h"
+#include "LabSound/extended/OscillatorBankNode.h"
 #include "LabSound/extended/ADSRNode.h"
 #include "LabSound/extended/AudioContextLock.h"
 
@@ -42,59 +42,49 @@ namespace LabSound
 
         void update(ContextRenderLock& r)
 		{
+            if (!saws)
+                return;
+
             if (cachedFrequency != frequency->value(r))
 			{
                 cachedFrequency = frequency->value(r);
-                for (auto i : saws)
-				{
-                    i->frequency()->setValue(cachedFrequency);
-                    i->frequency()->resetSmoothedValue();
-                }
+                saws->frequency()->setValue(cachedFrequency);
+                saws->frequency()->resetSmoothedValue();
             }
             
             if (cachedDetune != detune->value(r))
 			{
                 cachedDetune = detune->value(r);
-                float n = cachedDetune / ((float) saws.size() - 1.0f);
-                for (size_t i = 0; i < saws.size(); ++i) 
+                unsigned count = saws->numberOfVoices();
+                float n = count > 1 ? cachedDetune / ((float) count - 1.0f) : 0;
+                for (unsigned i = 0; i < count; ++i) 
 				{
-                    saws[i]->detune()->setValue(-cachedDetune + float(i) * 2 * n);
+                    saws->setVoiceDetune(r, i, -cachedDetune + float(i) * 2 * n);
                 }
             }
         }
         
         void update(ContextRenderLock& r, bool okayToReallocate) 
 		{
-            int currentN = saws.size();
-            int n = int(sawCount->value(r) + 0.5f);
+            unsigned n = unsigned(sawCount->value(r) + 0.5f);
 
-            if (okayToReallocate && (n != currentN)) 
+            if (okayToReallocate)
 			{
-                for (auto i : sawStorage) 
-				{
-                    r.context()->disconnect(i);
+                // All of the saws are voices of one bank, so changing their number doesn't touch the graph.
+                if (!saws)
+                {
+                    saws = std::make_shared<OscillatorBankNode>(r, sampleRate);
+                    saws->setType(r, OscillatorType::SAWTOOTH);
+                    r.context()->connect(saws, gainNode);
+                    saws->start(0);
                 }
 
-                sawStorage.clear();
-                saws.clear();
-
-                for (int i = 0; i < n; ++i)
-                    sawStorage.emplace_back(std::make_shared<OscillatorNode>(r, sampleRate));
-
-                for (int i = 0; i < n; ++i)
-                    saws.push_back(sawStorage[i].get());
-
-                
-                auto c = r.context();
-                for (auto i : sawStorage) 
-				{
-                    i->setType(r, OscillatorType::SAWTOOTH);
-                    c->connect(i, gainNode);
-                    i->start(0);
+                if (n != saws->numberOfVoices())
+                {
+                    saws->setNumberOfVoices(r, n);
+                    cachedFrequency = FLT_MAX;
+                    cachedDetune = FLT_MAX;
                 }
-
-                cachedFrequency = FLT_MAX;
-                cachedDetune = FLT_MAX;
             }
             
             update(r);
@@ -111,8 +101,7 @@ namespace LabSound
         float cachedDetune;
         float cachedFrequency;
 
-        std::vector<std::shared_ptr<OscillatorNode>> sawStorage;
-        std::vector<OscillatorNode * > saws;
+        std::shared_ptr<OscillatorBankNode> saws;
     };
 
 	//////////////////////////
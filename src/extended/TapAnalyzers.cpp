@@ -0,0 +1,413 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#include "LabSound/extended/TapAnalyzers.h"
+
+#include "internal/Assertions.h"
+#include "internal/MixingMatrix.h"
+#include "internal/SpectralAnalysis.h"
+
+#include <WTF/MathExtras.h>
+
+#include <algorithm>
+#include <math.h>
+
+namespace LabSound {
+
+namespace {
+
+    // The most frames taken from a tap at once by update().
+    const size_t ReadBlockFrames = 1024;
+
+    // Loudness is histogrammed in 0.1 LU bins from the absolute gate upwards.
+    const double AbsoluteGate = -70.0;
+    const double HistogramTop = 10.0;
+    const double HistogramResolution = 0.1;
+    const size_t HistogramBins = static_cast<size_t>((HistogramTop - AbsoluteGate) / HistogramResolution);
+
+    const size_t MomentarySubBlocks = 4;    // 400ms
+    const size_t ShortTermSubBlocks = 30;   // 3s
+
+    double loudness(double energy)
+    {
+        return energy > 0 ? -0.691 + 10 * log10(energy) : -HUGE_VAL;
+    }
+
+    float channelWeight(unsigned channel, unsigned numberOfChannels)
+    {
+        if (numberOfChannels != 6)
+            return 1;
+        if (channel == 3)
+            return 0;                   // LFE
+        return channel >= 4 ? 1.41f : 1;  // surrounds
+    }
+
+} // namespace
+
+//
+// TapAnalyzer
+//
+
+TapAnalyzer::TapAnalyzer()
+{
+}
+
+TapAnalyzer::~TapAnalyzer()
+{
+}
+
+void TapAnalyzer::update(AudioTap& tap)
+{
+    unsigned numberOfChannels = tap.numberOfChannels();
+    if (m_readBuffers.size() != numberOfChannels)
+        m_readBuffers.assign(numberOfChannels, std::vector<float>(ReadBlockFrames));
+
+    float* destinations[WebCore::MaxBusChannels];
+    for (unsigned c = 0; c < numberOfChannels; ++c)
+        destinations[c] = m_readBuffers[c].data();
+
+    while (size_t frames = tap.read(destinations, ReadBlockFrames))
+        analyze(destinations, numberOfChannels, frames);
+}
+
+//
+// LevelMeter
+//
+
+LevelMeter::LevelMeter(size_t windowSize)
+    : m_windowSize(std::max(windowSize, static_cast<size_t>(1)))
+    , m_framesSeen(0)
+    , m_writeIndex(0)
+{
+}
+
+void LevelMeter::setWindowSize(size_t windowSize)
+{
+    m_windowSize = std::max(windowSize, static_cast<size_t>(1));
+    reset();
+}
+
+void LevelMeter::reset()
+{
+    m_history.clear();
+    m_framesSeen = 0;
+    m_writeIndex = 0;
+}
+
+void LevelMeter::analyze(const float* const* channels, unsigned numberOfChannels, size_t framesToProcess)
+{
+    if (m_history.size() != numberOfChannels) {
+        m_history.assign(numberOfChannels, std::vector<float>(m_windowSize));
+        m_framesSeen = 0;
+        m_writeIndex = 0;
+    }
+
+    // Only the last window's worth of frames matters.
+    if (framesToProcess > m_windowSize) {
+        for (unsigned c = 0; c < numberOfChannels; ++c)
+            std::copy(channels[c] + framesToProcess - m_windowSize, channels[c] + framesToProcess, m_history[c].begin());
+        m_writeIndex = 0;
+    } else {
+        size_t firstPart = std::min(framesToProcess, m_windowSize - m_writeIndex);
+        for (unsigned c = 0; c < numberOfChannels; ++c) {
+            std::copy(channels[c], channels[c] + firstPart, m_history[c].begin() + m_writeIndex);
+            std::copy(channels[c] + firstPart, channels[c] + framesToProcess, m_history[c].begin());
+        }
+        m_writeIndex = (m_writeIndex + framesToProcess) % m_windowSize;
+    }
+
+    m_framesSeen = std::min(m_framesSeen + framesToProcess, m_windowSize);
+}
+
+float LevelMeter::rms(unsigned channel) const
+{
+    if (channel >= m_history.size() || !m_framesSeen)
+        return 0;
+
+    // The frames not yet written are zero, so they can be summed along with the rest.
+    double sum = 0;
+    for (float x : m_history[channel])
+        sum += x * x;
+    return static_cast<float>(sqrt(sum / m_framesSeen));
+}
+
+float LevelMeter::peak(unsigned channel) const
+{
+    if (channel >= m_history.size())
+        return 0;
+
+    float peak = 0;
+    for (float x : m_history[channel])
+        peak = std::max(peak, fabsf(x));
+    return peak;
+}
+
+float LevelMeter::rms() const
+{
+    if (m_history.empty())
+        return 0;
+
+    double sum = 0;
+    for (unsigned c = 0; c < m_history.size(); ++c) {
+        float r = rms(c);
+        sum += r * r;
+    }
+    return static_cast<float>(sqrt(sum / m_history.size()));
+}
+
+float LevelMeter::peak() const
+{
+    float result = 0;
+    for (unsigned c = 0; c < m_history.size(); ++c)
+        result = std::max(result, peak(c));
+    return result;
+}
+
+float LevelMeter::rmsDecibels() const
+{
+    float level = rms();
+    return level > 0.00001f ? 20 * log10f(level) : -100;
+}
+
+//
+// LoudnessMeter
+//
+
+// The two stage K weighting filter of BS.1770, a high shelf modelling the head followed by a high pass,
+// with the coefficients derived for the sample rate in use.
+struct LoudnessMeter::KWeighting
+{
+    double b[2][3];
+    double a[2][3];
+    double s[2][2];
+
+    explicit KWeighting(double sampleRate)
+    {
+        double f0 = 1681.974450955533;
+        double gain = 3.999843853973347;
+        double q = 0.7071752369554196;
+
+        double k = tan(piDouble * f0 / sampleRate);
+        double vh = pow(10.0, gain / 20);
+        double vb = pow(vh, 0.4996667741545416);
+        double a0 = 1 + k / q + k * k;
+
+        b[0][0] = (vh + vb * k / q + k * k) / a0;
+        b[0][1] = 2 * (k * k - vh) / a0;
+        b[0][2] = (vh - vb * k / q + k * k) / a0;
+        a[0][1] = 2 * (k * k - 1) / a0;
+        a[0][2] = (1 - k / q + k * k) / a0;
+
+        f0 = 38.13547087602444;
+        q = 0.5003270373238773;
+        k = tan(piDouble * f0 / sampleRate);
+        a0 = 1 + k / q + k * k;
+
+        b[1][0] = 1;
+        b[1][1] = -2;
+        b[1][2] = 1;
+        a[1][1] = 2 * (k * k - 1) / a0;
+        a[1][2] = (1 - k / q + k * k) / a0;
+
+        reset();
+    }
+
+    void reset()
+    {
+        s[0][0] = s[0][1] = s[1][0] = s[1][1] = 0;
+    }
+
+    // Returns the sum of the squares of the filtered frames.
+    double process(const float* source, size_t framesToProcess)
+    {
+        double sum = 0;
+        for (size_t i = 0; i < framesToProcess; ++i) {
+            double x = source[i];
+            for (int stage = 0; stage < 2; ++stage) {
+                double y = b[stage][0] * x + s[stage][0];
+                s[stage][0] = b[stage][1] * x - a[stage][1] * y + s[stage][1];
+                s[stage][1] = b[stage][2] * x - a[stage][2] * y;
+                x = y;
+            }
+            sum += x * x;
+        }
+        return sum;
+    }
+};
+
+LoudnessMeter::LoudnessMeter(float sampleRate)
+    : m_sampleRate(sampleRate)
+    , m_subBlockFrames(std::max(static_cast<size_t>(sampleRate / 10), static_cast<size_t>(1)))
+    , m_subBlocks(ShortTermSubBlocks)
+    , m_histogramCounts(HistogramBins)
+    , m_histogramEnergies(HistogramBins)
+{
+    reset();
+}
+
+LoudnessMeter::~LoudnessMeter()
+{
+}
+
+void LoudnessMeter::reset()
+{
+    for (auto& filter : m_filters)
+        filter->reset();
+
+    m_subBlockPosition = 0;
+    m_subBlockEnergy = 0;
+    m_subBlockCount = 0;
+    std::fill(m_subBlocks.begin(), m_subBlocks.end(), 0);
+    std::fill(m_histogramCounts.begin(), m_histogramCounts.end(), 0);
+    std::fill(m_histogramEnergies.begin(), m_histogramEnergies.end(), 0);
+}
+
+void LoudnessMeter::analyze(const float* const* channels, unsigned numberOfChannels, size_t framesToProcess)
+{
+    if (m_filters.size() != numberOfChannels) {
+        m_filters.clear();
+        for (unsigned c = 0; c < numberOfChannels; ++c)
+            m_filters.emplace_back(new KWeighting(m_sampleRate));
+        reset();
+    }
+
+    size_t done = 0;
+    while (done < framesToProcess) {
+        size_t frames = std::min(framesToProcess - done, m_subBlockFrames - m_subBlockPosition);
+
+        for (unsigned c = 0; c < numberOfChannels; ++c) {
+            double sum = m_filters[c]->process(channels[c] + done, frames);
+            m_subBlockEnergy += channelWeight(c, numberOfChannels) * sum;
+        }
+
+        done += frames;
+        m_subBlockPosition += frames;
+        if (m_subBlockPosition < m_subBlockFrames)
+            continue;
+
+        // A sub block is complete. Gating blocks are 400ms long and start every 100ms.
+        m_subBlocks[m_subBlockCount % ShortTermSubBlocks] = m_subBlockEnergy / m_subBlockFrames;
+        ++m_subBlockCount;
+        m_subBlockPosition = 0;
+        m_subBlockEnergy = 0;
+
+        if (m_subBlockCount >= MomentarySubBlocks) {
+            double blockEnergy = 0;
+            for (size_t i = 1; i <= MomentarySubBlocks; ++i)
+                blockEnergy += m_subBlocks[(m_subBlockCount - i) % ShortTermSubBlocks];
+            blockEnergy /= MomentarySubBlocks;
+
+            double blockLoudness = loudness(blockEnergy);
+            if (blockLoudness > AbsoluteGate) {
+                size_t bin = std::min(static_cast<size_t>((blockLoudness - AbsoluteGate) / HistogramResolution), HistogramBins - 1);
+                ++m_histogramCounts[bin];
+                m_histogramEnergies[bin] += blockEnergy;
+            }
+        }
+    }
+}
+
+float LoudnessMeter::momentaryLoudness() const
+{
+    if (m_subBlockCount < MomentarySubBlocks)
+        return static_cast<float>(-HUGE_VAL);
+
+    double sum = 0;
+    for (size_t i = 1; i <= MomentarySubBlocks; ++i)
+        sum += m_subBlocks[(m_subBlockCount - i) % ShortTermSubBlocks];
+    return static_cast<float>(loudness(sum / MomentarySubBlocks));
+}
+
+float LoudnessMeter::shortTermLoudness() const
+{
+    size_t count = std::min(m_subBlockCount, ShortTermSubBlocks);
+    if (count < MomentarySubBlocks)
+        return static_cast<float>(-HUGE_VAL);
+
+    double sum = 0;
+    for (size_t i = 1; i <= count; ++i)
+        sum += m_subBlocks[(m_subBlockCount - i) % ShortTermSubBlocks];
+    return static_cast<float>(loudness(sum / count));
+}
+
+float LoudnessMeter::integratedLoudness() const
+{
+    uint64_t count = 0;
+    double sum = 0;
+    for (size_t i = 0; i < HistogramBins; ++i) {
+        count += m_histogramCounts[i];
+        sum += m_histogramEnergies[i];
+    }
+    if (!count)
+        return static_cast<float>(-HUGE_VAL);
+
+    // The relative gate is 10 LU below the level of the blocks above the absolute gate.
+    double relativeGate = loudness(sum / count) - 10;
+    size_t firstBin = relativeGate > AbsoluteGate ? static_cast<size_t>((relativeGate - AbsoluteGate) / HistogramResolution) : 0;
+
+    count = 0;
+    sum = 0;
+    for (size_t i = firstBin; i < HistogramBins; ++i) {
+        count += m_histogramCounts[i];
+        sum += m_histogramEnergies[i];
+    }
+
+    // The bin holding the gate straddles it; its blocks below the gate can't be told apart, so they count.
+    return count ? static_cast<float>(loudness(sum / count)) : static_cast<float>(-HUGE_VAL);
+}
+
+//
+// SpectrumAnalyzer
+//
+
+SpectrumAnalyzer::SpectrumAnalyzer(size_t windowSize)
+{
+    setWindowSize(windowSize);
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+}
+
+void SpectrumAnalyzer::setWindowSize(size_t windowSize)
+{
+    size_t size = 2;
+    while (size < windowSize)
+        size <<= 1;
+
+    m_windowSize = size;
+    m_history.assign(size, 0);
+    m_writeIndex = 0;
+    m_analysis.reset(new WebCore::SpectralAnalysis(static_cast<uint32_t>(size)));
+}
+
+void SpectrumAnalyzer::reset()
+{
+    std::fill(m_history.begin(), m_history.end(), 0.0f);
+    m_writeIndex = 0;
+}
+
+void SpectrumAnalyzer::analyze(const float* const* channels, unsigned numberOfChannels, size_t framesToProcess)
+{
+    if (!numberOfChannels)
+        return;
+
+    const float scale = 1.0f / numberOfChannels;
+    size_t first = framesToProcess > m_windowSize ? framesToProcess - m_windowSize : 0;
+
+    for (size_t i = first; i < framesToProcess; ++i) {
+        float sum = 0;
+        for (unsigned c = 0; c < numberOfChannels; ++c)
+            sum += channels[c][i];
+        m_history[m_writeIndex] = sum * scale;
+        m_writeIndex = (m_writeIndex + 1) & (m_windowSize - 1);
+    }
+}
+
+void SpectrumAnalyzer::magnitudes(std::vector<float>& result)
+{
+    result.resize(m_windowSize / 2);
+    m_analysis->analyze(m_history.data(), m_windowSize, m_writeIndex, 1.0f, 0.0f, result.data());
+}
+
+} // namespace LabSound
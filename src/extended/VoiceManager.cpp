@@ -0,0 +1,108 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#include "LabSound/extended/AudioContextLock.h"
+#include "LabSound/extended/VoiceManager.h"
+
+#include <algorithm>
+
+using namespace WebCore;
+
+namespace LabSound
+{
+    namespace
+    {
+        // How much louder a real voice ranks than it is, about 2dB.
+        const float RealVoiceBias = 1.25f;
+    }
+
+    VoiceManager::VoiceManager(unsigned budget) : m_budget(budget), m_threshold(0.001f), m_realVoices(0)
+    {
+    }
+
+    VoiceManager::~VoiceManager()
+    {
+    }
+
+    std::vector<VoiceManager::Voice>::iterator VoiceManager::find(const std::shared_ptr<PannerNode>& panner)
+    {
+        return std::find_if(m_voices.begin(), m_voices.end(), [&](const Voice& v) { return v.panner == panner; });
+    }
+
+    void VoiceManager::addVoice(std::shared_ptr<PannerNode> panner, float sourceGain)
+    {
+        if (!panner)
+            return;
+
+        auto it = find(panner);
+        if (it != m_voices.end())
+        {
+            it->sourceGain = sourceGain;
+            return;
+        }
+
+        Voice voice = { panner, sourceGain, 0 };
+        m_voices.push_back(voice);
+        m_order.push_back(m_order.size());
+    }
+
+    void VoiceManager::removeVoice(std::shared_ptr<PannerNode> panner)
+    {
+        auto it = find(panner);
+        if (it == m_voices.end())
+            return;
+
+        if (!it->panner->isVirtualized() && m_realVoices)
+            --m_realVoices;
+        it->panner->setVirtualized(false);
+
+        *it = m_voices.back();
+        m_voices.pop_back();
+        m_order.pop_back();
+    }
+
+    void VoiceManager::setSourceGain(std::shared_ptr<PannerNode> panner, float sourceGain)
+    {
+        auto it = find(panner);
+        if (it != m_voices.end())
+            it->sourceGain = sourceGain;
+    }
+
+    void VoiceManager::update(ContextRenderLock& r)
+    {
+        if (!r.context())
+            return;
+
+        size_t count = m_voices.size();
+        for (size_t i = 0; i < count; ++i)
+        {
+            Voice& voice = m_voices[i];
+            float audibility = voice.panner->attenuation(r) * voice.sourceGain;
+
+            // Voices below the threshold sort below every voice above it.
+            voice.priority = audibility < m_threshold ? -1.0f : (voice.panner->isVirtualized() ? audibility : audibility * RealVoiceBias);
+            m_order[i] = i;
+        }
+
+        // Only the boundary of the budget matters, not the order within or beyond it.
+        size_t budget = std::min(static_cast<size_t>(m_budget), count);
+        if (budget < count)
+        {
+            std::nth_element(m_order.begin(), m_order.begin() + budget, m_order.end(), [this](size_t a, size_t b)
+            {
+                return m_voices[a].priority > m_voices[b].priority;
+            });
+        }
+
+        m_realVoices = 0;
+        for (size_t k = 0; k < count; ++k)
+        {
+            Voice& voice = m_voices[m_order[k]];
+            bool real = k < budget && voice.priority >= 0;
+            voice.panner->setVirtualized(!real);
+            if (real)
+                ++m_realVoices;
+        }
+    }
+
+} // end namespace LabSound
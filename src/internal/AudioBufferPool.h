@@ -0,0 +1,101 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifndef AudioBufferPool_h
+#define AudioBufferPool_h
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+
+namespace WebCore {
+
+// AudioBufferPool is a context-owned arena of render quantum sized channel blocks.
+// Blocks are carved out of large cache-line aligned slabs, so the buses used while rendering
+// are packed together in memory instead of being scattered across the heap.
+//
+// Released blocks are handed out again last-in first-out. Since the graph is rendered depth first,
+// a bus that is only live while its node processes (an input's summing bus for instance) is
+// reused by the next node that needs one, in the same way a register allocator reuses registers.
+// A large graph therefore touches as many hot summing blocks as its graph depth, not its node count.
+//
+// The free list is a lock-free stack, so the render thread acquires and releases blocks without
+// locking or allocating. Slabs are added only by replenish(), which the context calls from the graph
+// update, off the render thread, to keep as many blocks free as are in use. If the render thread
+// empties the pool before then, acquire() returns null and the bus allocates its own memory on the
+// render thread instead; those misses are counted, and replenish() logs them and grows the pool by
+// as many blocks so that they don't recur.
+class AudioBufferPool
+{
+    AudioBufferPool(const AudioBufferPool&); // noncopyable
+
+public:
+
+    explicit AudioBufferPool(size_t framesPerBlock);
+    ~AudioBufferPool();
+
+    // Returns an aligned block of framesPerBlock() floats. The contents are undefined. Returns null,
+    // and notes the shortfall for the next replenish(), if no block is free.
+    float* acquire();
+
+    // Returns a block previously obtained from acquire().
+    void release(float* block);
+
+    // A block of zeroes that is never handed out by acquire(). Buses that have released their
+    // blocks point here so that stray reads see silence rather than freed memory.
+    float* silentBlock() { return m_silentBlock; }
+
+    size_t framesPerBlock() const { return m_framesPerBlock; }
+
+    // Adds slabs until at least as many blocks are free as are in use, plus any acquire() went without.
+    // Allocates, so it must not be called on the render thread.
+    void replenish();
+
+    // Number of blocks carved from slabs so far, and how many of those are currently acquired.
+    size_t blockCount() const { return m_blockCount; }
+    size_t blocksInUse() const { return m_blocksInUse; }
+
+    // Number of times acquire() has found the pool empty, each of which cost a heap allocation on the
+    // render thread.
+    size_t missCount() const { return m_missCount; }
+
+private:
+
+    struct Slab
+    {
+        float* blocks;
+        uint32_t firstIndex;
+        uint32_t blockCount;
+    };
+
+    void addSlab(size_t blockCount);
+
+    // The free list links blocks by index. Its head packs the index of the top block into the low
+    // 32 bits and a count of changes into the high 32, so that a pop racing with a pop and push of
+    // the same block fails its compare-exchange rather than linking in a stale next.
+    uint32_t indexOf(const float* block) const;
+    void push(uint32_t index);
+    bool pop(uint32_t& index);
+
+    size_t m_framesPerBlock;
+    size_t m_blockStride; // in floats, rounded up to a whole number of cache lines
+
+    std::unique_ptr<Slab[]> m_slabs;            // written under m_slabMutex, published by m_slabCount
+    std::atomic<size_t> m_slabCount;
+    std::unique_ptr<float*[]> m_blocks;         // by index
+    std::unique_ptr<std::atomic<uint32_t>[]> m_next;
+    std::atomic<uint64_t> m_freeHead;
+
+    std::atomic<size_t> m_blockCount;
+    std::atomic<size_t> m_blocksInUse;
+    std::atomic<size_t> m_shortfall;           // misses since the last replenish()
+    std::atomic<size_t> m_missCount;
+    float* m_silentBlock;
+
+    std::mutex m_slabMutex;
+};
+
+} // namespace WebCore
+
+#endif // AudioBufferPool_h
@@ -32,10 +32,13 @@
 #include "internal/ConfigMacros.h"
 #include "LabSound/core/Mixing.h"
 #include "internal/AudioChannel.h"
+#include "internal/MixingMatrix.h"
 #include <vector>
 
 namespace WebCore {
 
+    class AudioBufferPool;
+
     using LabSound::ChannelInterpretation;
     using LabSound::Channel;
     
@@ -59,9 +62,23 @@ public:
     // If allocate is false then setChannelMemory() has to be called later on for each channel before the AudioBus is useable...
     AudioBus(unsigned numberOfChannels, size_t length, bool allocate = true);
 
+    // Creates a render quantum sized bus whose channels live in blocks from the given pool.
+    AudioBus(unsigned numberOfChannels, std::shared_ptr<AudioBufferPool> pool);
+
+    ~AudioBus();
+
     // Tells the given channel to use an externally allocated buffer.
     void setChannelMemory(unsigned channelIndex, float* storage, size_t length);
 
+    // Points every channel at a block acquired from the pool; the blocks are handed back by releasePooledMemory() or on destruction.
+    // The bus must have been created without allocating, or be a pooled bus, and its length must fit in the pool's blocks.
+    void acquirePooledMemory(std::shared_ptr<AudioBufferPool> pool);
+
+    // Returns pooled blocks to the pool. The channels are left pointing at the pool's silent block.
+    void releasePooledMemory();
+
+    bool isPooled() const { return m_pooledMemoryAcquired; }
+
     // Channels
     unsigned numberOfChannels() const { return (unsigned) m_channels.size(); }
 
@@ -125,6 +142,10 @@ public:
     // Our own internal gain m_busGain is ignored.
     void sumFrom(const AudioBus &sourceBus, ChannelInterpretation = ChannelInterpretation::Speakers);
 
+    // Mixes sourceBus through the matrix into our bus, replacing our contents or summing into them.
+    // The matrix must have been made for our channel counts; source channels flagged silent are skipped.
+    void mixFrom(const AudioBus& sourceBus, const MixingMatrix& matrix, bool sum);
+
     // Copy each channel from sourceBus into our corresponding channel.
     // We scale by targetGain (and our own internal gain m_busGain), performing "de-zippering" to smoothly change from *lastMixGain to (targetGain*m_busGain).
     // The caller is responsible for setting up lastMixGain to point to storage which is unique for every "stream" which will be applied to this bus.
@@ -144,12 +165,6 @@ protected:
 
     AudioBus() {};
 
-    void speakersCopyFrom(const AudioBus&);
-    void discreteCopyFrom(const AudioBus&);
-    void speakersSumFrom(const AudioBus&);
-    void discreteSumFrom(const AudioBus&);
-    void speakersSumFrom5_1_ToMono(const AudioBus&);
-
     size_t m_length;
 
     std::vector<std::unique_ptr<AudioChannel> > m_channels;
@@ -163,6 +178,9 @@ protected:
     bool m_isFirstTime;
     float m_sampleRate; // 0.0 if unknown or N/A
 
+    std::shared_ptr<AudioBufferPool> m_pool;
+    bool m_pooledMemoryAcquired = false;
+
 };
 
 } // WebCore
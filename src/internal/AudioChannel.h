@@ -77,6 +77,18 @@ public:
         m_silent = false;
     }
 
+    // Redefine the memory for this channel as zeroed storage managed for us.
+    void allocate(size_t length)
+    {
+        m_memBuffer.reset(new AudioFloatArray(length));
+        m_rawPointer = 0;
+        m_length = length;
+        m_silent = true;
+    }
+
+    // Whether the memory is managed for us rather than external.
+    bool ownsStorage() const { return !m_rawPointer; }
+
     // How many sample-frames do we contain?
     size_t length() const { return m_length; }
 
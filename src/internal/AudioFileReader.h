@@ -2,14 +2,41 @@
 #define AudioFileReader_H
 
 #include <memory>
+#include <string>
 #include <vector>
 #include <stdint.h>
 
+namespace nqr
+{
+    class NyquistIO;
+}
+
 namespace WebCore
 {
 
 class AudioBus;
 
+// Decodes files with a decoder of its own, so any number of readers, one per thread, can decode at once.
+// Throws std::runtime_error if a file can't be decoded.
+class AudioFileReader
+{
+    AudioFileReader(const AudioFileReader&); // noncopyable
+
+public:
+
+    AudioFileReader();
+    ~AudioFileReader();
+
+    // The bus is converted to sampleRate, unless sampleRate is zero, in which case it keeps the file's rate.
+    std::unique_ptr<AudioBus> loadFile(const char * filePath, bool mixToMono, float sampleRate);
+    std::unique_ptr<AudioBus> loadMemory(const std::vector<uint8_t> & buffer, const std::string & extension, bool mixToMono, float sampleRate);
+
+private:
+
+    std::unique_ptr<nqr::NyquistIO> m_io;
+};
+
+// Each call decodes with a reader of its own; calls on different threads don't wait for one another.
 std::unique_ptr<AudioBus> MakeBusFromFile(const char * filePath, bool mixToMono, float sampleRate);
 std::unique_ptr<AudioBus> MakeBusFromMemory(const std::vector<uint8_t> & buffer, std::string extension, bool mixToMono, float sampleRate);
 
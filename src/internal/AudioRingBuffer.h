@@ -0,0 +1,58 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifndef AudioRingBuffer_h
+#define AudioRingBuffer_h
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace WebCore {
+
+// AudioRingBuffer passes multichannel audio from one thread to another without locks or allocation,
+// for instance from the render thread to a thread that writes to disk. All of the memory is allocated
+// by the constructor. Exactly one thread may write and exactly one thread may read at a time.
+//
+// The positions are counts of frames written and read since construction, so the frames available are
+// their difference, and neither side ever has to distinguish a full buffer from an empty one.
+class AudioRingBuffer
+{
+    AudioRingBuffer(const AudioRingBuffer&); // noncopyable
+
+public:
+
+    // The capacity is rounded up to a power of two.
+    AudioRingBuffer(unsigned numberOfChannels, size_t capacityInFrames);
+
+    unsigned numberOfChannels() const { return static_cast<unsigned>(m_channels.size()); }
+    size_t capacity() const { return m_mask + 1; }
+
+    // Snapshots; the other side may have moved on by the time they return.
+    size_t framesAvailableToRead() const;
+    size_t framesAvailableToWrite() const;
+
+    // Writes up to framesToWrite frames from one source per channel and returns the number written.
+    size_t write(const float* const* sources, size_t framesToWrite);
+
+    // Reads up to framesToRead frames, either into one destination per channel or interleaved
+    // into a single destination, and returns the number read.
+    size_t read(float* const* destinations, size_t framesToRead);
+    size_t readInterleaved(float* destination, size_t framesToRead);
+
+    // Reader side. Skips up to framesToDiscard frames without copying them and returns the number skipped.
+    size_t discard(size_t framesToDiscard);
+
+private:
+
+    std::vector<std::vector<float>> m_channels;
+    size_t m_mask;
+
+    std::atomic<uint64_t> m_writePosition;
+    std::atomic<uint64_t> m_readPosition;
+};
+
+} // namespace WebCore
+
+#endif // AudioRingBuffer_h
@@ -46,11 +46,28 @@ class Biquad
 {
 public:   
 
+    // The arithmetic used for the filter state. Double precision keeps low, sharply resonant
+    // filters stable; single precision is cheaper and fine for most other settings.
+    enum Precision { DoublePrecision, SinglePrecision };
+
     Biquad();
     virtual ~Biquad();
 
     void process(const float* sourceP, float* destP, size_t framesToProcess);
 
+    // Filters numberOfChannels channels, one Biquad per channel, each with its own coefficients
+    // and state. On SSE2 the channels are run side by side in vector lanes, four at a time in
+    // single precision and two at a time in double precision, so a multichannel filter costs
+    // little more than a mono one. The Biquads in one call must share a precision.
+    static void processChannels(Biquad* const* biquads, const float* const* sourcesP, float* const* destsP, unsigned numberOfChannels, size_t framesToProcess);
+
+    void setPrecision(Precision precision) { m_precision = precision; }
+    Precision precision() const { return m_precision; }
+
+    // Copies the filter coefficients but not the state, so that the channels of a multichannel
+    // filter only need to compute them once.
+    void copyCoefficientsFrom(const Biquad&);
+
     // frequency is 0 - 1 normalized, resonance and dbGain are in decibels.
     // Q is a unitless quality factor.
     void setLowpassParams(double frequency, double resonance);
@@ -92,17 +109,25 @@ private:
     double m_a1;
     double m_a2;
 
+    Precision m_precision;
+
 #if OS(DARWIN)
     void processFast(const float* sourceP, float* destP, size_t framesToProcess);
     void processSliceFast(double* sourceP, double* destP, double* coefficientsP, size_t framesToProcess);
     AudioDoubleArray m_inputBuffer;
     AudioDoubleArray m_outputBuffer;
 #else
-    // Filter memory
-    double m_x1; // input delayed by 1 sample
-    double m_x2; // input delayed by 2 samples
-    double m_y1; // output delayed by 1 sample
-    double m_y2; // output delayed by 2 samples
+    void processSinglePrecision(const float* sourceP, float* destP, size_t framesToProcess);
+
+    // Filter memory of the transposed direct form II structure
+    //
+    // y[n] = m_b0*x[n] + s1
+    // s1 = m_b1*x[n] - m_a1*y[n] + s2
+    // s2 = m_b2*x[n] - m_a2*y[n]
+    //
+    // which needs half the state of direct form I and keeps the additions short enough to pipeline.
+    double m_s1;
+    double m_s2;
 #endif
 
 };
@@ -60,6 +60,13 @@ public:
     virtual double tailTime() const override;
     virtual double latencyTime() const override;
 
+    // Recomputes the filter coefficients if any of the parameters have changed. Every kernel of a
+    // processor uses the same coefficients, so they can instead be copied from a kernel that
+    // has already computed them this quantum.
+    void updateCoefficients(ContextRenderLock& r, const BiquadDSPKernel* updatedKernel);
+
+    Biquad& biquad() { return m_biquad; }
+
 protected:
     Biquad m_biquad;
     BiquadProcessor* biquadProcessor() { return static_cast<BiquadProcessor*>(processor()); }
@@ -0,0 +1,46 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifndef BufferResampler_h
+#define BufferResampler_h
+
+#include "LabSound/core/Synthesis.h"
+
+#include <stddef.h>
+
+namespace WebCore {
+
+using LabSound::InterpolationMode;
+
+// The channels of an in-memory sound, and the rules for reading beyond its ends.
+struct ResamplerSource
+{
+    const float* const* channels;
+    unsigned numberOfChannels;
+    size_t length;
+
+    // While looping, frames past the end are read loopDeltaFrames earlier, so the interpolation
+    // runs smoothly across the loop point. Otherwise the last frame is repeated. Frames before
+    // the start always repeat the first frame.
+    bool loop;
+    double loopDeltaFrames;
+};
+
+// Plays in-memory sounds back at arbitrary rates, a block and all channels at a time.
+namespace BufferResampler {
+
+// Reads framesToProcess frames starting at the fractional frame position and advancing by rate (> 0)
+// frames per output frame, and writes them to every destination channel starting at writeIndex.
+// The positions read must stay within the source; the caller takes care of loop and end points.
+// The positions and interpolation weights are computed once per frame and shared by all channels.
+// Only frames near the ends of the source take the slower path that applies the source's edge rules.
+void render(InterpolationMode, const ResamplerSource&, double position, double rate, float* const* destinations, size_t writeIndex, size_t framesToProcess);
+
+// The sinc tables are built on first use. Calling this from the main thread keeps that off the render thread.
+void prepare(InterpolationMode);
+
+} // namespace BufferResampler
+
+} // namespace WebCore
+
+#endif // BufferResampler_h
@@ -28,6 +28,7 @@
 #include "LabSound/core/AudioArray.h"
 
 #include "internal/AudioDSPKernel.h"
+#include "internal/DelayLine.h"
 #include "internal/DelayProcessor.h"
 
 namespace WebCore {
@@ -51,9 +52,8 @@ public:
     virtual double latencyTime() const override;
 
 private:
-    AudioFloatArray m_buffer;
+    DelayLine m_delayLine;
     double m_maxDelayTime;
-    int m_writeIndex;
     double m_currentDelayTime;
     double m_smoothingRate;
     bool m_firstTime;
@@ -62,7 +62,7 @@ private:
     AudioFloatArray m_delayTimes;
 
     DelayProcessor * delayProcessor() { return static_cast<DelayProcessor*>(processor()); }
-    size_t bufferLengthForDelay(double delayTime, double sampleRate) const;
+    size_t maxDelayFrames(double maxDelayTime, double sampleRate) const;
 };
 
 } // namespace WebCore
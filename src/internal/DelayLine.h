@@ -0,0 +1,82 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifndef DelayLine_h
+#define DelayLine_h
+
+#include "LabSound/core/AudioArray.h"
+#include "LabSound/core/DelayNode.h"
+
+#include <stddef.h>
+
+namespace WebCore {
+
+// The delay engine for a single channel. The history is a power of two long, so it is indexed with a
+// mask, and a block is written into it with at most two copies before the block is read back, so a
+// delay shorter than the block reads the block's own input.
+//
+// A delay that is constant over a block is read with at most two copies when it is a whole number of
+// frames, and otherwise with fixed interpolation weights applied a block at a time. A delay that varies
+// over the block reads each frame at its own fractional position; only the stretch of history the block
+// actually spans is gathered first, so the reads never wrap.
+//
+// Delays are in frames, from 0 to maxDelayFrames; anything outside that range is clamped.
+class DelayLine
+{
+    DelayLine(const DelayLine&); // noncopyable
+
+public:
+
+    DelayLine();
+    DelayLine(size_t maxDelayFrames, size_t maxFramesPerBlock);
+    ~DelayLine();
+
+    // Discards the history.
+    void allocate(size_t maxDelayFrames, size_t maxFramesPerBlock);
+
+    size_t maxDelayFrames() const { return m_maxDelayFrames; }
+    size_t maxFramesPerBlock() const { return m_maxFramesPerBlock; }
+
+    void setInterpolation(DelayInterpolation interpolation) { m_interpolation = interpolation; }
+    DelayInterpolation interpolation() const { return m_interpolation; }
+
+    // Blocks may be any length up to maxFramesPerBlock. source and destination may be the same.
+    void process(const float* source, float* destination, size_t framesToProcess, double delayFrames);
+    void process(const float* source, float* destination, size_t framesToProcess, const float* delayFrames);
+
+    // For several taps on one line, write a block and then read each tap: read() takes frame i from
+    // delayFrames before frame i of the block just written, as process() does. For feedback, readAhead()
+    // reads before the block is written, from delayFrames before each frame of the block to come; the
+    // delay should then be at least framesToProcess, as frames not written yet read as the newest one.
+    // The allpass interpolator is recursive, so each tap read with it keeps its own state.
+    void write(const float* source, size_t framesToProcess);
+    void read(float* destination, size_t framesToProcess, double delayFrames, float& allpassState);
+    void readAhead(float* destination, size_t framesToProcess, double delayFrames, float& allpassState);
+
+    void reset();
+
+private:
+
+    // Positions are relative to the next frame to be written, so the newest frame is at -1. A block
+    // read with an origin of -framesToProcess is the block just written, and with 0, the block to come.
+
+    // Copies the frames from position first to position last, repeating the newest for any beyond it.
+    void gather(ptrdiff_t first, ptrdiff_t last, float* window);
+
+    void readConstant(float* destination, size_t framesToProcess, ptrdiff_t origin, double delayFrames, float& allpassState);
+    void readVarying(float* destination, size_t framesToProcess, ptrdiff_t origin, const float* delayFrames, float& allpassState);
+
+    AudioFloatArray m_buffer;
+    AudioFloatArray m_window;
+    AudioFloatArray m_delays;
+    size_t m_mask;
+    size_t m_writeIndex;            // where the next frame will be written
+    size_t m_maxDelayFrames;
+    size_t m_maxFramesPerBlock;
+    DelayInterpolation m_interpolation;
+    float m_allpassState;           // the previous output of the allpass interpolator, for process()
+};
+
+} // namespace WebCore
+
+#endif // DelayLine_h
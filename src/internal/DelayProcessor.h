@@ -26,9 +26,12 @@
 #define DelayProcessor_h
 
 #include "LabSound/core/AudioParam.h"
+#include "LabSound/core/DelayNode.h"
 
 #include "internal/AudioDSPKernelProcessor.h"
 
+#include <atomic>
+
 namespace WebCore {
 
 class AudioDSPKernel;
@@ -44,9 +47,14 @@ public:
 
     double maxDelayTime() { return m_maxDelayTime; }
 
+    // Read by the kernels as each quantum is processed.
+    void setInterpolation(DelayInterpolation interpolation) { m_interpolation = interpolation; }
+    DelayInterpolation interpolation() const { return m_interpolation; }
+
 private:
     std::shared_ptr<AudioParam> m_delayTime;
     double m_maxDelayTime;
+    std::atomic<DelayInterpolation> m_interpolation;
 };
 
 } // namespace WebCore
@@ -67,7 +67,10 @@ public:
         ParamLast
     };
 
-    DynamicsCompressor(float sampleRate, unsigned numberOfChannels);
+    // The pre-delay, or lookahead, can be set up to maxPreDelayTime seconds.
+    DynamicsCompressor(float sampleRate, unsigned numberOfChannels, float maxPreDelayTime = DefaultMaxPreDelayTime);
+
+    static const float DefaultMaxPreDelayTime;
 
     void process(ContextRenderLock&, const AudioBus* sourceBus, AudioBus* destinationBus, unsigned framesToProcess);
     void reset();
@@ -49,11 +49,12 @@ class DynamicsCompressorKernel
 
 public:
 
-    DynamicsCompressorKernel(float sampleRate, unsigned numberOfChannels);
+    // The pre-delay can be set from 0 to maxPreDelayTime seconds; the lookahead buffers are sized for it.
+    DynamicsCompressorKernel(float sampleRate, unsigned numberOfChannels, float maxPreDelayTime);
 
     void setNumberOfChannels(unsigned);
 
-    // Performs stereo-linked compression.
+    // Performs linked compression: one gain is computed from the loudest channel and applied to every channel.
     void process(ContextRenderLock&,
                  float * sourceChannels[],
                  float * destinationChannels[],
@@ -94,17 +95,35 @@ protected:
     float m_meteringReleaseK;
     float m_meteringGain;
 
-    // Lookahead section.
-    enum { MaxPreDelayFrames = 1024 };
-    enum { MaxPreDelayFramesMask = MaxPreDelayFrames - 1 };
+    // The envelopes are updated once per division, and the detector and gains are computed a division at a time.
+    enum { DivisionFrames = 32 };
+
+    // Lookahead section. Each channel's buffer is a power of two long, with room for the longest pre-delay
+    // and a division.
     enum { DefaultPreDelayFrames = 256 }; // setPreDelayTime() will override this initial value
+    unsigned m_maxPreDelayFrames;
     unsigned m_lastPreDelayFrames;
     void setPreDelayTime(float);
 
     std::vector< std::unique_ptr<AudioFloatArray> > m_preDelayBuffers;
-
-    int m_preDelayReadIndex;
-    int m_preDelayWriteIndex;
+    size_t m_preDelayBufferMask;
+    size_t m_preDelayWriteIndex;
+
+    // Writes a division of undelayed input, and reads back the division delayed by the pre-delay.
+    void writePreDelay(unsigned channel, const float* source, size_t framesToProcess);
+    void readPreDelay(unsigned channel, float* destination, size_t framesToProcess);
+
+    // Computes the detector's target attenuation and release rate for each frame of a division.
+    void computeAttenuation(const float* detectorInput, size_t framesToProcess, float k, float satReleaseFrames);
+
+    // Division sized working buffers.
+    AudioFloatArray m_detectorInput;
+    AudioFloatArray m_channelMagnitude;
+    AudioFloatArray m_inputDb;
+    AudioFloatArray m_kneeDb;
+    AudioFloatArray m_attenuation;      // the attenuations, then the release rates
+    AudioFloatArray m_gain;
+    AudioFloatArray m_meteringDb;
 
     float m_maxAttackCompressionDiffDb;
 
@@ -44,6 +44,13 @@ public:
     virtual double tailTime() const override { return 0; }
     virtual double latencyTime() const override { return 0; }
 
+    // Applies left and right gains that start at gainL and gainR and advance by gainStepL and gainStepR per
+    // frame. A mono source (sourceR == sourceL) is scaled into both outputs. Of a stereo source, one side
+    // passes through and the other is panned across both outputs: the right side if keepLeft is set,
+    // otherwise the left side. The destination may be the source.
+    static void applyGains(const float* sourceL, const float* sourceR, float* destinationL, float* destinationR, bool keepLeft,
+                           float gainL, float gainStepL, float gainR, float gainStepR, size_t framesToProcess);
+
 private:
 
     // For smoothing / de-zippering
@@ -0,0 +1,70 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifndef HalfBandResampler_h
+#define HalfBandResampler_h
+
+#include "LabSound/core/AudioArray.h"
+
+#include <stddef.h>
+
+namespace WebCore {
+
+// Doubling and halving the sample rate with a windowed sinc half-band filter. Every other tap of a half-band
+// filter is zero, apart from the centre one, so the filter splits into two phases: one that is a plain delay
+// and one FIR of 2 * halfLength taps. Only that one is computed, at the lower of the two rates, so a
+// filter of 4 * halfLength - 1 taps costs 2 * halfLength multiplies per low rate frame.
+//
+// Both directions delay the signal by halfLength frames at the lower rate. Longer filters have steeper
+// transitions; a second stage, which only has to reject what lies an octave above the first one's
+// passband, can be much shorter than the first.
+
+class HalfBandUpSampler
+{
+    HalfBandUpSampler(const HalfBandUpSampler&); // noncopyable
+
+public:
+
+    HalfBandUpSampler(size_t halfLength, size_t maxFramesPerBlock);
+
+    // Writes 2 * framesToProcess frames to destination.
+    void process(const float* source, float* destination, size_t framesToProcess);
+    void reset();
+
+    size_t latencyFrames() const { return m_halfLength; }
+
+private:
+
+    size_t m_halfLength;
+    size_t m_maxFramesPerBlock;
+    AudioFloatArray m_kernel;
+    AudioFloatArray m_input;    // 2 * halfLength - 1 frames of history, then the block
+};
+
+class HalfBandDownSampler
+{
+    HalfBandDownSampler(const HalfBandDownSampler&); // noncopyable
+
+public:
+
+    // maxFramesPerBlock is at the higher rate.
+    HalfBandDownSampler(size_t halfLength, size_t maxFramesPerBlock);
+
+    // Reads an even framesToProcess frames and writes half as many to destination.
+    void process(const float* source, float* destination, size_t framesToProcess);
+    void reset();
+
+    size_t latencyFrames() const { return m_halfLength; }
+
+private:
+
+    size_t m_halfLength;
+    size_t m_maxFramesPerBlock;
+    AudioFloatArray m_kernel;
+    AudioFloatArray m_odd;      // 2 * halfLength frames of history, then the odd frames of the block
+    AudioFloatArray m_even;     // halfLength frames of history, then the even frames of the block
+};
+
+} // namespace WebCore
+
+#endif // HalfBandResampler_h
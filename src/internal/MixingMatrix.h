@@ -0,0 +1,61 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifndef MixingMatrix_h
+#define MixingMatrix_h
+
+#include "LabSound/core/Mixing.h"
+
+namespace WebCore {
+
+using LabSound::ChannelInterpretation;
+
+const unsigned MaxBusChannels = 32;
+
+// A MixingMatrix holds the gains for up or down mixing a bus with one channel count into a bus with another.
+// Only the non-zero gains are stored, grouped by destination channel, so that mixing a block is a single
+// pass over each destination channel that touches just the source channels contributing to it.
+//
+// Speaker layouts follow the Web Audio specification: mono, stereo, quad (L R SL SR) and 5.1 (L R C LFE SL SR).
+// 7.1 (L R C LFE SL SR BL BR) is mixed as 5.1 with the back channels folded into the sides at -3dB.
+// Any other combination, and every combination under discrete interpretation, maps channels by index,
+// dropping or leaving silent the channels one side has and the other lacks.
+class MixingMatrix
+{
+public:
+
+    // The most source channels any single destination channel can draw from.
+    static const unsigned MaxTermsPerChannel = 8;
+
+    struct Term
+    {
+        unsigned source;
+        float gain;
+    };
+
+    MixingMatrix(unsigned numberOfSourceChannels, unsigned numberOfDestinationChannels, ChannelInterpretation);
+
+    // Matrices are immutable, so one instance per layout pair is built on first use and shared from then on.
+    static const MixingMatrix& matrix(unsigned numberOfSourceChannels, unsigned numberOfDestinationChannels, ChannelInterpretation);
+
+    unsigned numberOfSourceChannels() const { return m_numberOfSourceChannels; }
+    unsigned numberOfDestinationChannels() const { return m_numberOfDestinationChannels; }
+
+    // The non-zero terms for a destination channel.
+    unsigned numberOfTerms(unsigned destinationChannel) const { return m_numberOfTerms[destinationChannel]; }
+    const Term* terms(unsigned destinationChannel) const { return m_terms[destinationChannel]; }
+
+private:
+
+    void setGains(const float gains[][MaxBusChannels]);
+
+    unsigned m_numberOfSourceChannels;
+    unsigned m_numberOfDestinationChannels;
+
+    unsigned m_numberOfTerms[MaxBusChannels];
+    Term m_terms[MaxBusChannels][MaxTermsPerChannel];
+};
+
+} // namespace WebCore
+
+#endif // MixingMatrix_h
@@ -56,10 +56,8 @@ private:
     // instead of SincResampler. For now the default implementation will be used on all ports.
     // https://bugs.webkit.org/show_bug.cgi?id=75118
     
-    // Each channel will be resampled using a high-quality SincResampler.
-    std::vector<std::unique_ptr<SincResampler> > m_kernels;
-    
-    unsigned m_numberOfChannels;
+    // The channels are resampled together by a high-quality SincResampler.
+    std::unique_ptr<SincResampler> m_kernel;
 };
 
 } // namespace WebCore
@@ -0,0 +1,59 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifndef PolyphaseResampler_h
+#define PolyphaseResampler_h
+
+#include <memory>
+#include <vector>
+
+namespace WebCore {
+
+class AudioBus;
+
+// PolyphaseResampler converts whole buffers between two sample rates whose ratio is a fraction of
+// integers L / M, such as 160 / 147 from 44.1kHz to 48kHz. Every output frame then lands on one of L
+// sub-sample offsets between input frames, so a windowed sinc() for each offset is computed once, into
+// a filter bank, and each output frame is a single dot product with no interpolation between kernels.
+//
+// The filter banks are shared by every conversion between the same pair of rates. Conversions are for
+// load time, when a file is brought to the rate of the context once so that playback doesn't resample;
+// long buffers are split across threads.
+class PolyphaseResampler {
+    PolyphaseResampler(const PolyphaseResampler&); // noncopyable
+
+public:
+    // Returns the resampler for a pair of rates, building its filter bank the first time it's asked for.
+    // Returns null if the rates aren't whole numbers of Hz or their ratio needs too many phases.
+    static std::shared_ptr<PolyphaseResampler> forRates(unsigned sourceSampleRate, unsigned destinationSampleRate);
+
+    // Converts every channel of sourceBus to the destination rate.
+    static std::unique_ptr<AudioBus> createBySampleRateConverting(const AudioBus* sourceBus, float newSampleRate);
+
+    PolyphaseResampler(unsigned sourceSampleRate, unsigned destinationSampleRate);
+
+    unsigned sourceSampleRate() const { return m_sourceSampleRate; }
+    unsigned destinationSampleRate() const { return m_destinationSampleRate; }
+
+    size_t destinationLength(size_t sourceLength) const;
+
+    // Produces destinationFrames frames, starting at firstDestinationFrame, of the conversion of the
+    // sourceLength frames at source. Frames beyond either end of source are taken to be silent.
+    void process(const float* source, size_t sourceLength, float* destination, size_t firstDestinationFrame, size_t destinationFrames) const;
+
+private:
+    unsigned m_sourceSampleRate;
+    unsigned m_destinationSampleRate;
+
+    unsigned m_interpolation;   // L
+    unsigned m_decimation;      // M
+
+    // m_kernels has m_interpolation kernels back-to-back, each of size m_kernelSize. Kernel p is for the
+    // output frames that fall p / L of a frame after a source frame.
+    unsigned m_kernelSize;
+    std::vector<float> m_kernels;
+};
+
+} // namespace WebCore
+
+#endif // PolyphaseResampler_h
@@ -32,30 +32,48 @@
 #include "LabSound/core/AudioSourceProvider.h"
 #include "LabSound/core/AudioArray.h"
 
+#include <vector>
+
 namespace WebCore {
 
+class AudioBus;
+
 // SincResampler is a high-quality sample-rate converter.
+//
+// A resampler can convert several channels at once. They share the buffering and, for each output frame,
+// the choice of kernels and the interpolation between them; pairs of channels share a single pass over
+// the kernels as well.
 
 class SincResampler {
 public:   
     // scaleFactor == sourceSampleRate / destinationSampleRate
     // kernelSize can be adjusted for quality (higher is better)
     // numberOfKernelOffsets is used for interpolation and is the number of sub-sample kernel shifts.
-    SincResampler(double scaleFactor, unsigned kernelSize = 32, unsigned numberOfKernelOffsets = 32);
+    SincResampler(double scaleFactor, unsigned kernelSize = 32, unsigned numberOfKernelOffsets = 32, unsigned numberOfChannels = 1);
     
     // Processes numberOfSourceFrames from source to produce numberOfSourceFrames / scaleFactor frames in destination.
+    // The resampler must have been made for one channel.
     void process(const float* source, float* destination, unsigned numberOfSourceFrames);
 
     // Process with input source callback function for streaming applications.
+    // The resampler must have been made for one channel.
     void process(AudioSourceProvider*, float* destination, size_t framesToProcess);
 
+    // Multi-channel forms of the above. The buses must have at least as many channels as the resampler.
+    void process(const AudioBus* source, AudioBus* destination, unsigned numberOfSourceFrames);
+    void process(AudioSourceProvider*, AudioBus* destination, size_t framesToProcess);
+
+    unsigned numberOfChannels() const { return m_numberOfChannels; }
+
 protected:
     void initializeKernel();
     void consumeSource(float* buffer, unsigned numberOfSourceFrames);
+    void process(AudioSourceProvider*, float* const* destinations, size_t framesToProcess);
     
     double m_scaleFactor;
     unsigned m_kernelSize;
     unsigned m_numberOfKernelOffsets;
+    unsigned m_numberOfChannels;
 
     // m_kernelStorage has m_numberOfKernelOffsets kernels back-to-back, each of size m_kernelSize.
     // The kernel offsets are sub-sample shifts of a windowed sinc() shifted from 0.0 to 1.0 sample.
@@ -68,7 +86,9 @@ protected:
     // This is the number of destination frames we generate per processing pass on the buffer.
     unsigned m_blockSize;
 
-    // Source is copied into this buffer for each processing pass.
+    // Source is copied into this buffer for each processing pass. Each channel has a buffer of
+    // m_inputStride frames, laid out one after another.
+    unsigned m_inputStride;
     AudioFloatArray m_inputBuffer;
 
     const float* m_source;
@@ -79,6 +99,9 @@ protected:
 
     // The buffer is primed once at the very beginning of processing.
     bool m_isBufferPrimed;
+
+    // The destination of each channel, for the multi-channel streaming form of process().
+    std::vector<float*> m_destinations;
 };
 
 } // namespace WebCore
@@ -0,0 +1,61 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifndef SpectralAnalysis_h
+#define SpectralAnalysis_h
+
+#include "LabSound/core/AudioArray.h"
+
+#include <memory>
+#include <stdint.h>
+
+namespace WebCore {
+
+class FFTFrame;
+
+// SpectralAnalysis is the magnitude spectrum engine shared by the analysis nodes: RealtimeAnalyser,
+// and through SpectrumAnalyzer the SpectralMonitorNode. Everything it needs is allocated by the
+// constructor, and the Blackman window tables are computed once per size and shared by every engine
+// of that size, so that refreshing a display of many channels many times a second neither allocates
+// nor recomputes a window.
+class SpectralAnalysis
+{
+    SpectralAnalysis(const SpectralAnalysis&); // noncopyable
+
+public:
+
+    // fftSize must be a power of two.
+    explicit SpectralAnalysis(uint32_t fftSize);
+    ~SpectralAnalysis();
+
+    uint32_t fftSize() const { return m_fftSize; }
+    uint32_t frequencyBinCount() const { return m_fftSize / 2; }
+
+    // Windows and transforms the fftSize frames of the circular buffer history that end just before
+    // writeIndex, leaving frequencyBinCount() complex values in realData() and imagData(). The Nyquist
+    // term, which FFTFrame packs into the imaginary part of the DC term, is dropped.
+    void transform(const float* history, size_t historySize, size_t writeIndex);
+    const float* realData() const;
+    const float* imagData() const;
+
+    // Transforms as above, and blends the frequencyBinCount() magnitudes, multiplied by scale, into
+    // magnitudes: magnitudes = smoothing * magnitudes + (1 - smoothing) * scale * |X|.
+    void analyze(const float* history, size_t historySize, size_t writeIndex, float scale, float smoothing, float* magnitudes);
+
+    // Converts linear magnitudes to decibels, mapping silence to silenceDecibels.
+    static void magnitudesToDecibels(const float* magnitudes, float* decibels, size_t count, float silenceDecibels);
+
+    // Scales decibels from minDecibels to maxDecibels onto 0 to 255, clipping values outside the range.
+    static void decibelsToBytes(const float* decibels, uint8_t* bytes, size_t count, float minDecibels, float maxDecibels);
+
+private:
+
+    uint32_t m_fftSize;
+    std::unique_ptr<FFTFrame> m_frame;
+    std::shared_ptr<const AudioFloatArray> m_window;
+    AudioFloatArray m_scratch;
+};
+
+} // namespace WebCore
+
+#endif // SpectralAnalysis_h
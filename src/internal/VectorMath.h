@@ -26,6 +26,9 @@
 #define VectorMath_h
 
 // Defines the interface for several vector math functions whose implementation will ideally be optimized.
+// On x86 the unit stride cases are dispatched at runtime to AVX2 or AVX-512 kernels when the CPU supports them.
+
+#include <stddef.h>
 
 namespace WebCore {
 
@@ -54,6 +57,39 @@ void zvmul(const float* real1P, const float* imag1P, const float* real2P, const
 // Copies elements while clipping values to the threshold inputs.
 void vclip(const float* sourceP, int sourceStride, const float* lowThresholdP, const float* highThresholdP, float* destP, int destStride, size_t framesToProcess);
 
+// The following take unit stride vectors only.
+
+// Multiplies by a linear gain ramp starting at *gainP and advancing by *gainStepP per frame. On return *gainP
+// holds the gain for the frame after the last one processed, so a ramp can be continued across render quanta.
+void vrampmul(const float* sourceP, float* gainP, const float* gainStepP, float* destP, size_t framesToProcess);
+
+// As vrampmul, but accumulates the result into destP.
+void vrampmuladd(const float* sourceP, float* gainP, const float* gainStepP, float* destP, size_t framesToProcess);
+
+// Linear crossfade, destP = fromP + (toP - fromP) * mix, with mix ramping as the gain of vrampmul does.
+void vcrossfade(const float* fromP, const float* toP, float* mixP, const float* mixStepP, float* destP, size_t framesToProcess);
+
+// Element-by-element minimum and maximum of two float vectors.
+void vmin(const float* source1P, const float* source2P, float* destP, size_t framesToProcess);
+void vmax(const float* source1P, const float* source2P, float* destP, size_t framesToProcess);
+
+// Element-by-element absolute value.
+void vabs(const float* sourceP, float* destP, size_t framesToProcess);
+
+// Converts magnitudes to decibels (20 * log10(|x|), with silence mapped to -1000 dB) and decibels back to linear gains.
+void vlin2db(const float* sourceP, float* destP, size_t framesToProcess);
+void vdb2lin(const float* sourceP, float* destP, size_t framesToProcess);
+
+// Complex magnitudes, destP = scale * sqrt(real * real + imag * imag), as for a spectrum from FFTFrame's split real and imaginary data.
+void zvmag(const float* realP, const float* imagP, const float* scale, float* destP, size_t framesToProcess);
+
+// Mixes several vectors in one pass, destP = sum of gainsP[k] * sourcesP[k], added to the existing contents of destP if accumulate is set.
+// A null gainsP means unity gains. Sources are consumed eight at a time, so each group costs one pass over destP rather than one per source.
+void vmix(const float* const* sourcesP, const float* gainsP, size_t numberOfSources, float* destP, bool accumulate, size_t framesToProcess);
+
+// Names the instruction set the portable kernels above were dispatched to on this machine, for logging.
+const char* kernelName();
+
 } // namespace VectorMath
 
 } // namespace WebCore
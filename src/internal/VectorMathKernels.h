@@ -0,0 +1,106 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifndef VectorMathKernels_h
+#define VectorMathKernels_h
+
+#include <stddef.h>
+
+namespace WebCore {
+
+namespace VectorMath {
+
+// The number of sources vmix accumulates per pass over its destination.
+const size_t MixGroupSize = 8;
+
+// Constants for the Cephes style logf and expf approximations used for decibel conversion by
+// the SSE2 baseline and the wider kernels alike.
+// Both are accurate to a few ulp over the range of levels audio deals with.
+const float Sqrt2 = 1.41421356237f;
+const float LogP0 = 7.0376836292e-2f;
+const float LogP1 = -1.1514610310e-1f;
+const float LogP2 = 1.1676998740e-1f;
+const float LogP3 = -1.2420140846e-1f;
+const float LogP4 = 1.4249322787e-1f;
+const float LogP5 = -1.6668057665e-1f;
+const float LogP6 = 2.0000714765e-1f;
+const float LogP7 = -2.4999993993e-1f;
+const float LogP8 = 3.3333331174e-1f;
+const float Ln2Hi = 0.693359375f;
+const float Ln2Lo = -2.12194440e-4f;
+const float Log2e = 1.44269504088896341f;
+const float ExpHi = 88.3762626647949f;
+const float ExpLo = -87.3365447505f;
+const float ExpP0 = 1.9875691500e-4f;
+const float ExpP1 = 1.3981999507e-3f;
+const float ExpP2 = 8.3334519073e-3f;
+const float ExpP3 = 4.1665795894e-2f;
+const float ExpP4 = 1.6666665459e-1f;
+const float ExpP5 = 5.0000001201e-1f;
+
+// 20 / ln(10) and ln(10) / 20, converting natural logs to decibels and back.
+const float DecibelsPerNeper = 8.68588963806503655f;
+const float NepersPerDecibel = 0.11512925464970228f;
+
+// Matches AudioUtilities::linearToDecibels for a silent sample.
+const float SilentDecibels = -1000.0f;
+
+// A table of unit stride kernels for an instruction set that can only be used once the running
+// CPU has been checked for it. The VectorMath entry points compiled for the baseline instruction
+// set (SSE2 on x86, NEON on ARM) forward to these when one is available, so that distribution
+// builds pick up wider vectors without requiring them. Scalars are passed by value, and the
+// ramp style kernels leave updating the caller's running gain to the VectorMath entry point.
+struct VectorKernels
+{
+    const char* name;
+
+    void (*vsma)(const float* sourceP, float scale, float* destP, size_t framesToProcess);
+    void (*vsmul)(const float* sourceP, float scale, float* destP, size_t framesToProcess);
+    void (*vadd)(const float* source1P, const float* source2P, float* destP, size_t framesToProcess);
+    void (*vmul)(const float* source1P, const float* source2P, float* destP, size_t framesToProcess);
+    void (*zvmul)(const float* real1P, const float* imag1P, const float* real2P, const float* imag2P, float* realDestP, float* imagDestP, size_t framesToProcess);
+    float (*vsvesq)(const float* sourceP, size_t framesToProcess);
+    float (*vmaxmgv)(const float* sourceP, size_t framesToProcess);
+    void (*vclip)(const float* sourceP, float lowThreshold, float highThreshold, float* destP, size_t framesToProcess);
+
+    // Interleave and deinterleave count complex pairs, not floats.
+    void (*vintlve)(const float* realSrcP, const float* imagSrcP, float* destP, size_t pairsToProcess);
+    void (*vdeintlve)(const float* sourceP, float* realDestP, float* imagDestP, size_t pairsToProcess);
+
+    void (*vrampmul)(const float* sourceP, float gain, float gainStep, float* destP, size_t framesToProcess);
+    void (*vrampmuladd)(const float* sourceP, float gain, float gainStep, float* destP, size_t framesToProcess);
+    void (*vcrossfade)(const float* fromP, const float* toP, float mix, float mixStep, float* destP, size_t framesToProcess);
+    void (*vmin)(const float* source1P, const float* source2P, float* destP, size_t framesToProcess);
+    void (*vmax)(const float* source1P, const float* source2P, float* destP, size_t framesToProcess);
+    void (*vabs)(const float* sourceP, float* destP, size_t framesToProcess);
+    void (*vlin2db)(const float* sourceP, float* destP, size_t framesToProcess);
+    void (*vdb2lin)(const float* sourceP, float* destP, size_t framesToProcess);
+    void (*zvmag)(const float* realP, const float* imagP, float scale, float* destP, size_t framesToProcess);
+
+    // Mixes at most MixGroupSize sources with the given gains.
+    void (*vmix)(const float* const* sourcesP, const float* gainsP, size_t numberOfSources, float* destP, bool accumulate, size_t framesToProcess);
+
+    // SincResampler's inner products. The first convolves one source with the two kernels either side of
+    // the source position; the second convolves two sources with the kernel interpolated between them.
+    void (*sincConvolve)(const float* sourceP, const float* kernel1P, const float* kernel2P, size_t kernelSize, float* sum1P, float* sum2P);
+    void (*sincConvolvePair)(const float* source1P, const float* source2P, const float* kernel1P, const float* kernel2P, float kernelInterpolationFactor, size_t kernelSize, float* sum1P, float* sum2P);
+};
+
+// Returns the widest kernel table the running x86 CPU and operating system support (AVX-512 or AVX2),
+// or null if there is none and the SSE2 baseline should be used. Always null on other architectures.
+const VectorKernels* selectX86Kernels();
+
+// The individual tables, or null where the running CPU or operating system doesn't support them.
+const VectorKernels* avx2Kernels();
+const VectorKernels* avx512Kernels();
+
+// Makes the VectorMath entry points forward to the given table, which must be one the CPU supports, or
+// to none so that they run the baseline code. For benchmarks; call it only while nothing else is using
+// VectorMath.
+void setKernels(const VectorKernels* kernels);
+
+} // namespace VectorMath
+
+} // namespace WebCore
+
+#endif // VectorMathKernels_h
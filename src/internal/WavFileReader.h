@@ -0,0 +1,61 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifndef WavFileReader_h
+#define WavFileReader_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace WebCore {
+
+// WavFileReader decodes a WAV file a block at a time, so that a file of any length can be streamed from disk
+// with a fixed amount of memory. It reads the files WavFileWriter writes, RF64 included, as well as 8, 16, 24
+// and 32 bit integer and 32 and 64 bit float files in either the plain or the extensible format.
+class WavFileReader
+{
+    WavFileReader(const WavFileReader&); // noncopyable
+
+public:
+
+    WavFileReader();
+    ~WavFileReader(); // closes the file
+
+    // Returns false if the file can't be read or isn't a WAV file in a supported format.
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return m_file != 0; }
+    unsigned numberOfChannels() const { return m_numberOfChannels; }
+    float sampleRate() const { return m_sampleRate; }
+    uint64_t length() const { return m_length; }   // in frames
+    uint64_t position() const { return m_position; }
+
+    // Moves the read position, clamped to the length. Returns false if the file couldn't seek.
+    bool seek(uint64_t frame);
+
+    // Reads up to framesToRead frames of interleaved samples, converted to float, and returns the number read.
+    // Fewer are read only at the end of the file, or if the file is truncated.
+    size_t read(float* interleaved, size_t framesToRead);
+
+private:
+
+    FILE* m_file;
+    unsigned m_numberOfChannels;
+    float m_sampleRate;
+    unsigned m_bytesPerSample;
+    bool m_isFloat;
+
+    uint64_t m_dataOffset;
+    uint64_t m_length;
+    uint64_t m_position;
+
+    // Raw bytes of the block being converted, grown to the largest block read.
+    std::vector<uint8_t> m_bytes;
+};
+
+} // namespace WebCore
+
+#endif // WavFileReader_h
@@ -0,0 +1,62 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#ifndef WavFileWriter_h
+#define WavFileWriter_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace WebCore {
+
+// WavFileWriter streams interleaved audio to a WAV file a block at a time, so a recording never has to
+// be held in memory. The header is written with placeholder sizes when the file is opened and patched
+// by close(). A file that grows beyond the 4GB a RIFF header can describe is promoted to RF64, using
+// the space reserved for that by a JUNK chunk in the header, so hours long recordings remain readable.
+class WavFileWriter
+{
+    WavFileWriter(const WavFileWriter&); // noncopyable
+
+public:
+
+    enum SampleFormat
+    {
+        Float32,
+        PCM16
+    };
+
+    WavFileWriter();
+    ~WavFileWriter(); // closes the file
+
+    // Returns false if the file could not be created.
+    bool open(const std::string& path, unsigned numberOfChannels, float sampleRate, SampleFormat);
+
+    // Appends frames of interleaved samples. Returns false if the disk refused them.
+    bool write(const float* interleaved, size_t framesToWrite);
+
+    // Writes the final sizes into the header and closes the file.
+    void close();
+
+    bool isOpen() const { return m_file != 0; }
+    uint64_t framesWritten() const { return m_framesWritten; }
+
+private:
+
+    FILE* m_file;
+    unsigned m_numberOfChannels;
+    SampleFormat m_format;
+    uint64_t m_framesWritten;
+
+    // Where the header fields patched by close() are.
+    long m_factOffset;
+    long m_dataOffset;
+
+    // Conversion space for PCM16, grown to the largest block written.
+    std::vector<int16_t> m_pcm;
+};
+
+} // namespace WebCore
+
+#endif // WavFileWriter_h
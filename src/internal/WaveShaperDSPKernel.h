@@ -27,6 +27,7 @@
 
 #include "internal/AudioDSPKernel.h"
 #include "internal/WaveShaperProcessor.h"
+#include "internal/HalfBandResampler.h"
 
 namespace WebCore {
 
@@ -36,19 +37,31 @@ class WaveShaperProcessor;
 
 class WaveShaperDSPKernel : public AudioDSPKernel {
 public:  
-    explicit WaveShaperDSPKernel(WaveShaperProcessor* processor)
-    : AudioDSPKernel(processor)
-    {
-    }
+    explicit WaveShaperDSPKernel(WaveShaperProcessor* processor);
     
     // AudioDSPKernel
     virtual void process(ContextRenderLock&, const float* source, float* dest, size_t framesToProcess);
-    virtual void reset() override { }
+    virtual void reset() override;
     virtual double tailTime() const override { return 0; }
-    virtual double latencyTime() const override { return 0; }
+    virtual double latencyTime() const override;
     
 protected:
     WaveShaperProcessor* waveShaperProcessor() { return static_cast<WaveShaperProcessor*>(processor()); }
+    const WaveShaperProcessor* waveShaperProcessor() const { return static_cast<const WaveShaperProcessor*>(processor()); }
+
+    // The first stage up and the last stage down, between the context's rate and twice that, take the long
+    // filters; the stages between twice and four times the rate only have to reject what lies above 1.5
+    // times the context's Nyquist frequency, so short ones suffice.
+    static const size_t OuterHalfLength = 32;
+    static const size_t InnerHalfLength = 8;
+
+    HalfBandUpSampler m_upSampler;
+    HalfBandUpSampler m_upSampler2;
+    HalfBandDownSampler m_downSampler2;
+    HalfBandDownSampler m_downSampler;
+
+    AudioFloatArray m_oversampled;      // at twice the rate
+    AudioFloatArray m_oversampled2;     // at four times the rate
 };
 
 } // namespace WebCore
@@ -28,6 +28,8 @@
 #include "internal/AudioDSPKernel.h"
 #include "internal/AudioDSPKernelProcessor.h"
 
+#include "LabSound/core/WaveShaperNode.h"
+
 namespace WebCore {
 
 // WaveShaperProcessor is an AudioDSPKernelProcessor which uses WaveShaperDSPKernel objects to implement non-linear distortion effects.
@@ -45,9 +47,14 @@ public:
     void setCurve(ContextRenderLock&, std::shared_ptr<std::vector<float>>);
     std::shared_ptr<std::vector<float>> curve() { return m_curve; }
 
+    void setOversample(ContextRenderLock&, OverSampleType);
+    OverSampleType oversample() const { return m_oversample; }
+
 private:
     // m_curve represents the non-linear shaping curve.
     std::shared_ptr<std::vector<float>> m_curve;
+
+    OverSampleType m_oversample;
 };
 
 } // namespace WebCore
@@ -43,6 +43,10 @@ public:
 
     void process(const float *source, float *destination, unsigned framesToProcess);
 
+    // Runs the filters in series. A cascade of four, as the compressor's emphasis filters are, is run in a single
+    // pass, so that the filters' recursions overlap rather than each waiting on a pass of its own.
+    static void processCascade(ZeroPole* filters, unsigned numberOfFilters, const float *source, float *destination, unsigned framesToProcess);
+
     // Reset filter state.
     void reset() { m_lastX = 0; m_lastY = 0; }
     
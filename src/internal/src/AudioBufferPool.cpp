@@ -0,0 +1,161 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#include "internal/AudioBufferPool.h"
+#include "internal/Assertions.h"
+
+#include "LabSound/core/AudioArray.h"
+#include "LabSound/extended/Logging.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace WebCore {
+
+namespace
+{
+    // Blocks allocated up front, so that a typical graph renders without waiting for a replenish().
+    // 128 blocks of 128 frames is 64kB.
+    const size_t InitialBlocks = 128;
+
+    // Each later slab doubles the pool, so it takes only a few slabs to reach the bound. The free
+    // list is fixed in size, so this bounds the pool; 4096 blocks of 128 frames is 2MB.
+    const size_t MaxBlocks = 4096;
+    const size_t MaxSlabs = 8;
+
+    const uint32_t NoBlock = 0xffffffff;
+}
+
+AudioBufferPool::AudioBufferPool(size_t framesPerBlock)
+    : m_framesPerBlock(framesPerBlock)
+    , m_slabs(new Slab[MaxSlabs])
+    , m_slabCount(0)
+    , m_blocks(new float*[MaxBlocks])
+    , m_next(new std::atomic<uint32_t>[MaxBlocks])
+    , m_freeHead(NoBlock)
+    , m_blockCount(0)
+    , m_blocksInUse(0)
+    , m_shortfall(0)
+    , m_missCount(0)
+{
+    const size_t floatsPerLine = AudioArrayAlignment / sizeof(float);
+    m_blockStride = (framesPerBlock + floatsPerLine - 1) & ~(floatsPerLine - 1);
+
+    addSlab(InitialBlocks);
+
+    // Reserve a block of the first slab as the shared silent block.
+    uint32_t index;
+    pop(index);
+    m_silentBlock = m_blocks[index];
+    memset(m_silentBlock, 0, sizeof(float) * m_blockStride);
+}
+
+AudioBufferPool::~AudioBufferPool()
+{
+    ASSERT(!m_blocksInUse);
+
+    for (size_t i = 0; i < m_slabCount; ++i)
+        alignedFree(m_slabs[i].blocks);
+}
+
+void AudioBufferPool::addSlab(size_t blockCount)
+{
+    size_t slabIndex = m_slabCount;
+    if (slabIndex == MaxSlabs || m_blockCount + blockCount > MaxBlocks)
+        return;
+
+    float* blocks = static_cast<float*>(alignedMalloc(sizeof(float) * m_blockStride * blockCount, AudioArrayAlignment));
+    if (!blocks)
+        return;
+
+    Slab& slab = m_slabs[slabIndex];
+    slab.blocks = blocks;
+    slab.firstIndex = static_cast<uint32_t>(m_blockCount);
+    slab.blockCount = static_cast<uint32_t>(blockCount);
+    for (size_t i = 0; i < blockCount; ++i)
+        m_blocks[slab.firstIndex + i] = blocks + i * m_blockStride;
+
+    // Publish the slab before any of its blocks can be released back to it.
+    m_slabCount.store(slabIndex + 1, std::memory_order_release);
+    m_blockCount += blockCount;
+
+    // Pushed in reverse, so the first block of the slab is the first handed out.
+    for (size_t i = blockCount; i > 0; --i)
+        push(static_cast<uint32_t>(slab.firstIndex + i - 1));
+}
+
+void AudioBufferPool::replenish()
+{
+    std::lock_guard<std::mutex> lock(m_slabMutex);
+
+    size_t shortfall = m_shortfall.exchange(0);
+    if (shortfall)
+        LOG("AudioBufferPool: %d channels allocated on the render thread; growing the pool from %d blocks", int(shortfall), int(m_blockCount));
+
+    size_t wanted = 2 * m_blocksInUse + shortfall + 1; // and the silent block
+    while (m_blockCount < wanted && m_blockCount < MaxBlocks && m_slabCount < MaxSlabs)
+        addSlab(std::min(size_t(m_blockCount), MaxBlocks - m_blockCount));
+}
+
+uint32_t AudioBufferPool::indexOf(const float* block) const
+{
+    size_t slabCount = m_slabCount.load(std::memory_order_acquire);
+    for (size_t i = 0; i < slabCount; ++i) {
+        const Slab& slab = m_slabs[i];
+        if (block >= slab.blocks && block < slab.blocks + slab.blockCount * m_blockStride)
+            return slab.firstIndex + static_cast<uint32_t>((block - slab.blocks) / m_blockStride);
+    }
+    return NoBlock;
+}
+
+void AudioBufferPool::push(uint32_t index)
+{
+    uint64_t head = m_freeHead.load(std::memory_order_relaxed);
+    uint64_t newHead;
+    do {
+        m_next[index].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        newHead = ((head >> 32) + 1) << 32 | index;
+    } while (!m_freeHead.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
+}
+
+bool AudioBufferPool::pop(uint32_t& index)
+{
+    uint64_t head = m_freeHead.load(std::memory_order_acquire);
+    uint64_t newHead;
+    do {
+        index = static_cast<uint32_t>(head);
+        if (index == NoBlock)
+            return false;
+        newHead = ((head >> 32) + 1) << 32 | m_next[index].load(std::memory_order_relaxed);
+    } while (!m_freeHead.compare_exchange_weak(head, newHead, std::memory_order_acquire, std::memory_order_acquire));
+    return true;
+}
+
+float* AudioBufferPool::acquire()
+{
+    uint32_t index;
+    if (!pop(index)) {
+        ++m_shortfall;
+        ++m_missCount;
+        return nullptr;
+    }
+
+    ++m_blocksInUse;
+    return m_blocks[index];
+}
+
+void AudioBufferPool::release(float* block)
+{
+    if (!block || block == m_silentBlock)
+        return;
+
+    uint32_t index = indexOf(block);
+    ASSERT(index != NoBlock);
+    if (index == NoBlock)
+        return;
+
+    push(index);
+    --m_blocksInUse;
+}
+
+} // namespace WebCore
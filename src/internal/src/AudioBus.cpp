@@ -27,6 +27,7 @@
  */
 
 #include "internal/AudioBus.h"
+#include "internal/AudioBufferPool.h"
 #include "internal/DenormalDisabler.h"
 #include "internal/SincResampler.h"
 #include "internal/VectorMath.h"
@@ -39,8 +40,6 @@ namespace WebCore {
 
 using namespace VectorMath;
 
-const unsigned MaxBusChannels = 32;
-
 AudioBus::AudioBus(unsigned numberOfChannels, size_t length, bool allocate)
     : m_length(length)
     , m_busGain(1)
@@ -62,6 +61,58 @@ AudioBus::AudioBus(unsigned numberOfChannels, size_t length, bool allocate)
     m_layout = LayoutCanonical; // for now this is the only layout we define
 }
 
+AudioBus::AudioBus(unsigned numberOfChannels, std::shared_ptr<AudioBufferPool> pool)
+    : AudioBus(numberOfChannels, pool->framesPerBlock(), false)
+{
+    acquirePooledMemory(pool);
+}
+
+AudioBus::~AudioBus()
+{
+    releasePooledMemory();
+}
+
+void AudioBus::acquirePooledMemory(std::shared_ptr<AudioBufferPool> pool)
+{
+    ASSERT(pool && m_length <= pool->framesPerBlock());
+    if (!pool || m_length > pool->framesPerBlock() || m_pooledMemoryAcquired)
+        return;
+
+    m_pool = pool;
+    m_pooledMemoryAcquired = true;
+
+    for (unsigned i = 0; i < m_channels.size(); ++i) {
+        // If the pool has run dry before the graph update could replenish it, the channel falls back
+        // to memory of its own, which allocates on the render thread. The pool counts the miss and
+        // grows by the shortfall at the next update.
+        float* block = m_pool->acquire();
+        if (block)
+            m_channels[i]->set(block, m_length);
+        else
+            m_channels[i]->allocate(m_length);
+
+        // Pooled memory holds whatever the previous owner left behind.
+        m_channels[i]->zero();
+    }
+}
+
+void AudioBus::releasePooledMemory()
+{
+    if (!m_pooledMemoryAcquired)
+        return;
+
+    float* silentBlock = m_pool->silentBlock();
+    for (unsigned i = 0; i < m_channels.size(); ++i) {
+        AudioChannel* c = m_channels[i].get();
+        if (!c->ownsStorage())
+            m_pool->release(const_cast<float*>(c->data()));
+        c->set(silentBlock, m_length);
+        c->zero(); // marks the channel silent
+    }
+
+    m_pooledMemoryAcquired = false;
+}
+
 void AudioBus::setChannelMemory(unsigned channelIndex, float* storage, size_t length)
 {
     if (channelIndex < m_channels.size()) {
@@ -206,7 +257,6 @@ void AudioBus::scale(float scale)
 
 // Just copies the samples from the source bus to this one.
 // This is just a simple copy if the number of channels match, otherwise a mixup or mixdown is done.
-// For now, we just support mixup from mono -> stereo and mixdown from stereo -> mono.
 void AudioBus::copyFrom(const AudioBus& sourceBus, ChannelInterpretation channelInterpretation)
 {
     if (&sourceBus == this)
@@ -218,18 +268,8 @@ void AudioBus::copyFrom(const AudioBus& sourceBus, ChannelInterpretation channel
     if (numberOfDestinationChannels == numberOfSourceChannels) {
         for (unsigned i = 0; i < numberOfSourceChannels; ++i)
             channel(i)->copyFrom(sourceBus.channel(i));
-    } else {
-        switch (channelInterpretation) {
-            case ChannelInterpretation::Speakers:
-                speakersCopyFrom(sourceBus);
-                break;
-            case ChannelInterpretation::Discrete:
-                discreteCopyFrom(sourceBus);
-                break;
-            default:
-                ASSERT_NOT_REACHED();
-        }
-    }
+    } else
+        mixFrom(sourceBus, MixingMatrix::matrix(numberOfSourceChannels, numberOfDestinationChannels, channelInterpretation), false);
 }
 
 void AudioBus::sumFrom(const AudioBus &sourceBus, ChannelInterpretation channelInterpretation)
@@ -243,162 +283,47 @@ void AudioBus::sumFrom(const AudioBus &sourceBus, ChannelInterpretation channelI
     if (numberOfDestinationChannels == numberOfSourceChannels) {
         for (unsigned i = 0; i < numberOfSourceChannels; ++i)
             channel(i)->sumFrom(sourceBus.channel(i));
-    } else {
-        switch (channelInterpretation) {
-            case ChannelInterpretation::Speakers:
-                speakersSumFrom(sourceBus);
-                break;
-            case ChannelInterpretation::Discrete:
-                discreteSumFrom(sourceBus);
-                break;
-            default:
-                ASSERT_NOT_REACHED();
-        }
-    }
+    } else
+        mixFrom(sourceBus, MixingMatrix::matrix(numberOfSourceChannels, numberOfDestinationChannels, channelInterpretation), true);
 }
 
-
-void AudioBus::speakersCopyFrom(const AudioBus& sourceBus)
+void AudioBus::mixFrom(const AudioBus& sourceBus, const MixingMatrix& matrix, bool sum)
 {
-    // FIXME: Implement down mixing 5.1 to stereo.
-    // https://bugs.webkit.org/show_bug.cgi?id=79192
-    
-    unsigned numberOfSourceChannels = sourceBus.numberOfChannels();
-    unsigned numberOfDestinationChannels = numberOfChannels();
-    
-    if (numberOfDestinationChannels == 2 && numberOfSourceChannels == 1) {
-        // Handle mono -> stereo case (for now simply copy mono channel into both left and right)
-        // FIXME: Really we should apply an equal-power scaling factor here, since we're effectively panning center...
-        const AudioChannel* sourceChannel = sourceBus.channel(0);
-        channelByType(Channel::Left)->copyFrom(sourceChannel);
-        channelByType(Channel::Right)->copyFrom(sourceChannel);
-    } else if (numberOfDestinationChannels == 1 && numberOfSourceChannels == 2) {
-        // Handle stereo -> mono case. output = 0.5 * (input.L + input.R).
-        AudioBus& sourceBusSafe = const_cast<AudioBus&>(sourceBus);
-        
-        const float* sourceL = sourceBusSafe.channelByType(Channel::Left)->data();
-        const float* sourceR = sourceBusSafe.channelByType(Channel::Right)->data();
-        
-        float* destination = channelByType(Channel::Left)->mutableData();
-        vadd(sourceL, 1, sourceR, 1, destination, 1, length());
-        float scale = 0.5;
-        vsmul(destination, 1, &scale, destination, 1, length());
-    } else if (numberOfDestinationChannels == 6 && numberOfSourceChannels == 1) {
-        // Handle mono -> 5.1 case, copy mono channel to center.
-        channelByType(Channel::Center)->copyFrom(sourceBus.channel(0));
-        channelByType(Channel::Left)->zero();
-        channelByType(Channel::Right)->zero();
-        channelByType(Channel::LFE)->zero();
-        channelByType(Channel::SurroundLeft)->zero();
-        channelByType(Channel::SurroundRight)->zero();
-    } else if (numberOfDestinationChannels == 1 && numberOfSourceChannels == 6) {
-        // Handle 5.1 -> mono case.
-        zero();
-        speakersSumFrom5_1_ToMono(sourceBus);
-    } else {
-        // Fallback for unknown combinations.
-        discreteCopyFrom(sourceBus);
-    }
-}
+    bool isSafe = matrix.numberOfSourceChannels() == sourceBus.numberOfChannels()
+        && matrix.numberOfDestinationChannels() == numberOfChannels()
+        && sourceBus.length() >= length();
+    ASSERT(isSafe);
+    if (!isSafe)
+        return;
 
-void AudioBus::speakersSumFrom(const AudioBus& sourceBus)
-{
-    // FIXME: Implement down mixing 5.1 to stereo.
-    // https://bugs.webkit.org/show_bug.cgi?id=79192
-    
-    unsigned numberOfSourceChannels = sourceBus.numberOfChannels();
-    unsigned numberOfDestinationChannels = numberOfChannels();
-    
-    if (numberOfDestinationChannels == 2 && numberOfSourceChannels == 1) {
-        // Handle mono -> stereo case (summing mono channel into both left and right).
-        const AudioChannel* sourceChannel = sourceBus.channel(0);
-        channelByType(Channel::Left)->sumFrom(sourceChannel);
-        channelByType(Channel::Right)->sumFrom(sourceChannel);
-    } else if (numberOfDestinationChannels == 1 && numberOfSourceChannels == 2) {
-        // Handle stereo -> mono case. output += 0.5 * (input.L + input.R).
-        AudioBus& sourceBusSafe = const_cast<AudioBus&>(sourceBus);
-        
-        const float* sourceL = sourceBusSafe.channelByType(Channel::Left)->data();
-        const float* sourceR = sourceBusSafe.channelByType(Channel::Right)->data();
-        
-        float* destination = channelByType(Channel::Left)->mutableData();
-        float scale = 0.5;
-        vsma(sourceL, 1, &scale, destination, 1, length());
-        vsma(sourceR, 1, &scale, destination, 1, length());
-    } else if (numberOfDestinationChannels == 6 && numberOfSourceChannels == 1) {
-        // Handle mono -> 5.1 case, sum mono channel into center.
-        channelByType(Channel::Center)->sumFrom(sourceBus.channel(0));
-    } else if (numberOfDestinationChannels == 1 && numberOfSourceChannels == 6) {
-        // Handle 5.1 -> mono case.
-        speakersSumFrom5_1_ToMono(sourceBus);
-    } else {
-        // Fallback for unknown combinations.
-        discreteSumFrom(sourceBus);
-    }
-}
+    const float* sources[MixingMatrix::MaxTermsPerChannel];
+    float gains[MixingMatrix::MaxTermsPerChannel];
 
-void AudioBus::speakersSumFrom5_1_ToMono(const AudioBus& sourceBus)
-{
-    AudioBus& sourceBusSafe = const_cast<AudioBus&>(sourceBus);
-    
-    const float* sourceL = sourceBusSafe.channelByType(Channel::Left)->data();
-    const float* sourceR = sourceBusSafe.channelByType(Channel::Right)->data();
-    const float* sourceC = sourceBusSafe.channelByType(Channel::Center)->data();
-    const float* sourceSL = sourceBusSafe.channelByType(Channel::SurroundLeft)->data();
-    const float* sourceSR = sourceBusSafe.channelByType(Channel::SurroundRight)->data();
-    
-    float* destination = channelByType(Channel::Left)->mutableData();
-    
-    AudioFloatArray temp(length());
-    float* tempData = temp.data();
-    
-    // Sum in L and R.
-    vadd(sourceL, 1, sourceR, 1, tempData, 1, length());
-    float scale = 0.7071f;
-    vsmul(tempData, 1, &scale, tempData, 1, length());
-    vadd(tempData, 1, destination, 1, destination, 1, length());
-    
-    // Sum in SL and SR.
-    vadd(sourceSL, 1, sourceSR, 1, tempData, 1, length());
-    scale = 0.5;
-    vsmul(tempData, 1, &scale, tempData, 1, length());
-    vadd(tempData, 1, destination, 1, destination, 1, length());
-    
-    // Sum in center.
-    vadd(sourceC, 1, destination, 1, destination, 1, length());
-}
+    for (unsigned d = 0; d < numberOfChannels(); ++d) {
+        const MixingMatrix::Term* terms = matrix.terms(d);
+        unsigned count = 0;
 
-void AudioBus::discreteCopyFrom(const AudioBus& sourceBus)
-{
-    unsigned numberOfSourceChannels = sourceBus.numberOfChannels();
-    unsigned numberOfDestinationChannels = numberOfChannels();
-    
-    if (numberOfDestinationChannels < numberOfSourceChannels) {
-        // Down-mix by copying channels and dropping the remaining.
-        for (unsigned i = 0; i < numberOfDestinationChannels; ++i)
-            channel(i)->copyFrom(sourceBus.channel(i));
-    } else if (numberOfDestinationChannels > numberOfSourceChannels) {
-        // Up-mix by copying as many channels as we have, then zeroing remaining channels.
-        for (unsigned i = 0; i < numberOfSourceChannels; ++i)
-            channel(i)->copyFrom(sourceBus.channel(i));
-        for (unsigned i = numberOfSourceChannels; i < numberOfDestinationChannels; ++i)
-            channel(i)->zero();
-    }
-}
+        for (unsigned t = 0; t < matrix.numberOfTerms(d); ++t) {
+            const AudioChannel* source = sourceBus.channel(terms[t].source);
+            if (source->isSilent())
+                continue;
 
-void AudioBus::discreteSumFrom(const AudioBus& sourceBus)
-{
-    unsigned numberOfSourceChannels = sourceBus.numberOfChannels();
-    unsigned numberOfDestinationChannels = numberOfChannels();
+            sources[count] = source->data();
+            gains[count] = terms[t].gain;
+            ++count;
+        }
 
-    if (numberOfDestinationChannels < numberOfSourceChannels) {
-        // Down-mix by summing channels and dropping the remaining.
-        for (unsigned i = 0; i < numberOfDestinationChannels; ++i) 
-            channel(i)->sumFrom(sourceBus.channel(i));
-    } else if (numberOfDestinationChannels > numberOfSourceChannels) {
-        // Up-mix by summing as many channels as we have.
-        for (unsigned i = 0; i < numberOfSourceChannels; ++i) 
-            channel(i)->sumFrom(sourceBus.channel(i));
+        AudioChannel* destination = channel(d);
+
+        if (!count) {
+            if (!sum)
+                destination->zero();
+            continue;
+        }
+
+        // A silent destination may hold stale samples, so overwrite rather than sum into it.
+        bool accumulate = sum && !destination->isSilent();
+        vmix(sources, gains, count, destination->mutableData(), accumulate, length());
     }
 }
 
@@ -583,14 +508,9 @@ std::unique_ptr<AudioBus> AudioBus::createBySampleRateConverting(const AudioBus*
     unsigned numberOfDestinationChannels = resamplerSourceBus->numberOfChannels();
     std::unique_ptr<AudioBus> destinationBus(new AudioBus(numberOfDestinationChannels, destinationLength));
 
-    // Sample-rate convert each channel.
-    for (unsigned i = 0; i < numberOfDestinationChannels; ++i) {
-        const float* source = resamplerSourceBus->channel(i)->data();
-        float* destination = destinationBus->channel(i)->mutableData();
-
-        SincResampler resampler(sampleRateRatio);
-        resampler.process(source, destination, sourceLength);
-    }
+    // Sample-rate convert the channels together.
+    SincResampler resampler(sampleRateRatio, 32, 32, numberOfDestinationChannels);
+    resampler.process(resamplerSourceBus, destinationBus.get(), sourceLength);
 
     destinationBus->clearSilentFlag();
     destinationBus->setSampleRate(newSampleRate);    
@@ -602,31 +522,14 @@ std::unique_ptr<AudioBus> AudioBus::createByMixingToMono(const AudioBus* sourceB
     if (sourceBus->isSilent())
         return std::unique_ptr<AudioBus>(new AudioBus(1, sourceBus->length()));
 
-    switch (sourceBus->numberOfChannels()) {
-    case 1:
-        // Simply create an exact copy.
+    // Simply create an exact copy.
+    if (sourceBus->numberOfChannels() == 1)
         return AudioBus::createBufferFromRange(sourceBus, 0, sourceBus->length());
-    case 2:
-        {
-            unsigned n = sourceBus->length();
-            std::unique_ptr<AudioBus> destinationBus(new AudioBus(1, n));
-
-            const float* sourceL = sourceBus->channelByType(Channel::Left)->data();
-            const float* sourceR = sourceBus->channelByType(Channel::Right)->data();
-            float* destination = destinationBus->channel(0)->mutableData();
-        
-            // Do the mono mixdown.
-            for (unsigned i = 0; i < n; ++i)
-                destination[i] = (sourceL[i] + sourceR[i]) / 2;
 
-            destinationBus->clearSilentFlag();
-            destinationBus->setSampleRate(sourceBus->sampleRate());    
-            return destinationBus;
-        }
-    }
-
-    ASSERT_NOT_REACHED();
-    return nullptr;
+    std::unique_ptr<AudioBus> destinationBus(new AudioBus(1, sourceBus->length()));
+    destinationBus->copyFrom(*sourceBus, ChannelInterpretation::Speakers);
+    destinationBus->setSampleRate(sourceBus->sampleRate());
+    return destinationBus;
 }
 
 bool AudioBus::isSilent() const
@@ -4,6 +4,7 @@
 #include "internal/AudioBus.h"
 #include "internal/AudioFileReader.h"
 #include "internal/FloatConversion.h"
+#include "internal/PolyphaseResampler.h"
 
 #include "libnyquist/AudioDecoder.h"
 
@@ -14,37 +15,40 @@ namespace detail
         size_t numSamples = audioData->samples.size();
         size_t numberOfFrames = int(numSamples / audioData->channelCount);
         const size_t busChannelCount = mixToMono ? 1 : (audioData->channelCount);
-        
-        std::vector<float> planarSamples(numSamples);
+        const size_t stride = audioData->channelCount;
+        const float * interleaved = audioData->samples.data();
 
         // Create AudioBus where we'll put the PCM audio data
         std::unique_ptr<WebCore::AudioBus> audioBus(new WebCore::AudioBus(busChannelCount, numberOfFrames));
         audioBus->setSampleRate(audioData->sampleRate);
         
-        // Deinterleave stereo into LabSound/WebAudio planar channel layout
-        nqr::DeinterleaveChannels(audioData->samples.data(), planarSamples.data(), numberOfFrames, audioData->channelCount, numberOfFrames);
-        
-        // Mix to mono if stereo -- easier to do in place instead of using libnyquist helper functions
-        // because we've already deinterleaved
+        // Deinterleave straight into the LabSound/WebAudio planar channel layout, rather than through
+        // a planar copy of the whole file, so that peak memory is the decoded file plus the bus.
         if (audioData->channelCount == 2 && mixToMono)
         {
             float * destinationMono = audioBus->channel(0)->mutableData();
-            float * leftSamples = planarSamples.data();
-            float * rightSamples = planarSamples.data() + numberOfFrames;
             
             for (size_t i = 0; i < numberOfFrames; i++)
-                destinationMono[i] = 0.5f * (leftSamples[i] + rightSamples[i]);
+                destinationMono[i] = 0.5f * (interleaved[2 * i] + interleaved[2 * i + 1]);
         }
         else
         {
-            for (size_t i = 0; i < busChannelCount; ++i)
+            for (size_t c = 0; c < busChannelCount; ++c)
             {
-                memcpy(audioBus->channel(i)->mutableData(), planarSamples.data() + (i * numberOfFrames), numberOfFrames * sizeof(float));
+                float * destination = audioBus->channel(c)->mutableData();
+                const float * source = interleaved + c;
+                for (size_t i = 0; i < numberOfFrames; ++i, source += stride)
+                    destination[i] = *source;
             }
         }
         
         delete audioData;
         
+        // Convert to the requested rate once, here, so that playback at that rate needn't resample. A rate
+        // of zero keeps the file's own.
+        if (sampleRate > 0 && audioBus->sampleRate() != sampleRate)
+            return WebCore::PolyphaseResampler::createBySampleRateConverting(audioBus.get(), sampleRate);
+        
         return audioBus;
 	}
 }
@@ -52,48 +56,62 @@ namespace detail
 namespace WebCore
 {
 
-nqr::NyquistIO nyquistFileIO;
-std::mutex g_fileIOMutex;
-    
-std::unique_ptr<AudioBus> MakeBusFromFile(const char * filePath, bool mixToMono, float sampleRate)
+AudioFileReader::AudioFileReader() : m_io(new nqr::NyquistIO())
+{
+}
+
+AudioFileReader::~AudioFileReader()
+{
+}
+
+std::unique_ptr<AudioBus> AudioFileReader::loadFile(const char * filePath, bool mixToMono, float sampleRate)
 {
-    std::lock_guard<std::mutex> lock(g_fileIOMutex);
-    
     nqr::AudioData * audioData = new nqr::AudioData();
     
     // Perform audio decode
-    int result = nyquistFileIO.Load(audioData, std::string(filePath));
+    int result = m_io->Load(audioData, std::string(filePath));
     
     // Check OK
     if (result == nqr::IOError::NoError)
     {
-		return detail::LoadInternal(audioData, mixToMono, sampleRate);
+        return detail::LoadInternal(audioData, mixToMono, sampleRate);
     }
     else
     {
+        delete audioData;
         throw std::runtime_error("Nyquist File IO Error: " + std::to_string(result));
     }
 }
 
-std::unique_ptr<AudioBus> MakeBusFromMemory(const std::vector<uint8_t> & buffer, std::string extension, bool mixToMono, float sampleRate)
+std::unique_ptr<AudioBus> AudioFileReader::loadMemory(const std::vector<uint8_t> & buffer, const std::string & extension, bool mixToMono, float sampleRate)
 {
-    std::lock_guard<std::mutex> lock(g_fileIOMutex);
-    
     nqr::AudioData * audioData = new nqr::AudioData();
     
     // Perform audio decode
-    int result = nyquistFileIO.Load(audioData, extension, buffer);
+    int result = m_io->Load(audioData, extension, buffer);
     
     // Check OK
     if (result == nqr::IOError::NoError)
     {
-		return detail::LoadInternal(audioData, mixToMono, sampleRate);
+        return detail::LoadInternal(audioData, mixToMono, sampleRate);
     }
     else
     {
+        delete audioData;
         throw std::runtime_error("Nyquist File IO Error: " + std::to_string(result));
     }
 }
-    
+
+std::unique_ptr<AudioBus> MakeBusFromFile(const char * filePath, bool mixToMono, float sampleRate)
+{
+    AudioFileReader reader;
+    return reader.loadFile(filePath, mixToMono, sampleRate);
+}
+
+std::unique_ptr<AudioBus> MakeBusFromMemory(const std::vector<uint8_t> & buffer, std::string extension, bool mixToMono, float sampleRate)
+{
+    AudioFileReader reader;
+    return reader.loadMemory(buffer, extension, mixToMono, sampleRate);
+}
     
 } // end namespace WebCore
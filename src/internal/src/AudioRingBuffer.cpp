@@ -0,0 +1,106 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#include "internal/AudioRingBuffer.h"
+#include "internal/Assertions.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace WebCore {
+
+AudioRingBuffer::AudioRingBuffer(unsigned numberOfChannels, size_t capacityInFrames)
+    : m_writePosition(0)
+    , m_readPosition(0)
+{
+    ASSERT(numberOfChannels);
+
+    size_t capacity = 1;
+    while (capacity < capacityInFrames)
+        capacity <<= 1;
+    m_mask = capacity - 1;
+
+    m_channels.resize(numberOfChannels, std::vector<float>(capacity));
+}
+
+size_t AudioRingBuffer::framesAvailableToRead() const
+{
+    return static_cast<size_t>(m_writePosition.load(std::memory_order_acquire) - m_readPosition.load(std::memory_order_acquire));
+}
+
+size_t AudioRingBuffer::framesAvailableToWrite() const
+{
+    return capacity() - framesAvailableToRead();
+}
+
+size_t AudioRingBuffer::write(const float* const* sources, size_t framesToWrite)
+{
+    // Only this thread moves the write position, and the read position only moves towards it,
+    // so the space seen here can't shrink before the frames are copied in.
+    uint64_t writePosition = m_writePosition.load(std::memory_order_relaxed);
+    size_t space = capacity() - static_cast<size_t>(writePosition - m_readPosition.load(std::memory_order_acquire));
+    size_t frames = std::min(framesToWrite, space);
+
+    size_t start = static_cast<size_t>(writePosition & m_mask);
+    size_t firstPart = std::min(frames, capacity() - start);
+
+    for (size_t c = 0; c < m_channels.size(); ++c) {
+        float* data = &m_channels[c][0];
+        memcpy(data + start, sources[c], sizeof(float) * firstPart);
+        memcpy(data, sources[c] + firstPart, sizeof(float) * (frames - firstPart));
+    }
+
+    m_writePosition.store(writePosition + frames, std::memory_order_release);
+    return frames;
+}
+
+size_t AudioRingBuffer::read(float* const* destinations, size_t framesToRead)
+{
+    uint64_t readPosition = m_readPosition.load(std::memory_order_relaxed);
+    size_t available = static_cast<size_t>(m_writePosition.load(std::memory_order_acquire) - readPosition);
+    size_t frames = std::min(framesToRead, available);
+
+    size_t start = static_cast<size_t>(readPosition & m_mask);
+    size_t firstPart = std::min(frames, capacity() - start);
+
+    for (size_t c = 0; c < m_channels.size(); ++c) {
+        const float* data = &m_channels[c][0];
+        memcpy(destinations[c], data + start, sizeof(float) * firstPart);
+        memcpy(destinations[c] + firstPart, data, sizeof(float) * (frames - firstPart));
+    }
+
+    m_readPosition.store(readPosition + frames, std::memory_order_release);
+    return frames;
+}
+
+size_t AudioRingBuffer::readInterleaved(float* destination, size_t framesToRead)
+{
+    uint64_t readPosition = m_readPosition.load(std::memory_order_relaxed);
+    size_t available = static_cast<size_t>(m_writePosition.load(std::memory_order_acquire) - readPosition);
+    size_t frames = std::min(framesToRead, available);
+
+    const size_t numberOfChannels = m_channels.size();
+    for (size_t c = 0; c < numberOfChannels; ++c) {
+        const float* data = &m_channels[c][0];
+        float* destP = destination + c;
+        for (size_t i = 0; i < frames; ++i) {
+            *destP = data[(readPosition + i) & m_mask];
+            destP += numberOfChannels;
+        }
+    }
+
+    m_readPosition.store(readPosition + frames, std::memory_order_release);
+    return frames;
+}
+
+size_t AudioRingBuffer::discard(size_t framesToDiscard)
+{
+    uint64_t readPosition = m_readPosition.load(std::memory_order_relaxed);
+    size_t available = static_cast<size_t>(m_writePosition.load(std::memory_order_acquire) - readPosition);
+    size_t frames = std::min(framesToDiscard, available);
+
+    m_readPosition.store(readPosition + frames, std::memory_order_release);
+    return frames;
+}
+
+} // namespace WebCore
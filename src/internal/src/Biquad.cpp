@@ -27,15 +27,19 @@
  */
 
 #include "internal/Biquad.h"
+#include "internal/Assertions.h"
 #include "internal/DenormalDisabler.h"
 
 #include <WTF/MathExtras.h>
 
 #include <algorithm>
+#include <float.h>
 #include <stdio.h>
 
 #if OS(DARWIN)
 #include <Accelerate/Accelerate.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
 #endif
 
 using namespace std;
@@ -44,7 +48,23 @@ namespace WebCore {
 
 const int kBufferSize = 1024;
 
+#if !OS(DARWIN)
+
+namespace {
+
+// Denormal filter memory is flushed once per block rather than in the inner loops.
+// The state is kept in double precision, so it must not round trip through a float.
+inline double flushDenormalToZero(double value)
+{
+    return fabs(value) < FLT_MIN ? 0 : value;
+}
+
+} // namespace
+
+#endif
+
 Biquad::Biquad()
+    : m_precision(DoublePrecision)
 {
 #if OS(DARWIN)
     // Allocate two samples more for filter history
@@ -68,14 +88,17 @@ void Biquad::process(const float* sourceP, float* destP, size_t framesToProcess)
     // Use vecLib if available
     processFast(sourceP, destP, framesToProcess);
 #else
-    
-    int n = framesToProcess;
+
+    if (m_precision == SinglePrecision) {
+        processSinglePrecision(sourceP, destP, framesToProcess);
+        return;
+    }
+
+    size_t n = framesToProcess;
 
     // Create local copies of member variables
-    double x1 = m_x1;
-    double x2 = m_x2;
-    double y1 = m_y1;
-    double y2 = m_y2;
+    double s1 = m_s1;
+    double s2 = m_s2;
 
     double b0 = m_b0;
     double b1 = m_b1;
@@ -84,32 +107,237 @@ void Biquad::process(const float* sourceP, float* destP, size_t framesToProcess)
     double a2 = m_a2;
 
     while (n--) {
-        // FIXME: this can be optimized by pipelining the multiply adds...
+        double x = *sourceP++;
+        double y = b0 * x + s1;
+        s1 = b1 * x - a1 * y + s2;
+        s2 = b2 * x - a2 * y;
+
+        *destP++ = static_cast<float>(y);
+    }
+
+    // Local variables back to member. Flush denormals here so we
+    // don't slow down the inner loop above.
+    m_s1 = flushDenormalToZero(s1);
+    m_s2 = flushDenormalToZero(s2);
+#endif
+}
+
+#if !OS(DARWIN)
+
+void Biquad::processSinglePrecision(const float* sourceP, float* destP, size_t framesToProcess)
+{
+    size_t n = framesToProcess;
+
+    float s1 = static_cast<float>(m_s1);
+    float s2 = static_cast<float>(m_s2);
+
+    float b0 = static_cast<float>(m_b0);
+    float b1 = static_cast<float>(m_b1);
+    float b2 = static_cast<float>(m_b2);
+    float a1 = static_cast<float>(m_a1);
+    float a2 = static_cast<float>(m_a2);
+
+    while (n--) {
         float x = *sourceP++;
-        float y = b0*x + b1*x1 + b2*x2 - a1*y1 - a2*y2;
+        float y = b0 * x + s1;
+        s1 = b1 * x - a1 * y + s2;
+        s2 = b2 * x - a2 * y;
 
         *destP++ = y;
+    }
+
+    m_s1 = DenormalDisabler::flushDenormalFloatToZero(s1);
+    m_s2 = DenormalDisabler::flushDenormalFloatToZero(s2);
+}
+
+#ifdef __SSE2__
 
-        // Update state variables
-        x2 = x1;
-        x1 = x;
-        y2 = y1;
-        y1 = y;
+namespace {
+
+// Four channels in the four lanes of a vector. Four frames are loaded from each channel and
+// transposed so that each vector holds one frame of every channel, then the frames are filtered
+// one after another, and transposed back to be stored.
+void processFourChannelsSinglePrecision(const float* const* sourcesP, float* const* destsP,
+                                        const float (*coefficients)[5], float (*state)[2], size_t framesToProcess)
+{
+    __m128 b0 = _mm_setr_ps(coefficients[0][0], coefficients[1][0], coefficients[2][0], coefficients[3][0]);
+    __m128 b1 = _mm_setr_ps(coefficients[0][1], coefficients[1][1], coefficients[2][1], coefficients[3][1]);
+    __m128 b2 = _mm_setr_ps(coefficients[0][2], coefficients[1][2], coefficients[2][2], coefficients[3][2]);
+    __m128 a1 = _mm_setr_ps(coefficients[0][3], coefficients[1][3], coefficients[2][3], coefficients[3][3]);
+    __m128 a2 = _mm_setr_ps(coefficients[0][4], coefficients[1][4], coefficients[2][4], coefficients[3][4]);
+    __m128 s1 = _mm_setr_ps(state[0][0], state[1][0], state[2][0], state[3][0]);
+    __m128 s2 = _mm_setr_ps(state[0][1], state[1][1], state[2][1], state[3][1]);
+
+#define BIQUAD_LANES_STEP(x, y) \
+    y = _mm_add_ps(_mm_mul_ps(b0, x), s1); \
+    s1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), s2); \
+    s2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+
+    size_t i = 0;
+    for (; i + 4 <= framesToProcess; i += 4) {
+        __m128 x0 = _mm_loadu_ps(sourcesP[0] + i);
+        __m128 x1 = _mm_loadu_ps(sourcesP[1] + i);
+        __m128 x2 = _mm_loadu_ps(sourcesP[2] + i);
+        __m128 x3 = _mm_loadu_ps(sourcesP[3] + i);
+        _MM_TRANSPOSE4_PS(x0, x1, x2, x3);
+
+        __m128 y0, y1, y2, y3;
+        BIQUAD_LANES_STEP(x0, y0)
+        BIQUAD_LANES_STEP(x1, y1)
+        BIQUAD_LANES_STEP(x2, y2)
+        BIQUAD_LANES_STEP(x3, y3)
+
+        _MM_TRANSPOSE4_PS(y0, y1, y2, y3);
+        _mm_storeu_ps(destsP[0] + i, y0);
+        _mm_storeu_ps(destsP[1] + i, y1);
+        _mm_storeu_ps(destsP[2] + i, y2);
+        _mm_storeu_ps(destsP[3] + i, y3);
     }
 
-    // Local variables back to member. Flush denormals here so we
-    // don't slow down the inner loop above.
-    m_x1 = DenormalDisabler::flushDenormalFloatToZero(x1);
-    m_x2 = DenormalDisabler::flushDenormalFloatToZero(x2);
-    m_y1 = DenormalDisabler::flushDenormalFloatToZero(y1);
-    m_y2 = DenormalDisabler::flushDenormalFloatToZero(y2);
-
-    m_b0 = b0;
-    m_b1 = b1;
-    m_b2 = b2;
-    m_a1 = a1;
-    m_a2 = a2;
+    for (; i < framesToProcess; ++i) {
+        __m128 x = _mm_setr_ps(sourcesP[0][i], sourcesP[1][i], sourcesP[2][i], sourcesP[3][i]);
+        __m128 y;
+        BIQUAD_LANES_STEP(x, y)
+
+        float frame[4];
+        _mm_storeu_ps(frame, y);
+        for (unsigned c = 0; c < 4; ++c)
+            destsP[c][i] = frame[c];
+    }
+
+#undef BIQUAD_LANES_STEP
+
+    _mm_storeu_ps(state[0], _mm_unpacklo_ps(s1, s2));
+    _mm_storeu_ps(state[2], _mm_unpackhi_ps(s1, s2));
+}
+
+// Two channels in the two lanes of a double precision vector, two frames at a time.
+void processTwoChannelsDoublePrecision(const float* const* sourcesP, float* const* destsP,
+                                       const double (*coefficients)[5], double (*state)[2], size_t framesToProcess)
+{
+    __m128d b0 = _mm_setr_pd(coefficients[0][0], coefficients[1][0]);
+    __m128d b1 = _mm_setr_pd(coefficients[0][1], coefficients[1][1]);
+    __m128d b2 = _mm_setr_pd(coefficients[0][2], coefficients[1][2]);
+    __m128d a1 = _mm_setr_pd(coefficients[0][3], coefficients[1][3]);
+    __m128d a2 = _mm_setr_pd(coefficients[0][4], coefficients[1][4]);
+    __m128d s1 = _mm_setr_pd(state[0][0], state[1][0]);
+    __m128d s2 = _mm_setr_pd(state[0][1], state[1][1]);
+
+#define BIQUAD_LANES_STEP(x, y) \
+    y = _mm_add_pd(_mm_mul_pd(b0, x), s1); \
+    s1 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(b1, x), _mm_mul_pd(a1, y)), s2); \
+    s2 = _mm_sub_pd(_mm_mul_pd(b2, x), _mm_mul_pd(a2, y));
+
+    size_t i = 0;
+    for (; i + 2 <= framesToProcess; i += 2) {
+        // Each load brings two frames of one channel in as doubles.
+        __m128d c0 = _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(sourcesP[0] + i))));
+        __m128d c1 = _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(sourcesP[1] + i))));
+        __m128d x0 = _mm_unpacklo_pd(c0, c1);
+        __m128d x1 = _mm_unpackhi_pd(c0, c1);
+
+        __m128d y0, y1;
+        BIQUAD_LANES_STEP(x0, y0)
+        BIQUAD_LANES_STEP(x1, y1)
+
+        _mm_storel_pi(reinterpret_cast<__m64*>(destsP[0] + i), _mm_cvtpd_ps(_mm_unpacklo_pd(y0, y1)));
+        _mm_storel_pi(reinterpret_cast<__m64*>(destsP[1] + i), _mm_cvtpd_ps(_mm_unpackhi_pd(y0, y1)));
+    }
+
+    if (i < framesToProcess) {
+        __m128d x = _mm_setr_pd(sourcesP[0][i], sourcesP[1][i]);
+        __m128d y;
+        BIQUAD_LANES_STEP(x, y)
+
+        double frame[2];
+        _mm_storeu_pd(frame, y);
+        destsP[0][i] = static_cast<float>(frame[0]);
+        destsP[1][i] = static_cast<float>(frame[1]);
+    }
+
+#undef BIQUAD_LANES_STEP
+
+    _mm_storeu_pd(state[0], _mm_unpacklo_pd(s1, s2));
+    _mm_storeu_pd(state[1], _mm_unpackhi_pd(s1, s2));
+}
+
+} // namespace
+
+#endif // __SSE2__
+
+#endif // !OS(DARWIN)
+
+void Biquad::processChannels(Biquad* const* biquads, const float* const* sourcesP, float* const* destsP, unsigned numberOfChannels, size_t framesToProcess)
+{
+    unsigned c = 0;
+
+#if !OS(DARWIN) && defined(__SSE2__)
+    if (numberOfChannels > 1) {
+        ASSERT(biquads[0]);
+        Precision precision = biquads[0]->precision();
+
+        if (precision == SinglePrecision) {
+            for (; c + 4 <= numberOfChannels; c += 4) {
+                float coefficients[4][5];
+                float state[4][2];
+                for (unsigned lane = 0; lane < 4; ++lane) {
+                    const Biquad* biquad = biquads[c + lane];
+                    ASSERT(biquad->precision() == precision);
+                    coefficients[lane][0] = static_cast<float>(biquad->m_b0);
+                    coefficients[lane][1] = static_cast<float>(biquad->m_b1);
+                    coefficients[lane][2] = static_cast<float>(biquad->m_b2);
+                    coefficients[lane][3] = static_cast<float>(biquad->m_a1);
+                    coefficients[lane][4] = static_cast<float>(biquad->m_a2);
+                    state[lane][0] = static_cast<float>(biquad->m_s1);
+                    state[lane][1] = static_cast<float>(biquad->m_s2);
+                }
+
+                processFourChannelsSinglePrecision(sourcesP + c, destsP + c, coefficients, state, framesToProcess);
+
+                for (unsigned lane = 0; lane < 4; ++lane) {
+                    biquads[c + lane]->m_s1 = DenormalDisabler::flushDenormalFloatToZero(state[lane][0]);
+                    biquads[c + lane]->m_s2 = DenormalDisabler::flushDenormalFloatToZero(state[lane][1]);
+                }
+            }
+        } else {
+            for (; c + 2 <= numberOfChannels; c += 2) {
+                double coefficients[2][5];
+                double state[2][2];
+                for (unsigned lane = 0; lane < 2; ++lane) {
+                    const Biquad* biquad = biquads[c + lane];
+                    ASSERT(biquad->precision() == precision);
+                    coefficients[lane][0] = biquad->m_b0;
+                    coefficients[lane][1] = biquad->m_b1;
+                    coefficients[lane][2] = biquad->m_b2;
+                    coefficients[lane][3] = biquad->m_a1;
+                    coefficients[lane][4] = biquad->m_a2;
+                    state[lane][0] = biquad->m_s1;
+                    state[lane][1] = biquad->m_s2;
+                }
+
+                processTwoChannelsDoublePrecision(sourcesP + c, destsP + c, coefficients, state, framesToProcess);
+
+                for (unsigned lane = 0; lane < 2; ++lane) {
+                    biquads[c + lane]->m_s1 = flushDenormalToZero(state[lane][0]);
+                    biquads[c + lane]->m_s2 = flushDenormalToZero(state[lane][1]);
+                }
+            }
+        }
+    }
 #endif
+
+    // Whatever is left over, and everything where there are no lanes to run them in, one at a time.
+    for (; c < numberOfChannels; ++c)
+        biquads[c]->process(sourcesP[c], destsP[c], framesToProcess);
+}
+
+void Biquad::copyCoefficientsFrom(const Biquad& other)
+{
+    m_b0 = other.m_b0;
+    m_b1 = other.m_b1;
+    m_b2 = other.m_b2;
+    m_a1 = other.m_a1;
+    m_a2 = other.m_a2;
 }
 
 #if OS(DARWIN)
@@ -182,7 +410,7 @@ void Biquad::reset()
     outputP[1] = 0;
 
 #else
-    m_x1 = m_x2 = m_y1 = m_y2 = 0;
+    m_s1 = m_s2 = 0;
 #endif
 }
 
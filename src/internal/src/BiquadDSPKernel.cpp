@@ -111,15 +111,20 @@ void BiquadDSPKernel::process(ContextRenderLock& r, const float* source, float*
 {
     ASSERT(source && destination && biquadProcessor());
     
-    // Recompute filter coefficients if any of the parameters have changed.
-    // FIXME: as an optimization, implement a way that a Biquad object can simply copy its internal filter coefficients from another Biquad object.
-    // Then re-factor this code to only run for the first BiquadDSPKernel of each BiquadProcessor.
-
-    updateCoefficientsIfNecessary(r, true, false);
+    updateCoefficients(r, nullptr);
 
     m_biquad.process(source, destination, framesToProcess);
 }
 
+void BiquadDSPKernel::updateCoefficients(ContextRenderLock& r, const BiquadDSPKernel* updatedKernel)
+{
+    if (updatedKernel) {
+        if (biquadProcessor()->filterCoefficientsDirty())
+            m_biquad.copyCoefficientsFrom(updatedKernel->m_biquad);
+    } else
+        updateCoefficientsIfNecessary(r, true, false);
+}
+
 void BiquadDSPKernel::getFrequencyResponse(ContextRenderLock& r,
                                            int nFrequencies,
                                            const float* frequencyHz,
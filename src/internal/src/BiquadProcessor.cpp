@@ -25,6 +25,10 @@
 #include "internal/BiquadProcessor.h"
 #include "internal/BiquadDSPKernel.h"
 
+#include "LabSound/core/AudioContext.h"
+
+#include <algorithm>
+
 namespace WebCore {
     
 BiquadProcessor::BiquadProcessor(float sampleRate, size_t numberOfChannels, bool autoInitialize)
@@ -96,11 +100,28 @@ void BiquadProcessor::process(ContextRenderLock& r, const AudioBus* source, Audi
     }
         
     checkForDirtyCoefficients(r);
-            
-    // For each channel of our input, process using the corresponding BiquadDSPKernel into the output channel.
-    for (unsigned i = 0; i < m_kernels.size(); ++i) {
-        m_kernels[i]->process(r, source->channel(i)->data(), destination->channel(i)->mutableData(), framesToProcess);
+
+    unsigned numberOfChannels = std::min(static_cast<unsigned>(m_kernels.size()), AudioContext::maxNumberOfChannels);
+    if (!numberOfChannels)
+        return;
+
+    // The coefficients only depend on the parameters, so the first kernel computes them and the
+    // others copy them. Then all of the channels are filtered together by the corresponding kernels.
+    Biquad* biquads[AudioContext::maxNumberOfChannels];
+    const float* sources[AudioContext::maxNumberOfChannels];
+    float* destinations[AudioContext::maxNumberOfChannels];
+
+    BiquadDSPKernel* firstKernel = static_cast<BiquadDSPKernel*>(m_kernels[0].get());
+    for (unsigned i = 0; i < numberOfChannels; ++i) {
+        BiquadDSPKernel* kernel = static_cast<BiquadDSPKernel*>(m_kernels[i].get());
+        kernel->updateCoefficients(r, i ? firstKernel : nullptr);
+
+        biquads[i] = &kernel->biquad();
+        sources[i] = source->channel(i)->data();
+        destinations[i] = destination->channel(i)->mutableData();
     }
+
+    Biquad::processChannels(biquads, sources, destinations, numberOfChannels, framesToProcess);
 }
 
 void BiquadProcessor::setType(FilterType type)
@@ -0,0 +1,298 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#include "internal/BufferResampler.h"
+#include "internal/Assertions.h"
+
+#include <WTF/MathExtras.h>
+
+#include <algorithm>
+#include <math.h>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace WebCore {
+
+namespace BufferResampler {
+
+namespace {
+
+// Frames whose positions and weights are worked out together before the channels are rendered.
+const size_t ChunkSize = 128;
+
+// The windowed sinc reads SincTaps frames, from SincTaps / 2 - 1 before a position to SincTaps / 2 after it.
+// Its coefficients are tabulated at SincPhases fractional positions per frame and interpolated between.
+const int SincTaps = 16;
+const int SincPhases = 256;
+const int SincBefore = SincTaps / 2 - 1;
+
+// The frames either side of a position that an interpolation reads.
+void reach(InterpolationMode mode, int& before, int& after)
+{
+    switch (mode) {
+    case InterpolationMode::CUBIC:
+        before = 1;
+        after = 2;
+        break;
+    case InterpolationMode::SINC:
+        before = SincBefore;
+        after = SincTaps / 2;
+        break;
+    case InterpolationMode::LINEAR:
+    default:
+        before = 0;
+        after = 1;
+        break;
+    }
+}
+
+// Blackman windowed sinc, one row of SincTaps coefficients per phase. The extra last row is
+// the first row shifted along by a frame, so a fraction just below one interpolates correctly.
+class SincTable
+{
+public:
+    SincTable()
+        : m_coefficients((SincPhases + 1) * SincTaps)
+    {
+        const double halfWidth = SincTaps / 2;
+
+        for (int phase = 0; phase <= SincPhases; ++phase) {
+            double fraction = static_cast<double>(phase) / SincPhases;
+            float* row = &m_coefficients[phase * SincTaps];
+
+            double sum = 0;
+            for (int j = 0; j < SincTaps; ++j) {
+                double t = (j - SincBefore) - fraction;
+                double x = t / halfWidth;
+                double window = fabs(x) < 1 ? 0.42 + 0.5 * cos(piDouble * x) + 0.08 * cos(2 * piDouble * x) : 0;
+                double sinc = t ? sin(piDouble * t) / (piDouble * t) : 1;
+                row[j] = static_cast<float>(window * sinc);
+                sum += row[j];
+            }
+
+            // Unity gain at DC for every phase.
+            for (int j = 0; j < SincTaps; ++j)
+                row[j] = static_cast<float>(row[j] / sum);
+        }
+    }
+
+    const float* row(int phase) const { return &m_coefficients[phase * SincTaps]; }
+
+private:
+    std::vector<float> m_coefficients;
+};
+
+const SincTable& sincTable()
+{
+    static SincTable table;
+    return table;
+}
+
+// The coefficients for a fractional position, interpolated between the two nearest phases.
+void sincWeights(const SincTable& table, float fraction, float* weights)
+{
+    float phase = fraction * SincPhases;
+    int row = std::min(static_cast<int>(phase), SincPhases - 1);
+    float blend = phase - row;
+
+    const float* lower = table.row(row);
+    const float* upper = table.row(row + 1);
+    for (int j = 0; j < SincTaps; ++j)
+        weights[j] = lower[j] + blend * (upper[j] - lower[j]);
+}
+
+// x points at the frame at or before the position; the frames around it must be readable.
+inline float interpolate(InterpolationMode mode, const float* x, float fraction, const float* weights)
+{
+    switch (mode) {
+    case InterpolationMode::CUBIC: {
+        float c1 = 0.5f * (x[1] - x[-1]);
+        float c2 = x[-1] - 2.5f * x[0] + 2 * x[1] - 0.5f * x[2];
+        float c3 = 0.5f * (x[2] - x[-1]) + 1.5f * (x[0] - x[1]);
+        return ((c3 * fraction + c2) * fraction + c1) * fraction + x[0];
+    }
+    case InterpolationMode::SINC: {
+        const float* taps = x - SincBefore;
+        float sum = 0;
+        for (int j = 0; j < SincTaps; ++j)
+            sum += weights[j] * taps[j];
+        return sum;
+    }
+    case InterpolationMode::LINEAR:
+    default:
+        return x[0] + fraction * (x[1] - x[0]);
+    }
+}
+
+// Applies the source's edge rules to a frame index outside of the source.
+inline float sampleAt(const ResamplerSource& source, const float* data, ptrdiff_t index)
+{
+    ptrdiff_t length = static_cast<ptrdiff_t>(source.length);
+
+    if (index >= length && source.loop && source.loopDeltaFrames >= 1) {
+        while (index >= length)
+            index = static_cast<ptrdiff_t>(floor(index - source.loopDeltaFrames));
+    }
+
+    index = std::max<ptrdiff_t>(0, std::min(index, length - 1));
+    return data[index];
+}
+
+void renderLinear(const float* sourceP, const ptrdiff_t* indices, const float* fractions, float* destP, size_t framesToProcess)
+{
+    size_t k = 0;
+
+#ifdef __SSE2__
+    for (; k + 4 <= framesToProcess; k += 4) {
+        const ptrdiff_t* i = indices + k;
+        __m128 x0 = _mm_setr_ps(sourceP[i[0]], sourceP[i[1]], sourceP[i[2]], sourceP[i[3]]);
+        __m128 x1 = _mm_setr_ps(sourceP[i[0] + 1], sourceP[i[1] + 1], sourceP[i[2] + 1], sourceP[i[3] + 1]);
+        __m128 f = _mm_loadu_ps(fractions + k);
+        _mm_storeu_ps(destP + k, _mm_add_ps(x0, _mm_mul_ps(f, _mm_sub_ps(x1, x0))));
+    }
+#endif
+
+    for (; k < framesToProcess; ++k)
+        destP[k] = interpolate(InterpolationMode::LINEAR, sourceP + indices[k], fractions[k], 0);
+}
+
+void renderCubic(const float* sourceP, const ptrdiff_t* indices, const float* fractions, float* destP, size_t framesToProcess)
+{
+    size_t k = 0;
+
+#ifdef __SSE2__
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 oneAndHalf = _mm_set1_ps(1.5f);
+    const __m128 two = _mm_set1_ps(2);
+    const __m128 twoAndHalf = _mm_set1_ps(2.5f);
+
+    for (; k + 4 <= framesToProcess; k += 4) {
+        const ptrdiff_t* i = indices + k;
+        __m128 xm1 = _mm_setr_ps(sourceP[i[0] - 1], sourceP[i[1] - 1], sourceP[i[2] - 1], sourceP[i[3] - 1]);
+        __m128 x0 = _mm_setr_ps(sourceP[i[0]], sourceP[i[1]], sourceP[i[2]], sourceP[i[3]]);
+        __m128 x1 = _mm_setr_ps(sourceP[i[0] + 1], sourceP[i[1] + 1], sourceP[i[2] + 1], sourceP[i[3] + 1]);
+        __m128 x2 = _mm_setr_ps(sourceP[i[0] + 2], sourceP[i[1] + 2], sourceP[i[2] + 2], sourceP[i[3] + 2]);
+        __m128 f = _mm_loadu_ps(fractions + k);
+
+        __m128 c1 = _mm_mul_ps(half, _mm_sub_ps(x1, xm1));
+        __m128 c2 = _mm_sub_ps(_mm_add_ps(xm1, _mm_mul_ps(two, x1)), _mm_add_ps(_mm_mul_ps(twoAndHalf, x0), _mm_mul_ps(half, x2)));
+        __m128 c3 = _mm_add_ps(_mm_mul_ps(half, _mm_sub_ps(x2, xm1)), _mm_mul_ps(oneAndHalf, _mm_sub_ps(x0, x1)));
+
+        __m128 y = _mm_add_ps(_mm_mul_ps(c3, f), c2);
+        y = _mm_add_ps(_mm_mul_ps(y, f), c1);
+        y = _mm_add_ps(_mm_mul_ps(y, f), x0);
+        _mm_storeu_ps(destP + k, y);
+    }
+#endif
+
+    for (; k < framesToProcess; ++k)
+        destP[k] = interpolate(InterpolationMode::CUBIC, sourceP + indices[k], fractions[k], 0);
+}
+
+void renderSinc(const float* sourceP, const ptrdiff_t* indices, const float (*weights)[SincTaps], float* destP, size_t framesToProcess)
+{
+    for (size_t k = 0; k < framesToProcess; ++k) {
+        const float* taps = sourceP + indices[k] - SincBefore;
+        const float* w = weights[k];
+
+#ifdef __SSE2__
+        __m128 sum = _mm_mul_ps(_mm_loadu_ps(w), _mm_loadu_ps(taps));
+        for (int j = 4; j < SincTaps; j += 4)
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(w + j), _mm_loadu_ps(taps + j)));
+
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        destP[k] = _mm_cvtss_f32(sum);
+#else
+        destP[k] = interpolate(InterpolationMode::SINC, taps + SincBefore, 0, w);
+#endif
+    }
+}
+
+} // namespace
+
+void render(InterpolationMode mode, const ResamplerSource& source, double position, double rate, float* const* destinations, size_t writeIndex, size_t framesToProcess)
+{
+    ASSERT(rate > 0);
+    ASSERT(source.length);
+
+    int before;
+    int after;
+    reach(mode, before, after);
+
+    const ptrdiff_t length = static_cast<ptrdiff_t>(source.length);
+    const SincTable* table = mode == InterpolationMode::SINC ? &sincTable() : 0;
+
+    ptrdiff_t indices[ChunkSize];
+    float fractions[ChunkSize];
+    float weights[ChunkSize][SincTaps];
+
+    for (size_t done = 0; done < framesToProcess; done += ChunkSize) {
+        size_t chunk = std::min(ChunkSize, framesToProcess - done);
+
+        for (size_t k = 0; k < chunk; ++k) {
+            double p = position + static_cast<double>(done + k) * rate;
+            double whole = floor(p);
+            indices[k] = static_cast<ptrdiff_t>(whole);
+            fractions[k] = static_cast<float>(p - whole);
+        }
+
+        if (table) {
+            for (size_t k = 0; k < chunk; ++k)
+                sincWeights(*table, fractions[k], weights[k]);
+        }
+
+        // The positions only increase, so the frames that can read the source directly form one run,
+        // and only the frames before and after it need the edge rules.
+        size_t begin = 0;
+        while (begin < chunk && indices[begin] - before < 0)
+            ++begin;
+        size_t end = chunk;
+        while (end > begin && indices[end - 1] + after >= length)
+            --end;
+
+        for (unsigned c = 0; c < source.numberOfChannels; ++c) {
+            const float* sourceP = source.channels[c];
+            float* destP = destinations[c] + writeIndex + done;
+
+            switch (mode) {
+            case InterpolationMode::CUBIC:
+                renderCubic(sourceP, indices + begin, fractions + begin, destP + begin, end - begin);
+                break;
+            case InterpolationMode::SINC:
+                renderSinc(sourceP, indices + begin, weights + begin, destP + begin, end - begin);
+                break;
+            case InterpolationMode::LINEAR:
+            default:
+                renderLinear(sourceP, indices + begin, fractions + begin, destP + begin, end - begin);
+                break;
+            }
+
+            for (size_t k = 0; k < chunk; ++k) {
+                if (k == begin)
+                    k = end;
+                if (k == chunk)
+                    break;
+
+                float taps[SincTaps];
+                for (int t = -before; t <= after; ++t)
+                    taps[before + t] = sampleAt(source, sourceP, indices[k] + t);
+
+                destP[k] = interpolate(mode, taps + before, fractions[k], weights[k]);
+            }
+        }
+    }
+}
+
+void prepare(InterpolationMode mode)
+{
+    if (mode == InterpolationMode::SINC)
+        sincTable();
+}
+
+} // namespace BufferResampler
+
+} // namespace WebCore
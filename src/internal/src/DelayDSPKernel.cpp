@@ -27,18 +27,25 @@
 #include "internal/DelayDSPKernel.h"
 #include "internal/AudioUtilities.h"
 #include "internal/Assertions.h"
+#include "internal/VectorMath.h"
 
 #include <algorithm>
+#include <math.h>
 
 using namespace std;
 
 namespace WebCore {
 
+using namespace VectorMath;
+
 const float SmoothingTimeConstant = 0.020f; // 20ms
 
+// Once the smoothed delay is this close to the desired one, in frames, it snaps to it, so that the
+// delay is constant over the quantum and the delay line can take its fast path.
+const double SmoothingSnapFrames = 1e-4;
+
 DelayDSPKernel::DelayDSPKernel(DelayProcessor* processor)
     : AudioDSPKernel(processor)
-    , m_writeIndex(0)
     , m_firstTime(true)
     , m_delayTimes(AudioNode::ProcessingSizeInFrames)
 {
@@ -51,8 +58,7 @@ DelayDSPKernel::DelayDSPKernel(DelayProcessor* processor)
     if (m_maxDelayTime < 0)
         return;
 
-    m_buffer.allocate(bufferLengthForDelay(m_maxDelayTime, processor->sampleRate()));
-    m_buffer.zero();
+    m_delayLine.allocate(maxDelayFrames(m_maxDelayTime, processor->sampleRate()), AudioNode::ProcessingSizeInFrames);
 
     m_smoothingRate = AudioUtilities::discreteTimeConstantForSampleRate(SmoothingTimeConstant, processor->sampleRate());
 }
@@ -60,105 +66,89 @@ DelayDSPKernel::DelayDSPKernel(DelayProcessor* processor)
 DelayDSPKernel::DelayDSPKernel(double maxDelayTime, float sampleRate)
     : AudioDSPKernel(sampleRate)
     , m_maxDelayTime(maxDelayTime)
-    , m_writeIndex(0)
     , m_firstTime(true)
+    , m_delayTimes(AudioNode::ProcessingSizeInFrames)
 {
     ASSERT(maxDelayTime > 0.0);
     if (maxDelayTime <= 0.0)
         return;
 
-    size_t bufferLength = bufferLengthForDelay(maxDelayTime, sampleRate);
-    ASSERT(bufferLength);
-    if (!bufferLength)
-        return;
-
-    m_buffer.allocate(bufferLength);
-    m_buffer.zero();
+    m_delayLine.allocate(maxDelayFrames(maxDelayTime, sampleRate), AudioNode::ProcessingSizeInFrames);
 
     m_smoothingRate = AudioUtilities::discreteTimeConstantForSampleRate(SmoothingTimeConstant, sampleRate);
 }
 
-size_t DelayDSPKernel::bufferLengthForDelay(double maxDelayTime, double sampleRate) const
+size_t DelayDSPKernel::maxDelayFrames(double maxDelayTime, double sampleRate) const
 {
-    // Compute the length of the buffer needed to handle a max delay of |maxDelayTime|. One is
-    // added to handle the case where the actual delay equals the maximum delay.
-    return 1 + AudioUtilities::timeToSampleFrame(maxDelayTime, sampleRate);
+    // Rounded up, so that the maximum delay time is always within reach.
+    return static_cast<size_t>(ceil(maxDelayTime * sampleRate));
 }
 
 void DelayDSPKernel::process(ContextRenderLock& r, const float* source, float* destination, size_t framesToProcess)
 {
-    size_t bufferLength = m_buffer.size();
-    float* buffer = m_buffer.data();
-
-    ASSERT(bufferLength);
-    if (!bufferLength)
+    ASSERT(m_delayLine.maxFramesPerBlock());
+    if (!m_delayLine.maxFramesPerBlock())
         return;
 
     ASSERT(source && destination);
     if (!source || !destination)
         return;
 
+    ASSERT(framesToProcess <= m_delayTimes.size());
+    framesToProcess = min(framesToProcess, m_delayTimes.size());
+
     float sampleRate = this->sampleRate();
-    double delayTime = 0;
     float* delayTimes = m_delayTimes.data();
     double maxTime = maxDelayTime();
+    DelayProcessor* processor = delayProcessor();
 
-    bool sampleAccurate = delayProcessor() && delayProcessor()->delayTime()->hasSampleAccurateValues();
+    if (processor)
+        m_delayLine.setInterpolation(processor->interpolation());
 
-    if (sampleAccurate)
-        delayProcessor()->delayTime()->calculateSampleAccurateValues(r, delayTimes, framesToProcess);
-    else {
-        delayTime = delayProcessor() ? delayProcessor()->delayTime()->finalValue(r) : m_desiredDelayFrames / sampleRate;
+    if (processor && processor->delayTime()->hasSampleAccurateValues()) {
+        processor->delayTime()->calculateSampleAccurateValues(r, delayTimes, framesToProcess);
 
-        // Make sure the delay time is in a valid range.
-        delayTime = min(maxTime, delayTime);
-        delayTime = max(0.0, delayTime);
+        // Make sure the delay times are in a valid range, then convert them to frames.
+        const float lowest = 0;
+        const float highest = static_cast<float>(maxTime);
+        vclip(delayTimes, 1, &lowest, &highest, delayTimes, 1, framesToProcess);
+        m_currentDelayTime = delayTimes[framesToProcess - 1];
+        vsmul(delayTimes, 1, &sampleRate, delayTimes, 1, framesToProcess);
 
-        if (m_firstTime) {
-            m_currentDelayTime = delayTime;
-            m_firstTime = false;
-        }
+        m_delayLine.process(source, destination, framesToProcess, delayTimes);
+        return;
     }
 
-    for (unsigned i = 0; i < framesToProcess; ++i) {
-        if (sampleAccurate) {
-            delayTime = delayTimes[i];
-            delayTime = std::min(maxTime, delayTime);
-            delayTime = std::max(0.0, delayTime);
-            m_currentDelayTime = delayTime;
-        } else {
-            // Approach desired delay time.
-            m_currentDelayTime += (delayTime - m_currentDelayTime) * m_smoothingRate;
-        }
+    double delayTime = processor ? processor->delayTime()->finalValue(r) : m_desiredDelayFrames / sampleRate;
 
-        double desiredDelayFrames = m_currentDelayTime * sampleRate;
+    // Make sure the delay time is in a valid range.
+    delayTime = min(maxTime, delayTime);
+    delayTime = max(0.0, delayTime);
 
-        double readPosition = m_writeIndex + bufferLength - desiredDelayFrames;
-        if (readPosition >= bufferLength)
-            readPosition -= bufferLength;
-
-        // Linearly interpolate in-between delay times.
-        int readIndex1 = static_cast<int>(readPosition);
-        int readIndex2 = (readIndex1 + 1) % bufferLength;
-        double interpolationFactor = readPosition - readIndex1;
-
-        double input = static_cast<float>(*source++);
-        buffer[m_writeIndex] = static_cast<float>(input);
-        m_writeIndex = (m_writeIndex + 1) % bufferLength;
-
-        double sample1 = buffer[readIndex1];
-        double sample2 = buffer[readIndex2];
+    if (m_firstTime) {
+        m_currentDelayTime = delayTime;
+        m_firstTime = false;
+    }
 
-        double output = (1.0 - interpolationFactor) * sample1 + interpolationFactor * sample2;
+    if (fabs(delayTime - m_currentDelayTime) * sampleRate < SmoothingSnapFrames) {
+        m_currentDelayTime = delayTime;
+        m_delayLine.process(source, destination, framesToProcess, delayTime * sampleRate);
+        return;
+    }
 
-        *destination++ = static_cast<float>(output);
+    for (size_t i = 0; i < framesToProcess; ++i) {
+        // Approach desired delay time.
+        m_currentDelayTime += (delayTime - m_currentDelayTime) * m_smoothingRate;
+        delayTimes[i] = static_cast<float>(m_currentDelayTime * sampleRate);
     }
+
+    m_delayLine.process(source, destination, framesToProcess, delayTimes);
 }
 
 void DelayDSPKernel::reset()
 {
     m_firstTime = true;
-    m_buffer.zero();
+    m_delayLine.reset();
 }
 
 double DelayDSPKernel::tailTime() const
@@ -0,0 +1,387 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#include "internal/DelayLine.h"
+#include "internal/Assertions.h"
+#include "internal/VectorMath.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace WebCore {
+
+using namespace VectorMath;
+
+namespace {
+
+// Reads at a position between x0 and x1, f of the way to x1. The allpass interpolator is recursive, so
+// it carries its previous output along; its coefficient is (1 - d) / (1 + d) for the fractional delay d.
+inline float interpolate(DelayInterpolation mode, float xm1, float x0, float x1, float x2, float f, float& allpassState)
+{
+    switch (mode) {
+    case DelayInterpolation::ALLPASS: {
+        float eta = f / (2 - f);
+        allpassState = eta * (x1 - allpassState) + x0;
+        return allpassState;
+    }
+    case DelayInterpolation::CUBIC: {
+        float c1 = 0.5f * (x1 - xm1);
+        float c2 = xm1 - 2.5f * x0 + 2 * x1 - 0.5f * x2;
+        float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+        return ((c3 * f + c2) * f + c1) * f + x0;
+    }
+    case DelayInterpolation::LINEAR:
+    default:
+        return x0 + f * (x1 - x0);
+    }
+}
+
+// The readers below take frame i from the window at position offset + i - delays[i], which is at
+// least 1 and leaves two frames to spare at the end of the window.
+
+void readLinear(const float* window, float offset, const float* delays, float* destP, size_t framesToProcess)
+{
+    size_t k = 0;
+
+#ifdef __SSE2__
+    const __m128 step = _mm_set1_ps(4);
+    __m128 base = _mm_setr_ps(offset, offset + 1, offset + 2, offset + 3);
+    int i[4];
+
+    for (; k + 4 <= framesToProcess; k += 4) {
+        __m128 p = _mm_sub_ps(base, _mm_loadu_ps(delays + k));
+        __m128i index = _mm_cvttps_epi32(p);
+        __m128 f = _mm_sub_ps(p, _mm_cvtepi32_ps(index));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(i), index);
+
+        __m128 x0 = _mm_setr_ps(window[i[0]], window[i[1]], window[i[2]], window[i[3]]);
+        __m128 x1 = _mm_setr_ps(window[i[0] + 1], window[i[1] + 1], window[i[2] + 1], window[i[3] + 1]);
+        _mm_storeu_ps(destP + k, _mm_add_ps(x0, _mm_mul_ps(f, _mm_sub_ps(x1, x0))));
+        base = _mm_add_ps(base, step);
+    }
+#endif
+
+    for (; k < framesToProcess; ++k) {
+        float p = offset + k - delays[k];
+        int i = static_cast<int>(p);
+        float f = p - i;
+        destP[k] = window[i] + f * (window[i + 1] - window[i]);
+    }
+}
+
+void readCubic(const float* window, float offset, const float* delays, float* destP, size_t framesToProcess)
+{
+    size_t k = 0;
+
+#ifdef __SSE2__
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 oneAndHalf = _mm_set1_ps(1.5f);
+    const __m128 two = _mm_set1_ps(2);
+    const __m128 twoAndHalf = _mm_set1_ps(2.5f);
+    const __m128 step = _mm_set1_ps(4);
+    __m128 base = _mm_setr_ps(offset, offset + 1, offset + 2, offset + 3);
+    int i[4];
+
+    for (; k + 4 <= framesToProcess; k += 4) {
+        __m128 p = _mm_sub_ps(base, _mm_loadu_ps(delays + k));
+        __m128i index = _mm_cvttps_epi32(p);
+        __m128 f = _mm_sub_ps(p, _mm_cvtepi32_ps(index));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(i), index);
+
+        __m128 xm1 = _mm_setr_ps(window[i[0] - 1], window[i[1] - 1], window[i[2] - 1], window[i[3] - 1]);
+        __m128 x0 = _mm_setr_ps(window[i[0]], window[i[1]], window[i[2]], window[i[3]]);
+        __m128 x1 = _mm_setr_ps(window[i[0] + 1], window[i[1] + 1], window[i[2] + 1], window[i[3] + 1]);
+        __m128 x2 = _mm_setr_ps(window[i[0] + 2], window[i[1] + 2], window[i[2] + 2], window[i[3] + 2]);
+
+        __m128 c1 = _mm_mul_ps(half, _mm_sub_ps(x1, xm1));
+        __m128 c2 = _mm_sub_ps(_mm_add_ps(xm1, _mm_mul_ps(two, x1)), _mm_add_ps(_mm_mul_ps(twoAndHalf, x0), _mm_mul_ps(half, x2)));
+        __m128 c3 = _mm_add_ps(_mm_mul_ps(half, _mm_sub_ps(x2, xm1)), _mm_mul_ps(oneAndHalf, _mm_sub_ps(x0, x1)));
+
+        __m128 y = _mm_add_ps(_mm_mul_ps(c3, f), c2);
+        y = _mm_add_ps(_mm_mul_ps(y, f), c1);
+        y = _mm_add_ps(_mm_mul_ps(y, f), x0);
+        _mm_storeu_ps(destP + k, y);
+        base = _mm_add_ps(base, step);
+    }
+#endif
+
+    float unused = 0;
+    for (; k < framesToProcess; ++k) {
+        float p = offset + k - delays[k];
+        int i = static_cast<int>(p);
+        destP[k] = interpolate(DelayInterpolation::CUBIC, window[i - 1], window[i], window[i + 1], window[i + 2], p - i, unused);
+    }
+}
+
+void readAllpass(const float* window, float offset, const float* delays, float* destP, size_t framesToProcess, float& allpassState)
+{
+    for (size_t k = 0; k < framesToProcess; ++k) {
+        float p = offset + k - delays[k];
+        int i = static_cast<int>(p);
+        destP[k] = interpolate(DelayInterpolation::ALLPASS, 0, window[i], window[i + 1], 0, p - i, allpassState);
+    }
+}
+
+} // namespace
+
+DelayLine::DelayLine()
+    : m_mask(0)
+    , m_writeIndex(0)
+    , m_maxDelayFrames(0)
+    , m_maxFramesPerBlock(0)
+    , m_interpolation(DelayInterpolation::LINEAR)
+    , m_allpassState(0)
+{
+}
+
+DelayLine::DelayLine(size_t maxDelayFrames, size_t maxFramesPerBlock)
+    : DelayLine()
+{
+    allocate(maxDelayFrames, maxFramesPerBlock);
+}
+
+DelayLine::~DelayLine()
+{
+}
+
+void DelayLine::allocate(size_t maxDelayFrames, size_t maxFramesPerBlock)
+{
+    ASSERT(maxFramesPerBlock > 0);
+
+    m_maxDelayFrames = maxDelayFrames;
+    m_maxFramesPerBlock = std::max<size_t>(maxFramesPerBlock, 1);
+
+    // The oldest frame ever read is maxDelayFrames + 1 before the start of a block just written, for the
+    // frame before it that the cubic interpolator reads.
+    size_t size = 2;
+    while (size < m_maxDelayFrames + m_maxFramesPerBlock + 2)
+        size <<= 1;
+
+    m_buffer.allocate(size);
+    m_mask = size - 1;
+
+    // A varying delay that spans more than this in one block is read straight from the history instead.
+    m_window.allocate(2 * m_maxFramesPerBlock + 8);
+    m_delays.allocate(m_maxFramesPerBlock);
+
+    reset();
+}
+
+void DelayLine::reset()
+{
+    m_buffer.zero();
+    m_writeIndex = 0;
+    m_allpassState = 0;
+}
+
+void DelayLine::write(const float* source, size_t framesToProcess)
+{
+    float* buffer = m_buffer.data();
+    size_t size = m_buffer.size();
+
+    while (framesToProcess) {
+        size_t n = std::min(framesToProcess, size - m_writeIndex);
+        memcpy(buffer + m_writeIndex, source, n * sizeof(float));
+        m_writeIndex = (m_writeIndex + n) & m_mask;
+        source += n;
+        framesToProcess -= n;
+    }
+}
+
+void DelayLine::gather(ptrdiff_t first, ptrdiff_t last, float* window)
+{
+    ASSERT(first < 0);
+
+    const float* buffer = m_buffer.data();
+    size_t size = m_buffer.size();
+
+    size_t count = static_cast<size_t>(last - first + 1);
+    size_t available = static_cast<size_t>(std::min<ptrdiff_t>(last, -1) - first + 1);
+
+    size_t start = (m_writeIndex + first) & m_mask;
+    size_t head = std::min(available, size - start);
+    memcpy(window, buffer + start, head * sizeof(float));
+    memcpy(window + head, buffer, (available - head) * sizeof(float));
+
+    std::fill(window + available, window + count, window[available - 1]);
+}
+
+void DelayLine::process(const float* source, float* destination, size_t framesToProcess, double delayFrames)
+{
+    ASSERT(m_buffer.size());
+
+    while (framesToProcess) {
+        size_t n = std::min(framesToProcess, m_maxFramesPerBlock);
+        write(source, n);
+        readConstant(destination, n, -static_cast<ptrdiff_t>(n), delayFrames, m_allpassState);
+
+        source += n;
+        destination += n;
+        framesToProcess -= n;
+    }
+}
+
+void DelayLine::process(const float* source, float* destination, size_t framesToProcess, const float* delayFrames)
+{
+    ASSERT(m_buffer.size());
+
+    while (framesToProcess) {
+        size_t n = std::min(framesToProcess, m_maxFramesPerBlock);
+        write(source, n);
+        readVarying(destination, n, -static_cast<ptrdiff_t>(n), delayFrames, m_allpassState);
+
+        source += n;
+        destination += n;
+        delayFrames += n;
+        framesToProcess -= n;
+    }
+}
+
+void DelayLine::read(float* destination, size_t framesToProcess, double delayFrames, float& allpassState)
+{
+    ASSERT(m_buffer.size());
+
+    ptrdiff_t origin = -static_cast<ptrdiff_t>(framesToProcess);
+    while (framesToProcess) {
+        size_t n = std::min(framesToProcess, m_maxFramesPerBlock);
+        readConstant(destination, n, origin, delayFrames, allpassState);
+
+        origin += n;
+        destination += n;
+        framesToProcess -= n;
+    }
+}
+
+void DelayLine::readAhead(float* destination, size_t framesToProcess, double delayFrames, float& allpassState)
+{
+    ASSERT(m_buffer.size());
+
+    ptrdiff_t origin = 0;
+    while (framesToProcess) {
+        size_t n = std::min(framesToProcess, m_maxFramesPerBlock);
+        readConstant(destination, n, origin, delayFrames, allpassState);
+
+        origin += n;
+        destination += n;
+        framesToProcess -= n;
+    }
+}
+
+void DelayLine::readConstant(float* destination, size_t framesToProcess, ptrdiff_t origin, double delayFrames, float& allpassState)
+{
+    delayFrames = std::min(std::max(delayFrames, 0.0), static_cast<double>(m_maxDelayFrames));
+
+    ptrdiff_t wholeFrames = static_cast<ptrdiff_t>(delayFrames);
+    float fraction = static_cast<float>(delayFrames - wholeFrames);
+
+    ptrdiff_t start = origin - wholeFrames;
+    ptrdiff_t end = start + static_cast<ptrdiff_t>(framesToProcess);
+
+    if (fraction == 0 && end <= 0) {
+        // The frames to read are already in order in the history.
+        const float* buffer = m_buffer.data();
+        size_t size = m_buffer.size();
+        size_t first = (m_writeIndex + start) & m_mask;
+        size_t head = std::min(framesToProcess, size - first);
+        memcpy(destination, buffer + first, head * sizeof(float));
+        memcpy(destination + head, buffer, (framesToProcess - head) * sizeof(float));
+
+        allpassState = destination[framesToProcess - 1];
+        return;
+    }
+
+    // Frame i lies between positions start + i - 1 and start + i, f of the way to the later one. The
+    // window begins a frame earlier still, and runs two frames beyond the last one read, for the cubic
+    // interpolator.
+    float f = 1 - fraction;
+    float* window = m_window.data();
+    gather(start - 2, end + 1, window);
+    const float* x0 = window + 1;
+
+    switch (m_interpolation) {
+    case DelayInterpolation::ALLPASS:
+        for (size_t i = 0; i < framesToProcess; ++i)
+            destination[i] = interpolate(DelayInterpolation::ALLPASS, 0, x0[i], x0[i + 1], 0, f, allpassState);
+        break;
+
+    case DelayInterpolation::CUBIC: {
+        float f2 = f * f;
+        float f3 = f2 * f;
+        float wm1 = -0.5f * f3 + f2 - 0.5f * f;
+        float w0 = 1.5f * f3 - 2.5f * f2 + 1;
+        float w1 = -1.5f * f3 + 2 * f2 + 0.5f * f;
+        float w2 = 0.5f * f3 - 0.5f * f2;
+        vsmul(x0 - 1, 1, &wm1, destination, 1, framesToProcess);
+        vsma(x0, 1, &w0, destination, 1, framesToProcess);
+        vsma(x0 + 1, 1, &w1, destination, 1, framesToProcess);
+        vsma(x0 + 2, 1, &w2, destination, 1, framesToProcess);
+        break;
+    }
+
+    case DelayInterpolation::LINEAR:
+    default: {
+        float w0 = 1 - f;
+        vsmul(x0, 1, &w0, destination, 1, framesToProcess);
+        vsma(x0 + 1, 1, &f, destination, 1, framesToProcess);
+        break;
+    }
+    }
+
+    if (m_interpolation != DelayInterpolation::ALLPASS)
+        allpassState = destination[framesToProcess - 1];
+}
+
+void DelayLine::readVarying(float* destination, size_t framesToProcess, ptrdiff_t origin, const float* delayFrames, float& allpassState)
+{
+    float* delays = m_delays.data();
+    const float lowest = 0;
+    const float highest = static_cast<float>(m_maxDelayFrames);
+    vclip(delayFrames, 1, &lowest, &highest, delays, 1, framesToProcess);
+
+    // The earliest and latest positions read, relative to the origin.
+    float earliest = -delays[0];
+    float latest = earliest;
+    for (size_t i = 1; i < framesToProcess; ++i) {
+        float p = i - delays[i];
+        earliest = std::min(earliest, p);
+        latest = std::max(latest, p);
+    }
+
+    ptrdiff_t first = origin + static_cast<ptrdiff_t>(floorf(earliest)) - 1;
+    ptrdiff_t last = origin + static_cast<ptrdiff_t>(floorf(latest)) + 2;
+
+    if (static_cast<size_t>(last - first + 1) <= m_window.size()) {
+        float* window = m_window.data();
+        gather(first, last, window);
+
+        float offset = static_cast<float>(origin - first);
+        switch (m_interpolation) {
+        case DelayInterpolation::ALLPASS: readAllpass(window, offset, delays, destination, framesToProcess, allpassState); break;
+        case DelayInterpolation::CUBIC: readCubic(window, offset, delays, destination, framesToProcess); break;
+        case DelayInterpolation::LINEAR:
+        default: readLinear(window, offset, delays, destination, framesToProcess); break;
+        }
+    }
+    else {
+        // The delay jumps too far within the block to gather; read each frame from the history.
+        const float* buffer = m_buffer.data();
+        for (size_t i = 0; i < framesToProcess; ++i) {
+            float p = i - delays[i];
+            ptrdiff_t k = origin + static_cast<ptrdiff_t>(floorf(p));
+            float x[4];
+            for (int j = 0; j < 4; ++j)
+                x[j] = buffer[(m_writeIndex + std::min<ptrdiff_t>(k + j - 1, -1)) & m_mask];
+            destination[i] = interpolate(m_interpolation, x[0], x[1], x[2], x[3], p - floorf(p), allpassState);
+        }
+    }
+
+    if (m_interpolation != DelayInterpolation::ALLPASS)
+        allpassState = destination[framesToProcess - 1];
+}
+
+} // namespace WebCore
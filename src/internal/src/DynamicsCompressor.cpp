@@ -33,14 +33,18 @@
 
 #include <WTF/MathExtras.h>
 
+#include <algorithm>
+
 namespace WebCore {
 
 using namespace AudioUtilities;
     
-DynamicsCompressor::DynamicsCompressor(float sampleRate, unsigned numberOfChannels)
+const float DynamicsCompressor::DefaultMaxPreDelayTime = 0.1f;
+
+DynamicsCompressor::DynamicsCompressor(float sampleRate, unsigned numberOfChannels, float maxPreDelayTime)
     : m_numberOfChannels(numberOfChannels)
     , m_sampleRate(sampleRate)
-    , m_compressor(sampleRate, numberOfChannels)
+    , m_compressor(sampleRate, numberOfChannels, maxPreDelayTime)
 {
     // Uninitialized state - for parameter recalculation.
     m_lastFilterStageRatio = -1;
@@ -141,22 +145,21 @@ void DynamicsCompressor::process(ContextRenderLock& r, const AudioBus* sourceBus
         return;
     }
 
-    switch (numberOfChannels)
+    if (numberOfChannels == 2)
     {
-    case 2:
         m_sourceChannels[0] = sourceBus->channelByType(Channel::Left)->data();
 
         if (numberOfSourceChannels > 1)
             m_sourceChannels[1] = sourceBus->channelByType(Channel::Right)->data();
         else
             m_sourceChannels[1] = m_sourceChannels[0]; // (left) mono duplicate to right channel
-
-        break;
-    default:
-        // FIXME : support other number of channels.
-        ASSERT_NOT_REACHED();
-        destinationBus->zero();
-        return;
+    }
+    else
+    {
+        // The channels are linked, so any number can be compressed together. Channels the source lacks
+        // duplicate its last one.
+        for (unsigned i = 0; i < numberOfChannels; ++i)
+            m_sourceChannels[i] = sourceBus->channel(std::min(i, numberOfSourceChannels - 1))->data();
     }
 
     for (unsigned i = 0; i < numberOfChannels; ++i)
@@ -178,18 +181,8 @@ void DynamicsCompressor::process(ContextRenderLock& r, const AudioBus* sourceBus
     }
 
     // Apply pre-emphasis filter.
-    // Note that the final three stages are computed in-place in the destination buffer.
     for (unsigned i = 0; i < numberOfChannels; ++i)
-    {
-        const float* sourceData = m_sourceChannels[i];
-        float* destinationData = m_destinationChannels[i];
-        ZeroPole* preFilters = m_preFilterPacks[i]->filters;
-
-        preFilters[0].process(sourceData, destinationData, framesToProcess);
-        preFilters[1].process(destinationData, destinationData, framesToProcess);
-        preFilters[2].process(destinationData, destinationData, framesToProcess);
-        preFilters[3].process(destinationData, destinationData, framesToProcess);
-    }
+        ZeroPole::processCascade(m_preFilterPacks[i]->filters, 4, m_sourceChannels[i], m_destinationChannels[i], framesToProcess);
 
     float dbThreshold = parameterValue(ParamThreshold);
     float dbKnee = parameterValue(ParamKnee);
@@ -240,15 +233,7 @@ void DynamicsCompressor::process(ContextRenderLock& r, const AudioBus* sourceBus
 
     // Apply de-emphasis filter.
     for (unsigned i = 0; i < numberOfChannels; ++i)
-    {
-        float* destinationData = m_destinationChannels[i];
-        ZeroPole* postFilters = m_postFilterPacks[i]->filters;
-
-        postFilters[0].process(destinationData, destinationData, framesToProcess);
-        postFilters[1].process(destinationData, destinationData, framesToProcess);
-        postFilters[2].process(destinationData, destinationData, framesToProcess);
-        postFilters[3].process(destinationData, destinationData, framesToProcess);
-    }
+        ZeroPole::processCascade(m_postFilterPacks[i]->filters, 4, m_destinationChannels[i], m_destinationChannels[i], framesToProcess);
 }
 
 void DynamicsCompressor::reset()
@@ -29,9 +29,11 @@
 #include "internal/DynamicsCompressorKernel.h"
 #include "internal/AudioUtilities.h"
 #include "internal/DenormalDisabler.h"
+#include "internal/VectorMath.h"
 
 #include <memory>
 #include <algorithm>
+#include <string.h>
 #include <WTF/MathExtras.h>
 
 using namespace std;
@@ -39,17 +41,29 @@ using namespace std;
 namespace WebCore {
 
 using namespace AudioUtilities;
+using namespace VectorMath;
 
 // Metering hits peaks instantly, but releases this fast (in seconds).
 const float meteringReleaseTimeConstant = 0.325f;
 
 const float uninitializedValue = -1;
 
-DynamicsCompressorKernel::DynamicsCompressorKernel(float sampleRate, unsigned numberOfChannels)
+// 20 / ln(10), for exponentials computed as decibels.
+const float decibelsPerNeper = 8.68588963806503655f;
+
+DynamicsCompressorKernel::DynamicsCompressorKernel(float sampleRate, unsigned numberOfChannels, float maxPreDelayTime)
     : m_sampleRate(sampleRate)
-    , m_lastPreDelayFrames(DefaultPreDelayFrames)
-    , m_preDelayReadIndex(0)
-    , m_preDelayWriteIndex(DefaultPreDelayFrames)
+    , m_maxPreDelayFrames(static_cast<unsigned>(max(0.0f, maxPreDelayTime) * sampleRate))
+    , m_lastPreDelayFrames(min(static_cast<unsigned>(DefaultPreDelayFrames), m_maxPreDelayFrames))
+    , m_preDelayBufferMask(0)
+    , m_preDelayWriteIndex(0)
+    , m_detectorInput(DivisionFrames)
+    , m_channelMagnitude(DivisionFrames)
+    , m_inputDb(DivisionFrames)
+    , m_kneeDb(DivisionFrames)
+    , m_attenuation(2 * DivisionFrames)
+    , m_gain(DivisionFrames)
+    , m_meteringDb(DivisionFrames)
     , m_ratio(uninitializedValue)
     , m_slope(uninitializedValue)
     , m_linearThreshold(uninitializedValue)
@@ -74,29 +88,50 @@ void DynamicsCompressorKernel::setNumberOfChannels(unsigned numberOfChannels)
     if (m_preDelayBuffers.size() == numberOfChannels)
         return;
 
+    size_t bufferSize = 1;
+    while (bufferSize < m_maxPreDelayFrames + DivisionFrames)
+        bufferSize <<= 1;
+    m_preDelayBufferMask = bufferSize - 1;
+
     m_preDelayBuffers.clear();
     for (unsigned i = 0; i < numberOfChannels; ++i)
-        m_preDelayBuffers.push_back(std::unique_ptr<AudioFloatArray>(new AudioFloatArray(MaxPreDelayFrames)));
+        m_preDelayBuffers.push_back(std::unique_ptr<AudioFloatArray>(new AudioFloatArray(bufferSize)));
 
 }
 
 void DynamicsCompressorKernel::setPreDelayTime(float preDelayTime)
 {
     // Re-configure look-ahead section pre-delay if delay time has changed.
-    unsigned preDelayFrames = preDelayTime * sampleRate();
-    if (preDelayFrames > MaxPreDelayFrames - 1)
-        preDelayFrames = MaxPreDelayFrames - 1;
+    unsigned preDelayFrames = max(0.0f, preDelayTime) * sampleRate();
+    if (preDelayFrames > m_maxPreDelayFrames)
+        preDelayFrames = m_maxPreDelayFrames;
 
     if (m_lastPreDelayFrames != preDelayFrames) {
         m_lastPreDelayFrames = preDelayFrames;
         for (unsigned i = 0; i < m_preDelayBuffers.size(); ++i)
             m_preDelayBuffers[i]->zero();
 
-        m_preDelayReadIndex = 0;
-        m_preDelayWriteIndex = preDelayFrames;
+        m_preDelayWriteIndex = 0;
     }
 }
 
+void DynamicsCompressorKernel::writePreDelay(unsigned channel, const float* source, size_t framesToProcess)
+{
+    float* buffer = m_preDelayBuffers[channel]->data();
+    size_t first = min(framesToProcess, m_preDelayBufferMask + 1 - m_preDelayWriteIndex);
+    memcpy(buffer + m_preDelayWriteIndex, source, first * sizeof(float));
+    memcpy(buffer, source + first, (framesToProcess - first) * sizeof(float));
+}
+
+void DynamicsCompressorKernel::readPreDelay(unsigned channel, float* destination, size_t framesToProcess)
+{
+    const float* buffer = m_preDelayBuffers[channel]->data();
+    size_t readIndex = (m_preDelayWriteIndex - m_lastPreDelayFrames) & m_preDelayBufferMask;
+    size_t first = min(framesToProcess, m_preDelayBufferMask + 1 - readIndex);
+    memcpy(destination, buffer + readIndex, first * sizeof(float));
+    memcpy(destination + first, buffer, (framesToProcess - first) * sizeof(float));
+}
+
 // Exponential curve for the knee.
 // It is 1st derivative matched at m_linearThreshold and asymptotically approaches the value m_linearThreshold + 1 / k.
 float DynamicsCompressorKernel::kneeCurve(float x, float k)
@@ -200,6 +235,45 @@ float DynamicsCompressorKernel::updateStaticCurveParameters(float dbThreshold, f
     return m_K;
 }
 
+// The shaping curve of saturate() for a division of detector input, as the attenuation it applies and the rate at
+// which the detector releases towards it. The curve's logs and exponentials are taken a division at a time with
+// VectorMath's decibel conversions, which are accurate to a few ulp.
+void DynamicsCompressorKernel::computeAttenuation(const float* detectorInput, size_t framesToProcess, float k, float satReleaseFrames)
+{
+    float* inputDb = m_inputDb.data();
+    float* kneeDb = m_kneeDb.data();
+    float* attenuation = m_attenuation.data();
+    float* releaseRate = attenuation + framesToProcess;
+
+    vlin2db(detectorInput, inputDb, framesToProcess);
+
+    // The knee, as in kneeCurve(), for the frames beyond the linear threshold.
+    for (size_t i = 0; i < framesToProcess; ++i)
+        kneeDb[i] = -k * max(detectorInput[i] - m_linearThreshold, 0.0f) * decibelsPerNeper;
+    vdb2lin(kneeDb, kneeDb, framesToProcess);
+    for (size_t i = 0; i < framesToProcess; ++i)
+        kneeDb[i] = m_linearThreshold + (1 - kneeDb[i]) / k;
+    vlin2db(kneeDb, kneeDb, framesToProcess);
+
+    for (size_t i = 0; i < framesToProcess; ++i) {
+        float x = detectorInput[i];
+
+        // The attenuation in dB, 0 below the threshold and for silence.
+        float attenuationDb = 0;
+        if (x > 0.0001f && x >= m_linearThreshold) {
+            if (x < m_kneeThreshold)
+                attenuationDb = inputDb[i] - kneeDb[i];
+            else
+                attenuationDb = inputDb[i] - (m_ykneeThresholdDb + m_slope * (inputDb[i] - m_kneeThresholdDb));
+        }
+
+        attenuation[i] = -attenuationDb;
+        releaseRate[i] = max(2.0f, attenuationDb) / satReleaseFrames;
+    }
+
+    vdb2lin(attenuation, attenuation, 2 * framesToProcess);
+}
+
 void DynamicsCompressorKernel::process(ContextRenderLock&,
                                        float * sourceChannels[],
                                        float * destinationChannels[],
@@ -222,6 +296,8 @@ void DynamicsCompressorKernel::process(ContextRenderLock&,
                                        )
 {
     ASSERT(m_preDelayBuffers.size() == numberOfChannels);
+    if (!numberOfChannels || m_preDelayBuffers.size() != numberOfChannels)
+        return;
 
     float sampleRate = this->sampleRate();
 
@@ -275,12 +351,9 @@ void DynamicsCompressorKernel::process(ContextRenderLock&,
 
     setPreDelayTime(preDelayTime);
 
-    const int nDivisionFrames = 32;
-
-    const int nDivisions = framesToProcess / nDivisionFrames;
+    for (unsigned frameIndex = 0; frameIndex < framesToProcess; frameIndex += DivisionFrames) {
+        const unsigned divisionFrames = min(static_cast<unsigned>(DivisionFrames), framesToProcess - frameIndex);
 
-    unsigned frameIndex = 0;
-    for (int i = 0; i < nDivisions; ++i) {
         // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
         // Calculate desired gain
         // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -359,54 +432,43 @@ void DynamicsCompressorKernel::process(ContextRenderLock&,
         }
 
         // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-        // Inner loop - calculate shaped power average - apply compression.
+        // Detector - the loudest channel, put through the shaping curve
         // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-        {
-            int preDelayReadIndex = m_preDelayReadIndex;
-            int preDelayWriteIndex = m_preDelayWriteIndex;
-            float detectorAverage = m_detectorAverage;
-            float compressorGain = m_compressorGain;
-
-            int loopFrames = nDivisionFrames;
-            while (loopFrames--) {
-                float compressorInput = 0;
-
-                // Predelay signal, computing compression amount from un-delayed version.
-                for (unsigned i = 0; i < numberOfChannels; ++i) {
-                    float* delayBuffer = m_preDelayBuffers[i]->data();
-                    float undelayedSource = sourceChannels[i][frameIndex];
-                    delayBuffer[preDelayWriteIndex] = undelayedSource;
-
-                    float absUndelayedSource = undelayedSource > 0 ? undelayedSource : -undelayedSource;
-                    if (compressorInput < absUndelayedSource)
-                        compressorInput = absUndelayedSource;
-                }
-
-                // Calculate shaped power on undelayed input.
-
-                float scaledInput = compressorInput;
-                float absInput = scaledInput > 0 ? scaledInput : -scaledInput;
+        // The whole division of undelayed input is consumed here, before any of the output is written,
+        // so the processing may be done in place.
+        float* detectorInput = m_detectorInput.data();
+        vabs(sourceChannels[0] + frameIndex, detectorInput, divisionFrames);
+        for (unsigned i = 1; i < numberOfChannels; ++i) {
+            vabs(sourceChannels[i] + frameIndex, m_channelMagnitude.data(), divisionFrames);
+            vmax(detectorInput, m_channelMagnitude.data(), detectorInput, divisionFrames);
+        }
 
-                // Put through shaping curve.
-                // This is linear up to the threshold, then enters a "knee" portion followed by the "ratio" portion.
-                // The transition from the threshold to the knee is smooth (1st derivative matched).
-                // The transition from the knee to the ratio portion is smooth (1st derivative matched).
-                float shapedInput = saturate(absInput, k);
+        for (unsigned i = 0; i < numberOfChannels; ++i)
+            writePreDelay(i, sourceChannels[i] + frameIndex, divisionFrames);
 
-                float attenuation = absInput <= 0.0001f ? 1 : shapedInput / absInput;
+        // This is linear up to the threshold, then enters a "knee" portion followed by the "ratio" portion.
+        // The transition from the threshold to the knee is smooth (1st derivative matched).
+        // The transition from the knee to the ratio portion is smooth (1st derivative matched).
+        computeAttenuation(detectorInput, divisionFrames, k, satReleaseFrames);
 
-                float attenuationDb = -linearToDecibels(attenuation);
-                attenuationDb = max(2.0f, attenuationDb);
+        // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+        // Inner loop - calculate shaped power average - apply compression.
+        // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-                float dbPerFrame = attenuationDb / satReleaseFrames;
+        {
+            const float* attenuation = m_attenuation.data();
+            const float* releaseRate = attenuation + divisionFrames;
+            float* gain = m_gain.data();
 
-                float satReleaseRate = decibelsToLinear(dbPerFrame) - 1;
+            float detectorAverage = m_detectorAverage;
+            float compressorGain = m_compressorGain;
 
-                bool isRelease = (attenuation > detectorAverage);
-                float rate = isRelease ? satReleaseRate : 1;
+            for (unsigned i = 0; i < divisionFrames; ++i) {
+                bool isRelease = (attenuation[i] > detectorAverage);
+                float rate = isRelease ? releaseRate[i] - 1 : 1;
 
-                detectorAverage += (attenuation - detectorAverage) * rate;
+                detectorAverage += (attenuation[i] - detectorAverage) * rate;
                 detectorAverage = min(1.0f, detectorAverage);
 
                 // Fix gremlins.
@@ -414,46 +476,62 @@ void DynamicsCompressorKernel::process(ContextRenderLock&,
                     detectorAverage = 1;
                 if (isinf(detectorAverage))
                     detectorAverage = 1;
+            }
 
-                // Exponential approach to desired gain.
-                if (envelopeRate < 1) {
-                    // Attack - reduce gain to desired.
+            // Exponential approach to desired gain. The envelope doesn't depend on the detector within
+            // a division, so it is a loop of its own.
+            if (envelopeRate < 1) {
+                // Attack - reduce gain to desired.
+                for (unsigned i = 0; i < divisionFrames; ++i) {
                     compressorGain += (scaledDesiredGain - compressorGain) * envelopeRate;
-                } else {
-                    // Release - exponentially increase gain to 1.0
+                    gain[i] = compressorGain;
+                }
+            } else {
+                // Release - exponentially increase gain to 1.0
+                for (unsigned i = 0; i < divisionFrames; ++i) {
                     compressorGain *= envelopeRate;
                     compressorGain = min(1.0f, compressorGain);
+                    gain[i] = compressorGain;
                 }
+            }
 
-                // Warp pre-compression gain to smooth out sharp exponential transition points.
-                float postWarpCompressorGain = sinf(0.5f * piFloat * compressorGain);
+            // Locals back to member variables.
+            m_detectorAverage = DenormalDisabler::flushDenormalFloatToZero(detectorAverage);
+            m_compressorGain = DenormalDisabler::flushDenormalFloatToZero(compressorGain);
 
-                // Calculate total gain using master gain and effect blend.
-                float totalGain = dryMix + wetMix * masterLinearGain * postWarpCompressorGain;
+            // Warp pre-compression gain to smooth out sharp exponential transition points. The gain is
+            // from 0 to 1, where the Taylor series of sin(0.5 * pi * gain) to the 11th power is good to 1e-7.
+            for (unsigned i = 0; i < divisionFrames; ++i) {
+                float x = 0.5f * piFloat * gain[i];
+                float x2 = x * x;
+                gain[i] = x * (1 - x2 / 6 * (1 - x2 / 20 * (1 - x2 / 42 * (1 - x2 / 72 * (1 - x2 / 110)))));
+            }
 
-                // Calculate metering.
-                float dbRealGain = 20 * log10(postWarpCompressorGain);
-                if (dbRealGain < m_meteringGain)
-                    m_meteringGain = dbRealGain;
+            // Calculate metering.
+            float* meteringDb = m_meteringDb.data();
+            vlin2db(gain, meteringDb, divisionFrames);
+            float meteringGain = m_meteringGain;
+            for (unsigned i = 0; i < divisionFrames; ++i) {
+                float dbRealGain = meteringDb[i];
+                if (dbRealGain < meteringGain)
+                    meteringGain = dbRealGain;
                 else
-                    m_meteringGain += (dbRealGain - m_meteringGain) * m_meteringReleaseK;
+                    meteringGain += (dbRealGain - meteringGain) * m_meteringReleaseK;
+            }
+            m_meteringGain = meteringGain;
 
-                // Apply final gain.
-                for (unsigned i = 0; i < numberOfChannels; ++i) {
-                    float* delayBuffer = m_preDelayBuffers[i]->data();
-                    destinationChannels[i][frameIndex] = delayBuffer[preDelayReadIndex] * totalGain;
-                }
+            // Calculate total gain using master gain and effect blend.
+            for (unsigned i = 0; i < divisionFrames; ++i)
+                gain[i] = dryMix + wetMix * masterLinearGain * gain[i];
 
-                frameIndex++;
-                preDelayReadIndex = (preDelayReadIndex + 1) & MaxPreDelayFramesMask;
-                preDelayWriteIndex = (preDelayWriteIndex + 1) & MaxPreDelayFramesMask;
+            // Apply final gain to the delayed signal.
+            for (unsigned i = 0; i < numberOfChannels; ++i) {
+                float* destination = destinationChannels[i] + frameIndex;
+                readPreDelay(i, destination, divisionFrames);
+                vmul(destination, 1, gain, 1, destination, 1, divisionFrames);
             }
 
-            // Locals back to member variables.
-            m_preDelayReadIndex = preDelayReadIndex;
-            m_preDelayWriteIndex = preDelayWriteIndex;
-            m_detectorAverage = DenormalDisabler::flushDenormalFloatToZero(detectorAverage);
-            m_compressorGain = DenormalDisabler::flushDenormalFloatToZero(compressorGain);
+            m_preDelayWriteIndex = (m_preDelayWriteIndex + divisionFrames) & m_preDelayBufferMask;
         }
     }
 }
@@ -468,8 +546,7 @@ void DynamicsCompressorKernel::reset()
     for (unsigned i = 0; i < m_preDelayBuffers.size(); ++i)
         m_preDelayBuffers[i]->zero();
 
-    m_preDelayReadIndex = 0;
-    m_preDelayWriteIndex = DefaultPreDelayFrames;
+    m_preDelayWriteIndex = 0;
 
     m_maxAttackCompressionDiffDb = -1; // uninitialized state
 }
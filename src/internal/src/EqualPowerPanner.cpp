@@ -25,9 +25,11 @@
 #include "internal/EqualPowerPanner.h"
 #include "internal/AudioBus.h"
 #include "internal/AudioUtilities.h"
+#include "internal/VectorMath.h"
 #include "LabSound/core/Mixing.h"
 
 #include <algorithm>
+#include <string.h>
 #include <WTF/MathExtras.h>
 
 // Use a 50ms smoothing / de-zippering time-constant.
@@ -104,48 +106,43 @@ void EqualPowerPanner::pan(ContextRenderLock&,
         m_gainL = desiredGainL;
         m_gainR = desiredGainR;
     }
-    
-    // Cache in local variables.
-    double gainL = m_gainL;
-    double gainR = m_gainR;
-    
-    // Get local copy of smoothing constant.
-    const double SmoothingConstant = m_smoothingConstant;
-    
-    int n = framesToProcess;
 
-    if (numberOfInputChannels == 1) { // For mono source case.
-        while (n--) {
-            float inputL = *sourceL++;
-            gainL += (desiredGainL - gainL) * SmoothingConstant;
-            gainR += (desiredGainR - gainR) * SmoothingConstant;
-            *destinationL++ = static_cast<float>(inputL * gainL);
-            *destinationR++ = static_cast<float>(inputL * gainR);
-        }
-    } else { // For stereo source case.
-        if (azimuth <= 0) { // from -90 -> 0
-            while (n--) {
-                float inputL = *sourceL++;
-                float inputR = *sourceR++;
-                gainL += (desiredGainL - gainL) * SmoothingConstant;
-                gainR += (desiredGainR - gainR) * SmoothingConstant;
-                *destinationL++ = static_cast<float>(inputL + inputR * gainL);
-                *destinationR++ = static_cast<float>(inputR * gainR);
-            }
-        } else { // from 0 -> +90
-            while (n--) {
-                float inputL = *sourceL++;
-                float inputR = *sourceR++;
-                gainL += (desiredGainL - gainL) * SmoothingConstant;
-                gainR += (desiredGainR - gainR) * SmoothingConstant;
-                *destinationL++ = static_cast<float>(inputL * gainL);
-                *destinationR++ = static_cast<float>(inputR + inputL * gainR);
-            }
-        }
-    }
+    // The gains approach the desired gains by m_smoothingConstant of the way each frame, so where they are
+    // at the first and the last frame of the quantum has a closed form. They ramp linearly between the two,
+    // which is close to the exponential curve over a quantum, and lets the gains be applied a vector at a time.
+    double decay = pow(1 - m_smoothingConstant, static_cast<double>(framesToProcess));
+    double firstGainL = m_gainL + (desiredGainL - m_gainL) * m_smoothingConstant;
+    double firstGainR = m_gainR + (desiredGainR - m_gainR) * m_smoothingConstant;
+    double lastGainL = desiredGainL + (m_gainL - desiredGainL) * decay;
+    double lastGainR = desiredGainR + (m_gainR - desiredGainR) * decay;
+
+    double frames = framesToProcess > 1 ? static_cast<double>(framesToProcess - 1) : 1.0;
+    applyGains(sourceL, sourceR, destinationL, destinationR, azimuth <= 0,
+               static_cast<float>(firstGainL), static_cast<float>((lastGainL - firstGainL) / frames),
+               static_cast<float>(firstGainR), static_cast<float>((lastGainR - firstGainR) / frames), framesToProcess);
+
+    m_gainL = lastGainL;
+    m_gainR = lastGainR;
+}
 
-    m_gainL = gainL;
-    m_gainR = gainR;
+void EqualPowerPanner::applyGains(const float* sourceL, const float* sourceR, float* destinationL, float* destinationR, bool keepLeft,
+                                  float gainL, float gainStepL, float gainR, float gainStepR, size_t framesToProcess)
+{
+    // Each output is written before a source it might share memory with is read for the other one.
+    if (sourceL == sourceR) {
+        VectorMath::vrampmul(sourceL, &gainR, &gainStepR, destinationR, framesToProcess);
+        VectorMath::vrampmul(sourceL, &gainL, &gainStepL, destinationL, framesToProcess);
+    } else if (keepLeft) {
+        if (destinationL != sourceL)
+            memcpy(destinationL, sourceL, framesToProcess * sizeof(float));
+        VectorMath::vrampmuladd(sourceR, &gainL, &gainStepL, destinationL, framesToProcess);
+        VectorMath::vrampmul(sourceR, &gainR, &gainStepR, destinationR, framesToProcess);
+    } else {
+        if (destinationR != sourceR)
+            memcpy(destinationR, sourceR, framesToProcess * sizeof(float));
+        VectorMath::vrampmuladd(sourceL, &gainR, &gainStepR, destinationR, framesToProcess);
+        VectorMath::vrampmul(sourceL, &gainL, &gainStepL, destinationL, framesToProcess);
+    }
 }
 
 } // namespace WebCore
@@ -0,0 +1,144 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#include "internal/HalfBandResampler.h"
+#include "internal/Assertions.h"
+
+#include <WTF/MathExtras.h>
+
+#include <math.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace WebCore {
+
+namespace {
+
+// Fills kernel with the 2 * halfLength odd taps of a Blackman windowed half-band filter, normalised so that
+// with the centre tap of 0.5 the filter has unity gain at DC. The taps are symmetric, so the order in which
+// they are applied doesn't matter.
+void makeHalfBandKernel(AudioFloatArray& kernel, size_t halfLength, float gain)
+{
+    size_t n = 2 * halfLength;
+    kernel.allocate(n);
+
+    float* k = kernel.data();
+    double sum = 0;
+    for (size_t q = 0; q < n; ++q) {
+        double m = static_cast<double>(n) - 2 * q - 1;
+        double sinc = sin(piDouble * m / 2) / (piDouble * m);
+        double x = piDouble * m / n;
+        double window = 0.42 + 0.5 * cos(x) + 0.08 * cos(2 * x);
+        k[q] = static_cast<float>(sinc * window);
+        sum += k[q];
+    }
+
+    float scale = static_cast<float>(0.5 * gain / sum);
+    for (size_t q = 0; q < n; ++q)
+        k[q] *= scale;
+}
+
+inline float dotProduct(const float* a, const float* b, size_t n)
+{
+    size_t i = 0;
+    float sum = 0;
+
+#ifdef __SSE2__
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4)
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+
+    for (; i < n; ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+} // namespace
+
+HalfBandUpSampler::HalfBandUpSampler(size_t halfLength, size_t maxFramesPerBlock)
+    : m_halfLength(halfLength)
+    , m_maxFramesPerBlock(maxFramesPerBlock)
+    , m_input(2 * halfLength - 1 + maxFramesPerBlock)
+{
+    ASSERT(halfLength > 0);
+
+    // Zero stuffing halves the level, which the odd taps make up for by being twice as large; the even
+    // frames are the input frames themselves.
+    makeHalfBandKernel(m_kernel, halfLength, 2);
+}
+
+void HalfBandUpSampler::process(const float* source, float* destination, size_t framesToProcess)
+{
+    ASSERT(framesToProcess <= m_maxFramesPerBlock);
+    if (framesToProcess > m_maxFramesPerBlock)
+        return;
+
+    size_t taps = 2 * m_halfLength;
+    size_t history = taps - 1;
+    float* input = m_input.data();
+    const float* kernel = m_kernel.data();
+
+    memcpy(input + history, source, framesToProcess * sizeof(float));
+
+    for (size_t i = 0; i < framesToProcess; ++i) {
+        destination[2 * i] = input[i + m_halfLength - 1];
+        destination[2 * i + 1] = dotProduct(kernel, input + i, taps);
+    }
+
+    memmove(input, input + framesToProcess, history * sizeof(float));
+}
+
+void HalfBandUpSampler::reset()
+{
+    m_input.zero();
+}
+
+HalfBandDownSampler::HalfBandDownSampler(size_t halfLength, size_t maxFramesPerBlock)
+    : m_halfLength(halfLength)
+    , m_maxFramesPerBlock(maxFramesPerBlock)
+    , m_odd(2 * halfLength + maxFramesPerBlock / 2)
+    , m_even(halfLength + maxFramesPerBlock / 2)
+{
+    ASSERT(halfLength > 0);
+    makeHalfBandKernel(m_kernel, halfLength, 1);
+}
+
+void HalfBandDownSampler::process(const float* source, float* destination, size_t framesToProcess)
+{
+    ASSERT(framesToProcess <= m_maxFramesPerBlock && !(framesToProcess & 1));
+    if (framesToProcess > m_maxFramesPerBlock)
+        return;
+
+    size_t taps = 2 * m_halfLength;
+    size_t outputFrames = framesToProcess / 2;
+    float* odd = m_odd.data();
+    float* even = m_even.data();
+    const float* kernel = m_kernel.data();
+
+    for (size_t i = 0; i < outputFrames; ++i) {
+        even[m_halfLength + i] = source[2 * i];
+        odd[taps + i] = source[2 * i + 1];
+    }
+
+    for (size_t i = 0; i < outputFrames; ++i)
+        destination[i] = 0.5f * even[i] + dotProduct(kernel, odd + i, taps);
+
+    memmove(odd, odd + outputFrames, taps * sizeof(float));
+    memmove(even, even + outputFrames, m_halfLength * sizeof(float));
+}
+
+void HalfBandDownSampler::reset()
+{
+    m_odd.zero();
+    m_even.zero();
+}
+
+} // namespace WebCore
@@ -0,0 +1,196 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#include "internal/MixingMatrix.h"
+#include "internal/Assertions.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string.h>
+
+namespace WebCore {
+
+namespace
+{
+    const float SqrtHalf = 0.70710678118654752f;
+
+    // Channel indices of the 5.1 and 7.1 layouts; quad is L R SL SR.
+    enum { L = 0, R = 1, C = 2, LFE = 3, SL = 4, SR = 5, BL = 6, BR = 7 };
+
+    typedef float Gains[MaxBusChannels][MaxBusChannels]; // [destination][source]
+
+    void clear(Gains g)
+    {
+        memset(g, 0, sizeof(Gains));
+    }
+
+    void identity(unsigned numberOfSourceChannels, unsigned numberOfDestinationChannels, Gains g)
+    {
+        clear(g);
+        for (unsigned i = 0; i < std::min(numberOfSourceChannels, numberOfDestinationChannels); ++i)
+            g[i][i] = 1;
+    }
+
+    // result = a * b, where a mixes 'middle' channels to 'destination' and b mixes 'source' channels to 'middle'.
+    void multiply(const Gains a, const Gains b, unsigned source, unsigned middle, unsigned destination, Gains result)
+    {
+        clear(result);
+        for (unsigned d = 0; d < destination; ++d)
+            for (unsigned s = 0; s < source; ++s)
+                for (unsigned m = 0; m < middle; ++m)
+                    result[d][s] += a[d][m] * b[m][s];
+    }
+
+    // The up and down mixing rules of the Web Audio specification for mono, stereo, quad and 5.1.
+    void specificationGains(unsigned source, unsigned destination, Gains g)
+    {
+        if (source == destination) {
+            identity(source, destination, g);
+            return;
+        }
+
+        clear(g);
+
+        switch (source) {
+        case 1:
+            if (destination == 6)
+                g[C][0] = 1;
+            else
+                g[0][0] = g[1][0] = 1; // stereo, or the front of quad
+            break;
+
+        case 2:
+            if (destination == 1)
+                g[0][L] = g[0][R] = 0.5f;
+            else
+                g[L][L] = g[R][R] = 1;
+            break;
+
+        case 4:
+            if (destination == 1)
+                g[0][0] = g[0][1] = g[0][2] = g[0][3] = 0.25f;
+            else if (destination == 2) {
+                g[L][0] = g[L][2] = 0.5f;
+                g[R][1] = g[R][3] = 0.5f;
+            } else {
+                g[L][0] = g[R][1] = 1;
+                g[SL][2] = g[SR][3] = 1;
+            }
+            break;
+
+        case 6:
+            if (destination == 1) {
+                g[0][L] = g[0][R] = SqrtHalf;
+                g[0][C] = 1;
+                g[0][SL] = g[0][SR] = 0.5f;
+            } else if (destination == 2) {
+                g[L][L] = 1;
+                g[L][C] = g[L][SL] = SqrtHalf;
+                g[R][R] = 1;
+                g[R][C] = g[R][SR] = SqrtHalf;
+            } else {
+                g[0][L] = g[1][R] = 1;
+                g[0][C] = g[1][C] = SqrtHalf;
+                g[2][SL] = g[3][SR] = 1;
+            }
+            break;
+        }
+    }
+
+    bool isSpeakerLayout(unsigned channels)
+    {
+        return channels == 1 || channels == 2 || channels == 4 || channels == 6 || channels == 8;
+    }
+
+    void speakerGains(unsigned source, unsigned destination, Gains g)
+    {
+        if (source != 8 && destination != 8) {
+            specificationGains(source, destination, g);
+            return;
+        }
+
+        if (source == 8 && destination == 8) {
+            identity(8, 8, g);
+            return;
+        }
+
+        Gains viaSurround;
+        if (source == 8) {
+            // Fold 7.1 down to 5.1, then mix that to the destination.
+            Gains fold;
+            identity(8, 6, fold);
+            fold[SL][BL] = fold[SR][BR] = SqrtHalf;
+            specificationGains(6, destination, viaSurround);
+            multiply(viaSurround, fold, 8, 6, destination, g);
+        } else {
+            // Mix up to 5.1, leaving the back channels of 7.1 silent.
+            Gains extend;
+            identity(6, 8, extend);
+            specificationGains(source, 6, viaSurround);
+            multiply(extend, viaSurround, source, 6, 8, g);
+        }
+    }
+}
+
+MixingMatrix::MixingMatrix(unsigned numberOfSourceChannels, unsigned numberOfDestinationChannels, ChannelInterpretation interpretation)
+    : m_numberOfSourceChannels(std::min(numberOfSourceChannels, MaxBusChannels))
+    , m_numberOfDestinationChannels(std::min(numberOfDestinationChannels, MaxBusChannels))
+{
+    ASSERT(numberOfSourceChannels <= MaxBusChannels && numberOfDestinationChannels <= MaxBusChannels);
+
+    Gains gains;
+    if (interpretation == ChannelInterpretation::Speakers && isSpeakerLayout(m_numberOfSourceChannels) && isSpeakerLayout(m_numberOfDestinationChannels))
+        speakerGains(m_numberOfSourceChannels, m_numberOfDestinationChannels, gains);
+    else
+        identity(m_numberOfSourceChannels, m_numberOfDestinationChannels, gains);
+
+    setGains(gains);
+}
+
+void MixingMatrix::setGains(const float gains[][MaxBusChannels])
+{
+    for (unsigned d = 0; d < m_numberOfDestinationChannels; ++d) {
+        unsigned count = 0;
+        for (unsigned s = 0; s < m_numberOfSourceChannels; ++s) {
+            if (!gains[d][s])
+                continue;
+
+            ASSERT(count < MaxTermsPerChannel);
+            if (count == MaxTermsPerChannel)
+                break;
+
+            m_terms[d][count].source = s;
+            m_terms[d][count].gain = gains[d][s];
+            ++count;
+        }
+        m_numberOfTerms[d] = count;
+    }
+}
+
+const MixingMatrix& MixingMatrix::matrix(unsigned numberOfSourceChannels, unsigned numberOfDestinationChannels, ChannelInterpretation interpretation)
+{
+    // Zero initialized as a static. Entries are published with a compare and swap, so the
+    // render thread and a main thread building the same entry at once simply agree on one of them.
+    // The matrices live as long as the process.
+    static std::atomic<MixingMatrix*> cache[2][MaxBusChannels][MaxBusChannels];
+
+    ASSERT(numberOfSourceChannels >= 1 && numberOfSourceChannels <= MaxBusChannels);
+    ASSERT(numberOfDestinationChannels >= 1 && numberOfDestinationChannels <= MaxBusChannels);
+    unsigned s = std::min(std::max(numberOfSourceChannels, 1u), MaxBusChannels) - 1;
+    unsigned d = std::min(std::max(numberOfDestinationChannels, 1u), MaxBusChannels) - 1;
+    unsigned i = interpretation == ChannelInterpretation::Speakers ? 0 : 1;
+
+    std::atomic<MixingMatrix*>& entry = cache[i][s][d];
+    MixingMatrix* matrix = entry.load(std::memory_order_acquire);
+    if (!matrix) {
+        MixingMatrix* created = new MixingMatrix(s + 1, d + 1, interpretation);
+        if (entry.compare_exchange_strong(matrix, created, std::memory_order_acq_rel))
+            matrix = created;
+        else
+            delete created;
+    }
+
+    return *matrix;
+}
+
+} // namespace WebCore
@@ -0,0 +1,235 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#include "internal/PolyphaseResampler.h"
+#include "internal/AudioBus.h"
+#include "internal/ConfigMacros.h"
+
+#include <WTF/MathExtras.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace WebCore {
+
+namespace {
+
+    // The kernel size when converting up. Converting down widens the kernels by the ratio, so that the
+    // transition band is as narrow at the destination rate.
+    const unsigned KernelSize = 64;
+
+    // Bounds on the size of a filter bank; ratios beyond them fall back to SincResampler.
+    const unsigned MaxPhases = 1024;
+    const unsigned MaxKernelSize = 512;
+
+    // A thread is only worth starting for this many destination frames.
+    const size_t MinFramesPerThread = 1 << 16;
+
+    unsigned greatestCommonDivisor(unsigned a, unsigned b)
+    {
+        while (b) {
+            unsigned t = a % b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+
+    inline float dot(const float* a, const float* b, unsigned n)
+    {
+        unsigned i = 0;
+        float sum = 0;
+#ifdef __SSE2__
+        __m128 mSum = _mm_setzero_ps();
+        for (; i + 4 <= n; i += 4)
+            mSum = _mm_add_ps(mSum, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        float sums[4];
+        _mm_storeu_ps(sums, mSum);
+        sum = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+#endif
+        for (; i < n; ++i)
+            sum += a[i] * b[i];
+        return sum;
+    }
+
+    std::mutex cacheLock;
+    std::map<std::pair<unsigned, unsigned>, std::shared_ptr<PolyphaseResampler>> cache;
+}
+
+PolyphaseResampler::PolyphaseResampler(unsigned sourceSampleRate, unsigned destinationSampleRate)
+    : m_sourceSampleRate(sourceSampleRate)
+    , m_destinationSampleRate(destinationSampleRate)
+{
+    unsigned divisor = greatestCommonDivisor(sourceSampleRate, destinationSampleRate);
+    m_interpolation = destinationSampleRate / divisor;
+    m_decimation = sourceSampleRate / divisor;
+
+    // The normalized cutoff, adjusted down as in SincResampler so that the windowed transition doesn't alias.
+    double cutoff = m_decimation > m_interpolation ? double(m_interpolation) / m_decimation : 1.0;
+    cutoff *= 0.9;
+
+    double widening = m_decimation > m_interpolation ? double(m_decimation) / m_interpolation : 1.0;
+    m_kernelSize = std::min(MaxKernelSize, (static_cast<unsigned>(std::ceil(KernelSize * widening)) + 3) & ~3u);
+
+    // Blackman window parameters.
+    const double alpha = 0.16;
+    const double a0 = 0.5 * (1.0 - alpha);
+    const double a1 = 0.5;
+    const double a2 = 0.5 * alpha;
+
+    int halfSize = m_kernelSize / 2;
+    m_kernels.resize(size_t(m_interpolation) * m_kernelSize);
+
+    for (unsigned phase = 0; phase < m_interpolation; ++phase) {
+        double subsampleOffset = double(phase) / m_interpolation;
+        float* kernel = &m_kernels[size_t(phase) * m_kernelSize];
+
+        double sum = 0;
+        for (int i = 0; i < int(m_kernelSize); ++i) {
+            // Tap i is over the source frame i - halfSize + 1 frames from the one the output follows.
+            double t = i - halfSize + 1 - subsampleOffset;
+            double s = cutoff * piDouble * t;
+            double sinc = !s ? 1.0 : sin(s) / s;
+
+            double x = (t + halfSize) / m_kernelSize;
+            double window = x <= 0 || x >= 1 ? 0 : a0 - a1 * cos(2.0 * piDouble * x) + a2 * cos(4.0 * piDouble * x);
+
+            kernel[i] = static_cast<float>(sinc * window);
+            sum += sinc * window;
+        }
+
+        // Normalizing each kernel to unity gain at DC keeps the phases from modulating a constant signal.
+        for (unsigned i = 0; i < m_kernelSize; ++i)
+            kernel[i] = static_cast<float>(kernel[i] / sum);
+    }
+}
+
+std::shared_ptr<PolyphaseResampler> PolyphaseResampler::forRates(unsigned sourceSampleRate, unsigned destinationSampleRate)
+{
+    if (!sourceSampleRate || !destinationSampleRate)
+        return nullptr;
+
+    unsigned divisor = greatestCommonDivisor(sourceSampleRate, destinationSampleRate);
+    unsigned interpolation = destinationSampleRate / divisor;
+    unsigned decimation = sourceSampleRate / divisor;
+    if (interpolation > MaxPhases || decimation > interpolation * (MaxKernelSize / KernelSize))
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(cacheLock);
+    std::shared_ptr<PolyphaseResampler>& resampler = cache[std::make_pair(sourceSampleRate, destinationSampleRate)];
+    if (!resampler)
+        resampler.reset(new PolyphaseResampler(sourceSampleRate, destinationSampleRate));
+    return resampler;
+}
+
+size_t PolyphaseResampler::destinationLength(size_t sourceLength) const
+{
+    return static_cast<size_t>(uint64_t(sourceLength) * m_interpolation / m_decimation);
+}
+
+void PolyphaseResampler::process(const float* source, size_t sourceLength, float* destination, size_t firstDestinationFrame, size_t destinationFrames) const
+{
+    const int64_t halfSize = m_kernelSize / 2;
+    const int64_t length = static_cast<int64_t>(sourceLength);
+
+    // The position of each output frame, as source frame and phase, advances by M / L without drift.
+    uint64_t position = uint64_t(firstDestinationFrame) * m_decimation;
+    int64_t frame = static_cast<int64_t>(position / m_interpolation);
+    unsigned phase = static_cast<unsigned>(position % m_interpolation);
+
+    const unsigned frameStep = m_decimation / m_interpolation;
+    const unsigned phaseStep = m_decimation % m_interpolation;
+
+    for (size_t i = 0; i < destinationFrames; ++i) {
+        const float* kernel = &m_kernels[size_t(phase) * m_kernelSize];
+        int64_t first = frame - halfSize + 1;
+
+        if (first >= 0 && first + m_kernelSize <= length)
+            destination[i] = dot(source + first, kernel, m_kernelSize);
+        else {
+            // Near the ends, only the taps over the source contribute.
+            int64_t begin = std::max<int64_t>(first, 0);
+            int64_t end = std::min<int64_t>(first + m_kernelSize, length);
+            float sum = 0;
+            for (int64_t j = begin; j < end; ++j)
+                sum += source[j] * kernel[j - first];
+            destination[i] = sum;
+        }
+
+        frame += frameStep;
+        phase += phaseStep;
+        if (phase >= m_interpolation) {
+            phase -= m_interpolation;
+            ++frame;
+        }
+    }
+}
+
+std::unique_ptr<AudioBus> PolyphaseResampler::createBySampleRateConverting(const AudioBus* sourceBus, float newSampleRate)
+{
+    ASSERT(sourceBus && sourceBus->sampleRate());
+    if (!sourceBus || !sourceBus->sampleRate())
+        return nullptr;
+
+    float sourceSampleRate = sourceBus->sampleRate();
+    std::shared_ptr<PolyphaseResampler> resampler;
+    if (sourceSampleRate == std::floor(sourceSampleRate) && newSampleRate == std::floor(newSampleRate))
+        resampler = forRates(static_cast<unsigned>(sourceSampleRate), static_cast<unsigned>(newSampleRate));
+
+    if (!resampler)
+        return AudioBus::createBySampleRateConverting(sourceBus, false, newSampleRate);
+
+    unsigned numberOfChannels = sourceBus->numberOfChannels();
+    size_t sourceLength = sourceBus->length();
+    size_t destinationLength = resampler->destinationLength(sourceLength);
+
+    std::unique_ptr<AudioBus> destinationBus(new AudioBus(numberOfChannels, destinationLength));
+    destinationBus->setSampleRate(newSampleRate);
+    if (!destinationLength)
+        return destinationBus;
+
+    // Each job is a span of one channel; the spans are independent, so they can run on any thread.
+    size_t concurrency = std::max(std::thread::hardware_concurrency(), 1u);
+    size_t spansPerChannel = std::max<size_t>(1, std::min(concurrency, destinationLength / MinFramesPerThread));
+    size_t spanLength = (destinationLength + spansPerChannel - 1) / spansPerChannel;
+    size_t numberOfJobs = numberOfChannels * spansPerChannel;
+
+    std::vector<const float*> sources(numberOfChannels);
+    std::vector<float*> destinations(numberOfChannels);
+    for (unsigned i = 0; i < numberOfChannels; ++i) {
+        sources[i] = sourceBus->channel(i)->data();
+        destinations[i] = destinationBus->channel(i)->mutableData();
+    }
+
+    std::atomic<size_t> nextJob(0);
+    auto work = [&]()
+    {
+        for (size_t job = nextJob++; job < numberOfJobs; job = nextJob++) {
+            unsigned channel = static_cast<unsigned>(job / spansPerChannel);
+            size_t start = (job % spansPerChannel) * spanLength;
+            size_t frames = std::min(spanLength, destinationLength - start);
+
+            resampler->process(sources[channel], sourceLength, destinations[channel] + start, start, frames);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    size_t numberOfThreads = std::min(concurrency, numberOfJobs);
+    for (size_t i = 1; i < numberOfThreads; ++i)
+        threads.emplace_back(work);
+    work();
+    for (auto& thread : threads)
+        thread.join();
+
+    return destinationBus;
+}
+
+} // namespace WebCore
@@ -29,6 +29,7 @@
 #include "internal/ConfigMacros.h"
 #include "internal/SincResampler.h"
 #include "internal/AudioBus.h"
+#include "internal/VectorMathKernels.h"
 
 #include <WTF/MathExtras.h>
 
@@ -67,18 +68,21 @@ using namespace std;
 
 namespace WebCore {
 
-SincResampler::SincResampler(double scaleFactor, unsigned kernelSize, unsigned numberOfKernelOffsets)
+SincResampler::SincResampler(double scaleFactor, unsigned kernelSize, unsigned numberOfKernelOffsets, unsigned numberOfChannels)
     : m_scaleFactor(scaleFactor)
     , m_kernelSize(kernelSize)
     , m_numberOfKernelOffsets(numberOfKernelOffsets)
+    , m_numberOfChannels(numberOfChannels)
     , m_kernelStorage(m_kernelSize * (m_numberOfKernelOffsets + 1))
     , m_virtualSourceIndex(0)
     , m_blockSize(512)
-    , m_inputBuffer(m_blockSize + m_kernelSize) // See input buffer layout above.
+    , m_inputStride(m_blockSize + m_kernelSize) // See input buffer layout above.
+    , m_inputBuffer(m_inputStride * m_numberOfChannels)
     , m_source(0)
     , m_sourceFramesAvailable(0)
     , m_sourceProvider(0)
     , m_isBufferPrimed(false)
+    , m_destinations(m_numberOfChannels)
 {
     initializeKernel();
 }
@@ -130,75 +134,201 @@ void SincResampler::consumeSource(float* buffer, unsigned numberOfSourceFrames)
     if (!m_sourceProvider)
         return;
     
-    // Wrap the provided buffer by an AudioBus for use by the source provider.
-    AudioBus bus(1, numberOfSourceFrames, false);
+    // Wrap the provided buffer, and the same region of each other channel's buffer, by an AudioBus for use by the source provider.
+    AudioBus bus(m_numberOfChannels, numberOfSourceFrames, false);
 
     // FIXME: Find a way to make the following const-correct:
-    bus.setChannelMemory(0, buffer, numberOfSourceFrames);
+    for (unsigned channelIndex = 0; channelIndex < m_numberOfChannels; ++channelIndex)
+        bus.setChannelMemory(channelIndex, buffer + channelIndex * m_inputStride, numberOfSourceFrames);
     
     m_sourceProvider->provideInput(&bus, numberOfSourceFrames);
 }
 
 namespace {
 
-// BufferSourceProvider is an AudioSourceProvider wrapping an in-memory buffer.
+// BufferSourceProvider is an AudioSourceProvider wrapping in-memory buffers, one for each channel.
 
 class BufferSourceProvider : public AudioSourceProvider {
 public:
-    BufferSourceProvider(const float* source, size_t numberOfSourceFrames)
-        : m_source(source)
+    BufferSourceProvider(const float* const* sources, unsigned numberOfChannels, size_t numberOfSourceFrames)
+        : m_sources(sources, sources + numberOfChannels)
         , m_sourceFramesAvailable(numberOfSourceFrames)
     {
     }
     
-    // Consumes samples from the in-memory buffer.
+    // Consumes samples from the in-memory buffers.
     virtual void provideInput(AudioBus* bus, size_t framesToProcess)
     {
-        ASSERT(m_source && bus);
-        if (!m_source || !bus)
+        ASSERT(bus && bus->numberOfChannels() >= m_sources.size());
+        if (!bus || bus->numberOfChannels() < m_sources.size())
             return;
-            
-        float* buffer = bus->channel(0)->mutableData();
 
         // Clamp to number of frames available and zero-pad.
         size_t framesToCopy = min(m_sourceFramesAvailable, framesToProcess);
-        memcpy(buffer, m_source, sizeof(float) * framesToCopy);
 
-        // Zero-pad if necessary.
-        if (framesToCopy < framesToProcess)
-            memset(buffer + framesToCopy, 0, sizeof(float) * (framesToProcess - framesToCopy));
+        for (size_t channelIndex = 0; channelIndex < m_sources.size(); ++channelIndex) {
+            float* buffer = bus->channel(channelIndex)->mutableData();
+            memcpy(buffer, m_sources[channelIndex], sizeof(float) * framesToCopy);
+
+            // Zero-pad if necessary.
+            if (framesToCopy < framesToProcess)
+                memset(buffer + framesToCopy, 0, sizeof(float) * (framesToProcess - framesToCopy));
+
+            m_sources[channelIndex] += framesToCopy;
+        }
 
         m_sourceFramesAvailable -= framesToCopy;
-        m_source += framesToCopy;
     }
     
 private:
-    const float* m_source;
+    std::vector<const float*> m_sources;
     size_t m_sourceFramesAvailable;
 };
 
+// The wider kernels for the running CPU, or null when the SSE2 code below is the best available.
+const VectorMath::VectorKernels* wideKernels()
+{
+    static const VectorMath::VectorKernels* kernels = VectorMath::selectX86Kernels();
+    return kernels;
+}
+
+#ifdef __SSE2__
+inline float sumOf(__m128 sums)
+{
+    float groupSum[4];
+    _mm_storeu_ps(groupSum, sums);
+    return groupSum[0] + groupSum[1] + groupSum[2] + groupSum[3];
+}
+#endif
+
+// Convolves one channel with the two kernels which straddle the virtual source index.
+inline void convolve(const float* inputP, const float* k1, const float* k2, unsigned n, float& sum1, float& sum2)
+{
+    if (const VectorMath::VectorKernels* kernels = wideKernels()) {
+        kernels->sincConvolve(inputP, k1, k2, n, &sum1, &sum2);
+        return;
+    }
+
+    unsigned i = 0;
+    sum1 = 0;
+    sum2 = 0;
+
+#ifdef __SSE2__
+    __m128 sums1 = _mm_setzero_ps();
+    __m128 sums2 = _mm_setzero_ps();
+
+    for (; i + 4 <= n; i += 4) {
+        __m128 input = _mm_loadu_ps(inputP + i);
+        sums1 = _mm_add_ps(sums1, _mm_mul_ps(input, _mm_loadu_ps(k1 + i)));
+        sums2 = _mm_add_ps(sums2, _mm_mul_ps(input, _mm_loadu_ps(k2 + i)));
+    }
+
+    sum1 = sumOf(sums1);
+    sum2 = sumOf(sums2);
+#endif
+
+    // FIXME: add ARM NEON optimizations for the following.
+    for (; i < n; ++i) {
+        sum1 += inputP[i] * k1[i];
+        sum2 += inputP[i] * k2[i];
+    }
+}
+
+// Convolves two channels with the kernel interpolated between the two which straddle the virtual source
+// index. The interpolated kernel is computed once for both channels, as it's read.
+inline void convolve(const float* inputA, const float* inputB, const float* k1, const float* k2, float kernelInterpolationFactor, unsigned n, float& sumA, float& sumB)
+{
+    if (const VectorMath::VectorKernels* kernels = wideKernels()) {
+        kernels->sincConvolvePair(inputA, inputB, k1, k2, kernelInterpolationFactor, n, &sumA, &sumB);
+        return;
+    }
+
+    unsigned i = 0;
+    sumA = 0;
+    sumB = 0;
+
+#ifdef __SSE2__
+    __m128 sumsA = _mm_setzero_ps();
+    __m128 sumsB = _mm_setzero_ps();
+    __m128 factor = _mm_set1_ps(kernelInterpolationFactor);
+
+    for (; i + 4 <= n; i += 4) {
+        __m128 kernel1 = _mm_loadu_ps(k1 + i);
+        __m128 kernel = _mm_add_ps(kernel1, _mm_mul_ps(factor, _mm_sub_ps(_mm_loadu_ps(k2 + i), kernel1)));
+        sumsA = _mm_add_ps(sumsA, _mm_mul_ps(_mm_loadu_ps(inputA + i), kernel));
+        sumsB = _mm_add_ps(sumsB, _mm_mul_ps(_mm_loadu_ps(inputB + i), kernel));
+    }
+
+    sumA = sumOf(sumsA);
+    sumB = sumOf(sumsB);
+#endif
+
+    for (; i < n; ++i) {
+        float kernel = k1[i] + kernelInterpolationFactor * (k2[i] - k1[i]);
+        sumA += inputA[i] * kernel;
+        sumB += inputB[i] * kernel;
+    }
+}
+
 } // namespace
 
 void SincResampler::process(const float* source, float* destination, unsigned numberOfSourceFrames)
 {
+    bool isGood = m_numberOfChannels == 1;
+    ASSERT(isGood);
+    if (!isGood)
+        return;
+
     // Resample an in-memory buffer using an AudioSourceProvider.
-    BufferSourceProvider sourceProvider(source, numberOfSourceFrames);
+    BufferSourceProvider sourceProvider(&source, 1, numberOfSourceFrames);
 
     unsigned numberOfDestinationFrames = static_cast<unsigned>(numberOfSourceFrames / m_scaleFactor);
-    unsigned remaining = numberOfDestinationFrames;
-    
-    while (remaining) {
-        unsigned framesThisTime = min(remaining, m_blockSize);
-        process(&sourceProvider, destination, framesThisTime);
-        
-        destination += framesThisTime;
-        remaining -= framesThisTime;
-    }
+    process(&sourceProvider, &destination, numberOfDestinationFrames);
 }
 
 void SincResampler::process(AudioSourceProvider* sourceProvider, float* destination, size_t framesToProcess)
 {
-    bool isGood = sourceProvider && m_blockSize > m_kernelSize && m_inputBuffer.size() >= m_blockSize + m_kernelSize && !(m_kernelSize % 2);
+    bool isGood = m_numberOfChannels == 1;
+    ASSERT(isGood);
+    if (!isGood)
+        return;
+
+    process(sourceProvider, &destination, framesToProcess);
+}
+
+void SincResampler::process(const AudioBus* source, AudioBus* destination, unsigned numberOfSourceFrames)
+{
+    bool isGood = source && source->numberOfChannels() >= m_numberOfChannels;
+    ASSERT(isGood);
+    if (!isGood)
+        return;
+
+    // Resample in-memory buffers using an AudioSourceProvider.
+    std::vector<const float*> sources(m_numberOfChannels);
+    for (unsigned channelIndex = 0; channelIndex < m_numberOfChannels; ++channelIndex)
+        sources[channelIndex] = source->channel(channelIndex)->data();
+    BufferSourceProvider sourceProvider(sources.data(), m_numberOfChannels, numberOfSourceFrames);
+
+    unsigned numberOfDestinationFrames = static_cast<unsigned>(numberOfSourceFrames / m_scaleFactor);
+    process(&sourceProvider, destination, numberOfDestinationFrames);
+}
+
+void SincResampler::process(AudioSourceProvider* sourceProvider, AudioBus* destination, size_t framesToProcess)
+{
+    bool isGood = destination && destination->numberOfChannels() >= m_numberOfChannels;
+    ASSERT(isGood);
+    if (!isGood)
+        return;
+
+    for (unsigned channelIndex = 0; channelIndex < m_numberOfChannels; ++channelIndex)
+        m_destinations[channelIndex] = destination->channel(channelIndex)->mutableData();
+
+    process(sourceProvider, m_destinations.data(), framesToProcess);
+}
+
+void SincResampler::process(AudioSourceProvider* sourceProvider, float* const* destinations, size_t framesToProcess)
+{
+    bool isGood = sourceProvider && m_blockSize > m_kernelSize && m_inputStride >= m_blockSize + m_kernelSize && !(m_kernelSize % 2);
     ASSERT(isGood);
     if (!isGood)
         return;
@@ -206,8 +336,10 @@ void SincResampler::process(AudioSourceProvider* sourceProvider, float* destinat
     m_sourceProvider = sourceProvider;
 
     unsigned numberOfDestinationFrames = framesToProcess;
+    size_t destinationIndex = 0;
     
     // Setup various region pointers in the buffer (see diagram above).
+    // These are in the first channel's buffer; each other channel's regions are at the same offsets in its own.
     float* r0 = m_inputBuffer.data() + m_kernelSize / 2;
     float* r1 = m_inputBuffer.data();
     float* r2 = r0;
@@ -227,222 +359,47 @@ void SincResampler::process(AudioSourceProvider* sourceProvider, float* destinat
     while (numberOfDestinationFrames) {
         while (m_virtualSourceIndex < m_blockSize) {
             // m_virtualSourceIndex lies in between two kernel offsets so figure out what they are.
+            // They, and the weighting between them, are the same for every channel.
             int sourceIndexI = static_cast<int>(m_virtualSourceIndex);
             double subsampleRemainder = m_virtualSourceIndex - sourceIndexI;
 
             double virtualOffsetIndex = subsampleRemainder * m_numberOfKernelOffsets;
             int offsetIndex = static_cast<int>(virtualOffsetIndex);
             
-            float* k1 = m_kernelStorage.data() + offsetIndex * m_kernelSize;
-            float* k2 = k1 + m_kernelSize;
+            const float* k1 = m_kernelStorage.data() + offsetIndex * m_kernelSize;
+            const float* k2 = k1 + m_kernelSize;
 
             // Initialize input pointer based on quantized m_virtualSourceIndex.
-            float* inputP = r1 + sourceIndexI;
-
-            // We'll compute "convolutions" for the two kernels which straddle m_virtualSourceIndex
-            float sum1 = 0;
-            float sum2 = 0;
+            const float* inputP = r1 + sourceIndexI;
 
             // Figure out how much to weight each kernel's "convolution".
             double kernelInterpolationFactor = virtualOffsetIndex - offsetIndex;
 
-            // Generate a single output sample. 
-            int n = m_kernelSize;
+            // Generate a single output sample for each channel, two channels at a time.
+            unsigned channelIndex = 0;
+            for (; channelIndex + 2 <= m_numberOfChannels; channelIndex += 2) {
+                float sumA;
+                float sumB;
+                convolve(inputP + channelIndex * m_inputStride, inputP + (channelIndex + 1) * m_inputStride,
+                         k1, k2, static_cast<float>(kernelInterpolationFactor), m_kernelSize, sumA, sumB);
 
-#define CONVOLVE_ONE_SAMPLE      \
-            input = *inputP++;   \
-            sum1 += input * *k1; \
-            sum2 += input * *k2; \
-            ++k1;                \
-            ++k2;
+                destinations[channelIndex][destinationIndex] = sumA;
+                destinations[channelIndex + 1][destinationIndex] = sumB;
+            }
 
-            {
-                float input;
+            if (channelIndex < m_numberOfChannels) {
+                // We'll compute "convolutions" for the two kernels which straddle m_virtualSourceIndex
+                float sum1;
+                float sum2;
+                convolve(inputP + channelIndex * m_inputStride, k1, k2, m_kernelSize, sum1, sum2);
 
-#ifdef __SSE2__
-                // If the sourceP address is not 16-byte aligned, the first several frames (at most three) should be processed seperately.
-                while ((reinterpret_cast<uintptr_t>(inputP) & 0x0F) && n) {
-                    CONVOLVE_ONE_SAMPLE
-                    n--;
-                }
-
-                // Now the inputP is aligned and start to apply SSE.
-                float* endP = inputP + n - n % 4;
-                __m128 mInput;
-                __m128 mK1;
-                __m128 mK2;
-                __m128 mul1;
-                __m128 mul2;
-
-                __m128 sums1 = _mm_setzero_ps();
-                __m128 sums2 = _mm_setzero_ps();
-                bool k1Aligned = !(reinterpret_cast<uintptr_t>(k1) & 0x0F);
-                bool k2Aligned = !(reinterpret_cast<uintptr_t>(k2) & 0x0F);
-
-#define LOAD_DATA(l1, l2)                        \
-                mInput = _mm_load_ps(inputP);    \
-                mK1 = _mm_##l1##_ps(k1);         \
-                mK2 = _mm_##l2##_ps(k2);
-
-#define CONVOLVE_4_SAMPLES                       \
-                mul1 = _mm_mul_ps(mInput, mK1);  \
-                mul2 = _mm_mul_ps(mInput, mK2);  \
-                sums1 = _mm_add_ps(sums1, mul1); \
-                sums2 = _mm_add_ps(sums2, mul2); \
-                inputP += 4;                     \
-                k1 += 4;                         \
-                k2 += 4;
-
-                if (k1Aligned && k2Aligned) { // both aligned
-                    while (inputP < endP) {
-                        LOAD_DATA(load, load)
-                        CONVOLVE_4_SAMPLES
-                    }
-                } else if (!k1Aligned && k2Aligned) { // only k2 aligned
-                    while (inputP < endP) {
-                        LOAD_DATA(loadu, load)
-                        CONVOLVE_4_SAMPLES
-                    }
-                } else if (k1Aligned && !k2Aligned) { // only k1 aligned
-                    while (inputP < endP) {
-                        LOAD_DATA(load, loadu)
-                        CONVOLVE_4_SAMPLES
-                    }
-                } else { // both non-aligned
-                    while (inputP < endP) {
-                        LOAD_DATA(loadu, loadu)
-                        CONVOLVE_4_SAMPLES
-                    }
-                }
-
-                // Summarize the SSE results to sum1 and sum2.
-                float* groupSumP = reinterpret_cast<float*>(&sums1);
-                sum1 += groupSumP[0] + groupSumP[1] + groupSumP[2] + groupSumP[3];
-                groupSumP = reinterpret_cast<float*>(&sums2);
-                sum2 += groupSumP[0] + groupSumP[1] + groupSumP[2] + groupSumP[3];
-
-                n %= 4;
-                while (n) {
-                    CONVOLVE_ONE_SAMPLE
-                    n--;
-                }
-#else
-                // FIXME: add ARM NEON optimizations for the following. The scalar code-path can probably also be optimized better.
-                
-                // Optimize size 32 and size 64 kernels by unrolling the while loop.
-                // A 20 - 30% speed improvement was measured in some cases by using this approach.
-                
-                if (n == 32) {
-                    CONVOLVE_ONE_SAMPLE // 1
-                    CONVOLVE_ONE_SAMPLE // 2
-                    CONVOLVE_ONE_SAMPLE // 3
-                    CONVOLVE_ONE_SAMPLE // 4
-                    CONVOLVE_ONE_SAMPLE // 5
-                    CONVOLVE_ONE_SAMPLE // 6
-                    CONVOLVE_ONE_SAMPLE // 7
-                    CONVOLVE_ONE_SAMPLE // 8
-                    CONVOLVE_ONE_SAMPLE // 9
-                    CONVOLVE_ONE_SAMPLE // 10
-                    CONVOLVE_ONE_SAMPLE // 11
-                    CONVOLVE_ONE_SAMPLE // 12
-                    CONVOLVE_ONE_SAMPLE // 13
-                    CONVOLVE_ONE_SAMPLE // 14
-                    CONVOLVE_ONE_SAMPLE // 15
-                    CONVOLVE_ONE_SAMPLE // 16
-                    CONVOLVE_ONE_SAMPLE // 17
-                    CONVOLVE_ONE_SAMPLE // 18
-                    CONVOLVE_ONE_SAMPLE // 19
-                    CONVOLVE_ONE_SAMPLE // 20
-                    CONVOLVE_ONE_SAMPLE // 21
-                    CONVOLVE_ONE_SAMPLE // 22
-                    CONVOLVE_ONE_SAMPLE // 23
-                    CONVOLVE_ONE_SAMPLE // 24
-                    CONVOLVE_ONE_SAMPLE // 25
-                    CONVOLVE_ONE_SAMPLE // 26
-                    CONVOLVE_ONE_SAMPLE // 27
-                    CONVOLVE_ONE_SAMPLE // 28
-                    CONVOLVE_ONE_SAMPLE // 29
-                    CONVOLVE_ONE_SAMPLE // 30
-                    CONVOLVE_ONE_SAMPLE // 31
-                    CONVOLVE_ONE_SAMPLE // 32
-                } else if (n == 64) {
-                    CONVOLVE_ONE_SAMPLE // 1
-                    CONVOLVE_ONE_SAMPLE // 2
-                    CONVOLVE_ONE_SAMPLE // 3
-                    CONVOLVE_ONE_SAMPLE // 4
-                    CONVOLVE_ONE_SAMPLE // 5
-                    CONVOLVE_ONE_SAMPLE // 6
-                    CONVOLVE_ONE_SAMPLE // 7
-                    CONVOLVE_ONE_SAMPLE // 8
-                    CONVOLVE_ONE_SAMPLE // 9
-                    CONVOLVE_ONE_SAMPLE // 10
-                    CONVOLVE_ONE_SAMPLE // 11
-                    CONVOLVE_ONE_SAMPLE // 12
-                    CONVOLVE_ONE_SAMPLE // 13
-                    CONVOLVE_ONE_SAMPLE // 14
-                    CONVOLVE_ONE_SAMPLE // 15
-                    CONVOLVE_ONE_SAMPLE // 16
-                    CONVOLVE_ONE_SAMPLE // 17
-                    CONVOLVE_ONE_SAMPLE // 18
-                    CONVOLVE_ONE_SAMPLE // 19
-                    CONVOLVE_ONE_SAMPLE // 20
-                    CONVOLVE_ONE_SAMPLE // 21
-                    CONVOLVE_ONE_SAMPLE // 22
-                    CONVOLVE_ONE_SAMPLE // 23
-                    CONVOLVE_ONE_SAMPLE // 24
-                    CONVOLVE_ONE_SAMPLE // 25
-                    CONVOLVE_ONE_SAMPLE // 26
-                    CONVOLVE_ONE_SAMPLE // 27
-                    CONVOLVE_ONE_SAMPLE // 28
-                    CONVOLVE_ONE_SAMPLE // 29
-                    CONVOLVE_ONE_SAMPLE // 30
-                    CONVOLVE_ONE_SAMPLE // 31
-                    CONVOLVE_ONE_SAMPLE // 32
-                    CONVOLVE_ONE_SAMPLE // 33
-                    CONVOLVE_ONE_SAMPLE // 34
-                    CONVOLVE_ONE_SAMPLE // 35
-                    CONVOLVE_ONE_SAMPLE // 36
-                    CONVOLVE_ONE_SAMPLE // 37
-                    CONVOLVE_ONE_SAMPLE // 38
-                    CONVOLVE_ONE_SAMPLE // 39
-                    CONVOLVE_ONE_SAMPLE // 40
-                    CONVOLVE_ONE_SAMPLE // 41
-                    CONVOLVE_ONE_SAMPLE // 42
-                    CONVOLVE_ONE_SAMPLE // 43
-                    CONVOLVE_ONE_SAMPLE // 44
-                    CONVOLVE_ONE_SAMPLE // 45
-                    CONVOLVE_ONE_SAMPLE // 46
-                    CONVOLVE_ONE_SAMPLE // 47
-                    CONVOLVE_ONE_SAMPLE // 48
-                    CONVOLVE_ONE_SAMPLE // 49
-                    CONVOLVE_ONE_SAMPLE // 50
-                    CONVOLVE_ONE_SAMPLE // 51
-                    CONVOLVE_ONE_SAMPLE // 52
-                    CONVOLVE_ONE_SAMPLE // 53
-                    CONVOLVE_ONE_SAMPLE // 54
-                    CONVOLVE_ONE_SAMPLE // 55
-                    CONVOLVE_ONE_SAMPLE // 56
-                    CONVOLVE_ONE_SAMPLE // 57
-                    CONVOLVE_ONE_SAMPLE // 58
-                    CONVOLVE_ONE_SAMPLE // 59
-                    CONVOLVE_ONE_SAMPLE // 60
-                    CONVOLVE_ONE_SAMPLE // 61
-                    CONVOLVE_ONE_SAMPLE // 62
-                    CONVOLVE_ONE_SAMPLE // 63
-                    CONVOLVE_ONE_SAMPLE // 64
-                } else {
-                    while (n--) {
-                        // Non-optimized using actual while loop.
-                        CONVOLVE_ONE_SAMPLE
-                    }
-                }
-#endif
-            }
+                // Linearly interpolate the two "convolutions".
+                double result = (1.0 - kernelInterpolationFactor) * sum1 + kernelInterpolationFactor * sum2;
 
-            // Linearly interpolate the two "convolutions".
-            double result = (1.0 - kernelInterpolationFactor) * sum1 + kernelInterpolationFactor * sum2;
+                destinations[channelIndex][destinationIndex] = static_cast<float>(result);
+            }
 
-            *destination++ = result;
+            ++destinationIndex;
 
             // Advance the virtual index.
             m_virtualSourceIndex += m_scaleFactor;
@@ -457,8 +414,11 @@ void SincResampler::process(AudioSourceProvider* sourceProvider, float* destinat
 
         // Step (3) Copy r3 to r1 and r4 to r2.
         // This wraps the last input frames back to the start of the buffer.
-        memcpy(r1, r3, sizeof(float) * (m_kernelSize / 2));
-        memcpy(r2, r4, sizeof(float) * (m_kernelSize / 2));
+        for (unsigned channelIndex = 0; channelIndex < m_numberOfChannels; ++channelIndex) {
+            size_t offset = channelIndex * m_inputStride;
+            memcpy(r1 + offset, r3 + offset, sizeof(float) * (m_kernelSize / 2));
+            memcpy(r2 + offset, r4 + offset, sizeof(float) * (m_kernelSize / 2));
+        }
 
         // Step (4)
         // Refresh the buffer with more input.
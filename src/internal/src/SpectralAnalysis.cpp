@@ -0,0 +1,139 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#include "internal/SpectralAnalysis.h"
+#include "internal/Assertions.h"
+#include "internal/FFTFrame.h"
+#include "internal/VectorMath.h"
+
+#include <WTF/MathExtras.h>
+
+#include <algorithm>
+#include <limits.h>
+#include <map>
+#include <math.h>
+#include <mutex>
+
+namespace WebCore {
+
+// The Blackman window used by the Web Audio analyser, w(i) = 0.42 - 0.5 cos(2 pi i / N) + 0.08 cos(4 pi i / N).
+// Tables are only computed when an engine is constructed; the cache holds them weakly so that a size
+// nobody uses any more is freed.
+static std::shared_ptr<const AudioFloatArray> blackmanWindow(uint32_t size)
+{
+    static std::mutex cacheMutex;
+    static std::map<uint32_t, std::weak_ptr<const AudioFloatArray>> cache;
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    std::shared_ptr<const AudioFloatArray> window = cache[size].lock();
+    if (window)
+        return window;
+
+    const double alpha = 0.16;
+    const double a0 = 0.5 * (1 - alpha);
+    const double a1 = 0.5;
+    const double a2 = 0.5 * alpha;
+
+    std::shared_ptr<AudioFloatArray> table = std::make_shared<AudioFloatArray>(size);
+    float* p = table->data();
+    for (uint32_t i = 0; i < size; ++i) {
+        double x = static_cast<double>(i) / static_cast<double>(size);
+        p[i] = static_cast<float>(a0 - a1 * cos(2 * piDouble * x) + a2 * cos(4 * piDouble * x));
+    }
+
+    cache[size] = table;
+    return table;
+}
+
+SpectralAnalysis::SpectralAnalysis(uint32_t fftSize)
+    : m_fftSize(fftSize)
+    , m_frame(new FFTFrame(fftSize))
+    , m_window(blackmanWindow(fftSize))
+    , m_scratch(fftSize)
+{
+    ASSERT(fftSize >= 2 && !(fftSize & (fftSize - 1)));
+}
+
+SpectralAnalysis::~SpectralAnalysis()
+{
+}
+
+void SpectralAnalysis::transform(const float* history, size_t historySize, size_t writeIndex)
+{
+    ASSERT(historySize >= m_fftSize && writeIndex <= historySize);
+
+    // Unroll the most recent fftSize frames of the history, oldest first, windowing them on the way.
+    const float* window = m_window->data();
+    float* input = m_scratch.data();
+    size_t fftSize = m_fftSize;
+
+    if (writeIndex < fftSize) {
+        size_t older = fftSize - writeIndex;
+        VectorMath::vmul(history + historySize - older, 1, window, 1, input, 1, older);
+        VectorMath::vmul(history, 1, window + older, 1, input + older, 1, writeIndex);
+    }
+    else
+        VectorMath::vmul(history + writeIndex - fftSize, 1, window, 1, input, 1, fftSize);
+
+    m_frame->doFFT(input);
+
+    // Blow away the packed nyquist component.
+    m_frame->imagData()[0] = 0;
+}
+
+const float* SpectralAnalysis::realData() const
+{
+    return m_frame->realData();
+}
+
+const float* SpectralAnalysis::imagData() const
+{
+    return m_frame->imagData();
+}
+
+void SpectralAnalysis::analyze(const float* history, size_t historySize, size_t writeIndex, float scale, float smoothing, float* magnitudes)
+{
+    transform(history, historySize, writeIndex);
+
+    const float* realP = m_frame->realData();
+    const float* imagP = m_frame->imagData();
+    float* input = m_scratch.data();
+
+    size_t count = frequencyBinCount();
+    smoothing = std::min(std::max(smoothing, 0.0f), 1.0f);
+
+    if (!smoothing) {
+        VectorMath::zvmag(realP, imagP, &scale, magnitudes, count);
+        return;
+    }
+
+    // The windowed input is no longer needed, so the fresh magnitudes go there before being blended in.
+    VectorMath::zvmag(realP, imagP, &scale, input, count);
+    float mix = 1 - smoothing;
+    float step = 0;
+    VectorMath::vcrossfade(magnitudes, input, &mix, &step, magnitudes, count);
+}
+
+void SpectralAnalysis::magnitudesToDecibels(const float* magnitudes, float* decibels, size_t count, float silenceDecibels)
+{
+    VectorMath::vlin2db(magnitudes, decibels, count);
+
+    for (size_t i = 0; i < count; ++i) {
+        if (!magnitudes[i])
+            decibels[i] = silenceDecibels;
+    }
+}
+
+void SpectralAnalysis::decibelsToBytes(const float* decibels, uint8_t* bytes, size_t count, float minDecibels, float maxDecibels)
+{
+    const float rangeScaleFactor = UCHAR_MAX * (maxDecibels == minDecibels ? 1 : 1 / (maxDecibels - minDecibels));
+
+    for (size_t i = 0; i < count; ++i) {
+        float scaledValue = (decibels[i] - minDecibels) * rangeScaleFactor;
+        scaledValue = std::min(std::max(scaledValue, 0.0f), static_cast<float>(UCHAR_MAX));
+        bytes[i] = static_cast<uint8_t>(scaledValue);
+    }
+}
+
+} // namespace WebCore
@@ -26,6 +26,7 @@
 #include "internal/Assertions.h"
 
 #include "internal/VectorMath.h"
+#include "internal/VectorMathKernels.h"
 
 #if OS(DARWIN)
 #include <Accelerate/Accelerate.h>
@@ -40,12 +41,32 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <math.h>
+#include <string.h>
 
 namespace WebCore {
 
 namespace VectorMath {
 
+// The wider kernels for the running CPU, or null when the code compiled for the baseline instruction set is the best available.
+// The entry points below forward their unit stride cases to these. setKernels() replaces them.
+static std::atomic<const VectorKernels*>& kernelTable()
+{
+    static std::atomic<const VectorKernels*> kernels(selectX86Kernels());
+    return kernels;
+}
+
+static const VectorKernels* wideKernels()
+{
+    return kernelTable().load(std::memory_order_relaxed);
+}
+
+void setKernels(const VectorKernels* kernels)
+{
+    kernelTable().store(kernels, std::memory_order_relaxed);
+}
+
 #if OS(DARWIN)
 // On the Mac we use the highly optimized versions in Accelerate.framework
 // In 32-bit mode (__ppc__ or __i386__) <Accelerate/Accelerate.h> includes <vecLib/vDSP_translate.h> which defines macros of the same name as
@@ -119,6 +140,13 @@ void vclip(const float* sourceP, int sourceStride, const float* lowThresholdP, c
 
 void vsma(const float* sourceP, int sourceStride, const float* scale, float* destP, int destStride, size_t framesToProcess)
 {
+    if ((sourceStride == 1) && (destStride == 1)) {
+        if (const VectorKernels* kernels = wideKernels()) {
+            kernels->vsma(sourceP, *scale, destP, framesToProcess);
+            return;
+        }
+    }
+
     int n = framesToProcess;
 
 #ifdef __SSE2__
@@ -192,6 +220,13 @@ void vsma(const float* sourceP, int sourceStride, const float* scale, float* des
 
 void vsmul(const float* sourceP, int sourceStride, const float* scale, float* destP, int destStride, size_t framesToProcess)
 {
+    if ((sourceStride == 1) && (destStride == 1)) {
+        if (const VectorKernels* kernels = wideKernels()) {
+            kernels->vsmul(sourceP, *scale, destP, framesToProcess);
+            return;
+        }
+    }
+
     int n = framesToProcess;
 
 #ifdef __SSE2__
@@ -272,6 +307,13 @@ void vsmul(const float* sourceP, int sourceStride, const float* scale, float* de
 
 void vadd(const float* source1P, int sourceStride1, const float* source2P, int sourceStride2, float* destP, int destStride, size_t framesToProcess)
 {
+    if ((sourceStride1 == 1) && (sourceStride2 == 1) && (destStride == 1)) {
+        if (const VectorKernels* kernels = wideKernels()) {
+            kernels->vadd(source1P, source2P, destP, framesToProcess);
+            return;
+        }
+    }
+
     int n = framesToProcess;
 
 #ifdef __SSE2__
@@ -384,6 +426,13 @@ void vadd(const float* source1P, int sourceStride1, const float* source2P, int s
 
 void vmul(const float* source1P, int sourceStride1, const float* source2P, int sourceStride2, float* destP, int destStride, size_t framesToProcess)
 {
+    if ((sourceStride1 == 1) && (sourceStride2 == 1) && (destStride == 1)) {
+        if (const VectorKernels* kernels = wideKernels()) {
+            kernels->vmul(source1P, source2P, destP, framesToProcess);
+            return;
+        }
+    }
+
 
     int n = framesToProcess;
 
@@ -459,6 +508,11 @@ void vmul(const float* source1P, int sourceStride1, const float* source2P, int s
 
 void zvmul(const float* real1P, const float* imag1P, const float* real2P, const float* imag2P, float* realDestP, float* imagDestP, size_t framesToProcess)
 {
+    if (const VectorKernels* kernels = wideKernels()) {
+        kernels->zvmul(real1P, imag1P, real2P, imag2P, realDestP, imagDestP, framesToProcess);
+        return;
+    }
+
     unsigned i = 0;
 #ifdef __SSE2__
     // Only use the SSE optimization in the very common case that all addresses are 16-byte aligned. 
@@ -515,6 +569,14 @@ void zvmul(const float* real1P, const float* imag1P, const float* real2P, const
 
 void vsvesq(const float* sourceP, int sourceStride, float* sumP, size_t framesToProcess)
 {
+    if (sourceStride == 1) {
+        if (const VectorKernels* kernels = wideKernels()) {
+            ASSERT(sumP);
+            *sumP = kernels->vsvesq(sourceP, framesToProcess);
+            return;
+        }
+    }
+
     int n = framesToProcess;
     float sum = 0;
 
@@ -580,6 +642,14 @@ void vsvesq(const float* sourceP, int sourceStride, float* sumP, size_t framesTo
 
 void vmaxmgv(const float* sourceP, int sourceStride, float* maxP, size_t framesToProcess)
 {
+    if (sourceStride == 1) {
+        if (const VectorKernels* kernels = wideKernels()) {
+            ASSERT(maxP);
+            *maxP = kernels->vmaxmgv(sourceP, framesToProcess);
+            return;
+        }
+    }
+
     int n = framesToProcess;
     float max = 0;
 
@@ -649,12 +719,33 @@ void vmaxmgv(const float* sourceP, int sourceStride, float* maxP, size_t framesT
 
 void vclip(const float* sourceP, int sourceStride, const float* lowThresholdP, const float* highThresholdP, float* destP, int destStride, size_t framesToProcess)
 {
+    if ((sourceStride == 1) && (destStride == 1)) {
+        if (const VectorKernels* kernels = wideKernels()) {
+            kernels->vclip(sourceP, *lowThresholdP, *highThresholdP, destP, framesToProcess);
+            return;
+        }
+    }
+
     int n = framesToProcess;
     float lowThreshold = *lowThresholdP;
     float highThreshold = *highThresholdP;
 
-    // FIXME: Optimize for SSE2.
-#if HAVE(ARM_NEON_INTRINSICS)
+#ifdef __SSE2__
+    if ((sourceStride == 1) && (destStride == 1)) {
+        int tailFrames = n % 4;
+        const float* endP = destP + n - tailFrames;
+
+        __m128 low = _mm_set_ps1(lowThreshold);
+        __m128 high = _mm_set_ps1(highThreshold);
+        while (destP < endP) {
+            __m128 source = _mm_loadu_ps(sourceP);
+            _mm_storeu_ps(destP, _mm_max_ps(_mm_min_ps(source, high), low));
+            sourceP += 4;
+            destP += 4;
+        }
+        n = tailFrames;
+    }
+#elif HAVE(ARM_NEON_INTRINSICS)
     if ((sourceStride == 1) && (destStride == 1)) {
         int tailFrames = n % 4;
         const float* endP = destP + n - tailFrames;
@@ -679,64 +770,353 @@ void vclip(const float* sourceP, int sourceStride, const float* lowThresholdP, c
 
 #endif // OS(DARWIN)
 
-void vintlve(const float* realSrcP, const float* imagSrcP, float* destP, size_t framesToProcess) {
-	int i = 0;
-#if HAVE(ARM_NEON_INTRINSICS)
-	int j = 0;
-	int endSize = framesToProcess - framesToProcess % 4;
-	int len = endSize / 2;
-
-	while (i < len) {
-		float32x4_t source1 = vld1q_f32(realSrcP);
-		float32x4_t source2 = vld1q_f32(imagSrcP);
-		float32x4x2_t source = vzipq_f32(source1, source2);
-
-		vst1q_f32(destP + j, source.val[0]);
-		vst1q_f32(destP + j + 4, source.val[1]);
-		realSrcP += 4;
-		imagSrcP += 4;
-
-		i += 4;
-		j += 8;
-	}
+// The interleaved buffer holds framesToProcess floats, that is framesToProcess / 2 complex pairs.
+void vintlve(const float* realSrcP, const float* imagSrcP, float* destP, size_t framesToProcess)
+{
+    size_t pairs = framesToProcess / 2;
+
+    if (const VectorKernels* kernels = wideKernels()) {
+        kernels->vintlve(realSrcP, imagSrcP, destP, pairs);
+        return;
+    }
+
+    size_t i = 0;
+#ifdef __SSE2__
+    for (; i + 4 <= pairs; i += 4) {
+        __m128 real = _mm_loadu_ps(realSrcP + i);
+        __m128 imag = _mm_loadu_ps(imagSrcP + i);
+        _mm_storeu_ps(destP + 2 * i, _mm_unpacklo_ps(real, imag));
+        _mm_storeu_ps(destP + 2 * i + 4, _mm_unpackhi_ps(real, imag));
+    }
+#elif HAVE(ARM_NEON_INTRINSICS)
+    for (; i + 4 <= pairs; i += 4) {
+        float32x4x2_t source = vzipq_f32(vld1q_f32(realSrcP + i), vld1q_f32(imagSrcP + i));
+        vst1q_f32(destP + 2 * i, source.val[0]);
+        vst1q_f32(destP + 2 * i + 4, source.val[1]);
+    }
 #endif
-	int lenTail = framesToProcess / 2;
-	for (; i < lenTail; ++i) {
-		int baseIndex = 2 * i;
-		destP[baseIndex] = realSrcP[i];
-		destP[baseIndex + 1] = imagSrcP[i];
-	}
+    for (; i < pairs; ++i) {
+        destP[2 * i] = realSrcP[i];
+        destP[2 * i + 1] = imagSrcP[i];
+    }
 }
 
-void vdeintlve(const float* sourceP, float* realDestP, float* imagDestP, size_t framesToProcess) {
-	int i = 0;
-#if HAVE(ARM_NEON_INTRINSICS)
-	int j = 0;
-	int endSize = framesToProcess - framesToProcess % 4;
+void vdeintlve(const float* sourceP, float* realDestP, float* imagDestP, size_t framesToProcess)
+{
+    size_t pairs = framesToProcess / 2;
+
+    if (const VectorKernels* kernels = wideKernels()) {
+        kernels->vdeintlve(sourceP, realDestP, imagDestP, pairs);
+        return;
+    }
+
+    size_t i = 0;
+#ifdef __SSE2__
+    for (; i + 4 <= pairs; i += 4) {
+        __m128 a = _mm_loadu_ps(sourceP + 2 * i);
+        __m128 b = _mm_loadu_ps(sourceP + 2 * i + 4);
+        _mm_storeu_ps(realDestP + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(imagDestP + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+#elif HAVE(ARM_NEON_INTRINSICS)
+    for (; i + 4 <= pairs; i += 4) {
+        float32x4x2_t source = vuzpq_f32(vld1q_f32(sourceP + 2 * i), vld1q_f32(sourceP + 2 * i + 4));
+        vst1q_f32(realDestP + i, source.val[0]);
+        vst1q_f32(imagDestP + i, source.val[1]);
+    }
+#endif
+    for (; i < pairs; ++i) {
+        realDestP[i] = sourceP[2 * i];
+        imagDestP[i] = sourceP[2 * i + 1];
+    }
+}
+
+// The primitives below have no Accelerate counterpart with the same semantics, so they are shared by every platform.
+// Their fallbacks are kept to plain loops, which compilers vectorize for the baseline instruction set.
+
+void vrampmul(const float* sourceP, float* gainP, const float* gainStepP, float* destP, size_t framesToProcess)
+{
+    const float gain = *gainP;
+    const float step = *gainStepP;
+
+    if (const VectorKernels* kernels = wideKernels())
+        kernels->vrampmul(sourceP, gain, step, destP, framesToProcess);
+    else {
+        for (size_t i = 0; i < framesToProcess; ++i)
+            destP[i] = sourceP[i] * (gain + step * i);
+    }
+
+    *gainP = gain + step * framesToProcess;
+}
+
+void vrampmuladd(const float* sourceP, float* gainP, const float* gainStepP, float* destP, size_t framesToProcess)
+{
+    const float gain = *gainP;
+    const float step = *gainStepP;
+
+    if (const VectorKernels* kernels = wideKernels())
+        kernels->vrampmuladd(sourceP, gain, step, destP, framesToProcess);
+    else {
+        for (size_t i = 0; i < framesToProcess; ++i)
+            destP[i] += sourceP[i] * (gain + step * i);
+    }
 
-	while (i < endSize) {
-		float32x4_t source1 = vld1q_f32(sourceP);
-		float32x4_t source2 = vld1q_f32(sourceP + 4);
+    *gainP = gain + step * framesToProcess;
+}
+
+void vcrossfade(const float* fromP, const float* toP, float* mixP, const float* mixStepP, float* destP, size_t framesToProcess)
+{
+    const float mix = *mixP;
+    const float step = *mixStepP;
+
+    if (const VectorKernels* kernels = wideKernels())
+        kernels->vcrossfade(fromP, toP, mix, step, destP, framesToProcess);
+    else {
+        for (size_t i = 0; i < framesToProcess; ++i)
+            destP[i] = fromP[i] + (toP[i] - fromP[i]) * (mix + step * i);
+    }
+
+    *mixP = mix + step * framesToProcess;
+}
+
+void vmin(const float* source1P, const float* source2P, float* destP, size_t framesToProcess)
+{
+    if (const VectorKernels* kernels = wideKernels()) {
+        kernels->vmin(source1P, source2P, destP, framesToProcess);
+        return;
+    }
+
+    for (size_t i = 0; i < framesToProcess; ++i)
+        destP[i] = std::min(source1P[i], source2P[i]);
+}
+
+void vmax(const float* source1P, const float* source2P, float* destP, size_t framesToProcess)
+{
+    if (const VectorKernels* kernels = wideKernels()) {
+        kernels->vmax(source1P, source2P, destP, framesToProcess);
+        return;
+    }
+
+    for (size_t i = 0; i < framesToProcess; ++i)
+        destP[i] = std::max(source1P[i], source2P[i]);
+}
+
+void vabs(const float* sourceP, float* destP, size_t framesToProcess)
+{
+    if (const VectorKernels* kernels = wideKernels()) {
+        kernels->vabs(sourceP, destP, framesToProcess);
+        return;
+    }
+
+    for (size_t i = 0; i < framesToProcess; ++i)
+        destP[i] = fabsf(sourceP[i]);
+}
 
-		float32x4x2_t source = vuzpq_f32(source1, source2);
+#ifdef __SSE2__
+// SSE2 versions of the approximations the wider kernels use for decibel conversion, without FMA or blends.
 
-		vst1q_f32(realDestP + j, source.val[0]);
-		vst1q_f32(imagDestP + j, source.val[1]);
+// Natural log of strictly positive, normal values.
+static inline __m128 sse2Log(__m128 x)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128i bits = _mm_castps_si128(x);
+
+    // Split into an exponent and a mantissa in [sqrt(0.5), sqrt(2)).
+    __m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+    __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+    __m128 large = _mm_cmpgt_ps(m, _mm_set1_ps(Sqrt2));
+    m = _mm_or_ps(_mm_and_ps(large, _mm_mul_ps(m, _mm_set1_ps(0.5f))), _mm_andnot_ps(large, m));
+    e = _mm_add_ps(e, _mm_and_ps(large, one));
+    x = _mm_sub_ps(m, one);
+
+    __m128 p = _mm_set1_ps(LogP0);
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(LogP1));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(LogP2));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(LogP3));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(LogP4));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(LogP5));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(LogP6));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(LogP7));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(LogP8));
+
+    __m128 z = _mm_mul_ps(x, x);
+    __m128 y = _mm_mul_ps(_mm_mul_ps(p, x), z);
+    y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(Ln2Lo)));
+    y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+    x = _mm_add_ps(x, y);
+    return _mm_add_ps(x, _mm_mul_ps(e, _mm_set1_ps(Ln2Hi)));
+}
 
-		sourceP += 8;
+static inline __m128 sse2Exp(__m128 x)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(ExpLo)), _mm_set1_ps(ExpHi));
+
+    // x = n * ln(2) + r, with |r| <= ln(2) / 2. Truncation rounds negative values up, so those are stepped down.
+    __m128 fx = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(Log2e)), _mm_set1_ps(0.5f));
+    __m128 n = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+    n = _mm_sub_ps(n, _mm_and_ps(_mm_cmpgt_ps(n, fx), one));
+    x = _mm_sub_ps(x, _mm_mul_ps(n, _mm_set1_ps(Ln2Hi)));
+    x = _mm_sub_ps(x, _mm_mul_ps(n, _mm_set1_ps(Ln2Lo)));
+
+    __m128 p = _mm_set1_ps(ExpP0);
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(ExpP1));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(ExpP2));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(ExpP3));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(ExpP4));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(ExpP5));
+    p = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, x), x), _mm_add_ps(x, one));
+
+    __m128i pow2n = _mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(n), _mm_set1_epi32(127)), 23);
+    return _mm_mul_ps(p, _mm_castsi128_ps(pow2n));
+}
 
-		i += 8;
-		j += 4;
-	}
+static inline __m128 sse2Lin2Db(__m128 x)
+{
+    x = _mm_and_ps(x, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)));
+    __m128 silent = _mm_cmpeq_ps(x, _mm_setzero_ps());
+    __m128 db = _mm_mul_ps(sse2Log(_mm_max_ps(x, _mm_set1_ps(1.17549435e-38f))), _mm_set1_ps(DecibelsPerNeper));
+    return _mm_or_ps(_mm_and_ps(silent, _mm_set1_ps(SilentDecibels)), _mm_andnot_ps(silent, db));
+}
+
+static inline __m128 sse2Db2Lin(__m128 x)
+{
+    return sse2Exp(_mm_mul_ps(x, _mm_set1_ps(NepersPerDecibel)));
+}
 #endif
-	int lenTail = framesToProcess / 2;
-	for (; i < lenTail; ++i) {
-		int baseIndex = 2 * i;
-		realDestP[i] = sourceP[baseIndex];
-		imagDestP[i] = sourceP[baseIndex + 1];
-	}
+
+void vlin2db(const float* sourceP, float* destP, size_t framesToProcess)
+{
+    if (const VectorKernels* kernels = wideKernels()) {
+        kernels->vlin2db(sourceP, destP, framesToProcess);
+        return;
+    }
+
+    size_t i = 0;
+#ifdef __SSE2__
+    for (; i + 4 <= framesToProcess; i += 4)
+        _mm_storeu_ps(destP + i, sse2Lin2Db(_mm_loadu_ps(sourceP + i)));
+#endif
+
+    // -1000 dB stands in for silence, as in AudioUtilities::linearToDecibels.
+    for (; i < framesToProcess; ++i) {
+        float linear = fabsf(sourceP[i]);
+        destP[i] = linear ? 20 * log10f(linear) : -1000;
+    }
 }
 
+void vdb2lin(const float* sourceP, float* destP, size_t framesToProcess)
+{
+    if (const VectorKernels* kernels = wideKernels()) {
+        kernels->vdb2lin(sourceP, destP, framesToProcess);
+        return;
+    }
+
+    size_t i = 0;
+#ifdef __SSE2__
+    for (; i + 4 <= framesToProcess; i += 4)
+        _mm_storeu_ps(destP + i, sse2Db2Lin(_mm_loadu_ps(sourceP + i)));
+#endif
+
+    for (; i < framesToProcess; ++i)
+        destP[i] = powf(10, 0.05f * sourceP[i]);
+}
+
+void zvmag(const float* realP, const float* imagP, const float* scale, float* destP, size_t framesToProcess)
+{
+    const float gain = *scale;
+
+    if (const VectorKernels* kernels = wideKernels()) {
+        kernels->zvmag(realP, imagP, gain, destP, framesToProcess);
+        return;
+    }
+
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128 gains = _mm_set_ps1(gain);
+    for (; i + 4 <= framesToProcess; i += 4) {
+        __m128 real = _mm_loadu_ps(realP + i);
+        __m128 imag = _mm_loadu_ps(imagP + i);
+        __m128 power = _mm_add_ps(_mm_mul_ps(real, real), _mm_mul_ps(imag, imag));
+        _mm_storeu_ps(destP + i, _mm_mul_ps(_mm_sqrt_ps(power), gains));
+    }
+#elif HAVE(ARM_NEON_INTRINSICS) && defined(__aarch64__)
+    for (; i + 4 <= framesToProcess; i += 4) {
+        float32x4_t real = vld1q_f32(realP + i);
+        float32x4_t imag = vld1q_f32(imagP + i);
+        float32x4_t power = vmlaq_f32(vmulq_f32(real, real), imag, imag);
+        vst1q_f32(destP + i, vmulq_n_f32(vsqrtq_f32(power), gain));
+    }
+#endif
+    for (; i < framesToProcess; ++i)
+        destP[i] = gain * sqrtf(realP[i] * realP[i] + imagP[i] * imagP[i]);
+}
+
+void vmix(const float* const* sourcesP, const float* gainsP, size_t numberOfSources, float* destP, bool accumulate, size_t framesToProcess)
+{
+    static const float unityGains[MixGroupSize] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+
+    if (!numberOfSources) {
+        if (!accumulate)
+            memset(destP, 0, sizeof(float) * framesToProcess);
+        return;
+    }
+
+    const VectorKernels* kernels = wideKernels();
+
+    for (size_t group = 0; group < numberOfSources; group += MixGroupSize) {
+        const float* const* sources = sourcesP + group;
+        const float* gains = gainsP ? gainsP + group : unityGains;
+        size_t count = std::min(MixGroupSize, numberOfSources - group);
+
+        // Only the first group may overwrite the destination.
+        bool add = accumulate || group;
+
+        if (kernels) {
+            kernels->vmix(sources, gains, count, destP, add, framesToProcess);
+            continue;
+        }
+
+        size_t i = 0;
+#ifdef __SSE2__
+        for (; i + 4 <= framesToProcess; i += 4) {
+            __m128 sum = add ? _mm_loadu_ps(destP + i) : _mm_setzero_ps();
+            for (size_t k = 0; k < count; ++k)
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(sources[k] + i), _mm_set_ps1(gains[k])));
+            _mm_storeu_ps(destP + i, sum);
+        }
+#elif HAVE(ARM_NEON_INTRINSICS)
+        for (; i + 4 <= framesToProcess; i += 4) {
+            float32x4_t sum = add ? vld1q_f32(destP + i) : vdupq_n_f32(0);
+            for (size_t k = 0; k < count; ++k)
+                sum = vmlaq_n_f32(sum, vld1q_f32(sources[k] + i), gains[k]);
+            vst1q_f32(destP + i, sum);
+        }
+#endif
+        for (; i < framesToProcess; ++i) {
+            float sum = add ? destP[i] : 0;
+            for (size_t k = 0; k < count; ++k)
+                sum += sources[k][i] * gains[k];
+            destP[i] = sum;
+        }
+    }
+}
+
+const char* kernelName()
+{
+    if (const VectorKernels* kernels = wideKernels())
+        return kernels->name;
+
+#if OS(DARWIN)
+    return "Accelerate";
+#elif defined(__SSE2__)
+    return "SSE2";
+#elif HAVE(ARM_NEON_INTRINSICS)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
 
 } // namespace VectorMath
 
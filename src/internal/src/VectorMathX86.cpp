@@ -0,0 +1,977 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#include "internal/ConfigMacros.h"
+#include "internal/VectorMathKernels.h"
+
+#if CPU(X86) || CPU(X86_64)
+
+#if COMPILER(MSVC)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+#include <immintrin.h>
+#include <stdint.h>
+#include <string.h>
+
+// The kernels in this file are compiled for instruction sets beyond the baseline the rest of the
+// library is built for. GCC and Clang need each such function marked with the instruction sets it uses,
+// MSVC allows any intrinsic anywhere. Nothing here may be called until selectX86Kernels() has checked the CPU.
+#if COMPILER(GCC) || COMPILER(CLANG)
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+#define AVX512_TARGET __attribute__((target("avx512f,avx2,fma")))
+#else
+#define AVX2_TARGET
+#define AVX512_TARGET
+#endif
+
+namespace WebCore {
+
+namespace VectorMath {
+
+namespace {
+
+// ---------------------------------------------------------------------------------------------------------------------
+// AVX2 + FMA, 8 floats per vector
+
+AVX2_TARGET inline float avx2HorizontalSum(__m256 v)
+{
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+}
+
+AVX2_TARGET inline float avx2HorizontalMax(__m256 v)
+{
+    __m128 max = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    max = _mm_max_ps(max, _mm_movehl_ps(max, max));
+    max = _mm_max_ss(max, _mm_shuffle_ps(max, max, 1));
+    return _mm_cvtss_f32(max);
+}
+
+AVX2_TARGET inline __m256 avx2Abs(__m256 v)
+{
+    return _mm256_and_ps(v, _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff)));
+}
+
+// Natural log of strictly positive, normal values.
+AVX2_TARGET inline __m256 avx2Log(__m256 x)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    __m256i bits = _mm256_castps_si256(x);
+
+    // Split into an exponent and a mantissa in [sqrt(0.5), sqrt(2)).
+    __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+    __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f800000)));
+    __m256 large = _mm256_cmp_ps(m, _mm256_set1_ps(Sqrt2), _CMP_GT_OQ);
+    m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), large);
+    e = _mm256_add_ps(e, _mm256_and_ps(large, one));
+    x = _mm256_sub_ps(m, one);
+
+    __m256 p = _mm256_set1_ps(LogP0);
+    p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(LogP1));
+    p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(LogP2));
+    p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(LogP3));
+    p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(LogP4));
+    p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(LogP5));
+    p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(LogP6));
+    p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(LogP7));
+    p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(LogP8));
+
+    __m256 z = _mm256_mul_ps(x, x);
+    __m256 y = _mm256_mul_ps(_mm256_mul_ps(p, x), z);
+    y = _mm256_fmadd_ps(e, _mm256_set1_ps(Ln2Lo), y);
+    y = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), y);
+    x = _mm256_add_ps(x, y);
+    return _mm256_fmadd_ps(e, _mm256_set1_ps(Ln2Hi), x);
+}
+
+AVX2_TARGET inline __m256 avx2Exp(__m256 x)
+{
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(ExpLo)), _mm256_set1_ps(ExpHi));
+
+    // x = n * ln(2) + r, with |r| <= ln(2) / 2.
+    __m256 n = _mm256_floor_ps(_mm256_fmadd_ps(x, _mm256_set1_ps(Log2e), _mm256_set1_ps(0.5f)));
+    x = _mm256_fnmadd_ps(n, _mm256_set1_ps(Ln2Hi), x);
+    x = _mm256_fnmadd_ps(n, _mm256_set1_ps(Ln2Lo), x);
+
+    __m256 p = _mm256_set1_ps(ExpP0);
+    p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(ExpP1));
+    p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(ExpP2));
+    p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(ExpP3));
+    p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(ExpP4));
+    p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(ExpP5));
+    p = _mm256_fmadd_ps(p, _mm256_mul_ps(x, x), _mm256_add_ps(x, _mm256_set1_ps(1.0f)));
+
+    __m256i pow2n = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+    return _mm256_mul_ps(p, _mm256_castsi256_ps(pow2n));
+}
+
+AVX2_TARGET inline __m256 avx2Lin2Db(__m256 x)
+{
+    x = avx2Abs(x);
+    __m256 silent = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_EQ_OQ);
+    __m256 db = _mm256_mul_ps(avx2Log(_mm256_max_ps(x, _mm256_set1_ps(1.17549435e-38f))), _mm256_set1_ps(DecibelsPerNeper));
+    return _mm256_blendv_ps(db, _mm256_set1_ps(SilentDecibels), silent);
+}
+
+AVX2_TARGET inline __m256 avx2Db2Lin(__m256 x)
+{
+    return avx2Exp(_mm256_mul_ps(x, _mm256_set1_ps(NepersPerDecibel)));
+}
+
+AVX2_TARGET void avx2Vsma(const float* sourceP, float scale, float* destP, size_t framesToProcess)
+{
+    size_t i = 0;
+    __m256 k = _mm256_set1_ps(scale);
+    for (; i + 8 <= framesToProcess; i += 8)
+        _mm256_storeu_ps(destP + i, _mm256_fmadd_ps(_mm256_loadu_ps(sourceP + i), k, _mm256_loadu_ps(destP + i)));
+    for (; i < framesToProcess; ++i)
+        destP[i] += sourceP[i] * scale;
+}
+
+AVX2_TARGET void avx2Vsmul(const float* sourceP, float scale, float* destP, size_t framesToProcess)
+{
+    size_t i = 0;
+    __m256 k = _mm256_set1_ps(scale);
+    for (; i + 8 <= framesToProcess; i += 8)
+        _mm256_storeu_ps(destP + i, _mm256_mul_ps(_mm256_loadu_ps(sourceP + i), k));
+    for (; i < framesToProcess; ++i)
+        destP[i] = sourceP[i] * scale;
+}
+
+AVX2_TARGET void avx2Vadd(const float* source1P, const float* source2P, float* destP, size_t framesToProcess)
+{
+    size_t i = 0;
+    for (; i + 8 <= framesToProcess; i += 8)
+        _mm256_storeu_ps(destP + i, _mm256_add_ps(_mm256_loadu_ps(source1P + i), _mm256_loadu_ps(source2P + i)));
+    for (; i < framesToProcess; ++i)
+        destP[i] = source1P[i] + source2P[i];
+}
+
+AVX2_TARGET void avx2Vmul(const float* source1P, const float* source2P, float* destP, size_t framesToProcess)
+{
+    size_t i = 0;
+    for (; i + 8 <= framesToProcess; i += 8)
+        _mm256_storeu_ps(destP + i, _mm256_mul_ps(_mm256_loadu_ps(source1P + i), _mm256_loadu_ps(source2P + i)));
+    for (; i < framesToProcess; ++i)
+        destP[i] = source1P[i] * source2P[i];
+}
+
+AVX2_TARGET void avx2Zvmul(const float* real1P, const float* imag1P, const float* real2P, const float* imag2P, float* realDestP, float* imagDestP, size_t framesToProcess)
+{
+    size_t i = 0;
+    for (; i + 8 <= framesToProcess; i += 8) {
+        __m256 real1 = _mm256_loadu_ps(real1P + i);
+        __m256 imag1 = _mm256_loadu_ps(imag1P + i);
+        __m256 real2 = _mm256_loadu_ps(real2P + i);
+        __m256 imag2 = _mm256_loadu_ps(imag2P + i);
+        __m256 real = _mm256_fmsub_ps(real1, real2, _mm256_mul_ps(imag1, imag2));
+        __m256 imag = _mm256_fmadd_ps(real1, imag2, _mm256_mul_ps(imag1, real2));
+        _mm256_storeu_ps(realDestP + i, real);
+        _mm256_storeu_ps(imagDestP + i, imag);
+    }
+    for (; i < framesToProcess; ++i) {
+        float realResult = real1P[i] * real2P[i] - imag1P[i] * imag2P[i];
+        float imagResult = real1P[i] * imag2P[i] + imag1P[i] * real2P[i];
+        realDestP[i] = realResult;
+        imagDestP[i] = imagResult;
+    }
+}
+
+AVX2_TARGET float avx2Vsvesq(const float* sourceP, size_t framesToProcess)
+{
+    size_t i = 0;
+
+    // Two accumulators hide the latency of the fused multiply-add.
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    for (; i + 16 <= framesToProcess; i += 16) {
+        __m256 source0 = _mm256_loadu_ps(sourceP + i);
+        __m256 source1 = _mm256_loadu_ps(sourceP + i + 8);
+        sum0 = _mm256_fmadd_ps(source0, source0, sum0);
+        sum1 = _mm256_fmadd_ps(source1, source1, sum1);
+    }
+    for (; i + 8 <= framesToProcess; i += 8) {
+        __m256 source = _mm256_loadu_ps(sourceP + i);
+        sum0 = _mm256_fmadd_ps(source, source, sum0);
+    }
+
+    float sum = avx2HorizontalSum(_mm256_add_ps(sum0, sum1));
+    for (; i < framesToProcess; ++i)
+        sum += sourceP[i] * sourceP[i];
+    return sum;
+}
+
+AVX2_TARGET float avx2Vmaxmgv(const float* sourceP, size_t framesToProcess)
+{
+    size_t i = 0;
+    __m256 mMax = _mm256_setzero_ps();
+    for (; i + 8 <= framesToProcess; i += 8)
+        mMax = _mm256_max_ps(mMax, avx2Abs(_mm256_loadu_ps(sourceP + i)));
+
+    float max = avx2HorizontalMax(mMax);
+    for (; i < framesToProcess; ++i)
+        max = std::max(max, fabsf(sourceP[i]));
+    return max;
+}
+
+AVX2_TARGET void avx2Vclip(const float* sourceP, float lowThreshold, float highThreshold, float* destP, size_t framesToProcess)
+{
+    size_t i = 0;
+    __m256 low = _mm256_set1_ps(lowThreshold);
+    __m256 high = _mm256_set1_ps(highThreshold);
+    for (; i + 8 <= framesToProcess; i += 8)
+        _mm256_storeu_ps(destP + i, _mm256_max_ps(_mm256_min_ps(_mm256_loadu_ps(sourceP + i), high), low));
+    for (; i < framesToProcess; ++i)
+        destP[i] = std::max(std::min(sourceP[i], highThreshold), lowThreshold);
+}
+
+AVX2_TARGET void avx2Vintlve(const float* realSrcP, const float* imagSrcP, float* destP, size_t pairsToProcess)
+{
+    size_t i = 0;
+    for (; i + 8 <= pairsToProcess; i += 8) {
+        __m256 real = _mm256_loadu_ps(realSrcP + i);
+        __m256 imag = _mm256_loadu_ps(imagSrcP + i);
+
+        // The unpacks work within 128 bit lanes, leaving pairs 0-1 and 4-5 in lo and pairs 2-3 and 6-7 in hi.
+        __m256 lo = _mm256_unpacklo_ps(real, imag);
+        __m256 hi = _mm256_unpackhi_ps(real, imag);
+        _mm256_storeu_ps(destP + 2 * i, _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(destP + 2 * i + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+    for (; i < pairsToProcess; ++i) {
+        destP[2 * i] = realSrcP[i];
+        destP[2 * i + 1] = imagSrcP[i];
+    }
+}
+
+AVX2_TARGET void avx2Vdeintlve(const float* sourceP, float* realDestP, float* imagDestP, size_t pairsToProcess)
+{
+    size_t i = 0;
+    for (; i + 8 <= pairsToProcess; i += 8) {
+        __m256 a = _mm256_loadu_ps(sourceP + 2 * i);
+        __m256 b = _mm256_loadu_ps(sourceP + 2 * i + 8);
+
+        // Gather pairs 0-1 with 4-5 and 2-3 with 6-7 so the shuffles can pick evens and odds within lanes.
+        __m256 lo = _mm256_permute2f128_ps(a, b, 0x20);
+        __m256 hi = _mm256_permute2f128_ps(a, b, 0x31);
+        _mm256_storeu_ps(realDestP + i, _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm256_storeu_ps(imagDestP + i, _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+    for (; i < pairsToProcess; ++i) {
+        realDestP[i] = sourceP[2 * i];
+        imagDestP[i] = sourceP[2 * i + 1];
+    }
+}
+
+AVX2_TARGET void avx2Vrampmul(const float* sourceP, float gain, float gainStep, float* destP, size_t framesToProcess)
+{
+    size_t i = 0;
+    __m256 start = _mm256_set1_ps(gain);
+    __m256 step = _mm256_set1_ps(gainStep);
+    __m256 index = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 eight = _mm256_set1_ps(8);
+    for (; i + 8 <= framesToProcess; i += 8) {
+        __m256 ramp = _mm256_fmadd_ps(index, step, start);
+        _mm256_storeu_ps(destP + i, _mm256_mul_ps(_mm256_loadu_ps(sourceP + i), ramp));
+        index = _mm256_add_ps(index, eight);
+    }
+    for (; i < framesToProcess; ++i)
+        destP[i] = sourceP[i] * (gain + gainStep * i);
+}
+
+AVX2_TARGET void avx2Vrampmuladd(const float* sourceP, float gain, float gainStep, float* destP, size_t framesToProcess)
+{
+    size_t i = 0;
+    __m256 start = _mm256_set1_ps(gain);
+    __m256 step = _mm256_set1_ps(gainStep);
+    __m256 index = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 eight = _mm256_set1_ps(8);
+    for (; i + 8 <= framesToProcess; i += 8) {
+        __m256 ramp = _mm256_fmadd_ps(index, step, start);
+        _mm256_storeu_ps(destP + i, _mm256_fmadd_ps(_mm256_loadu_ps(sourceP + i), ramp, _mm256_loadu_ps(destP + i)));
+        index = _mm256_add_ps(index, eight);
+    }
+    for (; i < framesToProcess; ++i)
+        destP[i] += sourceP[i] * (gain + gainStep * i);
+}
+
+AVX2_TARGET void avx2Vcrossfade(const float* fromP, const float* toP, float mix, float mixStep, float* destP, size_t framesToProcess)
+{
+    size_t i = 0;
+    __m256 start = _mm256_set1_ps(mix);
+    __m256 step = _mm256_set1_ps(mixStep);
+    __m256 index = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 eight = _mm256_set1_ps(8);
+    for (; i + 8 <= framesToProcess; i += 8) {
+        __m256 ramp = _mm256_fmadd_ps(index, step, start);
+        __m256 from = _mm256_loadu_ps(fromP + i);
+        __m256 to = _mm256_loadu_ps(toP + i);
+        _mm256_storeu_ps(destP + i, _mm256_fmadd_ps(_mm256_sub_ps(to, from), ramp, from));
+        index = _mm256_add_ps(index, eight);
+    }
+    for (; i < framesToProcess; ++i)
+        destP[i] = fromP[i] + (toP[i] - fromP[i]) * (mix + mixStep * i);
+}
+
+AVX2_TARGET void avx2Vmin(const float* source1P, const float* source2P, float* destP, size_t framesToProcess)
+{
+    size_t i = 0;
+    for (; i + 8 <= framesToProcess; i += 8)
+        _mm256_storeu_ps(destP + i, _mm256_min_ps(_mm256_loadu_ps(source1P + i), _mm256_loadu_ps(source2P + i)));
+    for (; i < framesToProcess; ++i)
+        destP[i] = std::min(source1P[i], source2P[i]);
+}
+
+AVX2_TARGET void avx2Vmax(const float* source1P, const float* source2P, float* destP, size_t framesToProcess)
+{
+    size_t i = 0;
+    for (; i + 8 <= framesToProcess; i += 8)
+        _mm256_storeu_ps(destP + i, _mm256_max_ps(_mm256_loadu_ps(source1P + i), _mm256_loadu_ps(source2P + i)));
+    for (; i < framesToProcess; ++i)
+        destP[i] = std::max(source1P[i], source2P[i]);
+}
+
+AVX2_TARGET void avx2Vabs(const float* sourceP, float* destP, size_t framesToProcess)
+{
+    size_t i = 0;
+    for (; i + 8 <= framesToProcess; i += 8)
+        _mm256_storeu_ps(destP + i, avx2Abs(_mm256_loadu_ps(sourceP + i)));
+    for (; i < framesToProcess; ++i)
+        destP[i] = fabsf(sourceP[i]);
+}
+
+// The decibel conversions run their tails through the vector code as well, so that every
+// sample of a block is converted with the same approximation.
+AVX2_TARGET void avx2Vlin2db(const float* sourceP, float* destP, size_t framesToProcess)
+{
+    size_t i = 0;
+    for (; i + 8 <= framesToProcess; i += 8)
+        _mm256_storeu_ps(destP + i, avx2Lin2Db(_mm256_loadu_ps(sourceP + i)));
+
+    if (size_t tail = framesToProcess - i) {
+        float block[8] = { 0 };
+        memcpy(block, sourceP + i, sizeof(float) * tail);
+        _mm256_storeu_ps(block, avx2Lin2Db(_mm256_loadu_ps(block)));
+        memcpy(destP + i, block, sizeof(float) * tail);
+    }
+}
+
+AVX2_TARGET void avx2Vdb2lin(const float* sourceP, float* destP, size_t framesToProcess)
+{
+    size_t i = 0;
+    for (; i + 8 <= framesToProcess; i += 8)
+        _mm256_storeu_ps(destP + i, avx2Db2Lin(_mm256_loadu_ps(sourceP + i)));
+
+    if (size_t tail = framesToProcess - i) {
+        float block[8] = { 0 };
+        memcpy(block, sourceP + i, sizeof(float) * tail);
+        _mm256_storeu_ps(block, avx2Db2Lin(_mm256_loadu_ps(block)));
+        memcpy(destP + i, block, sizeof(float) * tail);
+    }
+}
+
+AVX2_TARGET void avx2Zvmag(const float* realP, const float* imagP, float scale, float* destP, size_t framesToProcess)
+{
+    size_t i = 0;
+    __m256 gain = _mm256_set1_ps(scale);
+    for (; i + 8 <= framesToProcess; i += 8) {
+        __m256 real = _mm256_loadu_ps(realP + i);
+        __m256 imag = _mm256_loadu_ps(imagP + i);
+        __m256 power = _mm256_fmadd_ps(real, real, _mm256_mul_ps(imag, imag));
+        _mm256_storeu_ps(destP + i, _mm256_mul_ps(_mm256_sqrt_ps(power), gain));
+    }
+    for (; i < framesToProcess; ++i)
+        destP[i] = scale * sqrtf(realP[i] * realP[i] + imagP[i] * imagP[i]);
+}
+
+AVX2_TARGET void avx2Vmix(const float* const* sourcesP, const float* gainsP, size_t numberOfSources, float* destP, bool accumulate, size_t framesToProcess)
+{
+    __m256 gains[MixGroupSize];
+    for (size_t k = 0; k < numberOfSources; ++k)
+        gains[k] = _mm256_set1_ps(gainsP[k]);
+
+    size_t i = 0;
+    for (; i + 8 <= framesToProcess; i += 8) {
+        __m256 sum = accumulate ? _mm256_loadu_ps(destP + i) : _mm256_setzero_ps();
+        for (size_t k = 0; k < numberOfSources; ++k)
+            sum = _mm256_fmadd_ps(_mm256_loadu_ps(sourcesP[k] + i), gains[k], sum);
+        _mm256_storeu_ps(destP + i, sum);
+    }
+    for (; i < framesToProcess; ++i) {
+        float sum = accumulate ? destP[i] : 0;
+        for (size_t k = 0; k < numberOfSources; ++k)
+            sum += sourcesP[k][i] * gainsP[k];
+        destP[i] = sum;
+    }
+}
+
+AVX2_TARGET void avx2SincConvolve(const float* sourceP, const float* kernel1P, const float* kernel2P, size_t kernelSize, float* sum1P, float* sum2P)
+{
+    __m256 sums1 = _mm256_setzero_ps();
+    __m256 sums2 = _mm256_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 8 <= kernelSize; i += 8) {
+        __m256 source = _mm256_loadu_ps(sourceP + i);
+        sums1 = _mm256_fmadd_ps(source, _mm256_loadu_ps(kernel1P + i), sums1);
+        sums2 = _mm256_fmadd_ps(source, _mm256_loadu_ps(kernel2P + i), sums2);
+    }
+
+    float sum1 = avx2HorizontalSum(sums1);
+    float sum2 = avx2HorizontalSum(sums2);
+    for (; i < kernelSize; ++i) {
+        sum1 += sourceP[i] * kernel1P[i];
+        sum2 += sourceP[i] * kernel2P[i];
+    }
+    *sum1P = sum1;
+    *sum2P = sum2;
+}
+
+AVX2_TARGET void avx2SincConvolvePair(const float* source1P, const float* source2P, const float* kernel1P, const float* kernel2P, float kernelInterpolationFactor, size_t kernelSize, float* sum1P, float* sum2P)
+{
+    __m256 sums1 = _mm256_setzero_ps();
+    __m256 sums2 = _mm256_setzero_ps();
+    __m256 factor = _mm256_set1_ps(kernelInterpolationFactor);
+
+    size_t i = 0;
+    for (; i + 8 <= kernelSize; i += 8) {
+        __m256 kernel1 = _mm256_loadu_ps(kernel1P + i);
+        __m256 kernel = _mm256_fmadd_ps(factor, _mm256_sub_ps(_mm256_loadu_ps(kernel2P + i), kernel1), kernel1);
+        sums1 = _mm256_fmadd_ps(_mm256_loadu_ps(source1P + i), kernel, sums1);
+        sums2 = _mm256_fmadd_ps(_mm256_loadu_ps(source2P + i), kernel, sums2);
+    }
+
+    float sum1 = avx2HorizontalSum(sums1);
+    float sum2 = avx2HorizontalSum(sums2);
+    for (; i < kernelSize; ++i) {
+        float kernel = kernel1P[i] + kernelInterpolationFactor * (kernel2P[i] - kernel1P[i]);
+        sum1 += source1P[i] * kernel;
+        sum2 += source2P[i] * kernel;
+    }
+    *sum1P = sum1;
+    *sum2P = sum2;
+}
+
+const VectorKernels AVX2Kernels = {
+    "AVX2",
+    avx2Vsma, avx2Vsmul, avx2Vadd, avx2Vmul, avx2Zvmul, avx2Vsvesq, avx2Vmaxmgv, avx2Vclip,
+    avx2Vintlve, avx2Vdeintlve,
+    avx2Vrampmul, avx2Vrampmuladd, avx2Vcrossfade, avx2Vmin, avx2Vmax, avx2Vabs, avx2Vlin2db, avx2Vdb2lin, avx2Zvmag,
+    avx2Vmix,
+    avx2SincConvolve, avx2SincConvolvePair
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+// AVX-512F, 16 floats per vector. Tails are handled with masked loads and stores rather than scalar loops.
+
+// GCC's unmasked AVX-512 intrinsics, such as _mm512_max_ps, pass _mm512_undefined_ps() as the source their
+// results merge into. Every lane is written, but once they're inlined -Wuninitialized reports the undefined
+// value anyway, so the warning is silenced for this section.
+#if COMPILER(GCC) && !COMPILER(CLANG)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// Mask selecting the first 'frames' lanes, for frames < 16.
+AVX512_TARGET inline __mmask16 avx512TailMask(size_t frames)
+{
+    return static_cast<__mmask16>((1u << frames) - 1);
+}
+
+// The halves are combined and then reduced as in avx2HorizontalSum and avx2HorizontalMax.
+AVX512_TARGET inline float avx512HorizontalSum(__m512 v)
+{
+    __m256 high = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1));
+    return avx2HorizontalSum(_mm256_add_ps(_mm512_castps512_ps256(v), high));
+}
+
+AVX512_TARGET inline float avx512HorizontalMax(__m512 v)
+{
+    __m256 high = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1));
+    return avx2HorizontalMax(_mm256_max_ps(_mm512_castps512_ps256(v), high));
+}
+
+AVX512_TARGET inline __m512 avx512Log(__m512 x)
+{
+    const __m512 one = _mm512_set1_ps(1.0f);
+    __m512i bits = _mm512_castps_si512(x);
+
+    __m512 e = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_srli_epi32(bits, 23), _mm512_set1_epi32(127)));
+    __m512 m = _mm512_castsi512_ps(_mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi32(0x007fffff)), _mm512_set1_epi32(0x3f800000)));
+    __mmask16 large = _mm512_cmp_ps_mask(m, _mm512_set1_ps(Sqrt2), _CMP_GT_OQ);
+    m = _mm512_mask_mul_ps(m, large, m, _mm512_set1_ps(0.5f));
+    e = _mm512_mask_add_ps(e, large, e, one);
+    x = _mm512_sub_ps(m, one);
+
+    __m512 p = _mm512_set1_ps(LogP0);
+    p = _mm512_fmadd_ps(p, x, _mm512_set1_ps(LogP1));
+    p = _mm512_fmadd_ps(p, x, _mm512_set1_ps(LogP2));
+    p = _mm512_fmadd_ps(p, x, _mm512_set1_ps(LogP3));
+    p = _mm512_fmadd_ps(p, x, _mm512_set1_ps(LogP4));
+    p = _mm512_fmadd_ps(p, x, _mm512_set1_ps(LogP5));
+    p = _mm512_fmadd_ps(p, x, _mm512_set1_ps(LogP6));
+    p = _mm512_fmadd_ps(p, x, _mm512_set1_ps(LogP7));
+    p = _mm512_fmadd_ps(p, x, _mm512_set1_ps(LogP8));
+
+    __m512 z = _mm512_mul_ps(x, x);
+    __m512 y = _mm512_mul_ps(_mm512_mul_ps(p, x), z);
+    y = _mm512_fmadd_ps(e, _mm512_set1_ps(Ln2Lo), y);
+    y = _mm512_fnmadd_ps(z, _mm512_set1_ps(0.5f), y);
+    x = _mm512_add_ps(x, y);
+    return _mm512_fmadd_ps(e, _mm512_set1_ps(Ln2Hi), x);
+}
+
+AVX512_TARGET inline __m512 avx512Exp(__m512 x)
+{
+    x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(ExpLo)), _mm512_set1_ps(ExpHi));
+
+    __m512 n = _mm512_roundscale_ps(_mm512_fmadd_ps(x, _mm512_set1_ps(Log2e), _mm512_set1_ps(0.5f)), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    x = _mm512_fnmadd_ps(n, _mm512_set1_ps(Ln2Hi), x);
+    x = _mm512_fnmadd_ps(n, _mm512_set1_ps(Ln2Lo), x);
+
+    __m512 p = _mm512_set1_ps(ExpP0);
+    p = _mm512_fmadd_ps(p, x, _mm512_set1_ps(ExpP1));
+    p = _mm512_fmadd_ps(p, x, _mm512_set1_ps(ExpP2));
+    p = _mm512_fmadd_ps(p, x, _mm512_set1_ps(ExpP3));
+    p = _mm512_fmadd_ps(p, x, _mm512_set1_ps(ExpP4));
+    p = _mm512_fmadd_ps(p, x, _mm512_set1_ps(ExpP5));
+    p = _mm512_fmadd_ps(p, _mm512_mul_ps(x, x), _mm512_add_ps(x, _mm512_set1_ps(1.0f)));
+
+    __m512i pow2n = _mm512_slli_epi32(_mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127)), 23);
+    return _mm512_mul_ps(p, _mm512_castsi512_ps(pow2n));
+}
+
+AVX512_TARGET inline __m512 avx512Lin2Db(__m512 x)
+{
+    x = _mm512_abs_ps(x);
+    __mmask16 silent = _mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_EQ_OQ);
+    __m512 db = _mm512_mul_ps(avx512Log(_mm512_max_ps(x, _mm512_set1_ps(1.17549435e-38f))), _mm512_set1_ps(DecibelsPerNeper));
+    return _mm512_mask_mov_ps(db, silent, _mm512_set1_ps(SilentDecibels));
+}
+
+AVX512_TARGET inline __m512 avx512Db2Lin(__m512 x)
+{
+    return avx512Exp(_mm512_mul_ps(x, _mm512_set1_ps(NepersPerDecibel)));
+}
+
+AVX512_TARGET void avx512Vsma(const float* sourceP, float scale, float* destP, size_t framesToProcess)
+{
+    size_t i = 0;
+    __m512 k = _mm512_set1_ps(scale);
+    for (; i + 16 <= framesToProcess; i += 16)
+        _mm512_storeu_ps(destP + i, _mm512_fmadd_ps(_mm512_loadu_ps(sourceP + i), k, _mm512_loadu_ps(destP + i)));
+    if (i < framesToProcess) {
+        __mmask16 mask = avx512TailMask(framesToProcess - i);
+        __m512 dest = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, sourceP + i), k, _mm512_maskz_loadu_ps(mask, destP + i));
+        _mm512_mask_storeu_ps(destP + i, mask, dest);
+    }
+}
+
+AVX512_TARGET void avx512Vsmul(const float* sourceP, float scale, float* destP, size_t framesToProcess)
+{
+    size_t i = 0;
+    __m512 k = _mm512_set1_ps(scale);
+    for (; i + 16 <= framesToProcess; i += 16)
+        _mm512_storeu_ps(destP + i, _mm512_mul_ps(_mm512_loadu_ps(sourceP + i), k));
+    if (i < framesToProcess) {
+        __mmask16 mask = avx512TailMask(framesToProcess - i);
+        _mm512_mask_storeu_ps(destP + i, mask, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, sourceP + i), k));
+    }
+}
+
+AVX512_TARGET void avx512Vadd(const float* source1P, const float* source2P, float* destP, size_t framesToProcess)
+{
+    size_t i = 0;
+    for (; i + 16 <= framesToProcess; i += 16)
+        _mm512_storeu_ps(destP + i, _mm512_add_ps(_mm512_loadu_ps(source1P + i), _mm512_loadu_ps(source2P + i)));
+    if (i < framesToProcess) {
+        __mmask16 mask = avx512TailMask(framesToProcess - i);
+        _mm512_mask_storeu_ps(destP + i, mask, _mm512_add_ps(_mm512_maskz_loadu_ps(mask, source1P + i), _mm512_maskz_loadu_ps(mask, source2P + i)));
+    }
+}
+
+AVX512_TARGET void avx512Vmul(const float* source1P, const float* source2P, float* destP, size_t framesToProcess)
+{
+    size_t i = 0;
+    for (; i + 16 <= framesToProcess; i += 16)
+        _mm512_storeu_ps(destP + i, _mm512_mul_ps(_mm512_loadu_ps(source1P + i), _mm512_loadu_ps(source2P + i)));
+    if (i < framesToProcess) {
+        __mmask16 mask = avx512TailMask(framesToProcess - i);
+        _mm512_mask_storeu_ps(destP + i, mask, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, source1P + i), _mm512_maskz_loadu_ps(mask, source2P + i)));
+    }
+}
+
+AVX512_TARGET void avx512Zvmul(const float* real1P, const float* imag1P, const float* real2P, const float* imag2P, float* realDestP, float* imagDestP, size_t framesToProcess)
+{
+    for (size_t i = 0; i < framesToProcess; i += 16) {
+        __mmask16 mask = framesToProcess - i >= 16 ? 0xffff : avx512TailMask(framesToProcess - i);
+        __m512 real1 = _mm512_maskz_loadu_ps(mask, real1P + i);
+        __m512 imag1 = _mm512_maskz_loadu_ps(mask, imag1P + i);
+        __m512 real2 = _mm512_maskz_loadu_ps(mask, real2P + i);
+        __m512 imag2 = _mm512_maskz_loadu_ps(mask, imag2P + i);
+        __m512 real = _mm512_fmsub_ps(real1, real2, _mm512_mul_ps(imag1, imag2));
+        __m512 imag = _mm512_fmadd_ps(real1, imag2, _mm512_mul_ps(imag1, real2));
+        _mm512_mask_storeu_ps(realDestP + i, mask, real);
+        _mm512_mask_storeu_ps(imagDestP + i, mask, imag);
+    }
+}
+
+AVX512_TARGET float avx512Vsvesq(const float* sourceP, size_t framesToProcess)
+{
+    size_t i = 0;
+    __m512 sum0 = _mm512_setzero_ps();
+    __m512 sum1 = _mm512_setzero_ps();
+    for (; i + 32 <= framesToProcess; i += 32) {
+        __m512 source0 = _mm512_loadu_ps(sourceP + i);
+        __m512 source1 = _mm512_loadu_ps(sourceP + i + 16);
+        sum0 = _mm512_fmadd_ps(source0, source0, sum0);
+        sum1 = _mm512_fmadd_ps(source1, source1, sum1);
+    }
+    for (; i < framesToProcess; i += 16) {
+        __mmask16 mask = framesToProcess - i >= 16 ? 0xffff : avx512TailMask(framesToProcess - i);
+        __m512 source = _mm512_maskz_loadu_ps(mask, sourceP + i);
+        sum0 = _mm512_fmadd_ps(source, source, sum0);
+    }
+    return avx512HorizontalSum(_mm512_add_ps(sum0, sum1));
+}
+
+AVX512_TARGET float avx512Vmaxmgv(const float* sourceP, size_t framesToProcess)
+{
+    __m512 mMax = _mm512_setzero_ps();
+    for (size_t i = 0; i < framesToProcess; i += 16) {
+        __mmask16 mask = framesToProcess - i >= 16 ? 0xffff : avx512TailMask(framesToProcess - i);
+        mMax = _mm512_max_ps(mMax, _mm512_abs_ps(_mm512_maskz_loadu_ps(mask, sourceP + i)));
+    }
+    return avx512HorizontalMax(mMax);
+}
+
+AVX512_TARGET void avx512Vclip(const float* sourceP, float lowThreshold, float highThreshold, float* destP, size_t framesToProcess)
+{
+    __m512 low = _mm512_set1_ps(lowThreshold);
+    __m512 high = _mm512_set1_ps(highThreshold);
+    for (size_t i = 0; i < framesToProcess; i += 16) {
+        __mmask16 mask = framesToProcess - i >= 16 ? 0xffff : avx512TailMask(framesToProcess - i);
+        __m512 source = _mm512_maskz_loadu_ps(mask, sourceP + i);
+        _mm512_mask_storeu_ps(destP + i, mask, _mm512_max_ps(_mm512_min_ps(source, high), low));
+    }
+}
+
+AVX512_TARGET void avx512Vintlve(const float* realSrcP, const float* imagSrcP, float* destP, size_t pairsToProcess)
+{
+    // Indices 0-15 select from the real vector, 16-31 from the imaginary one.
+    const __m512i lowPairs = _mm512_setr_epi32(0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+    const __m512i highPairs = _mm512_setr_epi32(8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+
+    size_t i = 0;
+    for (; i + 16 <= pairsToProcess; i += 16) {
+        __m512 real = _mm512_loadu_ps(realSrcP + i);
+        __m512 imag = _mm512_loadu_ps(imagSrcP + i);
+        _mm512_storeu_ps(destP + 2 * i, _mm512_permutex2var_ps(real, lowPairs, imag));
+        _mm512_storeu_ps(destP + 2 * i + 16, _mm512_permutex2var_ps(real, highPairs, imag));
+    }
+    for (; i < pairsToProcess; ++i) {
+        destP[2 * i] = realSrcP[i];
+        destP[2 * i + 1] = imagSrcP[i];
+    }
+}
+
+AVX512_TARGET void avx512Vdeintlve(const float* sourceP, float* realDestP, float* imagDestP, size_t pairsToProcess)
+{
+    const __m512i evens = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    const __m512i odds = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+
+    size_t i = 0;
+    for (; i + 16 <= pairsToProcess; i += 16) {
+        __m512 a = _mm512_loadu_ps(sourceP + 2 * i);
+        __m512 b = _mm512_loadu_ps(sourceP + 2 * i + 16);
+        _mm512_storeu_ps(realDestP + i, _mm512_permutex2var_ps(a, evens, b));
+        _mm512_storeu_ps(imagDestP + i, _mm512_permutex2var_ps(a, odds, b));
+    }
+    for (; i < pairsToProcess; ++i) {
+        realDestP[i] = sourceP[2 * i];
+        imagDestP[i] = sourceP[2 * i + 1];
+    }
+}
+
+AVX512_TARGET void avx512Vrampmul(const float* sourceP, float gain, float gainStep, float* destP, size_t framesToProcess)
+{
+    __m512 start = _mm512_set1_ps(gain);
+    __m512 step = _mm512_set1_ps(gainStep);
+    __m512 index = _mm512_setr_ps(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512 sixteen = _mm512_set1_ps(16);
+    for (size_t i = 0; i < framesToProcess; i += 16) {
+        __mmask16 mask = framesToProcess - i >= 16 ? 0xffff : avx512TailMask(framesToProcess - i);
+        __m512 ramp = _mm512_fmadd_ps(index, step, start);
+        _mm512_mask_storeu_ps(destP + i, mask, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, sourceP + i), ramp));
+        index = _mm512_add_ps(index, sixteen);
+    }
+}
+
+AVX512_TARGET void avx512Vrampmuladd(const float* sourceP, float gain, float gainStep, float* destP, size_t framesToProcess)
+{
+    __m512 start = _mm512_set1_ps(gain);
+    __m512 step = _mm512_set1_ps(gainStep);
+    __m512 index = _mm512_setr_ps(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512 sixteen = _mm512_set1_ps(16);
+    for (size_t i = 0; i < framesToProcess; i += 16) {
+        __mmask16 mask = framesToProcess - i >= 16 ? 0xffff : avx512TailMask(framesToProcess - i);
+        __m512 ramp = _mm512_fmadd_ps(index, step, start);
+        __m512 dest = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, sourceP + i), ramp, _mm512_maskz_loadu_ps(mask, destP + i));
+        _mm512_mask_storeu_ps(destP + i, mask, dest);
+        index = _mm512_add_ps(index, sixteen);
+    }
+}
+
+AVX512_TARGET void avx512Vcrossfade(const float* fromP, const float* toP, float mix, float mixStep, float* destP, size_t framesToProcess)
+{
+    __m512 start = _mm512_set1_ps(mix);
+    __m512 step = _mm512_set1_ps(mixStep);
+    __m512 index = _mm512_setr_ps(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512 sixteen = _mm512_set1_ps(16);
+    for (size_t i = 0; i < framesToProcess; i += 16) {
+        __mmask16 mask = framesToProcess - i >= 16 ? 0xffff : avx512TailMask(framesToProcess - i);
+        __m512 ramp = _mm512_fmadd_ps(index, step, start);
+        __m512 from = _mm512_maskz_loadu_ps(mask, fromP + i);
+        __m512 to = _mm512_maskz_loadu_ps(mask, toP + i);
+        _mm512_mask_storeu_ps(destP + i, mask, _mm512_fmadd_ps(_mm512_sub_ps(to, from), ramp, from));
+        index = _mm512_add_ps(index, sixteen);
+    }
+}
+
+AVX512_TARGET void avx512Vmin(const float* source1P, const float* source2P, float* destP, size_t framesToProcess)
+{
+    for (size_t i = 0; i < framesToProcess; i += 16) {
+        __mmask16 mask = framesToProcess - i >= 16 ? 0xffff : avx512TailMask(framesToProcess - i);
+        _mm512_mask_storeu_ps(destP + i, mask, _mm512_min_ps(_mm512_maskz_loadu_ps(mask, source1P + i), _mm512_maskz_loadu_ps(mask, source2P + i)));
+    }
+}
+
+AVX512_TARGET void avx512Vmax(const float* source1P, const float* source2P, float* destP, size_t framesToProcess)
+{
+    for (size_t i = 0; i < framesToProcess; i += 16) {
+        __mmask16 mask = framesToProcess - i >= 16 ? 0xffff : avx512TailMask(framesToProcess - i);
+        _mm512_mask_storeu_ps(destP + i, mask, _mm512_max_ps(_mm512_maskz_loadu_ps(mask, source1P + i), _mm512_maskz_loadu_ps(mask, source2P + i)));
+    }
+}
+
+AVX512_TARGET void avx512Vabs(const float* sourceP, float* destP, size_t framesToProcess)
+{
+    for (size_t i = 0; i < framesToProcess; i += 16) {
+        __mmask16 mask = framesToProcess - i >= 16 ? 0xffff : avx512TailMask(framesToProcess - i);
+        _mm512_mask_storeu_ps(destP + i, mask, _mm512_abs_ps(_mm512_maskz_loadu_ps(mask, sourceP + i)));
+    }
+}
+
+AVX512_TARGET void avx512Vlin2db(const float* sourceP, float* destP, size_t framesToProcess)
+{
+    for (size_t i = 0; i < framesToProcess; i += 16) {
+        __mmask16 mask = framesToProcess - i >= 16 ? 0xffff : avx512TailMask(framesToProcess - i);
+        _mm512_mask_storeu_ps(destP + i, mask, avx512Lin2Db(_mm512_maskz_loadu_ps(mask, sourceP + i)));
+    }
+}
+
+AVX512_TARGET void avx512Vdb2lin(const float* sourceP, float* destP, size_t framesToProcess)
+{
+    for (size_t i = 0; i < framesToProcess; i += 16) {
+        __mmask16 mask = framesToProcess - i >= 16 ? 0xffff : avx512TailMask(framesToProcess - i);
+        _mm512_mask_storeu_ps(destP + i, mask, avx512Db2Lin(_mm512_maskz_loadu_ps(mask, sourceP + i)));
+    }
+}
+
+AVX512_TARGET void avx512Zvmag(const float* realP, const float* imagP, float scale, float* destP, size_t framesToProcess)
+{
+    __m512 gain = _mm512_set1_ps(scale);
+    for (size_t i = 0; i < framesToProcess; i += 16) {
+        __mmask16 mask = framesToProcess - i >= 16 ? 0xffff : avx512TailMask(framesToProcess - i);
+        __m512 real = _mm512_maskz_loadu_ps(mask, realP + i);
+        __m512 imag = _mm512_maskz_loadu_ps(mask, imagP + i);
+        __m512 power = _mm512_fmadd_ps(real, real, _mm512_mul_ps(imag, imag));
+        _mm512_mask_storeu_ps(destP + i, mask, _mm512_mul_ps(_mm512_sqrt_ps(power), gain));
+    }
+}
+
+AVX512_TARGET void avx512Vmix(const float* const* sourcesP, const float* gainsP, size_t numberOfSources, float* destP, bool accumulate, size_t framesToProcess)
+{
+    __m512 gains[MixGroupSize];
+    for (size_t k = 0; k < numberOfSources; ++k)
+        gains[k] = _mm512_set1_ps(gainsP[k]);
+
+    for (size_t i = 0; i < framesToProcess; i += 16) {
+        __mmask16 mask = framesToProcess - i >= 16 ? 0xffff : avx512TailMask(framesToProcess - i);
+        __m512 sum = accumulate ? _mm512_maskz_loadu_ps(mask, destP + i) : _mm512_setzero_ps();
+        for (size_t k = 0; k < numberOfSources; ++k)
+            sum = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, sourcesP[k] + i), gains[k], sum);
+        _mm512_mask_storeu_ps(destP + i, mask, sum);
+    }
+}
+
+AVX512_TARGET void avx512SincConvolve(const float* sourceP, const float* kernel1P, const float* kernel2P, size_t kernelSize, float* sum1P, float* sum2P)
+{
+    __m512 sums1 = _mm512_setzero_ps();
+    __m512 sums2 = _mm512_setzero_ps();
+
+    for (size_t i = 0; i < kernelSize; i += 16) {
+        __mmask16 mask = kernelSize - i >= 16 ? 0xffff : avx512TailMask(kernelSize - i);
+        __m512 source = _mm512_maskz_loadu_ps(mask, sourceP + i);
+        sums1 = _mm512_fmadd_ps(source, _mm512_maskz_loadu_ps(mask, kernel1P + i), sums1);
+        sums2 = _mm512_fmadd_ps(source, _mm512_maskz_loadu_ps(mask, kernel2P + i), sums2);
+    }
+
+    *sum1P = avx512HorizontalSum(sums1);
+    *sum2P = avx512HorizontalSum(sums2);
+}
+
+AVX512_TARGET void avx512SincConvolvePair(const float* source1P, const float* source2P, const float* kernel1P, const float* kernel2P, float kernelInterpolationFactor, size_t kernelSize, float* sum1P, float* sum2P)
+{
+    __m512 sums1 = _mm512_setzero_ps();
+    __m512 sums2 = _mm512_setzero_ps();
+    __m512 factor = _mm512_set1_ps(kernelInterpolationFactor);
+
+    for (size_t i = 0; i < kernelSize; i += 16) {
+        __mmask16 mask = kernelSize - i >= 16 ? 0xffff : avx512TailMask(kernelSize - i);
+        __m512 kernel1 = _mm512_maskz_loadu_ps(mask, kernel1P + i);
+        __m512 kernel = _mm512_fmadd_ps(factor, _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, kernel2P + i), kernel1), kernel1);
+        sums1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, source1P + i), kernel, sums1);
+        sums2 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, source2P + i), kernel, sums2);
+    }
+
+    *sum1P = avx512HorizontalSum(sums1);
+    *sum2P = avx512HorizontalSum(sums2);
+}
+
+const VectorKernels AVX512Kernels = {
+    "AVX-512",
+    avx512Vsma, avx512Vsmul, avx512Vadd, avx512Vmul, avx512Zvmul, avx512Vsvesq, avx512Vmaxmgv, avx512Vclip,
+    avx512Vintlve, avx512Vdeintlve,
+    avx512Vrampmul, avx512Vrampmuladd, avx512Vcrossfade, avx512Vmin, avx512Vmax, avx512Vabs, avx512Vlin2db, avx512Vdb2lin, avx512Zvmag,
+    avx512Vmix,
+    avx512SincConvolve, avx512SincConvolvePair
+};
+
+#if COMPILER(GCC) && !COMPILER(CLANG)
+#pragma GCC diagnostic pop
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+// CPU detection
+
+void cpuid(int leaf, int subleaf, uint32_t regs[4])
+{
+#if COMPILER(MSVC)
+    int info[4];
+    __cpuidex(info, leaf, subleaf);
+    for (int i = 0; i < 4; ++i)
+        regs[i] = static_cast<uint32_t>(info[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// The register state the operating system saves on a context switch. Wide registers
+// are unusable unless the OS has opted in to preserving them, whatever cpuid reports.
+uint64_t enabledRegisterState()
+{
+#if COMPILER(MSVC)
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+struct X86Support
+{
+    bool avx2;
+    bool avx512;
+};
+
+X86Support detectX86Support()
+{
+    X86Support support = { false, false };
+
+    uint32_t regs[4];
+    cpuid(0, 0, regs);
+    if (regs[0] < 7)
+        return support;
+
+    cpuid(1, 0, regs);
+    const bool osxsave = (regs[2] & (1u << 27)) != 0;
+    const bool fma = (regs[2] & (1u << 12)) != 0;
+    if (!osxsave)
+        return support;
+
+    const uint64_t state = enabledRegisterState();
+    const bool ymmState = (state & 0x06) == 0x06;     // SSE and AVX state
+    const bool zmmState = (state & 0xe6) == 0xe6;     // plus opmask and both halves of the upper ZMM registers
+
+    cpuid(7, 0, regs);
+    const bool avx2 = (regs[1] & (1u << 5)) != 0;
+    const bool avx512f = (regs[1] & (1u << 16)) != 0;
+
+    support.avx2 = avx2 && fma && ymmState;
+    support.avx512 = support.avx2 && avx512f && zmmState;
+    return support;
+}
+
+const X86Support& x86Support()
+{
+    static X86Support support = detectX86Support();
+    return support;
+}
+
+} // anonymous namespace
+
+const VectorKernels* avx2Kernels()
+{
+    return x86Support().avx2 ? &AVX2Kernels : nullptr;
+}
+
+const VectorKernels* avx512Kernels()
+{
+    return x86Support().avx512 ? &AVX512Kernels : nullptr;
+}
+
+const VectorKernels* selectX86Kernels()
+{
+    if (const VectorKernels* kernels = avx512Kernels())
+        return kernels;
+    return avx2Kernels();
+}
+
+} // namespace VectorMath
+
+} // namespace WebCore
+
+#else
+
+namespace WebCore {
+
+namespace VectorMath {
+
+const VectorKernels* avx2Kernels()
+{
+    return nullptr;
+}
+
+const VectorKernels* avx512Kernels()
+{
+    return nullptr;
+}
+
+const VectorKernels* selectX86Kernels()
+{
+    return nullptr;
+}
+
+} // namespace VectorMath
+
+} // namespace WebCore
+
+#endif // CPU(X86) || CPU(X86_64)
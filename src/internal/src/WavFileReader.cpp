@@ -0,0 +1,234 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#include "internal/WavFileReader.h"
+#include "internal/Assertions.h"
+#include "internal/ConfigMacros.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace WebCore {
+
+namespace {
+
+    const uint16_t WaveFormatPCM = 1;
+    const uint16_t WaveFormatIEEEFloat = 3;
+    const uint16_t WaveFormatExtensible = 0xfffe;
+
+    // WAV fields are little endian whatever the host is.
+    uint16_t u16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+    uint32_t u32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24); }
+    uint64_t u64(const uint8_t* p) { return u32(p) | (static_cast<uint64_t>(u32(p + 4)) << 32); }
+
+    // Files can be longer than a long can address on some platforms.
+    bool seekTo(FILE* file, uint64_t offset)
+    {
+#if OS(WINDOWS)
+        return !_fseeki64(file, static_cast<__int64>(offset), SEEK_SET);
+#else
+        return !fseeko(file, static_cast<off_t>(offset), SEEK_SET);
+#endif
+    }
+
+    bool readBytes(FILE* file, uint8_t* bytes, size_t count)
+    {
+        return fread(bytes, 1, count, file) == count;
+    }
+
+} // namespace
+
+WavFileReader::WavFileReader()
+    : m_file(0)
+    , m_numberOfChannels(0)
+    , m_sampleRate(0)
+    , m_bytesPerSample(0)
+    , m_isFloat(false)
+    , m_dataOffset(0)
+    , m_length(0)
+    , m_position(0)
+{
+}
+
+WavFileReader::~WavFileReader()
+{
+    close();
+}
+
+void WavFileReader::close()
+{
+    if (m_file)
+        fclose(m_file);
+
+    m_file = 0;
+    m_numberOfChannels = 0;
+    m_length = 0;
+    m_position = 0;
+}
+
+bool WavFileReader::open(const std::string& path)
+{
+    close();
+
+    m_file = fopen(path.c_str(), "rb");
+    if (!m_file)
+        return false;
+
+    uint8_t header[12];
+    bool isRF64 = false;
+    if (!readBytes(m_file, header, sizeof(header))
+        || !(memcmp(header, "RIFF", 4) == 0 || (isRF64 = memcmp(header, "RF64", 4) == 0))
+        || memcmp(header + 8, "WAVE", 4) != 0) {
+        close();
+        return false;
+    }
+
+    // Walk the chunks until the data chunk, which must come after fmt and, in an RF64 file, ds64.
+    uint64_t offset = sizeof(header);
+    uint64_t rf64DataSize = 0;
+    uint16_t formatTag = 0;
+    unsigned bitsPerSample = 0;
+    unsigned blockAlign = 0;
+    bool haveFormat = false;
+
+    for (;;) {
+        uint8_t chunk[8];
+        if (!seekTo(m_file, offset) || !readBytes(m_file, chunk, sizeof(chunk))) {
+            close();
+            return false;
+        }
+
+        uint64_t chunkSize = u32(chunk + 4);
+
+        if (!memcmp(chunk, "ds64", 4) && chunkSize >= 16) {
+            uint8_t ds64[16];
+            if (!readBytes(m_file, ds64, sizeof(ds64))) {
+                close();
+                return false;
+            }
+            rf64DataSize = u64(ds64 + 8);
+        }
+        else if (!memcmp(chunk, "fmt ", 4) && chunkSize >= 16) {
+            uint8_t format[40] = { 0 };
+            if (!readBytes(m_file, format, static_cast<size_t>(std::min(chunkSize, static_cast<uint64_t>(sizeof(format)))))) {
+                close();
+                return false;
+            }
+            formatTag = u16(format);
+            m_numberOfChannels = u16(format + 2);
+            m_sampleRate = static_cast<float>(u32(format + 4));
+            blockAlign = u16(format + 12);
+            bitsPerSample = u16(format + 14);
+
+            // The sub format GUID starts with the plain format tag.
+            if (formatTag == WaveFormatExtensible && chunkSize >= 40)
+                formatTag = u16(format + 24);
+
+            haveFormat = true;
+        }
+        else if (!memcmp(chunk, "data", 4)) {
+            if (isRF64 && chunkSize == 0xffffffffu)
+                chunkSize = rf64DataSize;
+            m_dataOffset = offset + sizeof(chunk);
+
+            if (!haveFormat)
+                break;
+
+            // Samples sit left-justified in a container that may be wider than
+            // the valid bits (20 or 24 bits in 32, for example), so the stride
+            // comes from the block alignment and samples decode by container width.
+            // Some writers leave the alignment zero; fall back to rounded-up bits.
+            if (!blockAlign)
+                blockAlign = ((bitsPerSample + 7) / 8) * m_numberOfChannels;
+            m_bytesPerSample = m_numberOfChannels ? blockAlign / m_numberOfChannels : 0;
+            m_isFloat = formatTag == WaveFormatIEEEFloat;
+
+            bool supported = m_numberOfChannels && m_sampleRate > 0
+                && m_bytesPerSample * m_numberOfChannels == blockAlign
+                && bitsPerSample <= m_bytesPerSample * 8
+                && ((formatTag == WaveFormatPCM && m_bytesPerSample >= 1 && m_bytesPerSample <= 4)
+                    || (m_isFloat && (m_bytesPerSample == 4 || m_bytesPerSample == 8)));
+            if (!supported)
+                break;
+
+            m_length = chunkSize / (m_bytesPerSample * m_numberOfChannels);
+            m_position = 0;
+            return seekTo(m_file, m_dataOffset);
+        }
+
+        // Chunks are padded to an even size.
+        offset += sizeof(chunk) + chunkSize + (chunkSize & 1);
+    }
+
+    close();
+    return false;
+}
+
+bool WavFileReader::seek(uint64_t frame)
+{
+    if (!m_file)
+        return false;
+
+    frame = std::min(frame, m_length);
+    if (!seekTo(m_file, m_dataOffset + frame * m_bytesPerSample * m_numberOfChannels))
+        return false;
+
+    m_position = frame;
+    return true;
+}
+
+size_t WavFileReader::read(float* interleaved, size_t framesToRead)
+{
+    if (!m_file)
+        return 0;
+
+    framesToRead = static_cast<size_t>(std::min(static_cast<uint64_t>(framesToRead), m_length - m_position));
+
+    size_t frameBytes = m_bytesPerSample * m_numberOfChannels;
+    if (m_bytes.size() < framesToRead * frameBytes)
+        m_bytes.resize(framesToRead * frameBytes);
+
+    size_t framesRead = fread(m_bytes.data(), frameBytes, framesToRead, m_file);
+    size_t samples = framesRead * m_numberOfChannels;
+    const uint8_t* p = m_bytes.data();
+
+    if (m_isFloat && m_bytesPerSample == 4) {
+        for (size_t i = 0; i < samples; ++i, p += 4) {
+            uint32_t bits = u32(p);
+            memcpy(interleaved + i, &bits, sizeof(float));
+        }
+    }
+    else if (m_isFloat) {
+        for (size_t i = 0; i < samples; ++i, p += 8) {
+            uint64_t bits = u64(p);
+            double value;
+            memcpy(&value, &bits, sizeof(double));
+            interleaved[i] = static_cast<float>(value);
+        }
+    }
+    else {
+        switch (m_bytesPerSample) {
+        case 1: // unsigned
+            for (size_t i = 0; i < samples; ++i, ++p)
+                interleaved[i] = (static_cast<int>(*p) - 128) * (1.0f / 128);
+            break;
+        case 2:
+            for (size_t i = 0; i < samples; ++i, p += 2)
+                interleaved[i] = static_cast<int16_t>(u16(p)) * (1.0f / 32768);
+            break;
+        case 3:
+            for (size_t i = 0; i < samples; ++i, p += 3)
+                interleaved[i] = (static_cast<int32_t>(static_cast<uint32_t>(p[0]) << 8 | static_cast<uint32_t>(p[1]) << 16 | static_cast<uint32_t>(p[2]) << 24) >> 8) * (1.0f / 8388608);
+            break;
+        case 4:
+            for (size_t i = 0; i < samples; ++i, p += 4)
+                interleaved[i] = static_cast<int32_t>(u32(p)) * (1.0f / 2147483648.0f);
+            break;
+        }
+    }
+
+    m_position += framesRead;
+    return framesRead;
+}
+
+} // namespace WebCore
@@ -0,0 +1,194 @@
+// Copyright (c) 2015 Nick Porcino, All rights reserved.
+// License is MIT: http://opensource.org/licenses/MIT
+
+#include "internal/WavFileWriter.h"
+#include "internal/Assertions.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+namespace WebCore {
+
+namespace {
+
+    const uint16_t WaveFormatPCM = 1;
+    const uint16_t WaveFormatIEEEFloat = 3;
+
+    // The JUNK chunk is exactly the size of the ds64 chunk that replaces it in an RF64 file.
+    const uint32_t ReservedChunkSize = 28;
+
+    const uint64_t MaxRIFFSize = 0xffffffffu;
+
+    // WAV fields are little endian whatever the host is.
+    class HeaderBuilder
+    {
+    public:
+        void tag(const char* fourCC) { m_bytes.insert(m_bytes.end(), fourCC, fourCC + 4); }
+        void u16(uint16_t v) { for (int i = 0; i < 2; ++i) m_bytes.push_back(static_cast<uint8_t>(v >> (8 * i))); }
+        void u32(uint32_t v) { for (int i = 0; i < 4; ++i) m_bytes.push_back(static_cast<uint8_t>(v >> (8 * i))); }
+        void u64(uint64_t v) { for (int i = 0; i < 8; ++i) m_bytes.push_back(static_cast<uint8_t>(v >> (8 * i))); }
+        void zeroes(size_t count) { m_bytes.insert(m_bytes.end(), count, 0); }
+
+        long size() const { return static_cast<long>(m_bytes.size()); }
+
+        bool writeTo(FILE* file, long offset) const
+        {
+            return !fseek(file, offset, SEEK_SET) && fwrite(m_bytes.data(), 1, m_bytes.size(), file) == m_bytes.size();
+        }
+
+    private:
+        std::vector<uint8_t> m_bytes;
+    };
+
+    bool isLittleEndian()
+    {
+        const uint16_t probe = 1;
+        return *reinterpret_cast<const uint8_t*>(&probe) == 1;
+    }
+
+} // namespace
+
+WavFileWriter::WavFileWriter()
+    : m_file(0)
+    , m_numberOfChannels(0)
+    , m_format(Float32)
+    , m_framesWritten(0)
+    , m_factOffset(0)
+    , m_dataOffset(0)
+{
+}
+
+WavFileWriter::~WavFileWriter()
+{
+    close();
+}
+
+bool WavFileWriter::open(const std::string& path, unsigned numberOfChannels, float sampleRate, SampleFormat format)
+{
+    close();
+
+    ASSERT(numberOfChannels);
+    ASSERT(isLittleEndian());
+
+    m_file = fopen(path.c_str(), "wb");
+    if (!m_file)
+        return false;
+
+    m_numberOfChannels = numberOfChannels;
+    m_format = format;
+    m_framesWritten = 0;
+
+    const uint16_t bytesPerSample = format == PCM16 ? 2 : 4;
+    const uint32_t rate = static_cast<uint32_t>(sampleRate + 0.5f);
+
+    HeaderBuilder header;
+    header.tag("RIFF");
+    header.u32(0); // patched by close()
+    header.tag("WAVE");
+
+    header.tag("JUNK");
+    header.u32(ReservedChunkSize);
+    header.zeroes(ReservedChunkSize);
+
+    header.tag("fmt ");
+    header.u32(format == PCM16 ? 16 : 18);
+    header.u16(format == PCM16 ? WaveFormatPCM : WaveFormatIEEEFloat);
+    header.u16(static_cast<uint16_t>(numberOfChannels));
+    header.u32(rate);
+    header.u32(rate * numberOfChannels * bytesPerSample);
+    header.u16(static_cast<uint16_t>(numberOfChannels * bytesPerSample));
+    header.u16(bytesPerSample * 8);
+    if (format != PCM16) {
+        // Formats other than PCM need the extension size, and a fact chunk with the frame count.
+        header.u16(0);
+        header.tag("fact");
+        header.u32(4);
+        m_factOffset = header.size();
+        header.u32(0);
+    }
+
+    header.tag("data");
+    header.u32(0);
+    m_dataOffset = header.size();
+
+    if (!header.writeTo(m_file, 0)) {
+        fclose(m_file);
+        m_file = 0;
+        return false;
+    }
+
+    return true;
+}
+
+bool WavFileWriter::write(const float* interleaved, size_t framesToWrite)
+{
+    if (!m_file)
+        return false;
+
+    const size_t samples = framesToWrite * m_numberOfChannels;
+    size_t written;
+
+    if (m_format == PCM16) {
+        if (m_pcm.size() < samples)
+            m_pcm.resize(samples);
+        for (size_t i = 0; i < samples; ++i) {
+            float scaled = std::max(-1.0f, std::min(interleaved[i], 1.0f)) * 32767.0f;
+            m_pcm[i] = static_cast<int16_t>(lrintf(scaled));
+        }
+        written = fwrite(m_pcm.data(), sizeof(int16_t), samples, m_file);
+    } else
+        written = fwrite(interleaved, sizeof(float), samples, m_file);
+
+    m_framesWritten += written / m_numberOfChannels;
+    return written == samples;
+}
+
+void WavFileWriter::close()
+{
+    if (!m_file)
+        return;
+
+    const uint64_t bytesPerFrame = m_numberOfChannels * (m_format == PCM16 ? 2 : 4);
+    uint64_t dataSize = m_framesWritten * bytesPerFrame;
+
+    // Chunks are padded to an even length.
+    if (dataSize & 1)
+        fputc(0, m_file);
+    uint64_t riffSize = m_dataOffset - 8 + dataSize + (dataSize & 1);
+
+    const bool rf64 = riffSize > MaxRIFFSize;
+
+    HeaderBuilder riff;
+    riff.tag(rf64 ? "RF64" : "RIFF");
+    riff.u32(rf64 ? 0xffffffffu : static_cast<uint32_t>(riffSize));
+    riff.writeTo(m_file, 0);
+
+    if (rf64) {
+        HeaderBuilder ds64;
+        ds64.tag("ds64");
+        ds64.u32(ReservedChunkSize);
+        ds64.u64(riffSize);
+        ds64.u64(dataSize);
+        ds64.u64(m_framesWritten);
+        ds64.u32(0); // no table of other chunk sizes
+        ds64.writeTo(m_file, 12);
+    }
+
+    if (m_factOffset) {
+        HeaderBuilder fact;
+        fact.u32(rf64 ? 0xffffffffu : static_cast<uint32_t>(m_framesWritten));
+        fact.writeTo(m_file, m_factOffset);
+    }
+
+    HeaderBuilder data;
+    data.u32(rf64 ? 0xffffffffu : static_cast<uint32_t>(dataSize));
+    data.writeTo(m_file, m_dataOffset - 4);
+
+    fclose(m_file);
+    m_file = 0;
+    m_factOffset = 0;
+    m_dataOffset = 0;
+}
+
+} // namespace WebCore
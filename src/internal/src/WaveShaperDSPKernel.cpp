@@ -26,46 +26,151 @@
 #include "internal/WaveShaperDSPKernel.h"
 #include "internal/WaveShaperProcessor.h"
 
+#include "LabSound/core/AudioNode.h"
+
 #include <algorithm>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 using namespace std;
 
 namespace WebCore {
 
+namespace {
+
+const size_t MaxFramesPerBlock = AudioNode::ProcessingSizeInFrames;
+
+// Looks each input up in the curve, interpolating between its two nearest points. The curve spans inputs from
+// -1 to 1, and inputs beyond that, or NaN, take the value at the nearer end.
+void applyCurve(const float* curveData, size_t curveLength, const float* source, float* destination, size_t framesToProcess)
+{
+    if (curveLength == 1) {
+        std::fill(destination, destination + framesToProcess, curveData[0]);
+        return;
+    }
+
+    const float scale = 0.5f * (curveLength - 1);
+    const float last = static_cast<float>(curveLength - 1);
+    size_t k = 0;
+
+#ifdef __SSE2__
+    const __m128 one = _mm_set1_ps(1);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 scale4 = _mm_set1_ps(scale);
+    const __m128 last4 = _mm_set1_ps(last);
+    const __m128 lastIndex = _mm_set1_ps(last - 1);
+    int i[4];
+
+    for (; k + 4 <= framesToProcess; k += 4) {
+        __m128 v = _mm_mul_ps(scale4, _mm_add_ps(_mm_loadu_ps(source + k), one));
+
+        // max returns its second operand for NaN
+        v = _mm_min_ps(_mm_max_ps(v, zero), last4);
+
+        // The last point interpolates from the one before it, with a fraction of 1.
+        __m128 index = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(v)), lastIndex);
+        __m128 f = _mm_sub_ps(v, index);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(i), _mm_cvttps_epi32(index));
+
+        __m128 c0 = _mm_setr_ps(curveData[i[0]], curveData[i[1]], curveData[i[2]], curveData[i[3]]);
+        __m128 c1 = _mm_setr_ps(curveData[i[0] + 1], curveData[i[1] + 1], curveData[i[2] + 1], curveData[i[3] + 1]);
+        _mm_storeu_ps(destination + k, _mm_add_ps(c0, _mm_mul_ps(f, _mm_sub_ps(c1, c0))));
+    }
+#endif
+
+    for (; k < framesToProcess; ++k) {
+        float v = scale * (source[k] + 1);
+        if (!(v > 0))
+            v = 0;
+        else if (v > last)
+            v = last;
+
+        size_t index = min(static_cast<size_t>(v), curveLength - 2);
+        float f = v - index;
+        destination[k] = curveData[index] + f * (curveData[index + 1] - curveData[index]);
+    }
+}
+
+} // namespace
+
+WaveShaperDSPKernel::WaveShaperDSPKernel(WaveShaperProcessor* processor)
+    : AudioDSPKernel(processor)
+    , m_upSampler(OuterHalfLength, MaxFramesPerBlock)
+    , m_upSampler2(InnerHalfLength, 2 * MaxFramesPerBlock)
+    , m_downSampler2(InnerHalfLength, 4 * MaxFramesPerBlock)
+    , m_downSampler(OuterHalfLength, 2 * MaxFramesPerBlock)
+    , m_oversampled(2 * MaxFramesPerBlock)
+    , m_oversampled2(4 * MaxFramesPerBlock)
+{
+}
+
 void WaveShaperDSPKernel::process(ContextRenderLock&, const float* source, float* destination, size_t framesToProcess)
 {
     ASSERT(source && destination && waveShaperProcessor());
 
     std::shared_ptr<std::vector<float>> curve = waveShaperProcessor()->curve();
-    if (!curve) {
+    if (!curve || curve->empty()) {
         // Act as "straight wire" pass-through if no curve is set.
         memcpy(destination, source, sizeof(float) * framesToProcess);
         return;
     }
 
-    float* curveData = &(*curve)[0];
-    int curveLength = (*curve).size();
-
-    ASSERT(curveData);
+    const float* curveData = curve->data();
+    size_t curveLength = curve->size();
 
-    if (!curveData || !curveLength) {
-        memcpy(destination, source, sizeof(float) * framesToProcess);
+    OverSampleType oversample = waveShaperProcessor()->oversample();
+    if (oversample == OverSampleType::NONE) {
+        applyCurve(curveData, curveLength, source, destination, framesToProcess);
         return;
     }
 
-    // Apply waveshaping curve.
-    for (unsigned i = 0; i < framesToProcess; ++i) {
-        const float input = source[i];
+    // Only the curve runs at the higher rate. The samplers consume their input before they write, so the
+    // source and destination may be the same.
+    float* x2 = m_oversampled.data();
+    float* x4 = m_oversampled2.data();
+
+    for (size_t offset = 0; offset < framesToProcess; offset += MaxFramesPerBlock) {
+        size_t n = min(MaxFramesPerBlock, framesToProcess - offset);
+
+        m_upSampler.process(source + offset, x2, n);
+        if (oversample == OverSampleType::FOUR_X) {
+            m_upSampler2.process(x2, x4, 2 * n);
+            applyCurve(curveData, curveLength, x4, x4, 4 * n);
+            m_downSampler2.process(x4, x2, 4 * n);
+        }
+        else
+            applyCurve(curveData, curveLength, x2, x2, 2 * n);
+        m_downSampler.process(x2, destination + offset, 2 * n);
+    }
+}
 
-        // Calculate an index based on input -1 -> +1 with 0 being at the center of the curve data.
-        int index = (curveLength * (input + 1)) / 2;
+void WaveShaperDSPKernel::reset()
+{
+    m_upSampler.reset();
+    m_upSampler2.reset();
+    m_downSampler2.reset();
+    m_downSampler.reset();
+}
 
-        // Clip index to the input range of the curve.
-        // This takes care of input outside of nominal range -1 -> +1
-        index = max(index, 0);
-        index = min(index, curveLength - 1);
-        destination[i] = curveData[index];
+double WaveShaperDSPKernel::latencyTime() const
+{
+    size_t frames = 0;
+    switch (waveShaperProcessor()->oversample()) {
+    case OverSampleType::TWO_X:
+        frames = m_upSampler.latencyFrames() + m_downSampler.latencyFrames();
+        break;
+    case OverSampleType::FOUR_X:
+        // the inner stages' delays are counted at twice the rate
+        frames = m_upSampler.latencyFrames() + m_downSampler.latencyFrames() + (m_upSampler2.latencyFrames() + m_downSampler2.latencyFrames()) / 2;
+        break;
+    case OverSampleType::NONE:
+    default:
+        break;
     }
+    return frames / static_cast<double>(sampleRate());
 }
 
 } // namespace WebCore
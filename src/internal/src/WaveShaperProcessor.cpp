@@ -32,6 +32,7 @@ namespace WebCore {
     
 WaveShaperProcessor::WaveShaperProcessor(float sampleRate, size_t numberOfChannels)
     : AudioDSPKernelProcessor(sampleRate, numberOfChannels)
+    , m_oversample(OverSampleType::NONE)
 {
 }
 
@@ -53,6 +54,18 @@ void WaveShaperProcessor::setCurve(ContextRenderLock& r, std::shared_ptr<std::ve
     m_curve = curve;
 }
 
+void WaveShaperProcessor::setOversample(ContextRenderLock& r, OverSampleType type)
+{
+    // the kernels' filters hold the previous rate's history, so they are cleared for the new one
+    ASSERT(r.context());
+    if (type == m_oversample)
+        return;
+
+    m_oversample = type;
+    for (auto & kernel : m_kernels)
+        kernel->reset();
+}
+
 void WaveShaperProcessor::process(ContextRenderLock& r, const AudioBus* source, AudioBus* destination, size_t framesToProcess)
 {
     if (!isInitialized() || !r.context()) {
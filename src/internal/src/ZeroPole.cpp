@@ -66,4 +66,44 @@ void ZeroPole::process(const float *source, float *destination, unsigned framesT
     m_lastY = DenormalDisabler::flushDenormalFloatToZero(lastY);
 }
 
+void ZeroPole::processCascade(ZeroPole* filters, unsigned numberOfFilters, const float *source, float *destination, unsigned framesToProcess)
+{
+    if (numberOfFilters != 4) {
+        for (unsigned i = 0; i < numberOfFilters; ++i)
+            filters[i].process(i ? destination : source, destination, framesToProcess);
+        return;
+    }
+
+    float zero[4], pole[4], k1[4], k2[4], lastX[4], lastY[4];
+    for (unsigned i = 0; i < 4; ++i) {
+        zero[i] = filters[i].m_zero;
+        pole[i] = filters[i].m_pole;
+        k1[i] = 1 / (1 - zero[i]);
+        k2[i] = 1 - pole[i];
+        lastX[i] = filters[i].m_lastX;
+        lastY[i] = filters[i].m_lastY;
+    }
+
+    for (unsigned n = 0; n < framesToProcess; ++n) {
+        float input = source[n];
+
+        for (unsigned i = 0; i < 4; ++i) {
+            float output1 = k1[i] * (input - zero[i] * lastX[i]);
+            lastX[i] = input;
+
+            float output2 = k2[i] * output1 + pole[i] * lastY[i];
+            lastY[i] = output2;
+
+            input = output2;
+        }
+
+        destination[n] = input;
+    }
+
+    for (unsigned i = 0; i < 4; ++i) {
+        filters[i].m_lastX = DenormalDisabler::flushDenormalFloatToZero(lastX[i]);
+        filters[i].m_lastY = DenormalDisabler::flushDenormalFloatToZero(lastY[i]);
+    }
+}
+
 } // WebCore